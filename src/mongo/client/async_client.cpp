@@ -242,6 +242,181 @@ Future<executor::RemoteCommandResponse> AsyncDBClient::runCommandRequest(
         });
 }
 
+/**
+ * The requests passed to runCommandRequests() which are still waiting for their replies.
+ */
+struct AsyncDBClient::PipelinedCalls {
+    struct Call {
+        int32_t msgId;
+        Message request;
+        Promise<executor::RemoteCommandResponse> promise;
+        bool answered = false;
+    };
+
+    Milliseconds elapsed() const {
+        return duration_cast<Milliseconds>(clkSource->now() - start);
+    }
+
+    /**
+     * Takes the promise for the request with the given message ID, or returns boost::none if
+     * there is no such request or it has already been answered.
+     */
+    boost::optional<Promise<executor::RemoteCommandResponse>> takePromise(int32_t msgId) {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        for (auto& call : calls) {
+            if (call.msgId == msgId && !call.answered) {
+                call.answered = true;
+                --unanswered;
+                return std::move(call.promise);
+            }
+        }
+        return boost::none;
+    }
+
+    /**
+     * Takes the promises for all of the requests which have not been answered yet.
+     */
+    std::vector<Promise<executor::RemoteCommandResponse>> takeUnansweredPromises() {
+        std::vector<Promise<executor::RemoteCommandResponse>> promises;
+
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        for (auto& call : calls) {
+            if (!call.answered) {
+                call.answered = true;
+                promises.push_back(std::move(call.promise));
+            }
+        }
+        unanswered = 0;
+        return promises;
+    }
+
+    bool hasUnanswered() {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        return unanswered > 0;
+    }
+
+    ClockSource* clkSource;
+    Date_t start;
+
+    // Whether the replies are read while the requests are being written
+    bool concurrent;
+
+    stdx::mutex mutex;
+    std::vector<Call> calls;
+    size_t unanswered = 0;
+};
+
+std::vector<Future<executor::RemoteCommandResponse>> AsyncDBClient::runCommandRequests(
+    std::vector<executor::RemoteCommandRequest> requests) {
+    invariant(_negotiatedProtocol);
+
+    auto calls = std::make_shared<PipelinedCalls>();
+    calls->clkSource = _svcCtx->getPreciseClockSource();
+    calls->start = calls->clkSource->now();
+    calls->concurrent = _session->canSinkWhileSourcing();
+
+    std::vector<Future<executor::RemoteCommandResponse>> futures;
+    futures.reserve(requests.size());
+    calls->calls.reserve(requests.size());
+
+    for (auto& request : requests) {
+        auto pf = makePromiseFuture<executor::RemoteCommandResponse>();
+        futures.push_back(std::move(pf.future));
+
+        auto requestMsg = rpc::messageFromOpMsgRequest(
+            *_negotiatedProtocol,
+            OpMsgRequest::fromDBAndBody(
+                std::move(request.dbname), std::move(request.cmdObj), std::move(request.metadata)));
+        auto swm = _compressorManager.compressMessage(requestMsg);
+        if (!swm.isOK()) {
+            pf.promise.emplaceValue(
+                executor::RemoteCommandResponse(swm.getStatus(), Milliseconds(0)));
+            continue;
+        }
+
+        requestMsg = std::move(swm.getValue());
+        auto msgId = nextMessageId();
+        requestMsg.header().setId(msgId);
+        requestMsg.header().setResponseToMsgId(0);
+
+        calls->calls.push_back({msgId, std::move(requestMsg), std::move(pf.promise)});
+    }
+    calls->unanswered = calls->calls.size();
+
+    if (calls->unanswered) {
+        _sinkPipelined(calls, 0);
+        if (calls->concurrent) {
+            _sourcePipelined(calls);
+        }
+    }
+
+    return futures;
+}
+
+void AsyncDBClient::_sinkPipelined(std::shared_ptr<PipelinedCalls> calls, size_t next) {
+    if (next == calls->calls.size()) {
+        return;
+    }
+
+    auto self = shared_from_this();
+    auto sunk = _session->asyncSinkMessage(calls->calls[next].request);
+    if (!calls->concurrent) {
+        sunk = std::move(sunk).then([self, calls] { return self->_sourcePipelinedReply(calls); });
+    }
+
+    std::move(sunk).getAsync([self, calls, next](Status status) {
+        if (!status.isOK()) {
+            self->_failPipelined(calls, std::move(status));
+            return;
+        }
+
+        self->_sinkPipelined(calls, next + 1);
+    });
+}
+
+void AsyncDBClient::_sourcePipelined(std::shared_ptr<PipelinedCalls> calls) {
+    auto self = shared_from_this();
+    _sourcePipelinedReply(calls).getAsync([self, calls](Status status) {
+        if (!status.isOK()) {
+            self->_failPipelined(calls, std::move(status));
+            return;
+        }
+
+        if (calls->hasUnanswered()) {
+            self->_sourcePipelined(calls);
+        }
+    });
+}
+
+Future<void> AsyncDBClient::_sourcePipelinedReply(std::shared_ptr<PipelinedCalls> calls) {
+    return _session->asyncSourceMessage().then([this, calls](Message response) {
+        const auto responseTo = response.header().getResponseToMsgId();
+        if (response.operation() == dbCompressed) {
+            response = uassertStatusOK(_compressorManager.decompressMessage(response));
+        }
+
+        rpc::UniqueReply reply(response, rpc::makeReply(&response));
+
+        auto promise = calls->takePromise(responseTo);
+        uassert(51252, "ResponseId did not match any sent message ID.", promise);
+        promise->emplaceValue(executor::RemoteCommandResponse(*reply, calls->elapsed()));
+    });
+}
+
+void AsyncDBClient::_failPipelined(const std::shared_ptr<PipelinedCalls>& calls, Status status) {
+    auto promises = calls->takeUnansweredPromises();
+    if (promises.empty()) {
+        return;
+    }
+
+    // Whichever of the reads and writes is still outstanding will never complete normally.
+    _session->cancelAsyncOperations();
+
+    for (auto& promise : promises) {
+        promise.emplaceValue(executor::RemoteCommandResponse(status, calls->elapsed()));
+    }
+}
+
 void AsyncDBClient::cancel(const transport::BatonHandle& baton) {
     _session->cancelAsyncOperations(baton);
 }
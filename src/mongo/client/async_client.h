@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/db/service_context.h"
 #include "mongo/executor/network_connection_hook.h"
@@ -63,6 +64,20 @@ public:
     Future<rpc::UniqueReply> runCommand(OpMsgRequest request,
                                         const transport::BatonHandle& baton = nullptr);
 
+    /**
+     * Runs all of the given requests over this connection and returns a future for each of their
+     * responses, in the order of the requests. Replies are matched to their requests by
+     * responseTo, so the server may answer them in any order.
+     *
+     * If the session can sink while sourcing, every request is written without waiting for any
+     * replies, and the replies are read as they arrive. Otherwise each request is written once
+     * the reply to the one before it has been read.
+     *
+     * A network error fails every request which has not been answered yet.
+     */
+    std::vector<Future<executor::RemoteCommandResponse>> runCommandRequests(
+        std::vector<executor::RemoteCommandRequest> requests);
+
     Future<void> authenticate(const BSONObj& params);
 
     Future<void> initWireVersion(const std::string& appName,
@@ -78,7 +93,13 @@ public:
     const HostAndPort& local() const;
 
 private:
+    struct PipelinedCalls;
+
     Future<Message> _call(Message request, const transport::BatonHandle& baton = nullptr);
+    void _sinkPipelined(std::shared_ptr<PipelinedCalls> calls, size_t next);
+    void _sourcePipelined(std::shared_ptr<PipelinedCalls> calls);
+    Future<void> _sourcePipelinedReply(std::shared_ptr<PipelinedCalls> calls);
+    void _failPipelined(const std::shared_ptr<PipelinedCalls>& calls, Status status);
     BSONObj _buildIsMasterRequest(const std::string& appName);
     void _parseIsMasterResponse(BSONObj request,
                                 const std::unique_ptr<rpc::ReplyInterface>& response);
@@ -0,0 +1,164 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/client/async_client.h"
+
+#include "mongo/client/mock_server_session.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/rpc/factory.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/transport/transport_layer_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using executor::RemoteCommandRequest;
+using executor::RemoteCommandResponse;
+
+const HostAndPort kHost("localhost", 27017);
+
+class AsyncDBClientTest : public ServiceContextTest {
+public:
+    /**
+     * Makes a client over a MockServerSession and takes it through the isMaster handshake.
+     */
+    std::shared_ptr<AsyncDBClient> makeClient(bool canSinkWhileSourcing) {
+        session = std::make_shared<MockServerSession>(&tl, nullptr, canSinkWhileSourcing);
+        auto client = std::make_shared<AsyncDBClient>(kHost, session, getServiceContext());
+
+        auto handshake = client->initWireVersion("AsyncDBClientTest", nullptr);
+        session->replyToIsMaster();
+        ASSERT_OK(handshake.getNoThrow());
+
+        return client;
+    }
+
+    static std::vector<RemoteCommandRequest> makeRequests(int count) {
+        std::vector<RemoteCommandRequest> requests;
+        for (int i = 0; i < count; ++i) {
+            requests.emplace_back(kHost, "admin", BSON("echo" << 1 << "n" << i), nullptr);
+        }
+        return requests;
+    }
+
+    /**
+     * Answers the request with a reply which carries the request's "n".
+     */
+    void echo(const Message& request) {
+        auto n = rpc::opMsgRequestFromAnyProtocol(request).body["n"].numberInt();
+        session->reply(request, BSON("ok" << 1 << "n" << n));
+    }
+
+    static void assertEchoed(Future<RemoteCommandResponse>& future, int n) {
+        auto response = future.get();
+        ASSERT_OK(response.status);
+        ASSERT_EQ(response.data["n"].numberInt(), n);
+    }
+
+    transport::TransportLayerMock tl;
+    std::shared_ptr<MockServerSession> session;
+};
+
+TEST_F(AsyncDBClientTest, PipelinedRepliesAreMatchedByResponseTo) {
+    auto client = makeClient(true);
+    auto futures = client->runCommandRequests(makeRequests(3));
+
+    // Every request is written before any of them is answered.
+    std::vector<Message> requests;
+    for (int i = 0; i < 3; ++i) {
+        requests.push_back(session->waitForRequest());
+    }
+
+    echo(requests[2]);
+    ASSERT_TRUE(futures[2].isReady());
+    ASSERT_FALSE(futures[0].isReady());
+    ASSERT_FALSE(futures[1].isReady());
+
+    echo(requests[0]);
+    ASSERT_TRUE(futures[0].isReady());
+    ASSERT_FALSE(futures[1].isReady());
+
+    echo(requests[1]);
+    for (int i = 0; i < 3; ++i) {
+        assertEchoed(futures[i], i);
+    }
+}
+
+TEST_F(AsyncDBClientTest, RequestsAreSentOneAtATimeIfSessionCannotSinkWhileSourcing) {
+    auto client = makeClient(false);
+    auto futures = client->runCommandRequests(makeRequests(3));
+
+    for (int i = 0; i < 3; ++i) {
+        auto request = session->waitForRequest();
+        ASSERT_EQ(session->numUnreadRequests(), 0U);
+        ASSERT_FALSE(futures[i].isReady());
+
+        echo(request);
+        assertEchoed(futures[i], i);
+    }
+}
+
+TEST_F(AsyncDBClientTest, NetworkErrorFailsEveryUnansweredRequest) {
+    auto client = makeClient(true);
+    auto futures = client->runCommandRequests(makeRequests(3));
+
+    session->waitForRequest();
+    echo(session->waitForRequest());
+    session->waitForRequest();
+
+    session->fail(Status(ErrorCodes::HostUnreachable, "Connection reset"));
+
+    assertEchoed(futures[1], 1);
+    for (auto i : {0, 2}) {
+        auto response = futures[i].get();
+        ASSERT_EQ(response.status, ErrorCodes::HostUnreachable);
+    }
+}
+
+TEST_F(AsyncDBClientTest, ReplyToUnknownRequestFailsEveryUnansweredRequest) {
+    auto client = makeClient(true);
+    auto futures = client->runCommandRequests(makeRequests(2));
+
+    auto first = session->waitForRequest();
+    session->waitForRequest();
+    echo(first);
+
+    auto unknown = OpMsgRequest::fromDBAndBody("admin", BSON("echo" << 1)).serialize();
+    unknown.header().setId(nextMessageId());
+    session->reply(unknown, BSON("ok" << 1));
+
+    assertEchoed(futures[0], 0);
+    auto response = futures[1].get();
+    ASSERT_EQ(response.status, ErrorCodes::Error(51252));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,227 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/wire_version.h"
+#include "mongo/rpc/factory.h"
+#include "mongo/rpc/legacy_reply_builder.h"
+#include "mongo/rpc/op_msg_rpc_impls.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/transport/mock_session.h"
+#include "mongo/util/future.h"
+#include "mongo/rpc/message.h"
+
+namespace mongo {
+
+/**
+ * A session for testing AsyncDBClient, and what is built on it, without a network. The test
+ * plays the part of the server: every message the client sinks is kept until the test takes it
+ * with waitForRequest(), and the test answers it with reply(). The client reads the replies in
+ * the order the test gives them, whatever order the requests were sent in.
+ *
+ * If the session has a reactor, replies and errors are delivered on the reactor's thread, as a
+ * real session would deliver them. Otherwise they are delivered on the thread which gives them.
+ */
+class MockServerSession : public transport::MockSession {
+public:
+    MockServerSession(transport::TransportLayer* tl,
+                      transport::ReactorHandle reactor,
+                      bool canSinkWhileSourcing)
+        : MockSession(tl),
+          _reactor(std::move(reactor)),
+          _canSinkWhileSourcing(canSinkWhileSourcing) {}
+
+    Future<Message> asyncSourceMessage(const transport::BatonHandle& baton = nullptr) override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_replies.empty()) {
+            auto reply = std::move(_replies.front());
+            _replies.pop_front();
+            return Future<Message>::makeReady(std::move(reply));
+        }
+
+        if (!_status.isOK()) {
+            return _status;
+        }
+
+        invariant(!_pendingSource);
+        auto pf = makePromiseFuture<Message>();
+        _pendingSource.emplace(std::move(pf.promise));
+        return std::move(pf.future);
+    }
+
+    Future<void> asyncSinkMessage(Message message,
+                                  const transport::BatonHandle& baton = nullptr) override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (!_status.isOK()) {
+            return _status;
+        }
+
+        _requests.push_back(std::move(message));
+        _requestsCV.notify_all();
+        return Future<void>::makeReady();
+    }
+
+    void cancelAsyncOperations(const transport::BatonHandle& baton = nullptr) override {
+        _failPendingSource(Status(ErrorCodes::CallbackCanceled, "Canceled by the client"));
+    }
+
+    void end() override {
+        fail(Status(ErrorCodes::SocketException, "Session ended by the client"));
+    }
+
+    bool isConnected() override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _status.isOK();
+    }
+
+    bool canSinkWhileSourcing() const override {
+        return _canSinkWhileSourcing;
+    }
+
+    /**
+     * Waits for the client to send a request and returns it.
+     */
+    Message waitForRequest() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _requestsCV.wait(lk, [&] { return !_requests.empty(); });
+        auto request = std::move(_requests.front());
+        _requests.pop_front();
+        return request;
+    }
+
+    /**
+     * Returns the number of requests the client has sent which the test has not taken yet.
+     */
+    size_t numUnreadRequests() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _requests.size();
+    }
+
+    /**
+     * Answers the given request with the given command reply, in the protocol of the request.
+     */
+    void reply(const Message& request, const BSONObj& commandReply) {
+        auto reply = [&] {
+            if (request.operation() == dbQuery) {
+                rpc::LegacyReplyBuilder builder;
+                builder.setRawCommandReply(commandReply).setMetadata(BSONObj());
+                return builder.done();
+            }
+
+            rpc::OpMsgReplyBuilder builder;
+            builder.setRawCommandReply(commandReply);
+            return builder.done();
+        }();
+        reply.header().setId(nextMessageId());
+        reply.header().setResponseToMsgId(request.header().getId());
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        if (!_pendingSource) {
+            _replies.push_back(std::move(reply));
+            return;
+        }
+
+        auto promise = std::move(*_pendingSource);
+        _pendingSource = boost::none;
+        lk.unlock();
+
+        _deliver([ promise = promise.share(), reply = std::move(reply) ]() mutable {
+            promise.emplaceValue(std::move(reply));
+        });
+    }
+
+    /**
+     * Waits for the client's isMaster and answers it with one from a server of the latest wire
+     * version.
+     */
+    void replyToIsMaster() {
+        auto request = waitForRequest();
+        invariant(rpc::opMsgRequestFromAnyProtocol(request).getCommandName() == "isMaster");
+        reply(request,
+              BSON("ok" << 1 << "ismaster" << true << "minWireVersion"
+                        << WireVersion::RELEASE_2_4_AND_BEFORE
+                        << "maxWireVersion"
+                        << WireVersion::LATEST_WIRE_VERSION));
+    }
+
+    /**
+     * Breaks the connection: the pending read and every operation after it fail with the given
+     * status. Replies which were already given are still read first.
+     */
+    void fail(Status status) {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (!_status.isOK()) {
+                return;
+            }
+            _status = status;
+        }
+        _failPendingSource(std::move(status));
+    }
+
+private:
+    void _failPendingSource(Status status) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        if (!_pendingSource) {
+            return;
+        }
+
+        auto promise = std::move(*_pendingSource);
+        _pendingSource = boost::none;
+        lk.unlock();
+
+        _deliver([ promise = promise.share(), status = std::move(status) ]() mutable {
+            promise.setError(std::move(status));
+        });
+    }
+
+    void _deliver(transport::Reactor::Task task) {
+        if (_reactor) {
+            _reactor->schedule(transport::Reactor::kPost, std::move(task));
+        } else {
+            task();
+        }
+    }
+
+    const transport::ReactorHandle _reactor;
+    const bool _canSinkWhileSourcing;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _requestsCV;
+    std::deque<Message> _requests;
+    std::deque<Message> _replies;
+    boost::optional<Promise<Message>> _pendingSource;
+    Status _status = Status::OK();
+};
+
+}  // namespace mongo
@@ -67,4 +67,28 @@ void AuthorizationSession::ScopedImpersonate::swap() {
 }
 
 MONGO_DEFINE_SHIM(AuthorizationSession::create);
+
+Status AuthorizationSession::inheritAuthenticatedUsers(OperationContext* opCtx,
+                                                       AuthorizationSession* other) {
+    if (getAuthenticatedUserNamesToken() == other->getAuthenticatedUserNamesToken()) {
+        return Status::OK();
+    }
+
+    std::vector<std::string> dbnames;
+    for (auto nameIter = getAuthenticatedUserNames(); nameIter.more(); nameIter.next()) {
+        dbnames.push_back(nameIter->getDB().toString());
+    }
+    for (const auto& dbname : dbnames) {
+        logoutDatabase(dbname);
+    }
+
+    for (auto nameIter = other->getAuthenticatedUserNames(); nameIter.more(); nameIter.next()) {
+        Status status = addAndAuthorizeUser(opCtx, *nameIter);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
+    return Status::OK();
+}
 }  // namespace mongo
@@ -128,6 +128,12 @@ public:
      */
     static void set(Client* client, std::unique_ptr<AuthorizationSession> session);
 
+    /**
+     * Authenticates this AuthorizationSession as the same users as "other", which belongs to
+     * another Client of the same connection, logging out any other users.
+     */
+    Status inheritAuthenticatedUsers(OperationContext* opCtx, AuthorizationSession* other);
+
     // Takes ownership of the externalState.
     virtual ~AuthorizationSession() = 0;
 
@@ -34,6 +34,11 @@
 #include <array>
 #include <cstdlib>
 #include <iterator>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
@@ -81,6 +86,38 @@ static constexpr std::array<SpecialArgRecord, 25> specials{{
     {"lastCommittedOpTime"_sd,               0, 0, 1}}};
 // clang-format on
 
+struct DecodedArgRecord {
+    StringData name;
+    BSONElement GenericArguments::*element;
+};
+
+// The arguments which GenericArguments::parse() picks out of a request body, roughly in order of
+// how often requests carry them.
+// clang-format off
+static const std::array<DecodedArgRecord, 12> decodedArgs{{
+    {"$clusterTime"_sd,                     &GenericArguments::clusterTime},
+    {"readConcern"_sd,                      &GenericArguments::readConcern},
+    {"maxTimeMS"_sd,                        &GenericArguments::maxTimeMS},
+    {"$readPreference"_sd,                  &GenericArguments::readPreference},
+    {"$client"_sd,                          &GenericArguments::client},
+    {"$audit"_sd,                           &GenericArguments::audit},
+    {"$configServerState"_sd,               &GenericArguments::configServerState},
+    {"tracking_info"_sd,                    &GenericArguments::trackingInfo},
+    {"allowImplicitCollectionCreation"_sd,  &GenericArguments::allowImplicitCollectionCreation},
+    {"customerCmd"_sd,                      &GenericArguments::customerCmd},
+    {"$maxTimeMS"_sd,                       &GenericArguments::queryOptionMaxTimeMS},
+    {"help"_sd,                             &GenericArguments::help}}};
+// clang-format on
+
+// Requests with up to this many fields are checked for duplicates without allocating.
+const size_t kMaxFieldsForInlineDuplicateCheck = 16;
+
+void uassertedDuplicateField(StringData fieldName) {
+    uasserted(ErrorCodes::FailedToParse,
+              str::stream() << "Parsed command object contains duplicate top level key: "
+                            << fieldName);
+}
+
 const SpecialArgRecord* findSpecialArg(StringData arg) {
     for (const auto& e : specials)
         if (e.name == arg)
@@ -105,4 +142,48 @@ bool isReplyStripArgument(StringData arg) {
     return p && p->stripFromReply;
 }
 
+GenericArguments GenericArguments::parse(const BSONObj& body) {
+    GenericArguments args;
+
+    std::array<StringData, kMaxFieldsForInlineDuplicateCheck> fieldNames;
+    size_t numFields = 0;
+
+    for (auto&& element : body) {
+        const auto fieldName = element.fieldNameStringData();
+
+        if (numFields < fieldNames.size()) {
+            for (size_t i = 0; i < numFields; i++) {
+                if (fieldNames[i] == fieldName) {
+                    uassertedDuplicateField(fieldName);
+                }
+            }
+            fieldNames[numFields] = fieldName;
+        }
+        numFields++;
+
+        for (const auto& arg : decodedArgs) {
+            if (arg.name == fieldName) {
+                args.*arg.element = element;
+                break;
+            }
+        }
+    }
+
+    if (numFields > fieldNames.size()) {
+        // Too many fields to compare pairwise, so sort their names instead.
+        std::vector<StringData> allFieldNames;
+        allFieldNames.reserve(numFields);
+        for (auto&& element : body) {
+            allFieldNames.push_back(element.fieldNameStringData());
+        }
+        std::sort(allFieldNames.begin(), allFieldNames.end());
+        auto duplicate = std::adjacent_find(allFieldNames.begin(), allFieldNames.end());
+        if (duplicate != allFieldNames.end()) {
+            uassertedDuplicateField(*duplicate);
+        }
+    }
+
+    return args;
+}
+
 }  // namespace mongo
@@ -29,9 +29,12 @@
 #pragma once
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/bsonelement.h"
 
 namespace mongo {
 
+class BSONObj;
+
 /**
  * Returns true if the provided argument is one that is handled by the command processing layer
  * and should generally be ignored by individual command implementations. In particular,
@@ -52,4 +55,38 @@ bool isRequestStripArgument(StringData arg);
  */
 bool isReplyStripArgument(StringData arg);
 
+/**
+ * The generic arguments of a command request, found in a single pass over the request body so that
+ * command dispatch does not have to look each of them up separately. The element for an argument
+ * which the request does not have is EOO.
+ *
+ * The elements point into the body, which must outlive this object.
+ */
+struct GenericArguments {
+    /**
+     * Scans the top-level fields of a command request body. Throws FailedToParse if a field name
+     * appears more than once.
+     */
+    static GenericArguments parse(const BSONObj& body);
+
+    // Metadata.
+    BSONElement audit;
+    BSONElement client;
+    BSONElement configServerState;
+    BSONElement clusterTime;
+    BSONElement readPreference;
+    BSONElement trackingInfo;
+
+    // Operation options.
+    BSONElement maxTimeMS;
+    BSONElement queryOptionMaxTimeMS;  // The unsupported "$maxTimeMS" spelling.
+    BSONElement readConcern;
+    BSONElement allowImplicitCollectionCreation;
+    BSONElement customerCmd;
+
+    // Not a generic argument, since help requests never reach the command parser, but dispatch
+    // looks for it along with them.
+    BSONElement help;
+};
+
 }  // namespace mongo
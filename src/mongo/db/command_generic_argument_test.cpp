@@ -0,0 +1,112 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/command_generic_argument.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+TEST(GenericArgumentsTest, FindsGenericArguments) {
+    const auto body = BSON("find"
+                           << "coll"
+                           << "filter"
+                           << BSON("_id" << 1)
+                           << "maxTimeMS"
+                           << 100
+                           << "readConcern"
+                           << BSON("level"
+                                   << "majority")
+                           << "lsid"
+                           << BSON("id" << 1)
+                           << "txnNumber"
+                           << 3LL
+                           << "$readPreference"
+                           << BSON("mode"
+                                   << "secondary")
+                           << "$db"
+                           << "test");
+
+    auto args = GenericArguments::parse(body);
+    ASSERT_EQ(args.maxTimeMS.numberInt(), 100);
+    ASSERT_BSONOBJ_EQ(args.readConcern.Obj(),
+                      BSON("level"
+                           << "majority"));
+    ASSERT_BSONOBJ_EQ(args.readPreference.Obj(),
+                      BSON("mode"
+                           << "secondary"));
+
+    ASSERT(args.clusterTime.eoo());
+    ASSERT(args.help.eoo());
+    ASSERT(args.queryOptionMaxTimeMS.eoo());
+}
+
+TEST(GenericArgumentsTest, ArgumentsParsedElsewhereAreStillGeneric) {
+    // GenericArguments::parse() leaves these to their own parsers, but commands must still accept
+    // them and passthrough must still treat them as generic.
+    ASSERT_TRUE(isGenericArgument("lsid"));
+    ASSERT_TRUE(isGenericArgument("txnNumber"));
+    ASSERT_TRUE(isGenericArgument("writeConcern"));
+    ASSERT_TRUE(isRequestStripArgument("shardVersion"));
+    ASSERT_TRUE(isRequestStripArgument("databaseVersion"));
+    ASSERT_FALSE(isRequestStripArgument("lsid"));
+}
+
+TEST(GenericArgumentsTest, RejectsDuplicateFields) {
+    ASSERT_THROWS_CODE(
+        GenericArguments::parse(BSON("ping" << 1 << "maxTimeMS" << 1 << "maxTimeMS" << 2)),
+        AssertionException,
+        ErrorCodes::FailedToParse);
+    ASSERT_THROWS_CODE(GenericArguments::parse(BSON("ping" << 1 << "a" << 1 << "a" << 2)),
+                       AssertionException,
+                       ErrorCodes::FailedToParse);
+}
+
+TEST(GenericArgumentsTest, RejectsDuplicateFieldsInLargeBodies) {
+    BSONObjBuilder bob;
+    bob.append("ping", 1);
+    for (int i = 0; i < 40; i++) {
+        bob.append(str::stream() << "field" << i, i);
+    }
+    const auto body = bob.obj();
+    GenericArguments::parse(body);
+
+    BSONObjBuilder duplicated;
+    duplicated.appendElements(body);
+    duplicated.append("field3", 3);
+    ASSERT_THROWS_CODE(GenericArguments::parse(duplicated.obj()),
+                       AssertionException,
+                       ErrorCodes::FailedToParse);
+}
+
+}  // namespace
+}  // namespace mongo
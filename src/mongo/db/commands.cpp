@@ -69,6 +69,45 @@ const WriteConcernOptions kMajorityWriteConcern(
     // supported by the mongod.
     WriteConcernOptions::SyncMode::UNSET,
     Seconds(60));
+
+// The command names for which to check out a session. These are commands that support retryable
+// writes, readConcern snapshot, or multi-statement transactions. We additionally check out the
+// session for commands that can take a lock and then run another whitelisted command in
+// DBDirectClient. Otherwise, the nested command would try to check out a session under a lock,
+// which is not allowed.
+//
+// Commands are constructed during static initialization, so the list is built on first use.
+bool shouldCheckoutSessionForCommand(const std::string& name) {
+    static const StringMap<int> sessionCheckoutWhitelist = {{"abortTransaction", 1},
+                                                            {"aggregate", 1},
+                                                            {"applyOps", 1},
+                                                            {"commitTransaction", 1},
+                                                            {"count", 1},
+                                                            {"dbHash", 1},
+                                                            {"delete", 1},
+                                                            {"distinct", 1},
+                                                            {"doTxn", 1},
+                                                            {"eval", 1},
+                                                            {"$eval", 1},
+                                                            {"explain", 1},
+                                                            {"filemd5", 1},
+                                                            {"find", 1},
+                                                            {"findandmodify", 1},
+                                                            {"findAndModify", 1},
+                                                            {"geoNear", 1},
+                                                            {"geoSearch", 1},
+                                                            {"getMore", 1},
+                                                            {"group", 1},
+                                                            {"insert", 1},
+                                                            {"killCursors", 1},
+                                                            {"mapReduce", 1},
+                                                            {"parallelCollectionScan", 1},
+                                                            {"prepareTransaction", 1},
+                                                            {"refreshLogicalSessionCacheNow", 1},
+                                                            {"update", 1}};
+    return sessionCheckoutWhitelist.count(name);
+}
+
 }  // namespace
 
 /*****modify mongodb code start*****/
@@ -769,6 +808,8 @@ std::unique_ptr<CommandInvocation> BasicCommand::parse(OperationContext* opCtx,
 
 Command::Command(StringData name, StringData oldName)
     : _name(name.toString()),
+      _shouldCheckoutSession(shouldCheckoutSessionForCommand(_name)),
+      _isDoTxn(_name == "doTxn"),
       _commandsExecutedMetric("commands." + _name + ".total", &_commandsExecuted),
       _commandsFailedMetric("commands." + _name + ".failed", &_commandsFailed) {
     globalCommandRegistry()->registerCommand(this, name, oldName);
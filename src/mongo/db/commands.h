@@ -275,6 +275,21 @@ public:
         return _name;
     }
 
+    /**
+     * Returns true if command dispatch should check out the session of a request for this command
+     * which has a txnNumber.
+     */
+    bool shouldCheckoutSession() const {
+        return _shouldCheckoutSession;
+    }
+
+    /**
+     * Returns true for the 'doTxn' command, which dispatch runs as a multi-document transaction.
+     */
+    bool isDoTxn() const {
+        return _isDoTxn;
+    }
+
     /**
      * Used by command implementations to hint to the rpc system how much space they will need in
      * their replies.
@@ -413,6 +428,10 @@ private:
     // The full name of the command
     const std::string _name;
 
+    // Worked out from the name once, rather than by looking it up on every request.
+    const bool _shouldCheckoutSession;
+    const bool _isDoTxn;
+
     // Counters for how many times this command has been executed and failed
     mutable Counter64 _commandsExecuted;
     mutable Counter64 _commandsFailed;
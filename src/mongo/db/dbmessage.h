@@ -446,6 +446,10 @@ Message makeGetMoreMessage(StringData ns, long long cursorId, int nToReturn, int
 struct DbResponse {
     Message response;       // If empty, nothing will be returned to the client.
     std::string exhaustNS;  // Namespace of cursor if exhaust mode, else "".
+
+    // For an OP_MSG request which allows exhaust, the command to run next on behalf of the client
+    // to stream the following batch of its cursor, else empty.
+    BSONObj nextInvocation;
 };
 
 /**
@@ -53,6 +53,9 @@ const auto kInsertGroupMaxBatchSize = insertVectorMaxBytes;
 // Limit number of ops in a single group.
 constexpr auto kInsertGroupMaxBatchCount = 64;
 
+// Limit number of ops applied under a single lock acquisition.
+constexpr auto kCrudGroupMaxBatchCount = 128;
+
 }  // namespace
 
 // static
@@ -211,5 +214,80 @@ StatusWith<InsertGroup::ConstIterator> InsertGroup::groupAndApplyInserts(ConstIt
     MONGO_UNREACHABLE;
 }
 
+using CrudGroup = ApplierHelpers::CrudGroup;
+
+CrudGroup::CrudGroup(ApplierHelpers::OperationPtrs* ops,
+                     OperationContext* opCtx,
+                     CrudGroup::Mode mode)
+    : _doNotGroupBeforePoint(ops->cbegin()), _end(ops->cend()), _opCtx(opCtx), _mode(mode) {}
+
+bool CrudGroup::_startsInsertGroup(ConstIterator it) const {
+    const auto& entry = **it;
+    if (entry.getOpType() != OpTypeEnum::kInsert || entry.isForCappedCollection) {
+        return false;
+    }
+    auto next = it + 1;
+    return next != _end && (*next)->getOpType() == OpTypeEnum::kInsert &&
+        (*next)->getNamespace() == entry.getNamespace();
+}
+
+StatusWith<CrudGroup::ConstIterator> CrudGroup::groupAndApplyCrudOps(ConstIterator it) {
+    const auto& entry = **it;
+
+    // The following conditions must be met before attempting to group the oplog entries starting
+    // at 'oplogEntriesIterator':
+    // 1) The operation must be a CRUD operation, and not an index build through system.indexes;
+    // 2) The operation must not start a run of inserts, which InsertGroup has either applied or
+    //    failed to apply in bulk already;
+    // 3) We have not stopped at or beyond this operation while applying a previous group.
+    if (!entry.isCrudOpType() || entry.getNamespace().isSystemDotIndexes()) {
+        return Status(ErrorCodes::TypeMismatch, "Can only group CRUD operations.");
+    }
+    if (_startsInsertGroup(it)) {
+        return Status(ErrorCodes::InvalidOptions,
+                      "Cannot group inserts which could not be applied as a grouped insert.");
+    }
+    if (_hasFailedGroup && it <= _doNotGroupBeforePoint) {
+        return Status(ErrorCodes::InvalidPath,
+                      "Cannot group an operation that previously failed to apply in a group.");
+    }
+
+    const auto& batchNamespace = entry.getNamespace();
+    const auto batchUuid = entry.getUuid();
+
+    // Search for the op that delimits this group, i.e. the first op that *can't* be added to it.
+    auto endOfGroupableOpsIterator = it + 1;
+    for (; endOfGroupableOpsIterator != _end; ++endOfGroupableOpsIterator) {
+        const auto& nextEntry = **endOfGroupableOpsIterator;
+        // The op must be a CRUD op on the same collection, and must not exceed the group size
+        // limit.
+        if (!nextEntry.isCrudOpType() || nextEntry.getNamespace() != batchNamespace ||
+            nextEntry.getUuid() != batchUuid ||
+            std::distance(it, endOfGroupableOpsIterator) >= kCrudGroupMaxBatchCount) {
+            break;
+        }
+    }
+
+    const auto groupSize = std::distance(it, endOfGroupableOpsIterator);
+    if (groupSize == 1) {
+        return Status(ErrorCodes::NoSuchKey,
+                      "Not able to create a group with more than a single CRUD operation");
+    }
+
+    const auto numApplied =
+        SyncTail::syncApplyCrudOps(_opCtx, it, endOfGroupableOpsIterator, _mode);
+    if (numApplied == static_cast<std::size_t>(groupSize)) {
+        return endOfGroupableOpsIterator - 1;
+    }
+
+    // Leave the op we stopped at, and any op before it, to be applied individually.
+    _hasFailedGroup = true;
+    _doNotGroupBeforePoint = it + numApplied;
+    if (numApplied == 0) {
+        return Status(ErrorCodes::OperationFailed, "Unable to apply grouped CRUD operations");
+    }
+    return it + (numApplied - 1);
+}
+
 }  // namespace repl
 }  // namespace mongo
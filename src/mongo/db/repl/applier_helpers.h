@@ -51,6 +51,7 @@ public:
     static void stableSortByNamespace(OperationPtrs* oplogEntryPointers);
 
     class InsertGroup;
+    class CrudGroup;
 };
 
 /**
@@ -88,5 +89,45 @@ private:
     Mode _mode;
 };
 
+/**
+ * Groups consecutive CRUD operations on the same collection, starting with an operation which is
+ * not left to InsertGroup, and applies them under a single acquisition of the collection's locks.
+ * The runs of inserts within the group are written in bulk.
+ * Advances the MultiApplier::OperationPtrs iterator past the operations applied successfully.
+ */
+class ApplierHelpers::CrudGroup {
+    MONGO_DISALLOW_COPYING(CrudGroup);
+
+public:
+    using ConstIterator = OperationPtrs::const_iterator;
+    using Mode = OplogApplication::Mode;
+
+    CrudGroup(OperationPtrs* ops, OperationContext* opCtx, Mode mode);
+
+    /**
+     * Attempts to group CRUD operations starting at 'iter'.
+     * If at least one operation of the group is applied successfully, returns the iterator to the
+     * last operation applied. The operation following it, if it was part of the group, failed and
+     * should be applied individually.
+     */
+    StatusWith<ConstIterator> groupAndApplyCrudOps(ConstIterator oplogEntriesIterator);
+
+private:
+    // Returns true if the operation at 'it' starts a run of inserts that InsertGroup may combine.
+    bool _startsInsertGroup(ConstIterator it) const;
+
+    // The operation at which applying the last group stopped. Grouping is not attempted again
+    // until we are beyond this op, so that a failing op is applied individually.
+    ConstIterator _doNotGroupBeforePoint;
+    bool _hasFailedGroup = false;
+
+    // Used for constructing search bounds when grouping operations.
+    ConstIterator _end;
+
+    // Passed to syncApplyCrudOps when applying grouped operations.
+    OperationContext* _opCtx;
+    Mode _mode;
+};
+
 }  // namespace repl
 }  // namespace mongo
@@ -99,6 +99,11 @@ MONGO_EXPORT_SERVER_PARAMETER(rollbackRemoteOplogQueryBatchSize, int, defaultRol
 constexpr bool forceRollbackViaRefetchByDefault = false;
 MONGO_EXPORT_SERVER_PARAMETER(forceRollbackViaRefetch, bool, forceRollbackViaRefetchByDefault);
 
+// If 'bgSyncOplogFetcherReadAhead' is true, a fetched batch that does not fit in the oplog buffer
+// is held back while the next getMore is sent, rather than blocking the oplog fetcher until the
+// applier has made room for it.
+MONGO_EXPORT_SERVER_PARAMETER(bgSyncOplogFetcherReadAhead, bool, true);
+
 /**
  * Extends DataReplicatorExternalStateImpl to be member state aware.
  */
@@ -156,6 +161,10 @@ static ServerStatusMetricField<Counter64> displayBufferSize("repl.buffer.sizeByt
 static Counter64 bufferMaxSizeGauge;
 static ServerStatusMetricField<Counter64> displayBufferMaxSize("repl.buffer.maxSizeBytes",
                                                                &bufferMaxSizeGauge);
+// The number of fetched batches held back by read-ahead because the buffer was full
+static Counter64 readAheadBatchesStats;
+static ServerStatusMetricField<Counter64> displayReadAheadBatches("repl.network.readAheadBatches",
+                                                                  &readAheadBatchesStats);
 
 
 BackgroundSync::BackgroundSync(
@@ -494,6 +503,13 @@ void BackgroundSync::_produce() {
     oplogFetcher->join();
     LOG(1) << "fetcher stopped reading remote oplog on " << source;
 
+    // A batch held back by read-ahead was validated by the fetcher and must reach the buffer before
+    // the last fetched optime is used to restart fetching or to look for a rollback common point.
+    if (_readAheadBatch) {
+        auto opCtx = cc().makeOperationContext();
+        _flushReadAheadBatch(opCtx.get());
+    }
+
     // If the background sync is stopped after the fetcher is started, we need to
     // re-evaluate our sync source and oplog common point.
     if (getState() != ProducerState::Running) {
@@ -539,9 +555,47 @@ Status BackgroundSync::_enqueueDocuments(Fetcher::Documents::const_iterator begi
 
     auto opCtx = cc().makeOperationContext();
 
+    // Operations held back from the previous batch must be buffered before this batch.
+    if (_readAheadBatch) {
+        _flushReadAheadBatch(opCtx.get());
+    }
+
+    const auto maxSize = _oplogBuffer->getMaxSize();
+    if (bgSyncOplogFetcherReadAhead.load() && maxSize > 0 &&
+        _oplogBuffer->getSize() + info.toApplyDocumentBytes > maxSize) {
+        // The buffer is full. Hold this batch back and return so that the fetcher can request the
+        // next batch from the sync source while the applier frees space. The documents share the
+        // network reply's buffer, so holding onto them does not copy the operations.
+        _readAheadBatch = ReadAheadBatch{Fetcher::Documents(begin, end), info};
+        readAheadBatchesStats.increment();
+        return Status::OK();
+    }
+
     // Wait for enough space.
     _oplogBuffer->waitForSpace(opCtx.get(), info.toApplyDocumentBytes);
 
+    if (!_pushToOplogBuffer(opCtx.get(), begin, end, info)) {
+        return Status::OK();
+    }
+
+    // Check some things periodically (whenever we run out of items in the current cursor batch).
+    if (info.networkDocumentBytes > 0 && info.networkDocumentBytes < kSmallBatchLimitBytes) {
+        // On a very low latency network, if we don't wait a little, we'll be
+        // getting ops to write almost one at a time.  This will both be expensive
+        // for the upstream server as well as potentially defeating our parallel
+        // application of batches on the secondary.
+        //
+        // The inference here is basically if the batch is really small, we are "caught up".
+        sleepmillis(kSleepToAllowBatchingMillis);
+    }
+
+    return Status::OK();
+}
+
+bool BackgroundSync::_pushToOplogBuffer(OperationContext* opCtx,
+                                        Fetcher::Documents::const_iterator begin,
+                                        Fetcher::Documents::const_iterator end,
+                                        const OplogFetcher::DocumentsInfo& info) {
     {
         // Don't add more to the buffer if we are in shutdown. Continue holding the lock until we
         // are done to prevent going into shutdown. This avoids a race where shutdown() clears the
@@ -549,7 +603,7 @@ Status BackgroundSync::_enqueueDocuments(Fetcher::Documents::const_iterator begi
         // buffer.
         stdx::unique_lock<stdx::mutex> lock(_mutex);
         if (_state != ProducerState::Running) {
-            return Status::OK();
+            return false;
         }
 
         OCCASIONALLY {
@@ -557,7 +611,7 @@ Status BackgroundSync::_enqueueDocuments(Fetcher::Documents::const_iterator begi
         }
 
         // Buffer docs for later application.
-        _oplogBuffer->pushAllNonBlocking(opCtx.get(), begin, end);
+        _oplogBuffer->pushAllNonBlocking(opCtx, begin, end);
 
         // Update last fetched info.
         _lastFetchedHash = info.lastDocument.value;
@@ -567,19 +621,22 @@ Status BackgroundSync::_enqueueDocuments(Fetcher::Documents::const_iterator begi
 
     bufferCountGauge.increment(info.toApplyDocumentCount);
     bufferSizeGauge.increment(info.toApplyDocumentBytes);
+    return true;
+}
 
-    // Check some things periodically (whenever we run out of items in the current cursor batch).
-    if (info.networkDocumentBytes > 0 && info.networkDocumentBytes < kSmallBatchLimitBytes) {
-        // On a very low latency network, if we don't wait a little, we'll be
-        // getting ops to write almost one at a time.  This will both be expensive
-        // for the upstream server as well as potentially defeating our parallel
-        // application of batches on the secondary.
-        //
-        // The inference here is basically if the batch is really small, we are "caught up".
-        sleepmillis(kSleepToAllowBatchingMillis);
+void BackgroundSync::_flushReadAheadBatch(OperationContext* opCtx) {
+    invariant(_readAheadBatch);
+    const auto batch = std::move(*_readAheadBatch);
+    _readAheadBatch = boost::none;
+
+    // Dropping the batch is safe: the last fetched optime has not been advanced past it, so it will
+    // be fetched again when the producer restarts.
+    if (getState() != ProducerState::Running) {
+        return;
     }
 
-    return Status::OK();
+    _oplogBuffer->waitForSpace(opCtx, batch.info.toApplyDocumentBytes);
+    _pushToOplogBuffer(opCtx, batch.documents.cbegin(), batch.documents.cend(), batch.info);
 }
 
 void BackgroundSync::onOperationConsumed(const BSONObj& op) {
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 
 #include "mongo/base/disallow_copying.h"
@@ -173,6 +174,21 @@ private:
                              Fetcher::Documents::const_iterator end,
                              const OplogFetcher::DocumentsInfo& info);
 
+    /**
+     * Pushes operations into the oplog buffer and advances the last fetched optime. Does not wait
+     * for space. Returns false without modifying the buffer if the producer is no longer running.
+     */
+    bool _pushToOplogBuffer(OperationContext* opCtx,
+                            Fetcher::Documents::const_iterator begin,
+                            Fetcher::Documents::const_iterator end,
+                            const OplogFetcher::DocumentsInfo& info);
+
+    /**
+     * Waits for space in the oplog buffer and pushes the batch held back by read-ahead, if any.
+     * The held batch is discarded if the producer is no longer running.
+     */
+    void _flushReadAheadBatch(OperationContext* opCtx);
+
     /**
      * Executes a rollback.
      */
@@ -236,6 +252,9 @@ private:
       *
       * (M)  Reads and writes guarded by _mutex
       *
+      * (F)  Accessed only by the oplog fetcher's enqueue callback, or by the main BackgroundSync
+      *      thread once the oplog fetcher has been joined.
+      *
      */
 
     // Protects member data of BackgroundSync.
@@ -269,6 +288,15 @@ private:
     // Current oplog fetcher tailing the oplog on the sync source.
     std::unique_ptr<OplogFetcher> _oplogFetcher;
 
+    // A fetched batch that did not fit in the oplog buffer. Holding it here instead of blocking the
+    // fetcher lets the next getMore be sent while the applier frees space, so that the sync
+    // source's round trip overlaps with application. Only one batch is ever held back.
+    struct ReadAheadBatch {
+        Fetcher::Documents documents;
+        OplogFetcher::DocumentsInfo info;
+    };
+    boost::optional<ReadAheadBatch> _readAheadBatch;  // (F)
+
     // Current rollback process. If this component is active, we are currently reverting local
     // operations in the local oplog in order to bring this server to a consistent state relative
     // to the sync source.
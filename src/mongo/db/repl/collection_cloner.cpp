@@ -880,6 +880,9 @@ void CollectionCloner::_insertDocumentsCallback(
     _documentsToInsert.swap(docs);
     _stats.documentsCopied += docs.size();
     ++_stats.fetchBatches;
+    for (auto&& doc : docs) {
+        _stats.bytesCopied += doc.objsize();
+    }
     _progressMeter.hit(int(docs.size()));
     invariant(_collLoader);
     const auto status = _collLoader->insertDocuments(docs.cbegin(), docs.cend());
@@ -887,6 +890,7 @@ void CollectionCloner::_insertDocumentsCallback(
         onCompletionGuard->setResultAndCancelRemainingWork_inlock(lk, status);
         return;
     }
+    _stats.lastBatchInserted = _executor->now();
 
     MONGO_FAIL_POINT_BLOCK(initialSyncHangDuringCollectionClone, options) {
         const BSONObj& data = options.getData();
@@ -973,6 +977,7 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
     builder->appendNumber(kDocumentsCopiedFieldName, documentsCopied);
     builder->appendNumber("indexes", indexes);
     builder->appendNumber("fetchedBatches", fetchBatches);
+    builder->appendNumber("bytesCopied", static_cast<long long>(bytesCopied));
     if (start != Date_t()) {
         builder->appendDate("start", start);
         if (end != Date_t()) {
@@ -981,6 +986,14 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
             long long elapsedMillis = duration_cast<Milliseconds>(elapsed).count();
             builder->appendNumber("elapsedMillis", elapsedMillis);
         }
+
+        // Throughput of the copy so far, so that progress can be tracked while cloning.
+        const auto copyEnd = end != Date_t() ? end : lastBatchInserted;
+        const auto copyMillis = durationCount<Milliseconds>(copyEnd - start);
+        if (copyEnd != Date_t() && copyMillis > 0) {
+            builder->append("documentsPerSecond", documentsCopied * 1000.0 / copyMillis);
+            builder->append("bytesPerSecond", bytesCopied * 1000.0 / copyMillis);
+        }
     }
 }
 }  // namespace repl
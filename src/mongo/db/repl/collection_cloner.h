@@ -80,6 +80,9 @@ public:
         size_t documentsCopied{0};
         size_t indexes{0};
         size_t fetchBatches{0};
+        size_t bytesCopied{0};
+        // Time at which the last batch of documents was inserted.
+        Date_t lastBatchInserted;
 
         std::string toString() const;
         BSONObj toBSON() const;
@@ -75,6 +75,16 @@ MONGO_EXPORT_SERVER_PARAMETER(numInitialSyncListCollectionsAttempts, int, 3);
 // The number of cursors to use in the collection cloning process.
 MONGO_EXPORT_SERVER_PARAMETER(maxNumInitialSyncCollectionClonerCursors, int, 1);
 
+// The number of collections in a database to clone concurrently.
+MONGO_EXPORT_SERVER_PARAMETER(initialSyncCollectionClonerConcurrency, int, 1)
+    ->withValidator([](const int& potentialNewValue) {
+        if (potentialNewValue < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "initialSyncCollectionClonerConcurrency must be at least 1");
+        }
+        return Status::OK();
+    });
+
 // Failpoint which causes initial sync to hang right after listCollections, but before cloning
 // any colelctions in the 'database' database.
 MONGO_FAIL_POINT_DEFINE(initialSyncHangAfterListCollections);
@@ -416,20 +426,40 @@ void DatabaseCloner::_listCollectionsCallback(const StatusWith<Fetcher::QueryRes
         }
     }
 
-    // Start first collection cloner.
-    _currentCollectionClonerIter = _collectionCloners.begin();
-
-    LOG(1) << "    cloning collection " << _currentCollectionClonerIter->getSourceNamespace();
+    // Start the first collection cloners.
+    _nextCollectionClonerIter = _collectionCloners.begin();
 
-    Status startStatus = _startCollectionCloner(*_currentCollectionClonerIter);
+    Status startStatus = _startCollectionCloners_inlock();
     if (!startStatus.isOK()) {
-        LOG(1) << "    failed to start collection cloning on "
-               << _currentCollectionClonerIter->getSourceNamespace() << ": " << redact(startStatus);
-        _finishCallback_inlock(lk, startStatus);
+        _startCollectionClonersStatus = startStatus;
+        if (_activeCollectionCloners == 0) {
+            _finishCallback_inlock(lk, startStatus);
+        }
         return;
     }
 }
 
+Status DatabaseCloner::_startCollectionCloners_inlock() {
+    const auto maxActive = static_cast<size_t>(initialSyncCollectionClonerConcurrency.load());
+    while (_nextCollectionClonerIter != _collectionCloners.end() &&
+           _activeCollectionCloners < maxActive) {
+        auto& collectionCloner = *_nextCollectionClonerIter;
+        LOG(1) << "    cloning collection " << collectionCloner.getSourceNamespace();
+
+        Status startStatus = _startCollectionCloner(collectionCloner);
+        if (!startStatus.isOK()) {
+            LOG(1) << "    failed to start collection cloning on "
+                   << collectionCloner.getSourceNamespace() << ": " << redact(startStatus);
+            // Do not start any further collection cloners.
+            _nextCollectionClonerIter = _collectionCloners.end();
+            return startStatus;
+        }
+        ++_nextCollectionClonerIter;
+        ++_activeCollectionCloners;
+    }
+    return Status::OK();
+}
+
 void DatabaseCloner::_collectionClonerCallback(const Status& status, const NamespaceString& nss) {
     auto newStatus = status;
 
@@ -447,19 +477,23 @@ void DatabaseCloner::_collectionClonerCallback(const Status& status, const Names
     lk.unlock();
     _collectionWork(newStatus, nss);
     lk.lock();
-    _currentCollectionClonerIter++;
+    invariant(_activeCollectionCloners > 0);
+    --_activeCollectionCloners;
 
-    if (_currentCollectionClonerIter != _collectionCloners.end()) {
-        Status startStatus = _startCollectionCloner(*_currentCollectionClonerIter);
-        if (!startStatus.isOK()) {
-            LOG(1) << "    failed to start collection cloning on "
-                   << _currentCollectionClonerIter->getSourceNamespace() << ": "
-                   << redact(startStatus);
-            _finishCallback_inlock(lk, startStatus);
-            return;
-        }
+    if (_startCollectionClonersStatus.isOK()) {
+        _startCollectionClonersStatus = _startCollectionCloners_inlock();
+    }
+
+    // Wait for the remaining collection cloners to complete before reporting our result.
+    if (_activeCollectionCloners > 0) {
+        return;
+    }
+
+    if (!_startCollectionClonersStatus.isOK()) {
+        _finishCallback_inlock(lk, _startCollectionClonersStatus);
         return;
     }
+    invariant(_nextCollectionClonerIter == _collectionCloners.end());
 
     Status finalStatus(Status::OK());
     if (_failedNamespaces.size() > 0) {
@@ -199,6 +199,14 @@ private:
      */
     void _finishCallback_inlock(stdx::unique_lock<stdx::mutex>& lk, const Status& status);
 
+    /**
+     * Starts collection cloners, in listCollections order, until the number of active cloners
+     * reaches the 'initialSyncCollectionClonerConcurrency' server parameter or every cloner has
+     * been started. Returns the error from the first cloner that fails to start; no further
+     * cloners are started after that.
+     */
+    Status _startCollectionCloners_inlock();
+
     //
     // All member variables are labeled with one of the following codes indicating the
     // synchronization rules for accessing them.
@@ -228,11 +236,13 @@ private:
     //     options: <collection options>
     // }
     // Holds all collection infos from listCollections.
-    std::vector<BSONObj> _collectionInfos;                               // (M)
-    std::vector<NamespaceString> _collectionNamespaces;                  // (M)
-    std::list<CollectionCloner> _collectionCloners;                      // (M)
-    std::list<CollectionCloner>::iterator _currentCollectionClonerIter;  // (M)
-    std::vector<std::pair<Status, NamespaceString>> _failedNamespaces;   // (M)
+    std::vector<BSONObj> _collectionInfos;                              // (M)
+    std::vector<NamespaceString> _collectionNamespaces;                 // (M)
+    std::list<CollectionCloner> _collectionCloners;                     // (M)
+    std::list<CollectionCloner>::iterator _nextCollectionClonerIter;    // (M)
+    size_t _activeCollectionCloners = 0;                                // (M)
+    Status _startCollectionClonersStatus = Status::OK();                // (M)
+    std::vector<std::pair<Status, NamespaceString>> _failedNamespaces;  // (M)
     CollectionCloner::ScheduleDbWorkFn
         _scheduleDbWorkFn;  // (RT) Function for scheduling database work using the executor.
     StartCollectionClonerFn _startCollectionCloner;  // (RT)
@@ -38,6 +38,7 @@
 #include "mongo/db/repl/base_cloner_test_fixture.h"
 #include "mongo/db/repl/database_cloner.h"
 #include "mongo/db/repl/storage_interface.h"
+#include "mongo/db/server_parameters_test_util.h"
 #include "mongo/unittest/task_executor_proxy.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/mongoutils/str.h"
@@ -730,6 +731,44 @@ TEST_F(DatabaseClonerTest, StartSecondCollectionClonerFailed) {
     ASSERT_EQUALS(DatabaseCloner::State::kComplete, _databaseCloner->getState_forTest());
 }
 
+TEST_F(DatabaseClonerTest, StartsUpToConfiguredNumberOfCollectionClonersConcurrently) {
+    ServerParameterControllerForTest concurrency("initialSyncCollectionClonerConcurrency", "2");
+
+    ASSERT_OK(_databaseCloner->startup());
+    ASSERT_EQUALS(DatabaseCloner::State::kRunning, _databaseCloner->getState_forTest());
+
+    std::vector<std::string> startedCollections;
+    _databaseCloner->setStartCollectionClonerFn([&startedCollections](CollectionCloner& cloner) {
+        startedCollections.push_back(cloner.getSourceNamespace().coll().toString());
+        return cloner.startup();
+    });
+
+    {
+        executor::NetworkInterfaceMock::InNetworkGuard guard(getNet());
+        processNetworkResponse(createListCollectionsResponse(
+            0,
+            BSON_ARRAY(BSON("name"
+                            << "a"
+                            << "options"
+                            << BSONObj())
+                       << BSON("name"
+                               << "b"
+                               << "options"
+                               << BSONObj())
+                       << BSON("name"
+                               << "c"
+                               << "options"
+                               << BSONObj()))));
+    }
+
+    // The third collection is not cloned until one of the first two collections is done.
+    ASSERT_EQUALS(2U, startedCollections.size());
+    ASSERT_EQUALS("a", startedCollections[0]);
+    ASSERT_EQUALS("b", startedCollections[1]);
+    ASSERT_TRUE(_databaseCloner->isActive());
+    ASSERT_EQUALS(DatabaseCloner::State::kRunning, _databaseCloner->getState_forTest());
+}
+
 TEST_F(DatabaseClonerTest, ShutdownCancelsCollectionCloning) {
     ASSERT_EQUALS(DatabaseCloner::State::kPreStart, _databaseCloner->getState_forTest());
 
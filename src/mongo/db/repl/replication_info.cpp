@@ -57,6 +57,7 @@
 #include "mongo/executor/network_interface.h"
 #include "mongo/rpc/metadata/client_metadata.h"
 #include "mongo/rpc/metadata/client_metadata_ismaster.h"
+#include "mongo/transport/request_pipelining.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/map_util.h"
 
@@ -437,6 +438,7 @@ public:
         if (opCtx->getClient()->session()) {
             MessageCompressorManager::forSession(opCtx->getClient()->session())
                 .serverNegotiate(cmdObj, &result);
+            transport::negotiatePipelining(opCtx->getClient()->session(), cmdObj, &result);
         }
 
         auto& saslMechanismRegistry = SASLServerMechanismRegistry::get(opCtx->getServiceContext());
@@ -33,6 +33,7 @@
 #include "mongo/db/repl/sync_tail.h"
 
 #include "third_party/murmurhash3/MurmurHash3.h"
+#include <algorithm>
 #include <boost/functional/hash.hpp>
 #include <memory>
 
@@ -72,6 +73,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/session.h"
 #include "mongo/db/session_txn_record_gen.h"
+#include "mongo/db/stats/counters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/storage/recovery_unit.h"
 #include "mongo/stdx/memory.h"
@@ -81,6 +83,7 @@
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/socket_exception.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -149,6 +152,57 @@ ServerStatusMetricField<Counter64> displayAttemptsToBecomeSecondary(
 TimerStats applyBatchStats;
 ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches", &applyBatchStats);
 
+// Number and time of waits the applier made on an empty oplog buffer while operations were
+// streaming in, i.e. "fetch bubbles" during which application was stalled on the network.
+TimerStats fetchBubbleStats;
+ServerStatusMetricField<TimerStats> displayFetchBubbles("repl.apply.fetchBubbles",
+                                                        &fetchBubbleStats);
+
+// Each writer thread claims conflict groups from a shared list while applying a batch, so that a
+// group which takes long to apply (e.g. one holding a hot document) does not hold up independent
+// groups. Splitting the batch into several groups per thread gives the other threads something
+// to take over.
+const size_t kConflictGroupsPerWriterThread = 4;
+
+/**
+ * Reports, for each writer thread, the time it spent applying operations and that time as a
+ * fraction of the time spent in the apply phase of all batches.
+ */
+class WriterUtilizationMetric : public ServerStatusMetric {
+public:
+    WriterUtilizationMetric() : ServerStatusMetric("repl.apply.writerUtilization") {}
+
+    void recordBatch(const std::vector<Microseconds>& busyPerWriter, Microseconds elapsed) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_busyPerWriter.size() < busyPerWriter.size()) {
+            _busyPerWriter.resize(busyPerWriter.size());
+        }
+        for (size_t i = 0; i < busyPerWriter.size(); ++i) {
+            _busyPerWriter[i] += busyPerWriter[i];
+        }
+        _elapsed += elapsed;
+    }
+
+    void appendAtLeaf(BSONObjBuilder& b) const override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        BSONObjBuilder utilization(b.subobjStart(_leafName));
+        utilization.append("totalMillis", durationCount<Milliseconds>(_elapsed));
+        BSONArrayBuilder threads(utilization.subarrayStart("threads"));
+        for (auto&& busy : _busyPerWriter) {
+            const double fraction = _elapsed > Microseconds(0)
+                ? static_cast<double>(busy.count()) / _elapsed.count()
+                : 0.0;
+            threads.append(BSON("busyMillis" << durationCount<Milliseconds>(busy) << "utilization"
+                                             << fraction));
+        }
+    }
+
+private:
+    mutable stdx::mutex _mutex;
+    std::vector<Microseconds> _busyPerWriter;
+    Microseconds _elapsed{0};
+} writerUtilizationMetric;
+
 class ApplyBatchFinalizer {
 public:
     ApplyBatchFinalizer(ReplicationCoordinator* replCoord) : _replCoord(replCoord) {}
@@ -397,6 +451,136 @@ Status SyncTail::syncApply(OperationContext* opCtx,
     MONGO_UNREACHABLE;
 }
 
+namespace {
+
+/**
+ * Returns true if the operation is an insert which syncApplyCrudOps() may apply together with the
+ * inserts next to it, through a single call to Collection::insertDocuments().
+ */
+bool isBatchableInsert(const OplogEntry* entry) {
+    return entry->getOpType() == OpTypeEnum::kInsert && !entry->isForCappedCollection &&
+        entry->getNamespace() != NamespaceString::kServerConfigurationNamespace &&
+        entry->getObject().hasField("_id");
+}
+
+/**
+ * Inserts the documents of a run of insert operations in a single WriteUnitOfWork, keeping the
+ * timestamp of each operation.
+ */
+Status insertDocumentsInBatch(OperationContext* opCtx,
+                              Collection* collection,
+                              MultiApplier::OperationPtrs::const_iterator begin,
+                              MultiApplier::OperationPtrs::const_iterator end) {
+    std::vector<InsertStatement> insertObjs;
+    for (auto it = begin; it != end; ++it) {
+        const auto& entry = **it;
+        // Term may not be present (pv0)
+        const auto term = entry.getTerm();
+        insertObjs.emplace_back(
+            entry.getObject(), entry.getTimestamp(), term ? *term : OpTime::kUninitializedTerm);
+    }
+
+    return writeConflictRetry(opCtx, "syncApply_CRUDGroupInsert", collection->ns().ns(), [&] {
+        WriteUnitOfWork wuow(opCtx);
+        OpDebug* const nullOpDebug = nullptr;
+        Status status = collection->insertDocuments(
+            opCtx, insertObjs.begin(), insertObjs.end(), nullOpDebug, true);
+        if (!status.isOK()) {
+            return status;
+        }
+        wuow.commit();
+        return Status::OK();
+    });
+}
+
+}  // namespace
+
+// static
+std::size_t SyncTail::syncApplyCrudOps(OperationContext* opCtx,
+                                       MultiApplier::OperationPtrs::const_iterator begin,
+                                       MultiApplier::OperationPtrs::const_iterator end,
+                                       OplogApplication::Mode oplogApplicationMode) {
+    invariant(begin != end);
+
+    // Count the group of operations as a single operation, for reporting purposes.
+    CurOp groupOp(opCtx);
+
+    const auto& firstEntry = **begin;
+    const auto& nss = firstEntry.getNamespace();
+
+    auto incrementOpsAppliedStats = [] { opsAppliedStats.increment(1); };
+
+    // See syncApply() for why updates are converted to upserts when not in initial sync.
+    const bool shouldAlwaysUpsert = (oplogApplicationMode != OplogApplication::Mode::kInitialSync);
+
+    std::size_t numApplied = 0;
+    try {
+        AutoGetCollection autoColl(opCtx, getNsOrUUID(nss, firstEntry.raw), MODE_IX);
+        auto db = autoColl.getDb();
+        auto collection = autoColl.getCollection();
+        if (!db || !collection) {
+            // Leave missing namespaces to syncApply(), which knows when they may be ignored.
+            return 0;
+        }
+        OldClientContext ctx(opCtx, autoColl.getNss().ns(), db);
+
+        auto it = begin;
+        while (it != end) {
+            // Insert the documents of a run of inserts together. If that fails, for instance
+            // because a document already exists and its insert must become an upsert, fall back
+            // to applying the inserts one at a time.
+            auto endOfRun = std::find_if_not(it, end, isBatchableInsert);
+            if (std::distance(it, endOfRun) > 1) {
+                Status status = [&] {
+                    try {
+                        return insertDocumentsInBatch(opCtx, collection, it, endOfRun);
+                    } catch (const DBException& ex) {
+                        return ex.toStatus();
+                    }
+                }();
+                if (status.isOK()) {
+                    for (; it != endOfRun; ++it) {
+                        replOpCounters.gotInsert();
+                        incrementOpsAppliedStats();
+                        ++numApplied;
+                    }
+                    continue;
+                }
+                LOG(2) << "Error inserting " << std::distance(it, endOfRun)
+                       << " documents in bulk into " << nss
+                       << ", inserting them individually: " << redact(status);
+            } else {
+                endOfRun = it + 1;
+            }
+
+            for (; it != endOfRun; ++it) {
+                const auto& op = (*it)->raw;
+                Status status = writeConflictRetry(opCtx, "syncApply_CRUDGroup", nss.ns(), [&] {
+                    Status status = applyOperation_inlock(opCtx,
+                                                          ctx.db(),
+                                                          op,
+                                                          shouldAlwaysUpsert,
+                                                          oplogApplicationMode,
+                                                          incrementOpsAppliedStats);
+                    if (status.code() == ErrorCodes::WriteConflict) {
+                        throw WriteConflictException();
+                    }
+                    return status;
+                });
+                if (!status.isOK()) {
+                    return numApplied;
+                }
+                ++numApplied;
+            }
+        }
+    } catch (const DBException& ex) {
+        LOG(2) << "Stopped applying grouped CRUD operations on " << nss << " after " << numApplied
+               << " operations: " << redact(ex);
+    }
+
+    return numApplied;
+}
+
 SyncTail::SyncTail(OplogApplier::Observer* observer,
                    ReplicationConsistencyMarkers* consistencyMarkers,
                    StorageInterface* storageInterface,
@@ -458,28 +642,64 @@ void prefetchOps(const MultiApplier::Operations& ops, ThreadPool* prefetcherPool
 }
 
 // Doles out all the work to the writer pool threads.
+// Each writer vector holds operations which may conflict with one another and are applied in order
+// by a single thread, but separate writer vectors are independent of each other. Instead of binding
+// each vector to a thread up front, every thread repeatedly claims the next vector not yet applied,
+// largest first, so that threads do not sit idle while a single thread works through a backlog.
 // Does not modify writerVectors, but passes non-const pointers to inner vectors into func.
+// 'workerMultikeyPathInfo' has an entry for each writer vector, since a thread may apply several of
+// them, and 'busyVector' has an entry for each thread in the writer pool.
 void applyOps(std::vector<MultiApplier::OperationPtrs>& writerVectors,
               ThreadPool* writerPool,
               const SyncTail::MultiSyncApplyFunc& func,
               SyncTail* st,
               std::vector<Status>* statusVector,
-              std::vector<WorkerMultikeyPathInfo>* workerMultikeyPathInfo) {
+              std::vector<WorkerMultikeyPathInfo>* workerMultikeyPathInfo,
+              std::vector<Microseconds>* busyVector) {
     invariant(writerVectors.size() == statusVector->size());
+    invariant(writerVectors.size() == workerMultikeyPathInfo->size());
+
+    struct ClaimQueue {
+        std::vector<size_t> order;
+        AtomicUInt64 next;
+    };
+    auto claimQueue = std::make_shared<ClaimQueue>();
     for (size_t i = 0; i < writerVectors.size(); i++) {
         if (!writerVectors[i].empty()) {
-            invariant(writerPool->schedule([
-                &func,
-                st,
-                &writer = writerVectors.at(i),
-                &status = statusVector->at(i),
-                &workerMultikeyPathInfo = workerMultikeyPathInfo->at(i)
-            ] {
-                auto opCtx = cc().makeOperationContext();
-                status = func(opCtx.get(), &writer, st, &workerMultikeyPathInfo);
-            }));
+            claimQueue->order.push_back(i);
         }
     }
+    std::stable_sort(claimQueue->order.begin(),
+                     claimQueue->order.end(),
+                     [&writerVectors](size_t lhs, size_t rhs) {
+                         return writerVectors[lhs].size() > writerVectors[rhs].size();
+                     });
+
+    const size_t numWorkers = std::min(claimQueue->order.size(), busyVector->size());
+    for (size_t worker = 0; worker < numWorkers; worker++) {
+        invariant(writerPool->schedule([
+            &func,
+            st,
+            &writerVectors,
+            statusVector,
+            claimQueue,
+            workerMultikeyPathInfo,
+            &busy = busyVector->at(worker)
+        ] {
+            Timer busyTimer;
+            for (auto next = claimQueue->next.fetchAndAdd(1); next < claimQueue->order.size();
+                 next = claimQueue->next.fetchAndAdd(1)) {
+                const auto writerVectorIndex = claimQueue->order[next];
+                auto opCtx = cc().makeOperationContext();
+                (*statusVector)[writerVectorIndex] =
+                    func(opCtx.get(),
+                         &writerVectors[writerVectorIndex],
+                         st,
+                         &(*workerMultikeyPathInfo)[writerVectorIndex]);
+            }
+            busy = Microseconds(busyTimer.micros());
+        }));
+    }
 }
 
 // Schedules the writes to the oplog for 'ops' into threadPool. The caller must guarantee that 'ops'
@@ -995,7 +1215,16 @@ bool SyncTail::tryPopAndWaitForMore(OperationContext* opCtx,
                 } else {
                     // Block up to 1 second. We still return true in this case because we want this
                     // op to be the first in a new batch with a new start time.
-                    oplogBuffer->waitForData(Seconds(1));
+                    Timer waitTimer;
+                    const bool gotData = oplogBuffer->waitForData(Seconds(1));
+
+                    // Only a wait which ends with new operations, and which does not follow a
+                    // wait that timed out, stalled application. Otherwise this node is idle
+                    // because its sync source has nothing more to send.
+                    if (gotData && !_waitForDataTimedOut) {
+                        fetchBubbleStats.record(waitTimer);
+                    }
+                    _waitForDataTimedOut = !gotData;
                 }
             }
 
@@ -1266,6 +1495,7 @@ Status multiSyncApply(OperationContext* opCtx,
         : OplogApplication::Mode::kSecondary;
 
     ApplierHelpers::InsertGroup insertGroup(ops, opCtx, oplogApplicationMode);
+    ApplierHelpers::CrudGroup crudGroup(ops, opCtx, oplogApplicationMode);
 
     {  // Ensure that the MultikeyPathTracker stops tracking paths.
         ON_BLOCK_EXIT([opCtx] { MultikeyPathTracker::get(opCtx).stopTrackingMultikeyPathInfo(); });
@@ -1282,6 +1512,13 @@ Status multiSyncApply(OperationContext* opCtx,
                 continue;
             }
 
+            // Otherwise, try to apply a run of CRUD operations on the same collection together.
+            auto crudGroupResult = crudGroup.groupAndApplyCrudOps(it);
+            if (crudGroupResult.isOK()) {
+                it = crudGroupResult.getValue();
+                continue;
+            }
+
             // If we didn't create a group, try to apply the op individually.
             try {
                 const Status status = SyncTail::syncApply(opCtx, entry.raw, oplogApplicationMode);
@@ -1396,7 +1633,7 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
                 "attempting to replicate ops while primary"};
     }
 
-    std::vector<WorkerMultikeyPathInfo> multikeyVector(_writerPool->getStats().numThreads);
+    std::vector<WorkerMultikeyPathInfo> multikeyVector;
     {
         // Each node records cumulative batch application stats for itself using this timer.
         TimerHolder timer(&applyBatchStats);
@@ -1446,7 +1683,9 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
         //   and create a pseudo oplog.
         std::vector<MultiApplier::Operations> derivedOps;
 
-        std::vector<MultiApplier::OperationPtrs> writerVectors(_writerPool->getStats().numThreads);
+        std::vector<MultiApplier::OperationPtrs> writerVectors(
+            _writerPool->getStats().numThreads * kConflictGroupsPerWriterThread);
+        multikeyVector.resize(writerVectors.size());
         fillWriterVectors(opCtx, &ops, &writerVectors, &derivedOps);
 
         // Wait for writes to finish before applying ops.
@@ -1459,9 +1698,19 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
         }
 
         {
-            std::vector<Status> statusVector(_writerPool->getStats().numThreads, Status::OK());
-            applyOps(writerVectors, _writerPool, _applyFunc, this, &statusVector, &multikeyVector);
+            std::vector<Status> statusVector(writerVectors.size(), Status::OK());
+            std::vector<Microseconds> busyVector(_writerPool->getStats().numThreads,
+                                                 Microseconds(0));
+            Timer applyTimer;
+            applyOps(writerVectors,
+                     _writerPool,
+                     _applyFunc,
+                     this,
+                     &statusVector,
+                     &multikeyVector,
+                     &busyVector);
             _writerPool->waitForIdle();
+            writerUtilizationMetric.recordBatch(busyVector, Microseconds(applyTimer.micros()));
 
             // If any of the statuses is not ok, return error.
             for (auto it = statusVector.cbegin(); it != statusVector.cend(); ++it) {
@@ -1471,7 +1720,7 @@ StatusWith<OpTime> SyncTail::multiApply(OperationContext* opCtx, MultiApplier::O
                         << "Failed to apply batch of operations. Number of operations in batch: "
                         << ops.size() << ". First operation: " << redact(ops.front().toBSON())
                         << ". Last operation: " << redact(ops.back().toBSON())
-                        << ". Oplog application failed in writer thread "
+                        << ". Oplog application failed in writer vector "
                         << std::distance(statusVector.cbegin(), it) << ": " << redact(status);
                     return status;
                 }
@@ -103,6 +103,22 @@ public:
                             const BSONObj& o,
                             OplogApplication::Mode oplogApplicationMode);
 
+    /**
+     * Applies a run of CRUD operations on a single collection one after another while holding the
+     * collection lock, rather than acquiring locks and resolving the collection for each operation
+     * as syncApply() does. Contiguous inserts are inserted with a single call to
+     * Collection::insertDocuments() in one WriteUnitOfWork, falling back to inserting them one at a
+     * time if that fails. Every other operation is applied in its own WriteUnitOfWork.
+     *
+     * Stops at the first operation that cannot be applied, and returns the number of operations
+     * applied successfully. The caller is expected to apply the remaining operations through
+     * syncApply(), which reports errors and handles missing namespaces.
+     */
+    static std::size_t syncApplyCrudOps(OperationContext* opCtx,
+                                        MultiApplier::OperationPtrs::const_iterator begin,
+                                        MultiApplier::OperationPtrs::const_iterator end,
+                                        OplogApplication::Mode oplogApplicationMode);
+
     /**
      *
      * Constructs a SyncTail.
@@ -221,7 +237,8 @@ public:
      *
      * Returns true if the (possibly empty) batch in ops should be ended and a new one started.
      * If ops is empty on entry and nothing can be added yet, will wait up to a second before
-     * returning true.
+     * returning true. Such a wait is recorded in the 'repl.apply.fetchBubbles' metric if new
+     * operations arrive during it and the previous wait did not time out.
      */
     bool tryPopAndWaitForMore(OperationContext* opCtx,
                               OplogBuffer* oplogBuffer,
@@ -291,6 +308,10 @@ private:
 
     // Set to true if shutdown() has been called.
     bool _inShutdown = false;
+
+    // Whether the last wait in tryPopAndWaitForMore() ended without new operations. Only accessed
+    // by the thread which batches operations.
+    bool _waitForDataTimedOut = false;
 };
 
 // These free functions are used by the thread pool workers to write ops to the db.
@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/repl/idempotency_test_fixture.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/storage_interface.h"
+#include "mongo/db/repl/sync_tail.h"
+#include "mongo/db/repl/sync_tail_test_fixture.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+const NamespaceString kNss("test.coll");
+
+// The number of operations applied in each iteration, and the size of the inserted documents.
+const int kNumOps = 1000;
+const int kDocSizeBytes = 100;
+
+/**
+ * Makes the oplog of a workload which does bursts of inserts, as insertMany does, and updates and
+ * deletes documents by _id in between them. Each burst of 'burstSize' inserts is followed by an
+ * update of its first document and a delete of its last one.
+ */
+MultiApplier::Operations makeOplog(int burstSize) {
+    const std::string padding(kDocSizeBytes, 'x');
+    MultiApplier::Operations ops;
+    int seconds = 1;
+    auto nextOpTime = [&seconds] { return OpTime(Timestamp(Seconds(seconds++), 0), 1LL); };
+    for (int id = 0; static_cast<int>(ops.size()) < kNumOps; id += burstSize) {
+        for (int i = 0; i < burstSize; ++i) {
+            ops.push_back(makeInsertDocumentOplogEntry(
+                nextOpTime(), kNss, BSON("_id" << id + i << "x" << 0 << "padding" << padding)));
+        }
+        ops.push_back(makeUpdateDocumentOplogEntry(
+            nextOpTime(), kNss, BSON("_id" << id), BSON("$inc" << BSON("x" << 1))));
+        ops.push_back(makeDeleteDocumentOplogEntry(
+            nextOpTime(), kNss, BSON("_id" << id + burstSize - 1)));
+    }
+    return ops;
+}
+
+/**
+ * Applies the oplog of makeOplog() to an empty collection in every iteration, either as a
+ * secondary's applier thread does through multiSyncApply(), or one operation at a time through
+ * SyncTail::syncApply(), which is how each operation that is not part of a group is applied.
+ */
+class OplogApplicationBenchmark : public SyncTailTest {
+public:
+    OplogApplicationBenchmark(benchmark::State& state, bool grouped)
+        : _state(state), _grouped(grouped) {}
+
+private:
+    void _doTest() override {
+        const auto ops = makeOplog(_state.range(0));
+
+        SyncTail syncTail(nullptr,
+                          getConsistencyMarkers(),
+                          getStorageInterface(),
+                          SyncTail::MultiSyncApplyFunc(),
+                          nullptr);
+
+        for (auto _ : _state) {
+            _state.PauseTiming();
+            invariant(getStorageInterface()->createCollection(
+                _opCtx.get(), kNss, CollectionOptions()));
+            MultiApplier::OperationPtrs opPtrs;
+            for (const auto& op : ops) {
+                opPtrs.push_back(&op);
+            }
+            _state.ResumeTiming();
+
+            if (_grouped) {
+                WorkerMultikeyPathInfo pathInfo;
+                invariant(multiSyncApply(_opCtx.get(), &opPtrs, &syncTail, &pathInfo));
+            } else {
+                UnreplicatedWritesBlock uwb(_opCtx.get());
+                for (const auto* op : opPtrs) {
+                    invariant(SyncTail::syncApply(
+                        _opCtx.get(), op->raw, OplogApplication::Mode::kSecondary));
+                }
+            }
+
+            _state.PauseTiming();
+            invariant(getStorageInterface()->dropCollection(_opCtx.get(), kNss));
+            _state.ResumeTiming();
+        }
+    }
+
+    benchmark::State& _state;
+    const bool _grouped;
+};
+
+void BM_MultiSyncApply(benchmark::State& state) {
+    OplogApplicationBenchmark(state, true).run();
+    state.SetItemsProcessed(state.iterations() * kNumOps);
+}
+
+void BM_SyncApplyEachOperation(benchmark::State& state) {
+    OplogApplicationBenchmark(state, false).run();
+    state.SetItemsProcessed(state.iterations() * kNumOps);
+}
+
+// The argument is the number of documents inserted by each insertMany.
+BENCHMARK(BM_MultiSyncApply)->Arg(1)->Arg(2)->Arg(10)->Arg(100);
+BENCHMARK(BM_SyncApplyEachOperation)->Arg(1)->Arg(2)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -40,8 +40,10 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/feature_compatibility_version_parser.h"
+#include "mongo/db/commands/server_status_internal.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
@@ -54,6 +56,7 @@
 #include "mongo/db/repl/idempotency_test_fixture.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplog_buffer_blocking_queue.h"
+#include "mongo/db/repl/oplog_buffer_proxy.h"
 #include "mongo/db/repl/oplog_interface_local.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
@@ -63,6 +66,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/service_context_d_test_fixture.h"
 #include "mongo/db/session_catalog.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/stdx/mutex.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
@@ -190,6 +194,46 @@ auto createCollectionWithUuid(OperationContext* opCtx, const NamespaceString& ns
     return options.uuid.get();
 }
 
+/**
+ * Returns the number of times the operation has acquired a collection lock, in any mode.
+ */
+long long getNumCollectionLockAcquisitions(OperationContext* opCtx) {
+    Locker::LockerInfo lockerInfo;
+    opCtx->lockState()->getLockerInfo(&lockerInfo);
+    long long numAcquisitions = 0;
+    for (int mode = MODE_NONE; mode < LockModesCount; ++mode) {
+        numAcquisitions += lockerInfo.stats
+                               .get(ResourceId(RESOURCE_COLLECTION, StringData()),
+                                    static_cast<LockMode>(mode))
+                               .numAcquisitions;
+    }
+    return numAcquisitions;
+}
+
+/**
+ * Returns the number of fetch bubbles recorded in the 'repl.apply.fetchBubbles' metric.
+ */
+long long getNumFetchBubbles() {
+    BSONObjBuilder builder;
+    MetricTree::theMetricTree->appendTo(builder);
+    return builder.obj()["metrics"]["repl"]["apply"]["fetchBubbles"]["num"].numberLong();
+}
+
+/**
+ * Empty oplog buffer whose waits for data return a value set by the test instead of blocking.
+ */
+class OplogBufferWithScriptedWaits : public OplogBufferProxy {
+public:
+    OplogBufferWithScriptedWaits()
+        : OplogBufferProxy(stdx::make_unique<OplogBufferBlockingQueue>()) {}
+
+    bool waitForData(Seconds waitDuration) override {
+        return dataArrives;
+    }
+
+    bool dataArrives = false;
+};
+
 /**
  * Create test database.
  */
@@ -510,6 +554,63 @@ TEST_F(SyncTailTest, MultiApplyAssignsOperationsToWriterThreadsBasedOnNamespaceH
     ASSERT_EQUALS(op2, lastEntry);
 }
 
+TEST_F(SyncTailTest, MultiApplyAppliesOperationsOnTheSameDocumentTogetherAndInOrder) {
+    NamespaceString nss("test.t");
+    auto writerPool = SyncTail::makeWriterPool(2);
+
+    stdx::mutex mutex;
+    std::vector<MultiApplier::Operations> operationsApplied;
+    auto applyOperationFn =
+        [&mutex, &operationsApplied](OperationContext* opCtx,
+                                     MultiApplier::OperationPtrs* operationsForWriterThreadToApply,
+                                     SyncTail* st,
+                                     WorkerMultikeyPathInfo*) -> Status {
+        stdx::lock_guard<stdx::mutex> lock(mutex);
+        operationsApplied.emplace_back();
+        for (auto&& opPtr : *operationsForWriterThreadToApply) {
+            operationsApplied.back().push_back(*opPtr);
+        }
+        return Status::OK();
+    };
+
+    // Interleave operations on one document with operations on many other documents.
+    MultiApplier::Operations ops;
+    const int numOps = 40;
+    for (int i = 0; i < numOps; ++i) {
+        const int id = (i % 2 == 0) ? 0 : i;
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(i + 1), 0), 1LL}, nss, BSON("_id" << id << "x" << i)));
+    }
+
+    SyncTail syncTail(nullptr,
+                      getConsistencyMarkers(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get());
+    ASSERT_EQUALS(ops.back().getOpTime(),
+                  unittest::assertGet(syncTail.multiApply(_opCtx.get(), ops)));
+
+    stdx::lock_guard<stdx::mutex> lock(mutex);
+    size_t numApplied = 0;
+    size_t numCallsWithHotDocument = 0;
+    for (auto&& operationsAppliedByCall : operationsApplied) {
+        numApplied += operationsAppliedByCall.size();
+        int lastX = -1;
+        bool sawHotDocument = false;
+        for (auto&& op : operationsAppliedByCall) {
+            if (op.getObject()["_id"].numberInt() != 0) {
+                continue;
+            }
+            sawHotDocument = true;
+            ASSERT_LESS_THAN(lastX, op.getObject()["x"].numberInt());
+            lastX = op.getObject()["x"].numberInt();
+        }
+        numCallsWithHotDocument += sawHotDocument ? 1 : 0;
+    }
+    ASSERT_EQUALS(size_t(numOps), numApplied);
+    ASSERT_EQUALS(1U, numCallsWithHotDocument);
+}
+
 TEST_F(SyncTailTest, MultiSyncApplyUsesSyncApplyToApplyOperation) {
     NamespaceString nss("local." + _agent.getSuiteName() + "_" + _agent.getTestName());
     auto op = makeCreateCollectionOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nss);
@@ -617,6 +718,72 @@ TEST_F(SyncTailTest, MultiSyncApplyDoesNotAddWorkerMultikeyPathInfoOnCreateIndex
     }
 }
 
+TEST_F(SyncTailTest, MultiApplyKeepsMultikeyPathInfoOfEachConflictGroupAppliedByOneThread) {
+    // This test relies on implementation details of how multiApply uses hashing to distribute ops
+    // to conflict groups. It needs the namespaces below to fall into at least two conflict groups,
+    // which the single writer thread then applies one after another. If it fails, consider
+    // adjusting the namespace names or their number.
+    const int numCollections = 8;
+    std::vector<NamespaceString> nsses;
+    for (int i = 0; i < numCollections; ++i) {
+        nsses.emplace_back("local." + _agent.getSuiteName() + "_" + _agent.getTestName() +
+                           std::to_string(i));
+        auto createOp = makeCreateCollectionOplogEntry({Timestamp(Seconds(1), 0), 1LL}, nsses[i]);
+        testWorkerMultikeyPaths(_opCtx.get(), createOp, 0UL);
+        auto indexOp = makeCreateIndexOplogEntry(
+            {Timestamp(Seconds(2), 0), 1LL}, nsses[i], "a_1", BSON("a" << 1));
+        testWorkerMultikeyPaths(_opCtx.get(), indexOp, 0UL);
+    }
+
+    auto writerPool = SyncTail::makeWriterPool(1);
+
+    // Every conflict group sets an index multikey, so the path info handed to each call of
+    // multiSyncApply must start out empty even though a single thread makes all of the calls.
+    stdx::mutex mutex;
+    size_t numCalls = 0;
+    auto applyOperationFn = [&mutex, &numCalls](OperationContext* opCtx,
+                                                MultiApplier::OperationPtrs* ops,
+                                                SyncTail* st,
+                                                WorkerMultikeyPathInfo* workerMultikeyPathInfo) {
+        {
+            stdx::lock_guard<stdx::mutex> lock(mutex);
+            ++numCalls;
+        }
+        return multiSyncApply(opCtx, ops, st, workerMultikeyPathInfo);
+    };
+
+    MultiApplier::Operations ops;
+    for (int i = 0; i < numCollections; ++i) {
+        auto doc = BSON("_id" << i << "a" << BSON_ARRAY(i << i + 1));
+        ops.push_back(
+            makeInsertDocumentOplogEntry({Timestamp(Seconds(3 + i), 0), 1LL}, nsses[i], doc));
+    }
+
+    SyncTail syncTail(nullptr,
+                      getConsistencyMarkers(),
+                      getStorageInterface(),
+                      applyOperationFn,
+                      writerPool.get());
+    ASSERT_EQUALS(ops.back().getOpTime(),
+                  unittest::assertGet(syncTail.multiApply(_opCtx.get(), ops)));
+
+    {
+        stdx::lock_guard<stdx::mutex> lock(mutex);
+        ASSERT_GREATER_THAN(numCalls, 1U);
+    }
+
+    // The multikey writes of every conflict group are applied once the batch is done.
+    for (auto&& nss : nsses) {
+        AutoGetCollectionForReadCommand autoColl(_opCtx.get(), nss);
+        auto collection = autoColl.getCollection();
+        ASSERT_TRUE(collection);
+        auto indexCatalog = collection->getIndexCatalog();
+        auto desc = indexCatalog->findIndexByName(_opCtx.get(), "a_1");
+        ASSERT_TRUE(desc);
+        ASSERT_TRUE(indexCatalog->isMultikey(_opCtx.get(), desc)) << nss;
+    }
+}
+
 TEST_F(SyncTailTest, MultiSyncApplyFailsWhenCollectionCreationTriesToMakeUUID) {
     ASSERT_OK(
         ReplicationCoordinator::get(_opCtx.get())->setFollowerMode(MemberState::RS_SECONDARY));
@@ -996,6 +1163,144 @@ TEST_F(SyncTailTest, MultiSyncApplyFallsBackOnApplyingInsertsIndividuallyWhenGro
     ASSERT_EQUALS(1U, numFailedGroupedInserts);
 }
 
+TEST_F(SyncTailTest, MultiSyncApplyAppliesGroupedCrudOperationsInOrder) {
+    int seconds = 1;
+    auto nextOpTime = [&seconds]() { return OpTime(Timestamp(Seconds(seconds++), 0), 1LL); };
+    NamespaceString nss("test." + _agent.getSuiteName() + "_" + _agent.getTestName());
+
+    // Interleave updates and deletes with lone inserts, so that none of the operations following
+    // the collection creation can be applied as a grouped insert.
+    MultiApplier::Operations ops;
+    ops.push_back(makeCreateCollectionOplogEntry(nextOpTime(), nss));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 1 << "x" << 0)));
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("_id" << 1), BSON("$set" << BSON("x" << 1))));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 2 << "x" << 0)));
+    ops.push_back(makeDeleteDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 2)));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 3 << "x" << 0)));
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("_id" << 1), BSON("$set" << BSON("x" << 2))));
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("_id" << 3), BSON("$set" << BSON("x" << 3))));
+
+    ASSERT_OK(runOpsSteadyState(ops));
+
+    auto findById = [&](int id) {
+        return getStorageInterface()->findById(_opCtx.get(), nss, BSON("_id" << id).firstElement());
+    };
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "x" << 2), unittest::assertGet(findById(1)));
+    ASSERT_EQUALS(ErrorCodes::NoSuchKey, findById(2).getStatus());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3 << "x" << 3), unittest::assertGet(findById(3)));
+}
+
+TEST_F(SyncTailTest, MultiSyncApplyAppliesCrudGroupUnderOneLockAndInsertsRunsInBulk) {
+    int seconds = 1;
+    auto nextOpTime = [&seconds]() { return OpTime(Timestamp(Seconds(seconds++), 0), 1LL); };
+    NamespaceString nss("test." + _agent.getSuiteName() + "_" + _agent.getTestName());
+    createCollectionWithUuid(_opCtx.get(), nss);
+
+    // The group starts with an update, so the run of inserts following it is part of the group.
+    MultiApplier::Operations ops;
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("_id" << 0), BSON("$set" << BSON("x" << 0))));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 1 << "x" << 0)));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 2 << "x" << 0)));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 3 << "x" << 0)));
+    ops.push_back(makeDeleteDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 2)));
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("_id" << 1), BSON("$set" << BSON("x" << 1))));
+
+    std::vector<std::vector<BSONObj>> docsInserted;
+    _opObserver->onInsertsFn =
+        [&](OperationContext*, const NamespaceString&, const std::vector<BSONObj>& docs) {
+            docsInserted.push_back(docs);
+        };
+
+    const auto numLockAcquisitionsBefore = getNumCollectionLockAcquisitions(_opCtx.get());
+    ASSERT_OK(runOpsSteadyState(ops));
+    ASSERT_EQUALS(1, getNumCollectionLockAcquisitions(_opCtx.get()) - numLockAcquisitionsBefore);
+
+    // The update of the missing document is applied as an upsert, and the three inserts are
+    // written by a single insert call.
+    ASSERT_EQUALS(2U, docsInserted.size());
+    ASSERT_EQUALS(1U, docsInserted[0].size());
+    ASSERT_EQUALS(3U, docsInserted[1].size());
+    for (std::size_t i = 0; i < docsInserted[1].size(); ++i) {
+        ASSERT_BSONOBJ_EQ(ops[i + 1].getObject(), docsInserted[1][i]);
+    }
+
+    auto findById = [&](int id) {
+        return getStorageInterface()->findById(_opCtx.get(), nss, BSON("_id" << id).firstElement());
+    };
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 0 << "x" << 0), unittest::assertGet(findById(0)));
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "x" << 1), unittest::assertGet(findById(1)));
+    ASSERT_EQUALS(ErrorCodes::NoSuchKey, findById(2).getStatus());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3 << "x" << 0), unittest::assertGet(findById(3)));
+}
+
+TEST_F(SyncTailTest, MultiSyncApplyInsertsRunOfCrudGroupIndividuallyWhenBulkInsertFails) {
+    int seconds = 1;
+    auto nextOpTime = [&seconds]() { return OpTime(Timestamp(Seconds(seconds++), 0), 1LL); };
+    NamespaceString nss("test." + _agent.getSuiteName() + "_" + _agent.getTestName());
+    createCollectionWithUuid(_opCtx.get(), nss);
+
+    // The second insert of the run hits a document which already exists, so the run can only be
+    // applied by turning that insert into an upsert.
+    MultiApplier::Operations ops;
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 2 << "x" << 0)));
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("_id" << 2), BSON("$set" << BSON("y" << 0))));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 1 << "x" << 1)));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 2 << "x" << 1)));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 3 << "x" << 1)));
+
+    const auto numLockAcquisitionsBefore = getNumCollectionLockAcquisitions(_opCtx.get());
+    ASSERT_OK(runOpsSteadyState(ops));
+    ASSERT_EQUALS(1, getNumCollectionLockAcquisitions(_opCtx.get()) - numLockAcquisitionsBefore);
+
+    auto findById = [&](int id) {
+        return getStorageInterface()->findById(_opCtx.get(), nss, BSON("_id" << id).firstElement());
+    };
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "x" << 1), unittest::assertGet(findById(1)));
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 2 << "x" << 1), unittest::assertGet(findById(2)));
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3 << "x" << 1), unittest::assertGet(findById(3)));
+}
+
+TEST_F(SyncTailTest, SyncApplyCrudOpsStopsAtFirstOperationWhichFails) {
+    int seconds = 1;
+    auto nextOpTime = [&seconds]() { return OpTime(Timestamp(Seconds(seconds++), 0), 1LL); };
+    NamespaceString nss("test." + _agent.getSuiteName() + "_" + _agent.getTestName());
+    createCollectionWithUuid(_opCtx.get(), nss);
+
+    // The third operation is an update without an _id, which cannot be applied.
+    MultiApplier::Operations ops;
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 1 << "x" << 0)));
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("_id" << 1), BSON("$set" << BSON("x" << 1))));
+    ops.push_back(makeUpdateDocumentOplogEntry(
+        nextOpTime(), nss, BSON("x" << 1), BSON("$set" << BSON("x" << 2))));
+    ops.push_back(makeInsertDocumentOplogEntry(nextOpTime(), nss, BSON("_id" << 2 << "x" << 0)));
+    MultiApplier::OperationPtrs opPtrs;
+    for (auto& op : ops) {
+        opPtrs.push_back(&op);
+    }
+
+    UnreplicatedWritesBlock uwb(_opCtx.get());
+    const auto numLockAcquisitionsBefore = getNumCollectionLockAcquisitions(_opCtx.get());
+    ASSERT_EQUALS(2U,
+                  SyncTail::syncApplyCrudOps(_opCtx.get(),
+                                             opPtrs.cbegin(),
+                                             opPtrs.cend(),
+                                             OplogApplication::Mode::kSecondary));
+    ASSERT_EQUALS(1, getNumCollectionLockAcquisitions(_opCtx.get()) - numLockAcquisitionsBefore);
+
+    auto findById = [&](int id) {
+        return getStorageInterface()->findById(_opCtx.get(), nss, BSON("_id" << id).firstElement());
+    };
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "x" << 1), unittest::assertGet(findById(1)));
+    ASSERT_EQUALS(ErrorCodes::NoSuchKey, findById(2).getStatus());
+}
+
 TEST_F(SyncTailTest, MultiInitialSyncApplyDisablesDocumentValidationWhileApplyingOperations) {
     SyncTailWithOperationContextChecker syncTail;
     NamespaceString nss("test.t");
@@ -1123,6 +1428,37 @@ public:
 
 }  // namespace
 
+TEST_F(SyncTailTest, FetchBubbleIsOnlyRecordedWhenOperationsArriveWhileStreaming) {
+    OplogBufferWithScriptedWaits oplogBuffer;
+    SyncTail syncTail(nullptr, getConsistencyMarkers(), getStorageInterface(), {}, nullptr);
+
+    SyncTail::BatchLimits limits;
+    limits.ops = 10;
+    limits.bytes = 1024 * 1024;
+
+    auto waitForMore = [&](bool dataArrives) {
+        oplogBuffer.dataArrives = dataArrives;
+        SyncTail::OpQueue ops(limits.ops);
+        ASSERT_TRUE(syncTail.tryPopAndWaitForMore(_opCtx.get(), &oplogBuffer, &ops, limits));
+        ASSERT_TRUE(ops.empty());
+    };
+
+    const auto numFetchBubblesBefore = getNumFetchBubbles();
+
+    // Operations arriving while the applier waits on an empty buffer end a fetch bubble.
+    waitForMore(true);
+    ASSERT_EQUALS(1, getNumFetchBubbles() - numFetchBubblesBefore);
+
+    // A wait which times out is idle time, and so is the wait after it, which ends once the sync
+    // source has something new to send.
+    waitForMore(false);
+    waitForMore(true);
+    ASSERT_EQUALS(1, getNumFetchBubbles() - numFetchBubblesBefore);
+
+    waitForMore(true);
+    ASSERT_EQUALS(2, getNumFetchBubbles() - numFetchBubblesBefore);
+}
+
 DEATH_TEST_F(SyncTailTest,
              OplogApplicationLogsExceptionFromSignalDrainCompleteBeforeAborting,
              "OperationFailed: failed to signal drain complete") {
@@ -48,6 +48,7 @@
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/repl/repl_client_info.h"
+#include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/s/collection_sharding_runtime.h"
 #include "mongo/db/s/sharding_state.h"
 #include "mongo/db/server_parameters.h"
@@ -57,6 +58,7 @@
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -68,8 +70,39 @@ MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterBatchDelayMS, int, 20)
         return Status::OK();
     });
 
+MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxBatchSize, int, 2048)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "rangeDeleterMaxBatchSize must be greater than or equal to 1");
+        }
+        return Status::OK();
+    });
+
 namespace {
 
+// The time a batch of deletions should take. The batch size grows while batches finish sooner and
+// shrinks when they take longer, so that the deletions neither starve user writes nor crawl.
+MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterTargetBatchTimeMS, int, 50)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "rangeDeleterTargetBatchTimeMS must be greater than or equal to 1");
+        }
+        return Status::OK();
+    });
+
+// While the majority commit point trails this node's last applied optime by more than this, the
+// batch size is halved after every batch.
+MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxReplicationLagSecs, int, 10)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "rangeDeleterMaxReplicationLagSecs must not be negative");
+        }
+        return Status::OK();
+    });
+
 using Deletion = CollectionRangeDeleter::Deletion;
 using DeleteNotification = CollectionRangeDeleter::DeleteNotification;
 
@@ -90,6 +123,25 @@ boost::optional<DeleteNotification> checkOverlap(std::list<Deletion> const& dele
     return boost::none;
 }
 
+/**
+ * Returns how far the majority commit point trails this node's last applied optime, or zero if
+ * this node is not a member of a replica set or the commit point is not known.
+ */
+Seconds getReplicationLag(OperationContext* opCtx) {
+    auto const replCoord = repl::ReplicationCoordinator::get(opCtx);
+    if (replCoord->getReplicationMode() != repl::ReplicationCoordinator::modeReplSet) {
+        return Seconds(0);
+    }
+
+    const auto lastApplied = replCoord->getMyLastAppliedOpTime().getTimestamp();
+    const auto lastCommitted = replCoord->getLastCommittedOpTime().getTimestamp();
+    if (lastCommitted.isNull() || lastCommitted >= lastApplied) {
+        return Seconds(0);
+    }
+
+    return Seconds(lastApplied.getSecs() - lastCommitted.getSecs());
+}
+
 }  // namespace
 
 CollectionRangeDeleter::CollectionRangeDeleter() = default;
@@ -107,6 +159,8 @@ boost::optional<Date_t> CollectionRangeDeleter::cleanUpNextRange(
     CollectionRangeDeleter* forTestOnly) {
 
     StatusWith<int> wrote = 0;
+    int batchSize = 0;
+    Milliseconds batchElapsed(0);
 
     auto range = boost::optional<ChunkRange>(boost::none);
     auto notification = DeleteNotification();
@@ -173,6 +227,17 @@ boost::optional<Date_t> CollectionRangeDeleter::cleanUpNextRange(
             const auto& frontRange = orphans.front().range;
             range.emplace(frontRange.getMin().getOwned(), frontRange.getMax().getOwned());
             notification = orphans.front().notification;
+
+            if (orphans.front().startTime == Date_t{}) {
+                orphans.front().startTime = Date_t::now();
+            }
+
+            // Start out with the historical batch size and tune it from there
+            if (self->_batchSize == 0) {
+                self->_batchSize = std::max(int(internalQueryExecYieldIterations.load()), 1);
+            }
+            self->_batchSize = std::min(self->_batchSize, maxToDelete);
+            batchSize = self->_batchSize;
         }
 
         invariant(range);
@@ -208,12 +273,22 @@ boost::optional<Date_t> CollectionRangeDeleter::cleanUpNextRange(
         }
 
         try {
+            Timer batchTimer;
             wrote = self->_doDeletion(
-                opCtx, collection, scopedCollectionMetadata->getKeyPattern(), *range, maxToDelete);
+                opCtx, collection, scopedCollectionMetadata->getKeyPattern(), *range, batchSize);
+            batchElapsed = Milliseconds(batchTimer.millis());
         } catch (const DBException& e) {
             wrote = e.toStatus();
             warning() << e.what();
         }
+
+        if (wrote.isOK() && wrote.getValue() > 0) {
+            const auto replicationLag = getReplicationLag(opCtx);
+
+            stdx::lock_guard<stdx::mutex> scopedLock(css->_metadataManager->_managerLock);
+            self->_recordBatch(
+                notification, wrote.getValue(), batchElapsed, replicationLag, maxToDelete);
+        }
     }  // drop autoColl
 
     if (!wrote.isOK() || wrote.getValue() == 0) {
@@ -420,10 +495,19 @@ boost::optional<Date_t> CollectionRangeDeleter::add(std::list<Deletion> ranges)
 }
 
 void CollectionRangeDeleter::append(BSONObjBuilder* builder) const {
+    const auto now = Date_t::now();
+
     BSONArrayBuilder arr(builder->subarrayStart("rangesToClean"));
     for (auto const& entry : _orphans) {
         BSONObjBuilder obj;
         entry.range.append(&obj);
+        if (entry.startTime != Date_t{}) {
+            const auto elapsedMillis = durationCount<Milliseconds>(now - entry.startTime);
+            obj.append("numDeleted", entry.numDeleted);
+            obj.append("deletingSince", entry.startTime);
+            obj.append("docsPerSecond",
+                       elapsedMillis > 0 ? entry.numDeleted * 1000.0 / elapsedMillis : 0.0);
+        }
         arr.append(obj.done());
     }
     for (auto const& entry : _delayedOrphans) {
@@ -432,6 +516,8 @@ void CollectionRangeDeleter::append(BSONObjBuilder* builder) const {
         arr.append(obj.done());
     }
     arr.done();
+
+    builder->append("rangeDeleterBatchSize", _batchSize);
 }
 
 size_t CollectionRangeDeleter::size() const {
@@ -453,6 +539,44 @@ void CollectionRangeDeleter::clear(Status status) {
     _delayedOrphans.clear();
 }
 
+void CollectionRangeDeleter::_recordBatch(DeleteNotification const& notification,
+                                          int numDeleted,
+                                          Milliseconds elapsed,
+                                          Seconds replicationLag,
+                                          int maxToDelete) {
+    if (!_orphans.empty() && _orphans.front().notification == notification) {
+        _orphans.front().numDeleted += numDeleted;
+    }
+
+    _batchSize = tuneBatchSize(_batchSize, numDeleted, elapsed, replicationLag, maxToDelete);
+}
+
+int CollectionRangeDeleter::tuneBatchSize(int batchSize,
+                                          int numDeleted,
+                                          Milliseconds elapsed,
+                                          Seconds replicationLag,
+                                          int maxToDelete) {
+    if (replicationLag > Seconds(rangeDeleterMaxReplicationLagSecs.load())) {
+        return std::max(1, std::min(batchSize / 2, maxToDelete));
+    }
+
+    // A batch cut short by the end of the range says nothing about how long a full one takes
+    if (numDeleted < batchSize) {
+        return std::max(1, std::min(batchSize, maxToDelete));
+    }
+
+    // A batch too fast to time grows at the highest rate
+    const long long elapsedMillis = durationCount<Milliseconds>(elapsed);
+    long long nextBatchSize = 2LL * batchSize;
+    if (elapsedMillis > 0) {
+        const long long idealBatchSize = numDeleted *
+            static_cast<long long>(rangeDeleterTargetBatchTimeMS.load()) / elapsedMillis;
+        nextBatchSize = std::min((batchSize + idealBatchSize) / 2, nextBatchSize);
+    }
+
+    return static_cast<int>(std::max(1LL, std::min<long long>(nextBatchSize, maxToDelete)));
+}
+
 void CollectionRangeDeleter::_pop(Status result) {
     _orphans.front().notification.notify(result);  // wake up waitForClean
     _orphans.pop_front();
@@ -46,6 +46,10 @@ class OperationContext;
 // next batch of deletions.
 extern AtomicInt32 rangeDeleterBatchDelayMS;
 
+// The largest number of documents the range deleter deletes in one batch. The actual batch size is
+// tuned between 1 and this value from the time each batch takes and the replication lag.
+extern AtomicInt32 rangeDeleterMaxBatchSize;
+
 class CollectionRangeDeleter {
     MONGO_DISALLOW_COPYING(CollectionRangeDeleter);
 
@@ -110,6 +114,10 @@ public:
         ChunkRange range;
         Date_t whenToDelete;  // A value of Date_t{} means immediately.
         DeleteNotification notification{};
+
+        // Progress of the deletion, reported by append() once it has started
+        Date_t startTime;
+        long long numDeleted{0};
     };
 
     CollectionRangeDeleter();
@@ -157,9 +165,10 @@ public:
     void append(BSONObjBuilder* builder) const;
 
     /**
-     * If any range deletions are scheduled, deletes up to maxToDelete documents, notifying
-     * watchers of ranges as they are done being deleted. It performs its own collection locking, so
-     * it must be called without locks.
+     * If any range deletions are scheduled, deletes a batch of up to maxToDelete documents,
+     * notifying watchers of ranges as they are done being deleted. The size of the batch adapts to
+     * the time previous batches took and to the replication lag. It performs its own collection
+     * locking, so it must be called without locks.
      *
      * If it should be scheduled to run again because there might be more documents to delete,
      * returns the time to begin, or boost::none otherwise.
@@ -173,6 +182,19 @@ public:
                                                     int maxToDelete,
                                                     CollectionRangeDeleter* forTestOnly = nullptr);
 
+    /**
+     * Returns the number of documents to delete in the batch after one of 'batchSize' documents,
+     * which deleted 'numDeleted' of them in 'elapsed'. The batch size moves towards the number of
+     * documents which can be deleted in rangeDeleterTargetBatchTimeMS, by at most a factor of two
+     * per batch, and is halved instead whenever 'replicationLag' exceeds
+     * rangeDeleterMaxReplicationLagSecs. It always stays between 1 and 'maxToDelete'.
+     */
+    static int tuneBatchSize(int batchSize,
+                             int numDeleted,
+                             Milliseconds elapsed,
+                             Seconds replicationLag,
+                             int maxToDelete);
+
 private:
     /**
      * Performs the deletion of up to maxToDelete entries within the range in progress. Must be
@@ -187,6 +209,17 @@ private:
                                 ChunkRange const& range,
                                 int maxToDelete);
 
+    /**
+     * Records a batch of 'numDeleted' documents, which took 'elapsed' to delete, against the range
+     * in progress if it is still the one identified by 'notification', and tunes the size of the
+     * next batch with tuneBatchSize().
+     */
+    void _recordBatch(DeleteNotification const& notification,
+                      int numDeleted,
+                      Milliseconds elapsed,
+                      Seconds replicationLag,
+                      int maxToDelete);
+
     /**
      * Removes the latest-scheduled range from the ranges to be cleaned up, and notifies any
      * interested callers of this->overlaps(range) with specified status.
@@ -199,6 +232,9 @@ private:
      */
     std::list<Deletion> _orphans;
     std::list<Deletion> _delayedOrphans;
+
+    // Number of documents to delete in the next batch, or 0 before the first batch
+    int _batchSize{0};
 };
 
 }  // namespace mongo
@@ -40,6 +40,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/s/collection_sharding_runtime.h"
 #include "mongo/db/s/sharding_state.h"
+#include "mongo/db/server_parameters_test_util.h"
 #include "mongo/s/balancer_configuration.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/client/shard_registry.h"
@@ -234,6 +235,96 @@ TEST_F(CollectionRangeDeleterTest, MultipleCleanupNextRangeCalls) {
     ASSERT_EQUALS(0ULL, dbclient.count(kAdminSysVer.ns(), BSON(kShardKey << "startRangeDeletion")));
 }
 
+// Tests that the range being cleaned up reports how many documents have been deleted from it.
+TEST_F(CollectionRangeDeleterTest, AppendReportsProgressOfRangeBeingCleaned) {
+    CollectionRangeDeleter rangeDeleter;
+    DBDirectClient dbclient(operationContext());
+    dbclient.insert(kNss.toString(), BSON(kShardKey << 1));
+    dbclient.insert(kNss.toString(), BSON(kShardKey << 2));
+    dbclient.insert(kNss.toString(), BSON(kShardKey << 3));
+
+    std::list<Deletion> ranges;
+    ranges.emplace_back(
+        Deletion{ChunkRange(BSON(kShardKey << 0), BSON(kShardKey << 10)), Date_t{}});
+    ranges.emplace_back(
+        Deletion{ChunkRange(BSON(kShardKey << 10), BSON(kShardKey << 20)), Date_t{}});
+    rangeDeleter.add(std::move(ranges));
+
+    ASSERT_TRUE(next(rangeDeleter, 1));
+    ASSERT_TRUE(next(rangeDeleter, 1));
+
+    BSONObjBuilder builder;
+    rangeDeleter.append(&builder);
+    const auto status = builder.obj();
+    ASSERT_EQ(1, status["rangeDeleterBatchSize"].numberInt());
+
+    const auto rangesToClean = status["rangesToClean"].Array();
+    ASSERT_EQ(2UL, rangesToClean.size());
+    ASSERT_EQ(2, rangesToClean[0].Obj()["numDeleted"].numberInt());
+    ASSERT_TRUE(rangesToClean[0].Obj().hasField("docsPerSecond"));
+    ASSERT_FALSE(rangesToClean[1].Obj().hasField("numDeleted"));
+}
+
+// Tests that the batch size converges on the number of documents deleted in the target time, moving
+// by at most a factor of two per batch.
+TEST(CollectionRangeDeleterBatchSizeTest, ConvergesOnTargetBatchTime) {
+    ServerParameterControllerForTest targetBatchTime("rangeDeleterTargetBatchTimeMS", "100");
+
+    // Deleting a document takes a millisecond, so 100 documents fit in the target time
+    int batchSize = 10;
+    int previous = batchSize;
+    for (int i = 0; i < 20; i++) {
+        batchSize = CollectionRangeDeleter::tuneBatchSize(
+            batchSize, batchSize, Milliseconds(batchSize), Seconds(0), 1000);
+        ASSERT_LTE(batchSize, 2 * previous);
+        ASSERT_LTE(batchSize, 100);
+        previous = batchSize;
+    }
+    ASSERT_GTE(batchSize, 99);
+
+    batchSize = 400;
+    for (int i = 0; i < 20; i++) {
+        batchSize = CollectionRangeDeleter::tuneBatchSize(
+            batchSize, batchSize, Milliseconds(batchSize), Seconds(0), 1000);
+        ASSERT_GTE(batchSize, 100);
+    }
+    ASSERT_LTE(batchSize, 101);
+
+    // A batch cut short by the end of the range leaves the size alone
+    ASSERT_EQ(400,
+              CollectionRangeDeleter::tuneBatchSize(400, 3, Milliseconds(1), Seconds(0), 1000));
+}
+
+// Tests that however fast batches are, the batch size never exceeds rangeDeleterMaxBatchSize.
+TEST(CollectionRangeDeleterBatchSizeTest, StaysWithinMaxBatchSize) {
+    ServerParameterControllerForTest maxBatchSize("rangeDeleterMaxBatchSize", "64");
+
+    int batchSize = 1;
+    for (int i = 0; i < 20; i++) {
+        batchSize = CollectionRangeDeleter::tuneBatchSize(
+            batchSize, batchSize, Milliseconds(0), Seconds(0), rangeDeleterMaxBatchSize.load());
+        ASSERT_GTE(batchSize, 1);
+        ASSERT_LTE(batchSize, 64);
+    }
+    ASSERT_EQ(64, batchSize);
+}
+
+// Tests that the batch size is halved, down to a single document, while the replication lag
+// exceeds rangeDeleterMaxReplicationLagSecs, no matter how fast batches are.
+TEST(CollectionRangeDeleterBatchSizeTest, HalvesWhileReplicationLagExceedsMax) {
+    ServerParameterControllerForTest maxLag("rangeDeleterMaxReplicationLagSecs", "10");
+
+    ASSERT_EQ(200,
+              CollectionRangeDeleter::tuneBatchSize(400, 400, Milliseconds(1), Seconds(11), 1000));
+    ASSERT_EQ(200,
+              CollectionRangeDeleter::tuneBatchSize(400, 3, Milliseconds(1), Seconds(11), 1000));
+    ASSERT_EQ(1, CollectionRangeDeleter::tuneBatchSize(1, 1, Milliseconds(1), Seconds(11), 1000));
+
+    // Lag up to the limit does not hold the batch size back
+    ASSERT_EQ(800,
+              CollectionRangeDeleter::tuneBatchSize(400, 400, Milliseconds(1), Seconds(10), 1000));
+}
+
 // Tests the case that there are two ranges to clean, each containing multiple documents.
 TEST_F(CollectionRangeDeleterTest, MultipleDocumentsInMultipleRangesToClean) {
     CollectionRangeDeleter rangeDeleter;
@@ -31,14 +31,26 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/s/collection_sharding_runtime.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/executor/network_interface_factory.h"
-#include "mongo/executor/network_interface_thread_pool.h"
 #include "mongo/executor/thread_pool_task_executor.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 namespace {
 
+// The number of threads deleting orphaned ranges. Each collection's ranges are deleted one batch
+// at a time, so additional threads only let different collections be cleaned up concurrently.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rangeDeleterThreads, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "rangeDeleterThreads must be greater than or equal to 1");
+        }
+        return Status::OK();
+    });
+
 class CollectionShardingStateFactoryShard final : public CollectionShardingStateFactory {
 public:
     CollectionShardingStateFactoryShard(ServiceContext* serviceContext)
@@ -61,8 +73,12 @@ private:
         if (!_taskExecutor) {
             const std::string kExecName("CollectionRangeDeleter-TaskExecutor");
 
+            ThreadPool::Options options;
+            options.poolName = "CollectionRangeDeleter";
+            options.maxThreads = static_cast<size_t>(rangeDeleterThreads);
+
             auto net = executor::makeNetworkInterface(kExecName);
-            auto pool = stdx::make_unique<executor::NetworkInterfaceThreadPool>(net.get());
+            auto pool = stdx::make_unique<ThreadPool>(options);
             auto taskExecutor = stdx::make_unique<executor::ThreadPoolTaskExecutor>(std::move(pool),
                                                                                     std::move(net));
             taskExecutor->startup();
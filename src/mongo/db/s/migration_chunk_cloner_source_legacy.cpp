@@ -37,7 +37,6 @@
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog_raii.h"
 #include "mongo/db/dbhelpers.h"
-#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/query/internal_plans.h"
@@ -88,45 +87,6 @@ BSONObj createRequestWithSessionId(StringData commandName,
 
 }  // namespace
 
-/**
- * Used to receive invalidation notifications from operations, which delete documents.
- */
-class DeleteNotificationStage final : public PlanStage {
-public:
-    DeleteNotificationStage(MigrationChunkClonerSourceLegacy* cloner, OperationContext* opCtx)
-        : PlanStage("SHARDING_NOTIFY_DELETE", opCtx), _cloner(cloner) {}
-
-    void doInvalidate(OperationContext* opCtx, const RecordId& dl, InvalidationType type) override {
-        if (type == INVALIDATION_DELETION) {
-            stdx::lock_guard<stdx::mutex> sl(_cloner->_mutex);
-            _cloner->_cloneLocs.erase(dl);
-        }
-    }
-
-    StageState doWork(WorkingSetID* out) override {
-        MONGO_UNREACHABLE;
-    }
-
-    bool isEOF() override {
-        MONGO_UNREACHABLE;
-    }
-
-    std::unique_ptr<PlanStageStats> getStats() override {
-        MONGO_UNREACHABLE;
-    }
-
-    SpecificStats* getSpecificStats() const override {
-        MONGO_UNREACHABLE;
-    }
-
-    StageType stageType() const override {
-        return STAGE_NOTIFY_DELETE;
-    }
-
-private:
-    MigrationChunkClonerSourceLegacy* const _cloner;
-};
-
 /**
  * Used to commit work for LogOpForSharding. Used to keep track of changes in documents that are
  * part of a chunk being migrated.
@@ -200,7 +160,7 @@ MigrationChunkClonerSourceLegacy::MigrationChunkClonerSourceLegacy(MoveChunkRequ
 
 MigrationChunkClonerSourceLegacy::~MigrationChunkClonerSourceLegacy() {
     invariant(_state == kDone);
-    invariant(!_deleteNotifyExec);
+    invariant(!_cloneExec);
 }
 
 Status MigrationChunkClonerSourceLegacy::startClone(OperationContext* opCtx) {
@@ -216,10 +176,10 @@ Status MigrationChunkClonerSourceLegacy::startClone(OperationContext* opCtx) {
         _sessionCatalogSource->fetchNextOplog(opCtx);
     }
 
-    // Load the ids of the currently available documents
-    auto storeCurrentLocsStatus = _storeCurrentLocs(opCtx);
-    if (!storeCurrentLocsStatus.isOK()) {
-        return storeCurrentLocsStatus;
+    // Size the chunk and position the scan, which will stream its documents to the recipient
+    auto initCloneScanStatus = _initCloneScan(opCtx);
+    if (!initCloneScanStatus.isOK()) {
+        return initCloneScanStatus;
     }
 
     // Tell the recipient shard to start cloning
@@ -277,17 +237,20 @@ Status MigrationChunkClonerSourceLegacy::awaitUntilCriticalSectionIsAppropriate(
 
         stdx::lock_guard<stdx::mutex> sl(_mutex);
 
-        const std::size_t cloneLocsRemaining = _cloneLocs.size();
+        const uint64_t cloneDocsRemaining = _cloneScanExhausted
+            ? 0
+            : _numRecordsToClone - std::min(_numRecordsToClone, _numRecordsCloned);
 
         log() << "moveChunk data transfer progress: " << redact(res) << " mem used: " << _memoryUsed
-              << " documents remaining to clone: " << cloneLocsRemaining;
+              << " documents remaining to clone: " << cloneDocsRemaining;
 
         if (res["state"].String() == "steady") {
-            if (cloneLocsRemaining != 0) {
+            if (!_cloneScanExhausted) {
                 return {ErrorCodes::OperationIncomplete,
                         str::stream() << "Unable to enter critical section because the recipient "
-                                         "shard thinks all data is cloned while there are still "
-                                      << cloneLocsRemaining
+                                         "shard thinks all data is cloned while the scan of the "
+                                         "chunk has not completed, with about "
+                                      << cloneDocsRemaining
                                       << " documents remaining"};
             }
 
@@ -461,8 +424,11 @@ void MigrationChunkClonerSourceLegacy::onDeleteOp(OperationContext* opCtx,
 uint64_t MigrationChunkClonerSourceLegacy::getCloneBatchBufferAllocationSize() {
     stdx::lock_guard<stdx::mutex> sl(_mutex);
 
+    const uint64_t cloneDocsRemaining =
+        _numRecordsToClone - std::min(_numRecordsToClone, _numRecordsCloned);
+
     return std::min(static_cast<uint64_t>(BSONObjMaxUserSize),
-                    _averageObjectSizeForCloneLocs * _cloneLocs.size());
+                    _averageObjectSizeForClone * cloneDocsRemaining);
 }
 
 Status MigrationChunkClonerSourceLegacy::nextCloneBatch(OperationContext* opCtx,
@@ -476,39 +442,67 @@ Status MigrationChunkClonerSourceLegacy::nextCloneBatch(OperationContext* opCtx,
 
     stdx::lock_guard<stdx::mutex> sl(_mutex);
 
-    std::set<RecordId>::iterator it;
+    if (!_cloneExec) {
+        if (_cloneScanExhausted) {
+            return Status::OK();
+        }
 
-    for (it = _cloneLocs.begin(); it != _cloneLocs.end(); ++it) {
-        // We must always make progress in this method by at least one document because empty return
-        // indicates there is no more initial clone data.
-        if (arrBuilder->arrSize() && tracker.intervalHasElapsed()) {
+        return {ErrorCodes::QueryPlanKilled,
+                "The scan of documents belonging to chunk was abandoned after an earlier error"};
+    }
+
+    // Unless the scan is left positioned for the next batch below, get rid of it. We have a
+    // different OperationContext than when we created the PlanExecutor, so need to manually
+    // destroy it ourselves.
+    auto disposeGuard = MakeGuard([&] {
+        _cloneExec->dispose(opCtx, collection->getCursorManager());
+        _cloneExec.reset();
+    });
+
+    _cloneExec->reattachToOperationContext(opCtx);
+
+    Status restoreStatus = _cloneExec->restoreState();
+    if (!restoreStatus.isOK()) {
+        return restoreStatus.withContext(
+            "Unable to resume the scan of documents belonging to chunk");
+    }
+
+    BSONObj obj;
+    PlanExecutor::ExecState state;
+    while (PlanExecutor::ADVANCED == (state = _cloneExec->getNext(&obj, nullptr))) {
+        // Use the builder size instead of accumulating the document sizes directly so that we
+        // take into consideration the overhead of BSONArray indices.
+        if (arrBuilder->arrSize() &&
+            (arrBuilder->len() + obj.objsize() + 1024) > BSONObjMaxUserSize) {
+            _cloneExec->enqueue(obj);
             break;
         }
 
-        Snapshotted<BSONObj> doc;
-        if (collection->findDoc(opCtx, *it, &doc)) {
-            // Use the builder size instead of accumulating the document sizes directly so that we
-            // take into consideration the overhead of BSONArray indices.
-            if (arrBuilder->arrSize() &&
-                (arrBuilder->len() + doc.value().objsize() + 1024) > BSONObjMaxUserSize) {
-                break;
-            }
+        arrBuilder->append(obj);
+        _numRecordsCloned++;
 
-            arrBuilder->append(doc.value());
+        // We must always make progress in this method by at least one document because empty return
+        // indicates there is no more initial clone data.
+        if (tracker.intervalHasElapsed()) {
+            break;
         }
     }
 
-    _cloneLocs.erase(_cloneLocs.begin(), it);
+    if (PlanExecutor::DEAD == state || PlanExecutor::FAILURE == state) {
+        return WorkingSetCommon::getMemberObjectStatus(obj).withContext(
+            "Executor error while scanning for documents belonging to chunk");
+    }
 
-    // If we have drained all the cloned data, there is no need to keep the delete notify executor
-    // around
-    if (_cloneLocs.empty() && _deleteNotifyExec) {
-        // We have a different OperationContext than when we created the PlanExecutor, so need to
-        // manually destroy it ourselves.
-        _deleteNotifyExec->dispose(opCtx, collection->getCursorManager());
-        _deleteNotifyExec.reset();
+    // If we have drained all the cloned data, there is no need to keep the executor around
+    if (PlanExecutor::IS_EOF == state) {
+        _cloneScanExhausted = true;
+        return Status::OK();
     }
 
+    _cloneExec->saveState();
+    _cloneExec->detachFromOperationContext();
+    disposeGuard.Dismiss();
+
     return Status::OK();
 }
 
@@ -520,7 +514,7 @@ Status MigrationChunkClonerSourceLegacy::nextModsBatch(OperationContext* opCtx,
     stdx::lock_guard<stdx::mutex> sl(_mutex);
 
     // All clone data must have been drained before starting to fetch the incremental changes
-    invariant(_cloneLocs.empty());
+    invariant(_cloneScanExhausted);
 
     long long docSizeAccumulator = 0;
 
@@ -539,20 +533,20 @@ void MigrationChunkClonerSourceLegacy::_cleanup(OperationContext* opCtx) {
         _reload.clear();
         _deleted.clear();
     }
-    // Implicitly resets _deleteNotifyExec to avoid possible invariant failure
+    // Implicitly resets _cloneExec to avoid possible invariant failure
     // in on destruction of MigrationChunkClonerSourceLegacy, and will always
-    // call deleteNotifyExec destructor on scope exit even if something in the
+    // call cloneExec destructor on scope exit even if something in the
     // below if statement fails
-    auto deleteNotifyExec = std::move(_deleteNotifyExec);
+    auto cloneExec = std::move(_cloneExec);
 
-    if (deleteNotifyExec) {
-        // Don't allow an Interrupt exception to prevent _deleteNotifyExec from getting cleaned up.
+    if (cloneExec) {
+        // Don't allow an Interrupt exception to prevent _cloneExec from getting cleaned up.
         UninterruptibleLockGuard noInterrupt(opCtx->lockState());
 
         AutoGetCollection autoColl(opCtx, _args.getNss(), MODE_IS);
         const auto cursorManager =
             autoColl.getCollection() ? autoColl.getCollection()->getCursorManager() : nullptr;
-        deleteNotifyExec->dispose(opCtx, cursorManager);
+        cloneExec->dispose(opCtx, cursorManager);
     }
 }
 
@@ -586,7 +580,7 @@ StatusWith<BSONObj> MigrationChunkClonerSourceLegacy::_callRecipient(const BSONO
     return responseStatus.data.getOwned();
 }
 
-Status MigrationChunkClonerSourceLegacy::_storeCurrentLocs(OperationContext* opCtx) {
+Status MigrationChunkClonerSourceLegacy::_initCloneScan(OperationContext* opCtx) {
     AutoGetCollection autoColl(opCtx, _args.getNss(), MODE_IS);
 
     Collection* const collection = autoColl.getCollection();
@@ -604,23 +598,10 @@ Status MigrationChunkClonerSourceLegacy::_storeCurrentLocs(OperationContext* opC
     if (!idx) {
         return {ErrorCodes::IndexNotFound,
                 str::stream() << "can't find index with prefix " << _shardKeyPattern.toBSON()
-                              << " in storeCurrentLocs for "
+                              << " in initCloneScan for "
                               << _args.getNss().ns()};
     }
 
-    // Install the stage, which will listen for notifications on the collection
-    auto statusWithDeleteNotificationPlanExecutor =
-        PlanExecutor::make(opCtx,
-                           stdx::make_unique<WorkingSet>(),
-                           stdx::make_unique<DeleteNotificationStage>(this, opCtx),
-                           collection,
-                           PlanExecutor::YIELD_MANUAL);
-    if (!statusWithDeleteNotificationPlanExecutor.isOK()) {
-        return statusWithDeleteNotificationPlanExecutor.getStatus();
-    }
-
-    _deleteNotifyExec = std::move(statusWithDeleteNotificationPlanExecutor.getValue());
-
     // Assume both min and max non-empty, append MinKey's to make them fit chosen index
     const KeyPattern kp(idx->keyPattern());
 
@@ -659,19 +640,13 @@ Status MigrationChunkClonerSourceLegacy::_storeCurrentLocs(OperationContext* opC
     unsigned long long recCount = 0;
 
     BSONObj obj;
-    RecordId recordId;
     PlanExecutor::ExecState state;
-    while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, &recordId))) {
+    while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr))) {
         Status interruptStatus = opCtx->checkForInterruptNoAssert();
         if (!interruptStatus.isOK()) {
             return interruptStatus;
         }
 
-        if (!isLargeChunk) {
-            stdx::lock_guard<stdx::mutex> lk(_mutex);
-            _cloneLocs.insert(recordId);
-        }
-
         if (++recCount > maxRecsWhenFull) {
             isLargeChunk = true;
             // Continue on despite knowing that it will fail, just to get the correct value for
@@ -706,8 +681,26 @@ Status MigrationChunkClonerSourceLegacy::_storeCurrentLocs(OperationContext* opC
                           << _args.getMaxKey()};
     }
 
+    // The documents themselves are fetched in index order by a second scan, which nextCloneBatch
+    // resumes for every batch instead of remembering the record ids found above. Documents deleted
+    // before the scan reaches them are skipped and documents inserted ahead of it are returned, in
+    // addition to being tracked as modifications like all writes during the clone.
+    auto cloneExec = InternalPlanner::indexScan(opCtx,
+                                                collection,
+                                                idx,
+                                                min,
+                                                max,
+                                                BoundInclusion::kIncludeStartKeyOnly,
+                                                PlanExecutor::YIELD_MANUAL,
+                                                InternalPlanner::FORWARD,
+                                                InternalPlanner::IXSCAN_FETCH);
+    cloneExec->saveState();
+    cloneExec->detachFromOperationContext();
+
     stdx::lock_guard<stdx::mutex> lk(_mutex);
-    _averageObjectSizeForCloneLocs = collectionAverageObjectSize + 12;
+    _cloneExec = std::move(cloneExec);
+    _numRecordsToClone = recCount;
+    _averageObjectSizeForClone = collectionAverageObjectSize + 12;
 
     return Status::OK();
 }
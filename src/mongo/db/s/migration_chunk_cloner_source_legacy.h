@@ -29,7 +29,6 @@
 #pragma once
 
 #include <list>
-#include <set>
 
 #include "mongo/bson/bsonobj.h"
 #include "mongo/client/connection_string.h"
@@ -51,7 +50,6 @@ class BSONArrayBuilder;
 class BSONObjBuilder;
 class Collection;
 class Database;
-class RecordId;
 
 class MigrationChunkClonerSourceLegacy final : public MigrationChunkClonerSource {
     MONGO_DISALLOW_COPYING(MigrationChunkClonerSourceLegacy);
@@ -118,7 +116,8 @@ public:
 
     /**
      * Called by the recipient shard. Populates the passed BSONArrayBuilder with a set of documents,
-     * which are part of the initial clone sequence.
+     * which are part of the initial clone sequence. The documents are streamed from an index scan
+     * over the chunk's range, which resumes where the previous call left off.
      *
      * Returns OK status on success. If there were documents returned in the result argument, this
      * method should be called more times until the result is empty. If it returns failure, it is
@@ -161,7 +160,6 @@ public:
                                                             BSONArrayBuilder* arrBuilder);
 
 private:
-    friend class DeleteNotificationStage;
     friend class LogOpForShardingHandler;
 
     // Represents the states in which the cloner can be
@@ -180,12 +178,12 @@ private:
     StatusWith<BSONObj> _callRecipient(const BSONObj& cmdObj);
 
     /**
-     * Get the disklocs that belong to the chunk migrated and sort them in _cloneLocs (to avoid
-     * seeking disk later).
+     * Counts the documents that belong to the chunk migrated, checking that the chunk is not too
+     * big to move, and positions _cloneExec at the start of the chunk's range.
      *
      * Returns OK or any error status otherwise.
      */
-    Status _storeCurrentLocs(OperationContext* opCtx);
+    Status _initCloneScan(OperationContext* opCtx);
 
     /**
      * Insert items from docIdList to a new array with the given fieldName in the given builder. If
@@ -218,10 +216,6 @@ private:
     // The resolved primary of the recipient shard
     const HostAndPort _recipientHost;
 
-    // Registered deletion notifications plan executor, which will listen for document deletions
-    // during the cloning stage
-    std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> _deleteNotifyExec;
-
     std::unique_ptr<SessionCatalogMigrationSource> _sessionCatalogSource;
 
     // Protects the entries below
@@ -230,12 +224,22 @@ private:
     // The current state of the cloner
     State _state{kNew};
 
-    // List of record ids that needs to be transferred (initial clone)
-    std::set<RecordId> _cloneLocs;
+    // Index scan over the chunk's range, which fetches the documents to transfer. It is kept in a
+    // saved and detached state between the calls to nextCloneBatch, so that each batch resumes
+    // the scan where the previous one left off (initial clone).
+    std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> _cloneExec;
+
+    // Whether _cloneExec was drained (initial clone)
+    bool _cloneScanExhausted{false};
+
+    // The number of documents in the chunk when the clone started and the number of documents
+    // returned by nextCloneBatch so far. Used to estimate the remaining work (initial clone).
+    uint64_t _numRecordsToClone{0};
+    uint64_t _numRecordsCloned{0};
 
     // The estimated average object size during the clone phase. Used for buffer size
     // pre-allocation (initial clone).
-    uint64_t _averageObjectSizeForCloneLocs{0};
+    uint64_t _averageObjectSizeForClone{0};
 
     // List of _id of documents that were modified that must be re-cloned (xfer mods)
     std::list<BSONObj> _reload;
@@ -303,6 +303,69 @@ TEST_F(MigrationChunkClonerSourceLegacyTest, CorrectDocumentsFetched) {
     futureCommit.timed_get(kFutureTimeout);
 }
 
+TEST_F(MigrationChunkClonerSourceLegacyTest, CloneBatchesResumeScanAfterConcurrentWrites) {
+    std::vector<BSONObj> contents;
+    for (int i = 100; i < 400; ++i) {
+        contents.push_back(createCollectionDocument(i));
+    }
+
+    createShardedCollection(contents);
+
+    MigrationChunkClonerSourceLegacy cloner(
+        createMoveChunkRequest(ChunkRange(BSON("X" << 100), BSON("X" << 1000))),
+        kShardKeyPattern,
+        kDonorConnStr,
+        kRecipientConnStr.getServers()[0]);
+
+    {
+        auto futureStartClone = launchAsync([&]() {
+            onCommand([&](const RemoteCommandRequest& request) { return BSON("ok" << true); });
+        });
+
+        ASSERT_OK(cloner.startClone(operationContext()));
+        futureStartClone.timed_get(kFutureTimeout);
+    }
+
+    std::vector<BSONObj> clonedDocs;
+    auto fetchNextCloneBatch = [&] {
+        AutoGetCollection autoColl(operationContext(), kNss, MODE_IS);
+
+        BSONArrayBuilder arrBuilder;
+        ASSERT_OK(cloner.nextCloneBatch(operationContext(), autoColl.getCollection(), &arrBuilder));
+        for (const auto& elem : arrBuilder.arr()) {
+            clonedDocs.push_back(elem.Obj().getOwned());
+        }
+        return arrBuilder.arrSize();
+    };
+
+    // The batch stops early once the yield interval has elapsed, leaving the scan in the middle of
+    // the chunk
+    const int firstBatchSize = fetchNextCloneBatch();
+    ASSERT_GT(firstBatchSize, 0);
+    ASSERT_LT(firstBatchSize, 300);
+
+    // Writes ahead of the scan position are seen by the following batches
+    client()->remove(kNss.ns(), BSON("X" << 390));
+    insertDocsInShardedCollection({createCollectionDocument(500)});
+
+    while (fetchNextCloneBatch() > 0) {
+    }
+
+    ASSERT_EQ(300U, clonedDocs.size());
+    for (size_t i = 0; i < clonedDocs.size() - 1; ++i) {
+        ASSERT_LT(clonedDocs[i]["X"].numberInt(), clonedDocs[i + 1]["X"].numberInt());
+        ASSERT_NE(390, clonedDocs[i]["X"].numberInt());
+    }
+    ASSERT_BSONOBJ_EQ(createCollectionDocument(500), clonedDocs.back());
+
+    auto futureCancel = launchAsync([&]() {
+        onCommand([&](const RemoteCommandRequest& request) { return BSON("ok" << true); });
+    });
+
+    cloner.cancelClone(operationContext());
+    futureCancel.timed_get(kFutureTimeout);
+}
+
 TEST_F(MigrationChunkClonerSourceLegacyTest, CollectionNotFound) {
     MigrationChunkClonerSourceLegacy cloner(
         createMoveChunkRequest(ChunkRange(BSON("X" << 100), BSON("X" << 200))),
@@ -52,6 +52,7 @@
 #include "mongo/db/s/migration_util.h"
 #include "mongo/db/s/move_timing_helper.h"
 #include "mongo/db/s/start_chunk_clone_request.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/service_context.h"
 #include "mongo/s/catalog/type_chunk.h"
 #include "mongo/s/client/shard_registry.h"
@@ -68,6 +69,16 @@
 namespace mongo {
 namespace {
 
+// Number of threads inserting the batches of documents cloned from the donor shard
+MONGO_EXPORT_SERVER_PARAMETER(migrationCloneInsertionThreads, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "migrationCloneInsertionThreads must be greater than or equal to 1");
+        }
+        return Status::OK();
+    });
+
 const auto getMigrationDestinationManager =
     ServiceContext::declareDecoration<MigrationDestinationManager>();
 
@@ -376,46 +387,77 @@ void MigrationDestinationManager::cloneDocumentsFromDonor(
     stdx::function<void(OperationContext*, BSONObj)> insertBatchFn,
     stdx::function<BSONObj(OperationContext*)> fetchBatchFn) {
 
-    ProducerConsumerQueue<BSONObj> batches(1);
-    stdx::thread inserterThread{[&] {
-        Client::initThreadIfNotAlready("chunkInserter");
-        auto inserterOpCtx = Client::getCurrent()->makeOperationContext();
-        auto consumerGuard = MakeGuard([&] { batches.closeConsumerEnd(); });
-        try {
-            while (true) {
-                auto nextBatch = batches.pop(inserterOpCtx.get());
-                auto arr = nextBatch["objects"].Obj();
-                if (arr.isEmpty()) {
-                    return;
-                }
-                insertBatchFn(inserterOpCtx.get(), arr);
-            }
-        } catch (...) {
-            stdx::lock_guard<Client> lk(*opCtx->getClient());
-            opCtx->getServiceContext()->killOperation(opCtx, exceptionToStatus().code());
-            log() << "Batch insertion failed " << causedBy(redact(exceptionToStatus()));
-        }
-    }};
-    auto inserterThreadJoinGuard = MakeGuard([&] {
+    const int numInserterThreads = migrationCloneInsertionThreads.load();
+
+    // Fetch ahead of the inserter threads, so that each of them has a batch ready to insert
+    ProducerConsumerQueue<BSONObj> batches(numInserterThreads);
+
+    std::vector<stdx::thread> inserterThreads;
+    auto inserterThreadsJoinGuard = MakeGuard([&] {
         batches.closeProducerEnd();
-        inserterThread.join();
+        for (auto& inserterThread : inserterThreads) {
+            inserterThread.join();
+        }
     });
 
+    for (int i = 0; i < numInserterThreads; ++i) {
+        inserterThreads.emplace_back([&] {
+            Client::initThreadIfNotAlready("chunkInserter");
+            auto inserterOpCtx = Client::getCurrent()->makeOperationContext();
+            try {
+                while (true) {
+                    auto nextBatch = batches.pop(inserterOpCtx.get());
+                    insertBatchFn(inserterOpCtx.get(), nextBatch["objects"].Obj());
+                }
+            } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueEndClosed>&) {
+                // Either all the batches have been inserted, or another inserter thread failed and
+                // has already interrupted the migration
+            } catch (...) {
+                {
+                    stdx::lock_guard<Client> lk(*opCtx->getClient());
+                    opCtx->getServiceContext()->killOperation(opCtx, exceptionToStatus().code());
+                }
+                batches.closeConsumerEnd();
+                log() << "Batch insertion failed " << causedBy(redact(exceptionToStatus()));
+            }
+        });
+    }
+
     while (true) {
         opCtx->checkForInterrupt();
 
         auto res = fetchBatchFn(opCtx);
 
         opCtx->checkForInterrupt();
-        batches.push(res.getOwned(), opCtx);
-        auto arr = res["objects"].Obj();
-        if (arr.isEmpty()) {
-            inserterThreadJoinGuard.Dismiss();
-            inserterThread.join();
+        if (res["objects"].Obj().isEmpty()) {
+            inserterThreadsJoinGuard.Dismiss();
+            batches.closeProducerEnd();
+            for (auto& inserterThread : inserterThreads) {
+                inserterThread.join();
+            }
             opCtx->checkForInterrupt();
             break;
         }
+
+        batches.push(res.getOwned(), opCtx);
+    }
+}
+
+bool MigrationDestinationManager::isDuplicateOfClonedDocument(OperationContext* opCtx,
+                                                              const NamespaceString& nss,
+                                                              const BSONObj& min,
+                                                              const BSONObj& max,
+                                                              const BSONObj& shardKeyPattern,
+                                                              const BSONObj& doc) {
+    AutoGetCollection autoColl(opCtx, nss, MODE_IS);
+
+    BSONObj localDoc;
+    if (!Helpers::findById(opCtx, autoColl.getDb(), nss.ns(), doc, localDoc)) {
+        return false;
     }
+
+    return localDoc["_id"].woCompare(doc["_id"], false) == 0 &&
+        isInRange(localDoc, min, max, shardKeyPattern);
 }
 
 Status MigrationDestinationManager::abort(const MigrationSessionId& sessionId) {
@@ -768,7 +810,7 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* opCtx) {
             assertNotAborted(opCtx);
 
             write_ops::Insert insertOp(_nss);
-            insertOp.getWriteCommandBase().setOrdered(true);
+            insertOp.getWriteCommandBase().setOrdered(false);
             insertOp.setDocuments([&] {
                 std::vector<BSONObj> toInsert;
                 for (const auto& doc : arr) {
@@ -783,6 +825,18 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* opCtx) {
             const WriteResult reply = performInserts(opCtx, insertOp, true);
 
             for (unsigned long i = 0; i < reply.results.size(); ++i) {
+                // The donor streams the documents from an index scan, which may return a document
+                // a second time if it was moved within the index or re-inserted while the clone
+                // was running. Since every such write is also transferred as a modification once
+                // the clone completes, the duplicate can be skipped.
+                if (reply.results[i].getStatus() == ErrorCodes::DuplicateKey &&
+                    isDuplicateOfClonedDocument(
+                        opCtx, _nss, _min, _max, _shardKeyPattern, insertOp.getDocuments()[i])) {
+                    batchNumCloned--;
+                    batchClonedBytes -= insertOp.getDocuments()[i].objsize();
+                    continue;
+                }
+
                 uassertStatusOKWithContext(reply.results[i],
                                            str::stream() << "Insert of "
                                                          << redact(insertOp.getDocuments()[i])
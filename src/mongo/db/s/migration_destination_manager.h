@@ -115,6 +115,21 @@ public:
         stdx::function<void(OperationContext*, BSONObj)> insertBatchFn,
         stdx::function<BSONObj(OperationContext*)> fetchBatchFn);
 
+    /**
+     * Returns true if a clone insert of 'doc' which failed with DuplicateKey can be skipped,
+     * because this shard already holds a document with the same _id inside the incoming chunk
+     * range [min, max). Such a document was written while the clone was running, and the write is
+     * also transferred as a modification. Any other duplicate, such as a document with the same _id
+     * in a different chunk, must fail the migration, since skipping it would lose the document
+     * once the donor deletes the range.
+     */
+    static bool isDuplicateOfClonedDocument(OperationContext* opCtx,
+                                            const NamespaceString& nss,
+                                            const BSONObj& min,
+                                            const BSONObj& max,
+                                            const BSONObj& shardKeyPattern,
+                                            const BSONObj& doc);
+
     /**
      * Idempotent method, which causes the current ongoing migration to abort only if it has the
      * specified session id. If the migration is already aborted, does nothing.
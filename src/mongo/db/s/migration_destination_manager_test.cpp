@@ -28,8 +28,11 @@
 
 #include "mongo/platform/basic.h"
 
+#include "mongo/db/dbdirectclient.h"
 #include "mongo/db/s/migration_destination_manager.h"
+#include "mongo/db/server_parameters_test_util.h"
 #include "mongo/s/shard_server_test_fixture.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/unittest/unittest.h"
 
 namespace mongo {
@@ -104,6 +107,43 @@ TEST_F(MigrationDestinationManagerTest, CloneDocumentsFromDonorWorksCorrectly) {
     }
 }
 
+// Tests that with multiple inserter threads every fetched batch is inserted exactly once.
+TEST_F(MigrationDestinationManagerTest, CloneDocumentsFromDonorWithMultipleInserterThreads) {
+    ServerParameterControllerForTest insertionThreads("migrationCloneInsertionThreads", "4");
+
+    const int kNumBatches = 20;
+    int numBatchesFetched = 0;
+
+    auto fetchBatchFn = [&](OperationContext* opCtx) {
+        BSONArrayBuilder arrayBuilder;
+        if (numBatchesFetched < kNumBatches) {
+            for (int i = 0; i < 3; ++i) {
+                arrayBuilder.append(createDocument(numBatchesFetched * 3 + i));
+            }
+            numBatchesFetched++;
+        }
+
+        return BSON("objects" << arrayBuilder.arr());
+    };
+
+    stdx::mutex resultDocsMutex;
+    std::set<int> resultIds;
+
+    auto insertBatchFn = [&](OperationContext* opCtx, BSONObj docs) {
+        stdx::lock_guard<stdx::mutex> lk(resultDocsMutex);
+        for (auto&& docToClone : docs) {
+            ASSERT(resultIds.insert(docToClone.Obj()["_id"].numberInt()).second);
+        }
+    };
+
+    MigrationDestinationManager::cloneDocumentsFromDonor(
+        operationContext(), insertBatchFn, fetchBatchFn);
+
+    ASSERT_EQ(static_cast<size_t>(kNumBatches * 3), resultIds.size());
+    ASSERT_EQ(0, *resultIds.begin());
+    ASSERT_EQ(kNumBatches * 3 - 1, *resultIds.rbegin());
+}
+
 // Tests that an exception in the fetch logic will successfully throw an exception on the main
 // thread.
 TEST_F(MigrationDestinationManagerTest, CloneDocumentsThrowsFetchErrors) {
@@ -156,5 +196,29 @@ TEST_F(MigrationDestinationManagerTest, CloneDocumentsCatchesInsertErrors) {
     ASSERT_EQ(operationContext()->getKillStatus(), ErrorCodes::FailedToParse);
 }
 
+// Tests that a clone insert which fails with DuplicateKey is only skipped when this shard already
+// holds the document with the same _id inside the incoming chunk range.
+TEST_F(MigrationDestinationManagerTest, DuplicateIdIsOnlySkippedInsideIncomingRange) {
+    const NamespaceString nss("TestDB", "TestColl");
+    const BSONObj min = BSON("X" << 0);
+    const BSONObj max = BSON("X" << 10);
+    const BSONObj shardKeyPattern = BSON("X" << 1);
+
+    DBDirectClient client(operationContext());
+    client.insert(nss.ns(), {BSON("_id" << 1 << "X" << 5), BSON("_id" << 2 << "X" << 100)});
+
+    // Written to the incoming range while the clone was running
+    ASSERT_TRUE(MigrationDestinationManager::isDuplicateOfClonedDocument(
+        operationContext(), nss, min, max, shardKeyPattern, BSON("_id" << 1 << "X" << 5)));
+
+    // The _id collides with a document of a different chunk, which must fail the migration
+    ASSERT_FALSE(MigrationDestinationManager::isDuplicateOfClonedDocument(
+        operationContext(), nss, min, max, shardKeyPattern, BSON("_id" << 2 << "X" << 5)));
+
+    // The duplicate is on some other unique index
+    ASSERT_FALSE(MigrationDestinationManager::isDuplicateOfClonedDocument(
+        operationContext(), nss, min, max, shardKeyPattern, BSON("_id" << 3 << "X" << 5)));
+}
+
 }  // namespace
 }  // namespace mongo
@@ -0,0 +1,73 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * Sets a server parameter for the lifetime of this object and restores the value it had before
+ * on destruction, so a test does not leak its settings into the next one. Throws if the parameter
+ * rejects the new value, in which case nothing is changed.
+ */
+class ServerParameterControllerForTest {
+    MONGO_DISALLOW_COPYING(ServerParameterControllerForTest);
+
+public:
+    ServerParameterControllerForTest(StringData name, StringData value) {
+        const auto& map = ServerParameterSet::getGlobal()->getMap();
+        auto it = map.find(name.toString());
+        invariant(it != map.end());
+        _param = it->second;
+
+        BSONObjBuilder oldValue;
+        _param->append(nullptr, oldValue, _param->name());
+        _oldValue = oldValue.obj();
+
+        uassertStatusOK(_param->setFromString(value.toString()));
+    }
+
+    ~ServerParameterControllerForTest() {
+        invariant(_param->set(_oldValue.firstElement()));
+    }
+
+private:
+    ServerParameter* _param;
+    BSONObj _oldValue;
+};
+
+}  // namespace mongo
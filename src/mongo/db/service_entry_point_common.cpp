@@ -43,6 +43,7 @@
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/client.h"
 #include "mongo/db/command_can_run_here.h"
+#include "mongo/db/command_generic_argument.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/test_commands_enabled.h"
 #include "mongo/db/concurrency/global_lock_acquisition_tracker.h"
@@ -112,39 +113,6 @@ const std::string CUSTOM_USER = "rwuser@admin";
 namespace {
 using logger::LogComponent;
 
-// The command names for which to check out a session. These are commands that support retryable
-// writes, readConcern snapshot, or multi-statement transactions. We additionally check out the
-// session for commands that can take a lock and then run another whitelisted command in
-// DBDirectClient. Otherwise, the nested command would try to check out a session under a lock,
-// which is not allowed.
-const StringMap<int> sessionCheckoutWhitelist = {{"abortTransaction", 1},
-                                                 {"aggregate", 1},
-                                                 {"applyOps", 1},
-                                                 {"commitTransaction", 1},
-                                                 {"count", 1},
-                                                 {"dbHash", 1},
-                                                 {"delete", 1},
-                                                 {"distinct", 1},
-                                                 {"doTxn", 1},
-                                                 {"eval", 1},
-                                                 {"$eval", 1},
-                                                 {"explain", 1},
-                                                 {"filemd5", 1},
-                                                 {"find", 1},
-                                                 {"findandmodify", 1},
-                                                 {"findAndModify", 1},
-                                                 {"geoNear", 1},
-                                                 {"geoSearch", 1},
-                                                 {"getMore", 1},
-                                                 {"group", 1},
-                                                 {"insert", 1},
-                                                 {"killCursors", 1},
-                                                 {"mapReduce", 1},
-                                                 {"parallelCollectionScan", 1},
-                                                 {"prepareTransaction", 1},
-                                                 {"refreshLogicalSessionCacheNow", 1},
-                                                 {"update", 1}};
-
 bool shouldActivateFailCommandFailPoint(const BSONObj& data, StringData cmdName) {
     if (cmdName == "configureFailPoint"_sd)  // Banned even if in failCommands.
         return false;
@@ -335,11 +303,11 @@ void appendReplyMetadata(OperationContext* opCtx,
  * if the read concern is not valid for the command.
  */
 StatusWith<repl::ReadConcernArgs> _extractReadConcern(const CommandInvocation* invocation,
-                                                      const BSONObj& cmdObj,
+                                                      const BSONElement& readConcernElem,
                                                       bool upconvertToSnapshot) {
     repl::ReadConcernArgs readConcernArgs;
 
-    auto readConcernParseStatus = readConcernArgs.initialize(cmdObj);
+    auto readConcernParseStatus = readConcernArgs.initialize(readConcernElem);
     if (!readConcernParseStatus.isOK()) {
         return readConcernParseStatus;
     }
@@ -645,6 +613,7 @@ void execCommandDatabase(OperationContext* opCtx,
     auto startOperationTime = getClientOperationTime(opCtx);
     auto invocation = command->parse(opCtx, request);
     boost::optional<OperationSessionInfoFromClient> sessionOptions = boost::none;
+    GenericArguments genericArgs;
 
     try {
         {
@@ -652,11 +621,18 @@ void execCommandDatabase(OperationContext* opCtx,
             CurOp::get(opCtx)->setCommand_inlock(command);
         }
 
+        // Find all of the generic arguments in one pass over the body, rather than looking each
+        // of them up as it is needed.
+        genericArgs = GenericArguments::parse(request.body);
+        uassert(ErrorCodes::InvalidOptions,
+                "no such command option $maxTimeMs; use maxTimeMS instead",
+                !genericArgs.queryOptionMaxTimeMS);
+
         // TODO: move this back to runCommands when mongos supports OperationContext
         // see SERVER-18515 for details.
-        rpc::readRequestMetadata(opCtx, request.body, command->requiresAuth());
+        rpc::readRequestMetadata(opCtx, genericArgs, command->requiresAuth());
         rpc::TrackingMetadata::get(opCtx).initWithOperName(command->getName());
-        if (request.body.hasField("customerCmd")) {
+        if (genericArgs.customerCmd) {
             opCtx->setCustomerTxn();
         }
         auto const replCoord = repl::ReplicationCoordinator::get(opCtx);
@@ -679,8 +655,8 @@ void execCommandDatabase(OperationContext* opCtx,
         // servers may result in a deadlock when a server tries to check out a session it is already
         // using to service an earlier operation in the command's chain. To avoid this, only check
         // out sessions for commands that require them.
-        const bool shouldCheckoutSession = static_cast<bool>(opCtx->getTxnNumber()) &&
-            sessionCheckoutWhitelist.find(command->getName()) != sessionCheckoutWhitelist.cend();
+        const bool shouldCheckoutSession =
+            static_cast<bool>(opCtx->getTxnNumber()) && command->shouldCheckoutSession();
 
         // Parse the arguments specific to multi-statement transactions.
         boost::optional<bool> startMultiDocTxn = boost::none;
@@ -688,7 +664,7 @@ void execCommandDatabase(OperationContext* opCtx,
         if (sessionOptions) {
             startMultiDocTxn = sessionOptions->getStartTransaction();
             autocommitVal = sessionOptions->getAutocommit();
-            if (command->getName() == "doTxn") {
+            if (command->isDoTxn()) {
                 // Autocommit and 'startMultiDocTxn' are overridden for 'doTxn' to get the oplog
                 // entry generation behavior used for multi-document transactions. The 'doTxn'
                 // command still logically behaves as a commit.
@@ -705,7 +681,7 @@ void execCommandDatabase(OperationContext* opCtx,
             uassert(ErrorCodes::OperationNotSupportedInTransaction,
                     str::stream() << "It is illegal to run command " << command->getName()
                                   << " in a multi-document transaction.",
-                    shouldCheckoutSession || !autocommitVal || command->getName() == "doTxn");
+                    shouldCheckoutSession || !autocommitVal || command->isDoTxn());
             uassert(50768,
                     str::stream() << "It is illegal to provide a txnNumber for command "
                                   << command->getName(),
@@ -724,31 +700,7 @@ void execCommandDatabase(OperationContext* opCtx,
 
         std::unique_ptr<MaintenanceModeSetter> mmSetter;
 
-        BSONElement cmdOptionMaxTimeMSField;
-        BSONElement allowImplicitCollectionCreationField;
-        BSONElement helpField;
-
-        StringMap<int> topLevelFields;
-        for (auto&& element : request.body) {
-            StringData fieldName = element.fieldNameStringData();
-            if (fieldName == QueryRequest::cmdOptionMaxTimeMS) {
-                cmdOptionMaxTimeMSField = element;
-            } else if (fieldName == "allowImplicitCollectionCreation") {
-                allowImplicitCollectionCreationField = element;
-            } else if (fieldName == CommandHelpers::kHelpFieldName) {
-                helpField = element;
-            } else if (fieldName == QueryRequest::queryOptionMaxTimeMS) {
-                uasserted(ErrorCodes::InvalidOptions,
-                          "no such command option $maxTimeMs; use maxTimeMS instead");
-            }
-
-            uassert(ErrorCodes::FailedToParse,
-                    str::stream() << "Parsed command object contains duplicate top level key: "
-                                  << fieldName,
-                    topLevelFields[fieldName]++ == 0);
-        }
-
-        if (CommandHelpers::isHelpRequest(helpField)) {
+        if (CommandHelpers::isHelpRequest(genericArgs.help)) {
             CurOp::get(opCtx)->ensureStarted();
             // We disable last-error for help requests due to SERVER-11492, because config servers
             // use help requests to determine which commands are database writes, and so must be
@@ -820,7 +772,7 @@ void execCommandDatabase(OperationContext* opCtx,
         // require introducing a new 'max await time' parameter for getMore, and eventually banning
         // maxTimeMS altogether on a getMore command.
         const int maxTimeMS =
-            uassertStatusOK(QueryRequest::parseMaxTimeMS(cmdOptionMaxTimeMSField));
+            uassertStatusOK(QueryRequest::parseMaxTimeMS(genericArgs.maxTimeMS));
         if (maxTimeMS > 0 && command->getLogicalOp() != LogicalOp::opGetMore) {
             uassert(40119,
                     "Illegal attempt to set operation deadline within DBDirectClient",
@@ -835,8 +787,8 @@ void execCommandDatabase(OperationContext* opCtx,
             const bool upconvertToSnapshot = session && session->inMultiDocumentTransaction() &&
                 sessionOptions &&
                 (sessionOptions->getStartTransaction() == boost::optional<bool>(true));
-            readConcernArgs = uassertStatusOK(
-                _extractReadConcern(invocation.get(), request.body, upconvertToSnapshot));
+            readConcernArgs = uassertStatusOK(_extractReadConcern(
+                invocation.get(), genericArgs.readConcern, upconvertToSnapshot));
         }
 
         if (readConcernArgs.getArgsAtClusterTime()) {
@@ -877,7 +829,7 @@ void execCommandDatabase(OperationContext* opCtx,
             rpc::advanceConfigOptimeFromRequestMetadata(opCtx);
         }
 
-        oss.setAllowImplicitCollectionCreation(allowImplicitCollectionCreationField);
+        oss.setAllowImplicitCollectionCreation(genericArgs.allowImplicitCollectionCreation);
         ScopedOperationCompletionShardingActions operationCompletionShardingActions(opCtx);
 
         // This may trigger the maxTimeAlwaysTimeOut failpoint.
@@ -955,7 +907,8 @@ void execCommandDatabase(OperationContext* opCtx,
         // parse it here, so if it is valid it can be used to compute the proper operationTime.
         auto& readConcernArgs = repl::ReadConcernArgs::get(opCtx);
         if (readConcernArgs.isEmpty()) {
-            auto readConcernArgsStatus = _extractReadConcern(invocation.get(), request.body, false);
+            auto readConcernArgsStatus =
+                _extractReadConcern(invocation.get(), genericArgs.readConcern, false);
             if (readConcernArgsStatus.isOK()) {
                 readConcernArgs = readConcernArgsStatus.getValue();
             }
@@ -993,8 +946,9 @@ DbResponse receivedCommands(OperationContext* opCtx,
                             const Message& message,
                             const ServiceEntryPointCommon::Hooks& behaviors) {
     auto replyBuilder = rpc::makeReplyBuilder(rpc::protocolForMessage(message));
+    OpMsgRequest request;
+    bool parsed = false;
     [&] {
-        OpMsgRequest request;
         try {  // Parse.
             request = rpc::opMsgRequestFromAnyProtocol(message);
         } catch (const DBException& ex) {
@@ -1020,6 +974,8 @@ DbResponse receivedCommands(OperationContext* opCtx,
             return;  // From lambda. Don't try executing if parsing failed.
         }
 
+        parsed = true;
+
         try {  // Execute.
             curOpCommandSetup(opCtx, request);
 
@@ -1074,8 +1030,16 @@ DbResponse receivedCommands(OperationContext* opCtx,
     auto response = replyBuilder->done();
     CurOp::get(opCtx)->debug().responseLength = response.header().dataLen();
 
-    // TODO exhaust
-    return DbResponse{std::move(response)};
+    DbResponse dbResponse{std::move(response)};
+    if (parsed && OpMsg::isFlagSet(message, OpMsg::kExhaustAllowed)) {
+        dbResponse.nextInvocation =
+            ServiceEntryPointCommon::makeExhaustGetMore(request, dbResponse.response);
+        if (!dbResponse.nextInvocation.isEmpty()) {
+            CurOp::get(opCtx)->debug().exhaust = true;
+        }
+    }
+
+    return dbResponse;
 }
 
 DbResponse receivedQuery(OperationContext* opCtx,
@@ -1455,6 +1419,65 @@ BSONObj ServiceEntryPointCommon::getRedactedCopyForLogging(const Command* comman
     return bob.obj();
 }
 
+BSONObj ServiceEntryPointCommon::makeExhaustGetMore(const OpMsgRequest& request,
+                                                    const Message& response) {
+    const auto commandName = request.getCommandName();
+    const bool isGetMore = (commandName == "getMore"_sd);
+    const bool isAggregate = (commandName == "aggregate"_sd);
+    if (!isGetMore && !isAggregate && commandName != "find"_sd)
+        return {};
+
+    // Cursors of multi-statement transactions are continued by the client as part of the
+    // transaction.
+    if (request.body.hasField(OperationSessionInfo::kTxnNumberFieldName))
+        return {};
+
+    const auto reply = OpMsg::parse(response).body;
+    if (!reply["ok"].trueValue())
+        return {};
+
+    const auto cursor = reply["cursor"];
+    if (cursor.type() != Object || cursor["id"].numberLong() == 0)
+        return {};
+
+    // Streaming the empty batches of a tailable cursor would only spin this thread, so the client
+    // continues such a cursor once it has data.
+    const auto batch = cursor[isGetMore ? "nextBatch" : "firstBatch"];
+    if (batch.type() != Array || batch.Obj().isEmpty())
+        return {};
+
+    if (isGetMore)
+        return request.body.getOwned();
+
+    BSONObjBuilder getMoreBuilder;
+    getMoreBuilder.append("getMore", cursor["id"].numberLong());
+    getMoreBuilder.append("collection", NamespaceString(cursor["ns"].str()).coll());
+
+    // The batch size of an aggregate is given in its cursor options. A batch size of zero only
+    // applies to the first batch, and getMore rejects it.
+    const auto batchSize =
+        isAggregate ? request.body["cursor"]["batchSize"] : request.body["batchSize"];
+    if (batchSize.isNumber() && batchSize.numberLong() > 0)
+        getMoreBuilder.append("batchSize", batchSize.numberLong());
+
+    // getMore only accepts maxTimeMS for awaitData cursors, where it bounds the wait for new
+    // results. The remaining time limit of any other cursor carries over to its getMores already.
+    const bool isAwaitData = isAggregate
+        ? request.body["pipeline"]["0"]["$changeStream"].type() == Object
+        : request.body["tailable"].trueValue() && request.body["awaitData"].trueValue();
+    const auto maxTimeMS = request.body["maxTimeMS"];
+    if (isAwaitData && maxTimeMS.isNumber() && maxTimeMS.numberLong() > 0)
+        getMoreBuilder.append("maxTimeMS", maxTimeMS.numberLong());
+
+    for (auto&& elem : request.body) {
+        const auto fieldName = elem.fieldNameStringData();
+        if (fieldName == "$db"_sd || fieldName == OperationSessionInfo::kSessionIdFieldName) {
+            getMoreBuilder.append(elem);
+        }
+    }
+    return getMoreBuilder.obj();
+}
+
 DbResponse ServiceEntryPointCommon::handleRequest(OperationContext* opCtx,
                                                   const Message& m,
                                                   const Hooks& behaviors) {
@@ -81,6 +81,14 @@ struct ServiceEntryPointCommon {
      * `command->redactForLogging`.
      */
     static BSONObj getRedactedCopyForLogging(const Command* command, const BSONObj& cmdObj);
+
+    /**
+     * Returns the getMore command which streams the next batch of the cursor that 'request' opened
+     * or continued, or an empty object if 'response' is an error, the cursor is exhausted or
+     * 'request' does not return a cursor which can be streamed. The getMore keeps the database,
+     * session, batch size and, for awaitData cursors, the maxTimeMS of 'request'.
+     */
+    static BSONObj makeExhaustGetMore(const OpMsgRequest& request, const Message& response);
 };
 
 }  // namespace mongo
@@ -0,0 +1,156 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/service_entry_point_common.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const long long kCursorId = 123;
+
+Message makeCursorReply(long long cursorId, StringData batchField, BSONArray batch) {
+    OpMsg reply;
+    reply.body = BSON("cursor" << BSON("id" << cursorId << "ns"
+                                            << "test.coll"
+                                            << batchField
+                                            << batch)
+                               << "ok"
+                               << 1);
+    return reply.serialize();
+}
+
+Message makeFirstBatchReply(long long cursorId = kCursorId) {
+    return makeCursorReply(cursorId, "firstBatch", BSON_ARRAY(BSON("_id" << 1)));
+}
+
+BSONObj makeExhaustGetMore(BSONObj body, const Message& reply = makeFirstBatchReply()) {
+    return ServiceEntryPointCommon::makeExhaustGetMore(
+        OpMsgRequest::fromDBAndBody("test", std::move(body)), reply);
+}
+
+TEST(MakeExhaustGetMoreTest, FindCarriesOverDatabaseSessionAndBatchSize) {
+    const auto lsid = BSON("id" << 1);
+    const auto getMore = makeExhaustGetMore(BSON("find"
+                                                 << "coll"
+                                                 << "filter"
+                                                 << BSON("a" << 1)
+                                                 << "batchSize"
+                                                 << 2
+                                                 << "lsid"
+                                                 << lsid));
+    ASSERT_BSONOBJ_EQ(getMore,
+                      BSON("getMore" << kCursorId << "collection"
+                                     << "coll"
+                                     << "batchSize"
+                                     << 2LL
+                                     << "lsid"
+                                     << lsid
+                                     << "$db"
+                                     << "test"));
+}
+
+TEST(MakeExhaustGetMoreTest, AggregateTakesBatchSizeFromCursorOptions) {
+    const auto getMore = makeExhaustGetMore(BSON("aggregate"
+                                                 << "coll"
+                                                 << "pipeline"
+                                                 << BSONArray()
+                                                 << "cursor"
+                                                 << BSON("batchSize" << 5)));
+    ASSERT_BSONOBJ_EQ(getMore,
+                      BSON("getMore" << kCursorId << "collection"
+                                     << "coll"
+                                     << "batchSize"
+                                     << 5LL
+                                     << "$db"
+                                     << "test"));
+}
+
+TEST(MakeExhaustGetMoreTest, MaxTimeMSIsOnlyCarriedOverForAwaitDataCursors) {
+    auto getMore = makeExhaustGetMore(BSON("find"
+                                           << "coll"
+                                           << "maxTimeMS"
+                                           << 100));
+    ASSERT_FALSE(getMore.hasField("maxTimeMS"));
+
+    getMore = makeExhaustGetMore(BSON("find"
+                                      << "coll"
+                                      << "tailable"
+                                      << true
+                                      << "awaitData"
+                                      << true
+                                      << "maxTimeMS"
+                                      << 100));
+    ASSERT_EQ(getMore["maxTimeMS"].numberLong(), 100);
+
+    getMore = makeExhaustGetMore(BSON("aggregate"
+                                      << "coll"
+                                      << "pipeline"
+                                      << BSON_ARRAY(BSON("$changeStream" << BSONObj()))
+                                      << "cursor"
+                                      << BSONObj()
+                                      << "maxTimeMS"
+                                      << 100));
+    ASSERT_EQ(getMore["maxTimeMS"].numberLong(), 100);
+}
+
+TEST(MakeExhaustGetMoreTest, GetMoreIsRepeated) {
+    const auto request = BSON("getMore" << kCursorId << "collection"
+                                        << "coll"
+                                        << "batchSize"
+                                        << 2);
+    const auto getMore = makeExhaustGetMore(
+        request, makeCursorReply(kCursorId, "nextBatch", BSON_ARRAY(BSON("_id" << 2))));
+    ASSERT_BSONOBJ_EQ(getMore, OpMsgRequest::fromDBAndBody("test", request).body);
+}
+
+TEST(MakeExhaustGetMoreTest, DoesNotStreamExhaustedOrEmptyCursors) {
+    const auto find = BSON("find"
+                           << "coll");
+    ASSERT_TRUE(makeExhaustGetMore(find, makeFirstBatchReply(0)).isEmpty());
+    ASSERT_TRUE(
+        makeExhaustGetMore(find, makeCursorReply(kCursorId, "firstBatch", BSONArray())).isEmpty());
+}
+
+TEST(MakeExhaustGetMoreTest, DoesNotStreamUnsupportedCommandsOrTransactions) {
+    ASSERT_TRUE(makeExhaustGetMore(BSON("count"
+                                        << "coll"))
+                    .isEmpty());
+    ASSERT_TRUE(makeExhaustGetMore(BSON("find"
+                                        << "coll"
+                                        << "txnNumber"
+                                        << 1LL))
+                    .isEmpty());
+}
+
+}  // namespace
+}  // namespace mongo
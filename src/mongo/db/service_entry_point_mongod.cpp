@@ -32,6 +32,7 @@
 
 #include "mongo/db/service_entry_point_mongod.h"
 
+#include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/commands/fsync_locked.h"
 #include "mongo/db/concurrency/global_lock_acquisition_tracker.h"
 #include "mongo/db/curop.h"
@@ -123,4 +124,11 @@ DbResponse ServiceEntryPointMongod::handleRequest(OperationContext* opCtx, const
     return ServiceEntryPointCommon::handleRequest(opCtx, m, Hooks{});
 }
 
+void ServiceEntryPointMongod::preparePipelinedClient(OperationContext* opCtx,
+                                                     Client* connectionClient) {
+    uassertStatusOK(AuthorizationSession::get(opCtx->getClient())
+                        ->inheritAuthenticatedUsers(opCtx,
+                                                    AuthorizationSession::get(connectionClient)));
+}
+
 }  // namespace mongo
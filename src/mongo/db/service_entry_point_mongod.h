@@ -42,6 +42,7 @@ class ServiceEntryPointMongod final : public ServiceEntryPointImpl {
 public:
     using ServiceEntryPointImpl::ServiceEntryPointImpl;
     DbResponse handleRequest(OperationContext* opCtx, const Message& request) override;
+    void preparePipelinedClient(OperationContext* opCtx, Client* connectionClient) override;
 
 private:
     class Hooks;
@@ -364,6 +364,89 @@ private:
     AtomicWord<std::uint64_t> _lastStableCheckpointTimestamp;
 };
 
+/**
+ * Writes dirty size storer entries back to the size storer table, a batch at a time, so that
+ * collection size bookkeeping never has to be flushed inline by user operations. A flush starts
+ * when requested, or after a minute without a request, which is the cadence at which sessions used
+ * to flush the size storer themselves. Its batches are then spread over as many seconds as needed.
+ */
+class WiredTigerKVEngine::WiredTigerSizeStorerFlusher : public BackgroundJob {
+public:
+    explicit WiredTigerSizeStorerFlusher(WiredTigerSizeStorer* sizeStorer)
+        : BackgroundJob(false /* deleteSelf */), _sizeStorer(sizeStorer) {}
+
+    virtual string name() const {
+        return "WTSizeStorerFlusher";
+    }
+
+    virtual void run() {
+        Client::initThread(name().c_str());
+        ON_BLOCK_EXIT([] { Client::destroy(); });
+
+        LOG(1) << "starting " << name() << " thread";
+
+        const auto flushInterval = stdx::chrono::seconds(60);
+        const auto passInterval = stdx::chrono::milliseconds(1000);
+        const int maxBatchesPerPass = 10;
+
+        bool flushed = true;
+        while (!_shuttingDown.load()) {
+            {
+                stdx::unique_lock<stdx::mutex> lock(_mutex);
+                MONGO_IDLE_THREAD_BLOCK;
+                _condvar.wait_for(lock, flushed ? flushInterval : passInterval, [this] {
+                    return _flushRequested || _shuttingDown.load();
+                });
+                _flushRequested = false;
+            }
+
+            // Bound the work done per pass, so a large number of dirty collections is written
+            // back over several passes rather than in one long burst.
+            flushed = false;
+            try {
+                for (int i = 0; i < maxBatchesPerPass && !_shuttingDown.load(); ++i) {
+                    if (_sizeStorer->flushBatch(WiredTigerSizeStorer::kFlushBatchSize) == 0) {
+                        flushed = true;
+                        break;
+                    }
+                }
+            } catch (const WriteConflictException&) {
+                // Ignore, the entries were placed back into the buffer and we'll try again later.
+            } catch (const AssertionException& exc) {
+                invariant(ErrorCodes::isShutdownError(exc.code()), exc.what());
+            }
+        }
+        LOG(1) << "stopping " << name() << " thread";
+    }
+
+    void shutdown() {
+        _shuttingDown.store(true);
+        {
+            stdx::unique_lock<stdx::mutex> lock(_mutex);
+            _condvar.notify_one();
+        }
+        wait();
+    }
+
+    /**
+     * Starts a flush now rather than at the end of the current interval.
+     */
+    void requestFlush() {
+        stdx::lock_guard<stdx::mutex> lock(_mutex);
+        _flushRequested = true;
+        _condvar.notify_one();
+    }
+
+private:
+    WiredTigerSizeStorer* _sizeStorer;
+
+    // _mutex/_condvar used to notify when _shuttingDown or _flushRequested is flipped.
+    stdx::mutex _mutex;
+    stdx::condition_variable _condvar;
+    AtomicBool _shuttingDown{false};
+    bool _flushRequested = false;  // Guarded by _mutex.
+};
+
 namespace {
 
 class TicketServerParameter : public ServerParameter {
@@ -555,6 +638,10 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
     }
 
     _sizeStorer = std::make_unique<WiredTigerSizeStorer>(_conn, _sizeStorerUri, _readOnly);
+    if (!_readOnly) {
+        _sizeStorerFlusher = std::make_unique<WiredTigerSizeStorerFlusher>(_sizeStorer.get());
+        _sizeStorerFlusher->go();
+    }
 
     Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
 }
@@ -647,6 +734,8 @@ void WiredTigerKVEngine::_openWiredTiger(const std::string& path, const std::str
 
 void WiredTigerKVEngine::cleanShutdown() {
     log() << "WiredTigerKVEngine shutting down";
+    if (_sizeStorerFlusher)
+        _sizeStorerFlusher->shutdown();
     if (!_readOnly)
         syncSizeInfo(true);
     if (!_conn) {
@@ -1171,9 +1260,9 @@ bool WiredTigerKVEngine::haveDropsQueued() const {
     Date_t now = _clockSource->now();
     Milliseconds delta = now - _previousCheckedDropsQueued;
 
-    if (!_readOnly && _sizeStorerSyncTracker.intervalHasElapsed()) {
+    if (_sizeStorerFlusher && _sizeStorerSyncTracker.intervalHasElapsed()) {
         _sizeStorerSyncTracker.resetLastTime();
-        syncSizeInfo(false);
+        _sizeStorerFlusher->requestFlush();
     }
 
     // We only want to check the queue max once per second or we'll thrash
@@ -1487,6 +1576,8 @@ StatusWith<Timestamp> WiredTigerKVEngine::recoverToStableTimestamp(OperationCont
     }
 
     LOG_FOR_ROLLBACK(2) << "WiredTiger::RecoverToStableTimestamp syncing size storer to disk.";
+    if (_sizeStorerFlusher)
+        _sizeStorerFlusher->shutdown();
     syncSizeInfo(true);
 
     LOG_FOR_ROLLBACK(2)
@@ -1514,6 +1605,10 @@ StatusWith<Timestamp> WiredTigerKVEngine::recoverToStableTimestamp(OperationCont
     _checkpointThread->go();
 
     _sizeStorer = std::make_unique<WiredTigerSizeStorer>(_conn, _sizeStorerUri, _readOnly);
+    if (!_readOnly) {
+        _sizeStorerFlusher = std::make_unique<WiredTigerSizeStorerFlusher>(_sizeStorer.get());
+        _sizeStorerFlusher->go();
+    }
 
     return {stableTimestamp};
 }
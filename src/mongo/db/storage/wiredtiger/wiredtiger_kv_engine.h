@@ -291,6 +291,7 @@ public:
 private:
     class WiredTigerJournalFlusher;
     class WiredTigerCheckpointThread;
+    class WiredTigerSizeStorerFlusher;
 
     /**
      * Opens a connection on the WiredTiger database 'path' with the configuration 'wtOpenConfig'.
@@ -350,6 +351,7 @@ private:
 
     std::unique_ptr<WiredTigerJournalFlusher> _journalFlusher;  // Depends on _sizeStorer
     std::unique_ptr<WiredTigerCheckpointThread> _checkpointThread;
+    std::unique_ptr<WiredTigerSizeStorerFlusher> _sizeStorerFlusher;  // Depends on _sizeStorer
 
     std::string _rsOptions;
     std::string _indexOptions;
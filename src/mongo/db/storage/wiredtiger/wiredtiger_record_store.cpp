@@ -111,7 +111,7 @@ public:
 
         _oplogStones->_currentRecords.addAndFetch(_countInserted);
         int64_t newCurrentBytes = _oplogStones->_currentBytes.addAndFetch(_bytesInserted);
-        if (newCurrentBytes >= _oplogStones->_minBytesPerStone) {
+        if (newCurrentBytes >= _oplogStones->_minBytesPerStone.load()) {
             _oplogStones->createNewStoneIfNeeded(_highestInserted);
         }
     }
@@ -135,6 +135,7 @@ public:
 
         stdx::lock_guard<stdx::mutex> lk(_oplogStones->_mutex);
         _oplogStones->_stones.clear();
+        _oplogStones->_stonesBytes = 0;
     }
 
     void rollback() final {}
@@ -149,15 +150,8 @@ WiredTigerRecordStore::OplogStones::OplogStones(OperationContext* opCtx, WiredTi
 
     invariant(rs->isCapped());
     invariant(rs->cappedMaxSize() > 0);
-    unsigned long long maxSize = rs->cappedMaxSize();
-
-    const unsigned long long kMinStonesToKeep = 10ULL;
-    const unsigned long long kMaxStonesToKeep = 100ULL;
-
-    unsigned long long numStones = maxSize / BSONObjMaxInternalSize;
-    size_t numStonesToKeep = std::min(kMaxStonesToKeep, std::max(kMinStonesToKeep, numStones));
-    _minBytesPerStone = maxSize / numStonesToKeep;
-    invariant(_minBytesPerStone > 0);
+    size_t numStonesToKeep = _setStoneSizeBounds_inlock(rs->cappedMaxSize());
+    _lastStoneCreated = Date_t::now();
 
     _calculateStones(opCtx, numStonesToKeep);
     _pokeReclaimThreadIfNeeded();  // Reclaim stones if over the limit.
@@ -204,6 +198,13 @@ void WiredTigerRecordStore::OplogStones::awaitHasExcessStonesOrDead() {
     }
 }
 
+bool WiredTigerRecordStore::OplogStones::isFarOverMaxSize() const {
+    // Tolerate up to 10% of excess before truncating without pausing between stones.
+    const int64_t maxSize = _rs->cappedMaxSize();
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _stonesBytes > maxSize + maxSize / 10;
+}
+
 boost::optional<WiredTigerRecordStore::OplogStones::Stone>
 WiredTigerRecordStore::OplogStones::peekOldestStoneIfNeeded() const {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
@@ -217,6 +218,7 @@ WiredTigerRecordStore::OplogStones::peekOldestStoneIfNeeded() const {
 
 void WiredTigerRecordStore::OplogStones::popOldestStone() {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _stonesBytes -= _stones.front().bytes;
     _stones.pop_front();
 }
 
@@ -228,7 +230,7 @@ void WiredTigerRecordStore::OplogStones::createNewStoneIfNeeded(RecordId lastRec
         return;
     }
 
-    if (_currentBytes.load() < _minBytesPerStone) {
+    if (_currentBytes.load() < _minBytesPerStone.load()) {
         // Must have raced to create a new stone, someone else already triggered it.
         return;
     }
@@ -243,6 +245,11 @@ void WiredTigerRecordStore::OplogStones::createNewStoneIfNeeded(RecordId lastRec
     LOG(2) << "create new oplogStone, current stones:" << _stones.size();
     OplogStones::Stone stone = {_currentRecords.swap(0), _currentBytes.swap(0), lastRecord};
     _stones.push_back(stone);
+    _stonesBytes += stone.bytes;
+
+    const Date_t now = Date_t::now();
+    _adaptMinBytesPerStone_inlock(stone.bytes, now - _lastStoneCreated);
+    _lastStoneCreated = now;
 
     _pokeReclaimThreadIfNeeded();
 }
@@ -282,6 +289,7 @@ void WiredTigerRecordStore::OplogStones::updateStonesAfterCappedTruncateAfter(
     // Remove the stones corresponding to the records that were deleted.
     int64_t offset = _stones.size() - numStonesToRemove;
     _stones.erase(_stones.begin() + offset, _stones.end());
+    _stonesBytes -= bytesInStonesToRemove;
 
     // Account for any remaining records from a partially truncated stone in the stone currently
     // being filled.
@@ -296,7 +304,38 @@ void WiredTigerRecordStore::OplogStones::setMinBytesPerStone(int64_t size) {
 
     // Only allow changing the minimum bytes per stone if no data has been inserted.
     invariant(_stones.size() == 0 && _currentRecords.load() == 0);
-    _minBytesPerStone = size;
+    _minBytesPerStone.store(size);
+    _adaptiveStoneSizing = false;
+}
+
+void WiredTigerRecordStore::OplogStones::recordTruncation(Microseconds duration) {
+    const long long micros = durationCount<Microseconds>(duration);
+    _truncateCount.fetchAndAdd(1);
+    _totalTimeTruncatingMicros.fetchAndAdd(micros);
+
+    long long maxMicros = _maxTruncateMicros.load();
+    while (micros > maxMicros) {
+        const long long prev = _maxTruncateMicros.compareAndSwap(maxMicros, micros);
+        if (prev == maxMicros)
+            break;
+        maxMicros = prev;
+    }
+}
+
+void WiredTigerRecordStore::OplogStones::appendStats(BSONObjBuilder* builder) const {
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        builder->append("numStones", static_cast<long long>(_stones.size()));
+        builder->append("stonesBytes", static_cast<long long>(_stonesBytes));
+        builder->append("minBytesPerStone", static_cast<long long>(_minBytesPerStone.load()));
+        builder->append("adaptiveStoneSizing", _adaptiveStoneSizing);
+    }
+    builder->append("currentStoneRecords", static_cast<long long>(_currentRecords.load()));
+    builder->append("currentStoneBytes", static_cast<long long>(_currentBytes.load()));
+    builder->append("truncateCount", static_cast<long long>(_truncateCount.load()));
+    builder->append("totalTimeTruncatingMicros",
+                    static_cast<long long>(_totalTimeTruncatingMicros.load()));
+    builder->append("maxTruncateMicros", static_cast<long long>(_maxTruncateMicros.load()));
 }
 
 void WiredTigerRecordStore::OplogStones::_calculateStones(OperationContext* opCtx,
@@ -323,7 +362,7 @@ void WiredTigerRecordStore::OplogStones::_calculateStones(OperationContext* opCt
     // Use the oplog's average record size to estimate the number of records in each stone, and thus
     // estimate the combined size of the records.
     double avgRecordSize = double(dataSize) / double(numRecords);
-    double estRecordsPerStone = std::ceil(_minBytesPerStone / avgRecordSize);
+    double estRecordsPerStone = std::ceil(_minBytesPerStone.load() / avgRecordSize);
     double estBytesPerStone = estRecordsPerStone * avgRecordSize;
 
     _calculateStonesBySampling(opCtx, int64_t(estRecordsPerStone), int64_t(estBytesPerStone));
@@ -339,12 +378,13 @@ void WiredTigerRecordStore::OplogStones::_calculateStonesByScanning(OperationCon
     while (auto record = cursor->next()) {
         _currentRecords.addAndFetch(1);
         int64_t newCurrentBytes = _currentBytes.addAndFetch(record->data.size());
-        if (newCurrentBytes >= _minBytesPerStone) {
+        if (newCurrentBytes >= _minBytesPerStone.load()) {
             LOG(1) << "Placing a marker at optime "
                    << Timestamp(record->id.repr()).toStringPretty();
 
             OplogStones::Stone stone = {_currentRecords.swap(0), _currentBytes.swap(0), record->id};
             _stones.push_back(stone);
+            _stonesBytes += stone.bytes;
         }
 
         numRecords++;
@@ -430,6 +470,7 @@ void WiredTigerRecordStore::OplogStones::_calculateStonesBySampling(OperationCon
         log() << "Placing a marker at optime " << Timestamp(lastRecord.repr()).toStringPretty();
         OplogStones::Stone stone = {estRecordsPerStone, estBytesPerStone, lastRecord};
         _stones.push_back(stone);
+        _stonesBytes += stone.bytes;
     }
 
     // Account for the partially filled chunk.
@@ -445,14 +486,53 @@ void WiredTigerRecordStore::OplogStones::_pokeReclaimThreadIfNeeded() {
 
 void WiredTigerRecordStore::OplogStones::adjust(int64_t maxSize) {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _setStoneSizeBounds_inlock(maxSize);
+    _pokeReclaimThreadIfNeeded();
+}
+
+size_t WiredTigerRecordStore::OplogStones::_setStoneSizeBounds_inlock(int64_t maxSize) {
     const unsigned long long kMinStonesToKeep = 10ULL;
     const unsigned long long kMaxStonesToKeep = 100ULL;
 
+    // When adapting to a low insert rate, keep up to this many stones, so that each truncation
+    // removes a smaller range of the oplog.
+    const unsigned long long kMaxAdaptiveStonesToKeep = 1000ULL;
+
     unsigned long long numStones = maxSize / BSONObjMaxInternalSize;
     size_t numStonesToKeep = std::min(kMaxStonesToKeep, std::max(kMinStonesToKeep, numStones));
-    _minBytesPerStone = maxSize / numStonesToKeep;
-    invariant(_minBytesPerStone > 0);
-    _pokeReclaimThreadIfNeeded();
+    _minBytesPerStone.store(maxSize / numStonesToKeep);
+    invariant(_minBytesPerStone.load() > 0);
+
+    size_t maxAdaptiveStones =
+        std::min(kMaxAdaptiveStonesToKeep, std::max(kMinStonesToKeep, numStones));
+    _lowerBoundBytesPerStone = maxSize / maxAdaptiveStones;
+    _upperBoundBytesPerStone = _minBytesPerStone.load();
+    return numStonesToKeep;
+}
+
+void WiredTigerRecordStore::OplogStones::_adaptMinBytesPerStone_inlock(int64_t stoneBytes,
+                                                                       Milliseconds elapsed) {
+    if (!_adaptiveStoneSizing || elapsed <= Milliseconds(0)) {
+        return;
+    }
+
+    // Size stones to hold about this much time worth of inserts at the current insert rate.
+    const int64_t kTargetSecondsPerStone = 10;
+
+    double bytesPerSecond = double(stoneBytes) * 1000 / durationCount<Milliseconds>(elapsed);
+    double targetBytes = bytesPerSecond * kTargetSecondsPerStone;
+    targetBytes = std::max(double(_lowerBoundBytesPerStone),
+                           std::min(double(_upperBoundBytesPerStone), targetBytes));
+
+    // Move halfway towards the target to smooth out bursts of inserts.
+    const int64_t minBytesPerStone = _minBytesPerStone.load();
+    const int64_t newMinBytesPerStone = (minBytesPerStone + int64_t(targetBytes)) / 2;
+    if (newMinBytesPerStone != minBytesPerStone) {
+        LOG(2) << "Adjusting the oplog stone size from " << minBytesPerStone << " to "
+               << newMinBytesPerStone << " bytes for an insert rate of " << bytesPerSecond
+               << " bytes/sec";
+        _minBytesPerStone.store(newMinBytesPerStone);
+    }
 }
 
 StatusWith<std::string> WiredTigerRecordStore::parseOptionsField(const BSONObj options) {
@@ -1097,6 +1177,12 @@ int64_t WiredTigerRecordStore::cappedDeleteAsNeeded_inlock(OperationContext* opC
     return docsRemoved;
 }
 
+void WiredTigerRecordStore::appendOplogTruncationStats(BSONObjBuilder* builder) const {
+    if (_oplogStones) {
+        _oplogStones->appendStats(builder);
+    }
+}
+
 bool WiredTigerRecordStore::yieldAndAwaitOplogDeletionRequest(OperationContext* opCtx) {
     // Create another reference to the oplog stones while holding a lock on the collection to
     // prevent it from being destructed.
@@ -1154,6 +1240,7 @@ void WiredTigerRecordStore::reclaimOplog(OperationContext* opCtx, Timestamp pers
         WT_SESSION* session = ru->getSession()->getSession();
 
         try {
+            Timer truncateTimer;
             WriteUnitOfWork wuow(opCtx);
 
             WiredTigerCursor cwrap(_uri, _tableId, true, opCtx);
@@ -1177,11 +1264,19 @@ void WiredTigerRecordStore::reclaimOplog(OperationContext* opCtx, Timestamp pers
 
             // Remove the stone after a successful truncation.
             _oplogStones->popOldestStone();
+            _oplogStones->recordTruncation(Microseconds(truncateTimer.micros()));
 
             // Stash the truncate point for next time to cleanly skip over tombstones, etc.
             _oplogStones->firstRecord = stone->lastRecord;
         } catch (const WriteConflictException&) {
             LOG(1) << "Caught WriteConflictException while truncating oplog entries, retrying";
+            continue;
+        }
+
+        // Truncate incrementally: unless the oplog is far over its maximum size, leave any
+        // remaining excess stones to the next pass, so that truncation is spread out over time.
+        if (!_oplogStones->isFarOverMaxSize()) {
+            break;
         }
     }
 
@@ -275,6 +275,9 @@ public:
     // Returns false if the oplog was dropped while waiting for a deletion request.
     bool yieldAndAwaitOplogDeletionRequest(OperationContext* opCtx);
 
+    // Appends the oplog stones and truncation statistics, if this record store has oplog stones.
+    void appendOplogTruncationStats(BSONObjBuilder* builder) const;
+
     bool haveCappedWaiters();
 
     void notifyCappedWaitersIfNeeded();
@@ -38,7 +38,9 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/catalog_raii.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/namespace_string.h"
@@ -50,6 +52,7 @@
 #include "mongo/util/background.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -114,7 +117,9 @@ public:
             if (!rs->yieldAndAwaitOplogDeletionRequest(opCtx.get())) {
                 return false;  // Oplog went away.
             }
+            Timer reclaimTimer;
             rs->reclaimOplog(opCtx.get());
+            _lastReclaimMillis = reclaimTimer.millis();
         } catch (const ExceptionForCat<ErrorCategory::Interruption>&) {
             return false;
         } catch (const std::exception& e) {
@@ -133,6 +138,14 @@ public:
         while (!globalInShutdownDeprecated()) {
             if (!_deleteExcessDocuments()) {
                 sleepmillis(1000);  // Back off in case there were problems deleting.
+                continue;
+            }
+
+            // Rate limit truncation by pausing for as long as the last pass took, up to a second,
+            // outside of any locks. This spreads the deletion of excess stones over time instead
+            // of issuing back-to-back truncates on the primary.
+            if (_lastReclaimMillis > 0) {
+                sleepmillis(std::min(_lastReclaimMillis, 1000LL));
             }
         }
     }
@@ -140,8 +153,44 @@ public:
 private:
     NamespaceString _ns;
     std::string _name;
+    long long _lastReclaimMillis = 0;
 };
 
+/**
+ * Reports oplog stones and truncation statistics in serverStatus 'oplogTruncation'.
+ */
+class OplogTruncationServerStatusSection final : public ServerStatusSection {
+public:
+    OplogTruncationServerStatusSection() : ServerStatusSection("oplogTruncation") {}
+
+    bool includeByDefault() const override {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx,
+                            const BSONElement& configElement) const override {
+        const NamespaceString& nss = NamespaceString::kRsOplogNamespace;
+        if (!getGlobalServiceContext()->getStorageEngine()) {
+            return BSONObj();
+        }
+
+        AutoGetCollection autoColl(opCtx, nss, MODE_IS);
+        Collection* collection = autoColl.getCollection();
+        if (!collection) {
+            return BSONObj();
+        }
+
+        auto rs = dynamic_cast<WiredTigerRecordStore*>(collection->getRecordStore());
+        if (!rs) {
+            return BSONObj();
+        }
+
+        BSONObjBuilder builder;
+        rs->appendOplogTruncationStats(&builder);
+        return builder.obj();
+    }
+} oplogTruncationServerStatusSection;
+
 bool initRsOplogBackgroundThread(StringData ns) {
     if (!NamespaceString::oplog(ns)) {
         return false;
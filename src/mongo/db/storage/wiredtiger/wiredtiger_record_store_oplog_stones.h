@@ -35,9 +35,11 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
+class BSONObjBuilder;
 class OperationContext;
 class RecordId;
 
@@ -58,15 +60,13 @@ public:
     void kill();
 
     bool hasExcessStones_inlock() const {
-        int64_t total_bytes = 0;
-        for (std::deque<OplogStones::Stone>::const_iterator it = _stones.begin();
-             it != _stones.end();
-             ++it) {
-            total_bytes += it->bytes;
-        }
-        return total_bytes > _rs->cappedMaxSize();
+        return _stonesBytes > _rs->cappedMaxSize();
     }
 
+    // Returns true if the oplog is so far over its maximum size that truncation should catch up
+    // without pausing between stones.
+    bool isFarOverMaxSize() const;
+
     void awaitHasExcessStonesOrDead();
 
     boost::optional<OplogStones::Stone> peekOldestStoneIfNeeded() const;
@@ -90,6 +90,12 @@ public:
     // Resize oplog size
     void adjust(int64_t maxSize);
 
+    // Records the outcome of truncating a single stone, for reporting in serverStatus.
+    void recordTruncation(Microseconds duration);
+
+    // Appends the oplog truncation statistics reported in serverStatus 'oplogTruncation'.
+    void appendStats(BSONObjBuilder* builder) const;
+
     // The start point of where to truncate next. Used by the background reclaim thread to
     // efficiently truncate records with WiredTiger by skipping over tombstones, etc.
     RecordId firstRecord;
@@ -111,8 +117,13 @@ public:
         return _currentRecords.load();
     }
 
+    // Fixes the minimum number of bytes per stone, disabling adaptive stone sizing.
     void setMinBytesPerStone(int64_t size);
 
+    int64_t minBytesPerStone() const {
+        return _minBytesPerStone.load();
+    }
+
 private:
     class InsertChange;
     class TruncateChange;
@@ -125,6 +136,13 @@ private:
 
     void _pokeReclaimThreadIfNeeded();
 
+    // Computes the bounds on the stone size for an oplog of 'maxSize' bytes and resets the
+    // minimum bytes per stone to its initial value. Returns the initial number of stones to keep.
+    size_t _setStoneSizeBounds_inlock(int64_t maxSize);
+
+    // Resizes future stones based on the insert rate observed while filling the last one.
+    void _adaptMinBytesPerStone_inlock(int64_t stoneBytes, Milliseconds elapsed);
+
     static const uint64_t kRandomSamplesPerStone = 10;
 
     WiredTigerRecordStore* _rs;
@@ -137,14 +155,28 @@ private:
     bool _isDead = false;
 
     // Minimum number of bytes the stone being filled should contain before it gets added to the
-    // deque of oplog stones.
-    int64_t _minBytesPerStone;
+    // deque of oplog stones. Only modified while holding '_mutex'.
+    AtomicInt64 _minBytesPerStone;
+
+    // Bounds on '_minBytesPerStone' when it is adapted to the insert rate. Adaptive sizing is
+    // disabled once the stone size is set explicitly.
+    int64_t _lowerBoundBytesPerStone;
+    int64_t _upperBoundBytesPerStone;
+    bool _adaptiveStoneSizing = true;
+
+    // When the most recent stone was created, used to estimate the insert rate.
+    Date_t _lastStoneCreated;
 
     AtomicInt64 _currentRecords;  // Number of records in the stone being filled.
     AtomicInt64 _currentBytes;    // Number of bytes in the stone being filled.
 
     mutable stdx::mutex _mutex;  // Protects against concurrent access to the deque of oplog stones.
     std::deque<OplogStones::Stone> _stones;  // front = oldest, back = newest.
+    int64_t _stonesBytes = 0;                // Sum of the bytes of all stones in '_stones'.
+
+    AtomicInt64 _truncateCount;              // Number of stones truncated.
+    AtomicInt64 _totalTimeTruncatingMicros;  // Time spent truncating stones.
+    AtomicInt64 _maxTruncateMicros;          // Slowest single stone truncation.
 };
 
 }  // namespace mongo
@@ -820,6 +820,66 @@ TEST(WiredTigerRecordStoreTest, OplogStones_ReclaimStones) {
     }
 }
 
+// Verify that oplog stones are reclaimed one at a time when the oplog is only slightly over
+// cappedMaxSize, and that truncations are reported in the oplog truncation statistics.
+TEST(WiredTigerRecordStoreTest, OplogStones_ReclaimStonesIncrementally) {
+    std::unique_ptr<RecordStoreHarnessHelper> harnessHelper = newRecordStoreHarnessHelper();
+
+    const int64_t cappedMaxSize = 10 * 1024;  // 10KB
+    unique_ptr<RecordStore> rs(
+        harnessHelper->newCappedRecordStore("local.oplog.stones", cappedMaxSize, -1));
+
+    WiredTigerRecordStore* wtrs = static_cast<WiredTigerRecordStore*>(rs.get());
+    WiredTigerRecordStore::OplogStones* oplogStones = wtrs->oplogStones();
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        ASSERT_OK(wtrs->updateCappedSize(opCtx.get(), 1000U));
+    }
+
+    oplogStones->setMinBytesPerStone(50);
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        for (int i = 1; i <= 22; ++i) {
+            ASSERT_EQ(insertBSONWithSize(opCtx.get(), rs.get(), Timestamp(1, i), 50),
+                      RecordId(1, i));
+        }
+
+        ASSERT_EQ(1100, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(22U, oplogStones->numStones());
+        ASSERT_FALSE(oplogStones->isFarOverMaxSize());
+    }
+
+    // Only one stone is truncated per pass while the oplog is within 10% of cappedMaxSize.
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+
+        wtrs->reclaimOplog(opCtx.get(), Timestamp(1, 22));
+
+        ASSERT_EQ(1050, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(21U, oplogStones->numStones());
+    }
+
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+
+        wtrs->reclaimOplog(opCtx.get(), Timestamp(1, 22));
+
+        ASSERT_EQ(1000, rs->dataSize(opCtx.get()));
+        ASSERT_EQ(20U, oplogStones->numStones());
+    }
+
+    BSONObjBuilder builder;
+    wtrs->appendOplogTruncationStats(&builder);
+    BSONObj stats = builder.obj();
+    ASSERT_EQ(20, stats["numStones"].numberLong());
+    ASSERT_EQ(1000, stats["stonesBytes"].numberLong());
+    ASSERT_EQ(50, stats["minBytesPerStone"].numberLong());
+    ASSERT_FALSE(stats["adaptiveStoneSizing"].trueValue());
+    ASSERT_EQ(2, stats["truncateCount"].numberLong());
+}
+
 // Verify that an oplog stone isn't created if it would cause the logical representation of the
 // records to not be in increasing order.
 TEST(WiredTigerRecordStoreTest, OplogStones_AscendingOrder) {
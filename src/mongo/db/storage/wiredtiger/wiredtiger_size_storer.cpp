@@ -33,6 +33,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <vector>
 #include <wiredtiger.h>
 
 #include "mongo/bson/bsonobj.h"
@@ -49,6 +50,8 @@
 
 namespace mongo {
 
+const size_t WiredTigerSizeStorer::kFlushBatchSize = 1000;
+
 WiredTigerSizeStorer::WiredTigerSizeStorer(WT_CONNECTION* conn,
                                            const std::string& storageUri,
                                            bool readOnly)
@@ -121,6 +124,8 @@ std::shared_ptr<WiredTigerSizeStorer::SizeInfo> WiredTigerSizeStorer::load(Strin
     auto result = std::make_shared<SizeInfo>();
     result->numRecords.store(data["numRecords"].safeNumberLong());
     result->dataSize.store(data["dataSize"].safeNumberLong());
+    result->_flushedNumRecords = result->numRecords.load();
+    result->_flushedDataSize = result->dataSize.load();
     return result;
 }
 
@@ -134,46 +139,121 @@ void WiredTigerSizeStorer::flush(bool syncToDisk) {
     if (buffer.empty())
         return;  // Nothing to do.
 
+    // Split the dirty entries into batches, so each WiredTiger transaction stays small.
+    std::vector<Buffer> batches(1);
+    for (auto& it : buffer) {
+        if (batches.back().size() >= kFlushBatchSize)
+            batches.emplace_back();
+        batches.back()[it.first] = std::move(it.second);
+    }
+    buffer.clear();
+
     Timer t;
-    stdx::lock_guard<stdx::mutex> cursorLock(_cursorMutex);
+    size_t nextBatch = 0;
     {
-        // On failure, place entries back into the map, unless a newer value already exists.
-        ON_BLOCK_EXIT([this, &buffer]() {
-            this->_cursor->reset(this->_cursor);
-            if (!buffer.empty()) {
-                stdx::lock_guard<stdx::mutex> bufferLock(this->_bufferMutex);
-                for (auto& it : buffer)
+        // On failure, place the entries of unwritten batches back into the map, unless a newer
+        // value already exists. A failed batch restores its own entries.
+        ON_BLOCK_EXIT([this, &batches, &nextBatch]() {
+            stdx::lock_guard<stdx::mutex> bufferLock(this->_bufferMutex);
+            for (size_t i = nextBatch; i < batches.size(); ++i) {
+                for (auto& it : batches[i])
                     this->_buffer.try_emplace(it.first, it.second);
             }
         });
 
-        WT_SESSION* session = _session.getSession();
-        WiredTigerBeginTxnBlock txnOpen(session, syncToDisk ? "sync=true" : nullptr);
-
-        for (auto it = buffer.begin(); it != buffer.end(); ++it) {
-
-            // Ordering is important here: when the store method checks if the SizeInfo
-            // is dirty and it returns true, the current values of numRecords and dataSize must
-            // still be written back. So, the required order is to clear the dirty flag first.
-            SizeInfo& sizeInfo = *it->second;
-            sizeInfo._dirty.store(false);
-            BSONObj data = BSON("numRecords" << sizeInfo.numRecords.load() << "dataSize"
-                                             << sizeInfo.dataSize.load());
-
-            auto& uri = it->first;
-            LOG(2) << "WiredTigerSizeStorer::flush " << uri << " -> " << redact(data);
-            WiredTigerItem key(uri.c_str(), uri.size());
-            WiredTigerItem value(data.objdata(), data.objsize());
-            _cursor->set_key(_cursor, key.Get());
-            _cursor->set_value(_cursor, value.Get());
-            invariantWTOK(_cursor->insert(_cursor));
+        while (nextBatch < batches.size()) {
+            // Syncing the last batch to disk also makes all earlier batches durable.
+            const bool lastBatch = nextBatch + 1 == batches.size();
+
+            // Take the cursor per batch, so that load() is not held up for the whole flush.
+            stdx::lock_guard<stdx::mutex> cursorLock(_cursorMutex);
+            _writeEntries(batches[nextBatch++], syncToDisk && lastBatch);
         }
-        txnOpen.done();
-        invariantWTOK(session->commit_transaction(session, nullptr));
-        buffer.clear();
     }
 
     auto micros = t.micros();
-    LOG(2) << "WiredTigerSizeStorer flush took " << micros << " µs";
+    LOG(2) << "WiredTigerSizeStorer flush of " << batches.size() << " batches took " << micros
+           << " µs";
+}
+
+size_t WiredTigerSizeStorer::flushBatch(size_t maxEntries) {
+    Buffer batch;
+    size_t remaining;
+    {
+        stdx::lock_guard<stdx::mutex> bufferLock(_bufferMutex);
+        for (auto& it : _buffer) {
+            if (batch.size() >= maxEntries)
+                break;
+            batch[it.first] = it.second;
+        }
+        for (auto& it : batch)
+            _buffer.erase(it.first);
+        remaining = _buffer.size();
+    }
+
+    if (batch.empty())
+        return remaining;
+
+    stdx::lock_guard<stdx::mutex> cursorLock(_cursorMutex);
+    _writeEntries(batch, false);
+    return remaining;
+}
+
+size_t WiredTigerSizeStorer::numDirtyEntries() const {
+    stdx::lock_guard<stdx::mutex> bufferLock(_bufferMutex);
+    return _buffer.size();
+}
+
+void WiredTigerSizeStorer::_writeEntries(Buffer& buffer, bool syncToDisk) {
+    // On failure, place entries back into the map, unless a newer value already exists.
+    ON_BLOCK_EXIT([this, &buffer]() {
+        this->_cursor->reset(this->_cursor);
+        if (!buffer.empty()) {
+            stdx::lock_guard<stdx::mutex> bufferLock(this->_bufferMutex);
+            for (auto& it : buffer)
+                this->_buffer.try_emplace(it.first, it.second);
+        }
+    });
+
+    WT_SESSION* session = _session.getSession();
+    WiredTigerBeginTxnBlock txnOpen(session, syncToDisk ? "sync=true" : nullptr);
+
+    // Values written by this transaction, published to the SizeInfo entries once it commits.
+    std::vector<std::pair<SizeInfo*, std::pair<int64_t, int64_t>>> written;
+    written.reserve(buffer.size());
+
+    for (auto it = buffer.begin(); it != buffer.end(); ++it) {
+
+        // Ordering is important here: when the store method checks if the SizeInfo
+        // is dirty and it returns true, the current values of numRecords and dataSize must
+        // still be written back. So, the required order is to clear the dirty flag first.
+        SizeInfo& sizeInfo = *it->second;
+        sizeInfo._dirty.store(false);
+        const int64_t numRecords = sizeInfo.numRecords.load();
+        const int64_t dataSize = sizeInfo.dataSize.load();
+
+        auto& uri = it->first;
+        if (numRecords == sizeInfo._flushedNumRecords && dataSize == sizeInfo._flushedDataSize) {
+            LOG(3) << "WiredTigerSizeStorer::flush " << uri << " unchanged, skipping";
+            continue;
+        }
+
+        BSONObj data = BSON("numRecords" << numRecords << "dataSize" << dataSize);
+        LOG(2) << "WiredTigerSizeStorer::flush " << uri << " -> " << redact(data);
+        WiredTigerItem key(uri.c_str(), uri.size());
+        WiredTigerItem value(data.objdata(), data.objsize());
+        _cursor->set_key(_cursor, key.Get());
+        _cursor->set_value(_cursor, value.Get());
+        invariantWTOK(_cursor->insert(_cursor));
+        written.push_back({&sizeInfo, {numRecords, dataSize}});
+    }
+    txnOpen.done();
+    invariantWTOK(session->commit_transaction(session, nullptr));
+
+    for (auto& entry : written) {
+        entry.first->_flushedNumRecords = entry.second.first;
+        entry.first->_flushedDataSize = entry.second.second;
+    }
+    buffer.clear();
 }
 }  // namespace mongo
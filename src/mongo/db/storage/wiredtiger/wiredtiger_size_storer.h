@@ -53,6 +53,10 @@ namespace mongo {
  * in size updates to be lost, so size information is only approximate. Reads use the buffer for
  * pending stores, or otherwise read directly from the WiredTiger table using a dedicated session
  * and cursor.
+ *
+ * Flushing is done in batches, each batch in its own WiredTiger transaction, so that a large number
+ * of dirty entries does not hold the cursor for the whole duration of the flush. Entries whose
+ * values have not changed since they were last written are skipped, so only deltas reach the table.
  */
 class WiredTigerSizeStorer {
 public:
@@ -73,6 +77,11 @@ public:
     private:
         friend WiredTigerSizeStorer;
         AtomicBool _dirty;
+
+        // Values as last read from or written to the size storer table, or -1 if unknown. Only
+        // accessed by the size storer while holding its cursor mutex.
+        int64_t _flushedNumRecords = -1;
+        int64_t _flushedDataSize = -1;
     };
 
     WiredTigerSizeStorer(WT_CONNECTION* conn,
@@ -93,6 +102,23 @@ public:
      */
     void flush(bool syncToDisk);
 
+    /**
+     * Writes at most 'maxEntries' buffered changes to the underlying table in a single
+     * transaction. The remaining changes stay buffered for a later call. Returns the number of
+     * entries still buffered. Used to spread size storer writes over time.
+     */
+    size_t flushBatch(size_t maxEntries);
+
+    /**
+     * Returns the number of entries waiting to be written to the underlying table.
+     */
+    size_t numDirtyEntries() const;
+
+    /**
+     * Maximum number of entries written per WiredTiger transaction by flush().
+     */
+    static const size_t kFlushBatchSize;
+
 private:
     const WiredTigerSession _session;
     const bool _readOnly;
@@ -102,6 +128,12 @@ private:
 
     using Buffer = StringMap<std::shared_ptr<SizeInfo>>;
 
+    /**
+     * Writes the entries of 'buffer' to the table in a single transaction. Must be called with
+     * _cursorMutex held. On failure the entries are placed back into _buffer.
+     */
+    void _writeEntries(Buffer& buffer, bool syncToDisk);
+
     mutable stdx::mutex _bufferMutex;  // Guards _buffer
     Buffer _buffer;
 };
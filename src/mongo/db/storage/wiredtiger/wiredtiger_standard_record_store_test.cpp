@@ -295,6 +295,44 @@ TEST(WiredTigerRecordStoreTest, SizeStorer1) {
     rs.reset(nullptr);  // this has to be deleted before ss
 }
 
+TEST(WiredTigerRecordStoreTest, SizeStorerFlushBatch) {
+    unique_ptr<WiredTigerHarnessHelper> harnessHelper(new WiredTigerHarnessHelper());
+
+    string sizeStorerUri = "table:sizeStorer";
+    const bool enableWtLogging = false;
+    WiredTigerSizeStorer ss(harnessHelper->conn(), sizeStorerUri, enableWtLogging);
+
+    const int N = 5;
+    for (int i = 0; i < N; i++) {
+        const string uri = str::stream() << "table:coll" << i;
+        auto info = ss.load(uri);
+        info->numRecords.store(i + 1);
+        info->dataSize.store(10 * (i + 1));
+        ss.store(uri, info);
+    }
+    ASSERT_EQUALS(static_cast<size_t>(N), ss.numDirtyEntries());
+
+    // Each batch only writes back the requested number of entries.
+    ASSERT_EQUALS(static_cast<size_t>(N - 2), ss.flushBatch(2));
+    ASSERT_EQUALS(static_cast<size_t>(N - 4), ss.flushBatch(2));
+    ASSERT_EQUALS(static_cast<size_t>(0), ss.flushBatch(2));
+    ASSERT_EQUALS(static_cast<size_t>(0), ss.numDirtyEntries());
+
+    // Storing an unchanged entry marks it dirty, but flushing it is a no-op.
+    ss.store("table:coll0", ss.load("table:coll0"));
+    ASSERT_EQUALS(static_cast<size_t>(1), ss.numDirtyEntries());
+    ss.flush(true);
+    ASSERT_EQUALS(static_cast<size_t>(0), ss.numDirtyEntries());
+
+    WiredTigerSizeStorer ss2(harnessHelper->conn(), sizeStorerUri, enableWtLogging);
+    for (int i = 0; i < N; i++) {
+        const string uri = str::stream() << "table:coll" << i;
+        auto info = ss2.load(uri);
+        ASSERT_EQUALS(i + 1, info->numRecords.load());
+        ASSERT_EQUALS(10 * (i + 1), info->dataSize.load());
+    }
+}
+
 class GoodValidateAdaptor : public ValidateAdaptor {
 public:
     virtual Status validate(const RecordId& recordId, const RecordData& record, size_t* dataSize) {
@@ -35,23 +35,34 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/executor/connection_pool_stats.h"
 #include "mongo/executor/remote_command_request.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/destructor_guard.h"
+#include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/lru_cache.h"
 #include "mongo/util/scopeguard.h"
 
 // One interesting implementation note herein concerns how setup() and
-// refresh() are invoked outside of the global lock, but setTimeout is not.
+// refresh() are invoked outside of the specific pool's lock, but setTimeout is not.
 // This implementation detail simplifies mocks, allowing them to return
 // synchronously sometimes, whereas having timeouts fire instantly adds little
 // value. In practice, dumping the locks is always safe (because we restrict
 // ourselves to operations over the connection).
+//
+// Each specific pool has its own mutex, so traffic to one host never waits on traffic to another.
+// The parent's mutex only guards the map of pools and is never acquired while a specific pool's
+// mutex is held by the same thread, except for the brief moment a shut down pool delists itself.
+// Hence the lock order is always specific pool, then parent.
 
 namespace mongo {
 namespace executor {
 
+namespace {
+MONGO_FAIL_POINT_DEFINE(connectionPoolGetSpinsUntilPoolShutsDown);
+}  // namespace
+
 /**
  * A pool for a specific HostAndPort
  *
@@ -67,11 +78,9 @@ public:
      * The presence of one of these guards will bump a counter on the specific pool
      * which will prevent the pool from removing itself from the map of pools.
      *
-     * The complexity comes from the need to hold a lock when writing to the
-     * _activeClients param on the specific pool.  Because the code beneath the client needs to lock
-     * and unlock the parent mutex (and can leave unlocked), we want to start the client with the
-     * lock acquired, move it into the client, then re-acquire to decrement the counter on the way
-     * out.
+     * The counter is atomic so that it can be dropped on the way out without re-acquiring the
+     * specific pool's mutex, which the code beneath the client is free to unlock (and leave
+     * unlocked). The client is started with the lock acquired and the lock is moved into it.
      *
      * This callback also (perhaps overly aggressively) binds a shared pointer to the guard.
      * It is *always* safe to reference the original specific pool in the guarded function object.
@@ -85,13 +94,10 @@ public:
     template <typename Callback>
     auto guardCallback(Callback&& cb) {
         return [ cb = std::forward<Callback>(cb), anchor = shared_from_this() ](auto&&... args) {
-            stdx::unique_lock<stdx::mutex> lk(anchor->_parent->_mutex);
-            ++(anchor->_activeClients);
+            anchor->_activeClients.fetchAndAdd(1);
+            ON_BLOCK_EXIT([&anchor]() { anchor->_activeClients.fetchAndSubtract(1); });
 
-            ON_BLOCK_EXIT([anchor]() {
-                stdx::unique_lock<stdx::mutex> lk(anchor->_parent->_mutex);
-                --(anchor->_activeClients);
-            });
+            stdx::unique_lock<stdx::mutex> lk(anchor->_mutex);
 
             return cb(std::move(lk), std::forward<decltype(args)>(args)...);
         };
@@ -101,8 +107,23 @@ public:
     ~SpecificPool();
 
     /**
-     * Gets a connection from the specific pool. Sinks a unique_lock from the
-     * parent to preserve the lock on _mutex
+     * Acquires the mutex which guards the state of this specific pool.
+     */
+    stdx::unique_lock<stdx::mutex> lock() {
+        return stdx::unique_lock<stdx::mutex>(_mutex);
+    }
+
+    /**
+     * Returns true once the pool has started shutting down. Such a pool must not hand out any more
+     * connections and is replaced in the parent's map by the next request for its host.
+     */
+    bool isInShutdown(const stdx::unique_lock<stdx::mutex>& lk) const {
+        return _state == State::kInShutdown;
+    }
+
+    /**
+     * Gets a connection from the specific pool. Sinks a unique_lock on this
+     * pool's _mutex to preserve the lock
      */
     Future<ConnectionHandle> getConnection(const HostAndPort& hostAndPort,
                                            Milliseconds timeout,
@@ -124,8 +145,8 @@ public:
     void processFailure(const Status& status, stdx::unique_lock<stdx::mutex> lk);
 
     /**
-     * Returns a connection to a specific pool. Sinks a unique_lock from the
-     * parent to preserve the lock on _mutex
+     * Returns a connection to a specific pool. Sinks a unique_lock on this
+     * pool's _mutex to preserve the lock
      */
     void returnConnection(ConnectionInterface* connection, stdx::unique_lock<stdx::mutex> lk);
 
@@ -156,6 +177,10 @@ public:
      */
     size_t openConnections(const stdx::unique_lock<stdx::mutex>& lk);
 
+    const HostAndPort& hostAndPort() const {
+        return _hostAndPort;
+    }
+
     /**
      * Return true if the tags on the specific pool match the passed in tags
      */
@@ -203,6 +228,9 @@ private:
 
     const HostAndPort _hostAndPort;
 
+    // Guards all of the state below, except for _activeClients
+    stdx::mutex _mutex;
+
     LRUOwnershipPool _readyPool;
     OwnershipPool _processingPool;
     OwnershipPool _droppedProcessingPool;
@@ -212,7 +240,7 @@ private:
 
     std::shared_ptr<TimerInterface> _requestTimer;
     Date_t _requestTimerExpiration;
-    size_t _activeClients;
+    AtomicWord<size_t> _activeClients;
     size_t _generation;
     bool _inFulfillRequests;
     bool _inSpawnConnections;
@@ -289,7 +317,7 @@ void ConnectionPool::shutdown() {
     }();
 
     for (const auto& pair : pools) {
-        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        auto lk = pair.second->lock();
         pair.second->triggerShutdown(
             Status(ErrorCodes::ShutdownInProgress, "Shutting down the connection pool"),
             std::move(lk));
@@ -297,14 +325,12 @@ void ConnectionPool::shutdown() {
 }
 
 void ConnectionPool::dropConnections(const HostAndPort& hostAndPort) {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
-
-    auto iter = _pools.find(hostAndPort);
+    auto pool = findPool(hostAndPort);
 
-    if (iter == _pools.end())
+    if (!pool)
         return;
 
-    auto pool = iter->second;
+    auto lk = pool->lock();
     pool->processFailure(Status(ErrorCodes::PooledConnectionsDropped, "Pooled connections dropped"),
                          std::move(lk));
 }
@@ -319,7 +345,7 @@ void ConnectionPool::dropConnections(transport::Session::TagMask tags) {
     for (const auto& pair : pools) {
         auto& pool = pair.second;
 
-        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        auto lk = pool->lock();
         if (pool->matchesTags(lk, tags))
             continue;
 
@@ -332,14 +358,12 @@ void ConnectionPool::dropConnections(transport::Session::TagMask tags) {
 void ConnectionPool::mutateTags(
     const HostAndPort& hostAndPort,
     const stdx::function<transport::Session::TagMask(transport::Session::TagMask)>& mutateFunc) {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    auto pool = findPool(hostAndPort);
 
-    auto iter = _pools.find(hostAndPort);
-
-    if (iter == _pools.end())
+    if (!pool)
         return;
 
-    auto pool = iter->second;
+    auto lk = pool->lock();
     pool->mutateTags(lk, mutateFunc);
 }
 
@@ -351,31 +375,50 @@ void ConnectionPool::get(const HostAndPort& hostAndPort,
 
 Future<ConnectionPool::ConnectionHandle> ConnectionPool::get(const HostAndPort& hostAndPort,
                                                              Milliseconds timeout) {
-    std::shared_ptr<SpecificPool> pool;
+    while (true) {
+        auto pool = [&] {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
 
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+            auto& pool = _pools[hostAndPort];
+            if (!pool) {
+                pool = std::make_shared<SpecificPool>(this, hostAndPort);
+            }
 
-    auto iter = _pools.find(hostAndPort);
+            return pool;
+        }();
 
-    if (iter == _pools.end()) {
-        pool = stdx::make_unique<SpecificPool>(this, hostAndPort);
-        _pools[hostAndPort] = pool;
-    } else {
-        pool = iter->second;
-    }
+        if (MONGO_FAIL_POINT(connectionPoolGetSpinsUntilPoolShutsDown)) {
+            connectionPoolGetSpinsUntilPoolShutsDown.setMode(FailPoint::off);
+            while (!pool->isInShutdown(pool->lock())) {
+                sleepmillis(10);
+            }
+        }
 
-    invariant(pool);
+        auto lk = pool->lock();
+
+        // The pool may have started shutting down between the lookup and acquiring its lock. It
+        // will not take any more requests, so replace it with a fresh one and try again.
+        if (pool->isInShutdown(lk)) {
+            delistPool(pool.get());
+            continue;
+        }
 
-    return pool->getConnection(hostAndPort, timeout, std::move(lk));
+        return pool->getConnection(hostAndPort, timeout, std::move(lk));
+    }
 }
 
 void ConnectionPool::appendConnectionStats(ConnectionPoolStats* stats) const {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    // Grab all current pools (under the lock)
+    auto pools = [&] {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _pools;
+    }();
 
-    for (const auto& kv : _pools) {
+    for (const auto& kv : pools) {
         HostAndPort host = kv.first;
 
         auto& pool = kv.second;
+        auto lk = pool->lock();
         ConnectionStatsPer hostStats{pool->inUseConnections(lk),
                                      pool->availableConnections(lk),
                                      pool->createdConnections(lk),
@@ -385,28 +428,48 @@ void ConnectionPool::appendConnectionStats(ConnectionPoolStats* stats) const {
 }
 
 size_t ConnectionPool::getNumConnectionsPerHost(const HostAndPort& hostAndPort) const {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
-    auto iter = _pools.find(hostAndPort);
-    if (iter != _pools.end()) {
-        return iter->second->openConnections(lk);
+    auto pool = findPool(hostAndPort);
+    if (pool) {
+        auto lk = pool->lock();
+        return pool->openConnections(lk);
     }
 
     return 0;
 }
 
 void ConnectionPool::returnConnection(ConnectionInterface* conn) {
-    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    auto pool = findPool(conn->getHostAndPort());
 
-    auto iter = _pools.find(conn->getHostAndPort());
-
-    invariant(iter != _pools.end(),
+    invariant(pool,
               str::stream() << "Tried to return connection but no pool found for "
                             << conn->getHostAndPort());
 
-    auto pool = iter->second;
+    auto lk = pool->lock();
     pool->returnConnection(conn, std::move(lk));
 }
 
+std::shared_ptr<ConnectionPool::SpecificPool> ConnectionPool::findPool(
+    const HostAndPort& hostAndPort) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    auto iter = _pools.find(hostAndPort);
+    if (iter == _pools.end())
+        return nullptr;
+
+    return iter->second;
+}
+
+void ConnectionPool::delistPool(const SpecificPool* pool) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    // A replacement pool for the same host may already have been listed, so only remove the
+    // entry if it still refers to this pool.
+    auto iter = _pools.find(pool->hostAndPort());
+    if (iter != _pools.end() && iter->second.get() == pool) {
+        _pools.erase(iter);
+    }
+}
+
 ConnectionPool::SpecificPool::SpecificPool(ConnectionPool* parent, const HostAndPort& hostAndPort)
     : _parent(parent),
       _hostAndPort(hostAndPort),
@@ -803,10 +866,10 @@ ConnectionPool::SpecificPool::OwnedConnection ConnectionPool::SpecificPool::take
 void ConnectionPool::SpecificPool::updateStateInLock() {
     if (_state == State::kInShutdown) {
         // If we're in shutdown, there is nothing to update. Our clients are all gone.
-        if (_processingPool.empty() && !_activeClients) {
+        if (_processingPool.empty() && !_activeClients.load()) {
             // If we have no more clients that require access to us, delist from the parent pool
             LOG(2) << "Delisting connection pool for " << _hostAndPort;
-            _parent->_pools.erase(_hostAndPort);
+            _parent->delistPool(this);
         }
         return;
     }
@@ -876,7 +939,7 @@ void ConnectionPool::SpecificPool::updateStateInLock() {
 
         // Set the shutdown timer, this gets reset on any request
         _requestTimer->setTimeout(timeout, [ this, anchor = shared_from_this() ]() {
-            stdx::unique_lock<stdx::mutex> lk(anchor->_parent->_mutex);
+            stdx::unique_lock<stdx::mutex> lk(anchor->_mutex);
             if (_state != State::kIdle)
                 return;
 
@@ -157,6 +157,17 @@ public:
 private:
     void returnConnection(ConnectionInterface* connection);
 
+    /**
+     * Returns the specific pool for the given host, or nullptr if there is none.
+     */
+    std::shared_ptr<SpecificPool> findPool(const HostAndPort& hostAndPort) const;
+
+    /**
+     * Removes the given specific pool from _pools, unless it has already been replaced. May be
+     * called while holding the specific pool's mutex.
+     */
+    void delistPool(const SpecificPool* pool);
+
     std::string _name;
 
     // Options are set at startup and never changed at run time, so these are
@@ -165,7 +176,8 @@ private:
 
     const std::shared_ptr<DependentTypeFactoryInterface> _factory;
 
-    // The global mutex for specific pool access and the generation counter
+    // Guards only the map of specific pools. Each specific pool has its own mutex for its state,
+    // which is always acquired before this one if both are held.
     mutable stdx::mutex _mutex;
     stdx::unordered_map<HostAndPort, std::shared_ptr<SpecificPool>> _pools;
 
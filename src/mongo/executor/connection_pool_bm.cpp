@@ -0,0 +1,167 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/executor/connection_pool.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/net/hostandport.h"
+
+namespace mongo {
+namespace executor {
+namespace {
+
+/**
+ * A timer which never fires. The benchmark never gets near the refresh requirement or the host
+ * timeout, so none of the pool's timers are expected to go off.
+ */
+class TimerImpl final : public ConnectionPool::TimerInterface {
+public:
+    void setTimeout(Milliseconds timeout, TimeoutCallback cb) override {}
+    void cancelTimeout() override {}
+};
+
+/**
+ * A connection which is set up and refreshed synchronously and always stays healthy, so that the
+ * benchmark measures nothing but the pool's own bookkeeping.
+ */
+class ConnectionImpl final : public ConnectionPool::ConnectionInterface {
+public:
+    ConnectionImpl(const HostAndPort& hostAndPort, size_t generation, Date_t now)
+        : _hostAndPort(hostAndPort), _generation(generation), _lastUsed(now) {}
+
+    void indicateSuccess() override {}
+    void indicateFailure(Status status) override {
+        _status = std::move(status);
+    }
+    void indicateUsed() override {}
+
+    const HostAndPort& getHostAndPort() const override {
+        return _hostAndPort;
+    }
+
+    bool isHealthy() override {
+        return true;
+    }
+
+    void setTimeout(Milliseconds timeout, TimeoutCallback cb) override {}
+    void cancelTimeout() override {}
+
+private:
+    Date_t getLastUsed() const override {
+        return _lastUsed;
+    }
+
+    const Status& getStatus() const override {
+        return _status;
+    }
+
+    void setup(Milliseconds timeout, SetupCallback cb) override {
+        cb(this, Status::OK());
+    }
+
+    void resetToUnknown() override {}
+
+    void refresh(Milliseconds timeout, RefreshCallback cb) override {
+        cb(this, Status::OK());
+    }
+
+    size_t getGeneration() const override {
+        return _generation;
+    }
+
+    const HostAndPort _hostAndPort;
+    const size_t _generation;
+    const Date_t _lastUsed;
+    Status _status = Status::OK();
+};
+
+/**
+ * Hands out ConnectionImpls and TimerImpls. The clock is frozen so that connections never need to
+ * be refreshed.
+ */
+class FactoryImpl final : public ConnectionPool::DependentTypeFactoryInterface {
+public:
+    std::shared_ptr<ConnectionPool::ConnectionInterface> makeConnection(
+        const HostAndPort& hostAndPort, size_t generation) override {
+        return std::make_shared<ConnectionImpl>(hostAndPort, generation, now());
+    }
+
+    std::shared_ptr<ConnectionPool::TimerInterface> makeTimer() override {
+        return std::make_shared<TimerImpl>();
+    }
+
+    Date_t now() override {
+        return _now;
+    }
+
+    void shutdown() override {}
+
+private:
+    const Date_t _now = Date_t::now();
+};
+
+ConnectionPool* pool;
+std::vector<HostAndPort> hosts;
+
+/**
+ * Each thread repeatedly checks a connection out of the pool and returns it straight away. The
+ * threads are spread evenly over the given number of hosts, so with as many hosts as threads no
+ * two threads ever touch the same specific pool.
+ */
+void BM_CheckoutReturn(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        pool = new ConnectionPool(std::make_shared<FactoryImpl>(), "benchmark");
+        for (int i = 0; i < state.range(0); i++) {
+            hosts.emplace_back("localhost", 30000 + i);
+        }
+    }
+
+    for (auto _ : state) {
+        const auto& host = hosts[state.thread_index % hosts.size()];
+        auto conn = pool->get(host, Milliseconds(-1)).get();
+        conn->indicateSuccess();
+        benchmark::DoNotOptimize(conn.get());
+    }
+
+    if (state.thread_index == 0) {
+        delete pool;
+        pool = nullptr;
+        hosts.clear();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CheckoutReturn)->Arg(1)->Arg(16)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+}  // namespace executor
+}  // namespace mongo
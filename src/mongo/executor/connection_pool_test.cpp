@@ -36,7 +36,9 @@
 #include "mongo/executor/connection_pool.h"
 #include "mongo/stdx/future.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/fail_point_service.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
@@ -965,6 +967,62 @@ TEST_F(ConnectionPoolTest, hostTimeoutHappens) {
 }
 
 
+/**
+ * Verify that a request which looked up a pool just before its hostTimeout shut it down gets a
+ * connection from a fresh pool instead.
+ */
+TEST_F(ConnectionPoolTest, hostTimeoutBetweenLookupAndCheckoutUsesFreshPool) {
+    ConnectionPool::Options options;
+    options.minConnections = 0;
+    options.hostTimeout = Milliseconds(1000);
+    ConnectionPool pool(stdx::make_unique<PoolImpl>(), "test pool", options);
+
+    auto now = Date_t::now();
+
+    PoolImpl::setNow(now);
+
+    // Leave an idle pool behind whose only timer is the hostTimeout
+    bool reachedA = false;
+    ConnectionImpl::pushSetup(Status(ErrorCodes::HostUnreachable, "host unreachable"));
+    pool.get(HostAndPort(),
+             Milliseconds(5000),
+             [&](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                 ASSERT_EQ(ErrorCodes::HostUnreachable, swConn.getStatus());
+                 reachedA = true;
+             });
+
+    ASSERT(reachedA);
+
+    auto failPoint =
+        getGlobalFailPointRegistry()->getFailPoint("connectionPoolGetSpinsUntilPoolShutsDown");
+    failPoint->setMode(FailPoint::alwaysOn);
+    ON_BLOCK_EXIT([&] { failPoint->setMode(FailPoint::off); });
+
+    bool reachedB = false;
+    Status statusB = Status::OK();
+    ConnectionImpl::pushSetup(Status::OK());
+    stdx::thread getThread([&] {
+        pool.get(HostAndPort(),
+                 Milliseconds(5000),
+                 [&](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+                     statusB = swConn.getStatus();
+                     reachedB = true;
+                     if (swConn.isOK()) {
+                         doneWith(swConn.getValue());
+                     }
+                 });
+    });
+
+    // Wait for the request to look up the idle pool, then let the hostTimeout shut it down
+    MONGO_FAIL_POINT_PAUSE_WHILE_SET((*failPoint));
+    PoolImpl::setNow(now + Milliseconds(1000));
+    getThread.join();
+
+    ASSERT(reachedB);
+    ASSERT_OK(statusB);
+    ASSERT_EQ(1U, pool.getNumConnectionsPerHost(HostAndPort()));
+}
+
 /**
  * Verify that the hostTimeout happens, but that continued gets delay
  * activation.
@@ -32,6 +32,8 @@
 
 #include "mongo/executor/network_interface_tl.h"
 
+#include <algorithm>
+
 #include "mongo/db/commands/test_commands_enabled.h"
 #include "mongo/db/server_options.h"
 #include "mongo/executor/connection_pool_tl.h"
@@ -209,6 +211,12 @@ Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHa
         return Status::OK();
     }
 
+    if (getMaxCoalescedRemoteCommands() > 1 && canCoalesceRemoteCommand(state->request, baton)) {
+        _finishCommand(state, std::move(pf.future), onFinish);
+        _coalesceCommand(state);
+        return Status::OK();
+    }
+
     // Interacting with the connection pool can involve more work than just getting a connection
     // out.  In particular, we can end up having to spin up new connections, and fulfilling promises
     // for other requesters.  Returning connections has the same issue.
@@ -243,29 +251,14 @@ Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHa
         baton,
         onFinish
     ](StatusWith<std::shared_ptr<CommandState::ConnHandle>> swConn) mutable {
-        makeReadyFutureWith([&] {
-            return _onAcquireConn(
-                state, std::move(*future), std::move(*uassertStatusOK(swConn)), baton);
-        })
-            .onError([](Status error) -> StatusWith<RemoteCommandResponse> {
-                // The TransportLayer has, for historical reasons returned SocketException for
-                // network errors, but sharding assumes HostUnreachable on network errors.
-                if (error == ErrorCodes::SocketException) {
-                    error = Status(ErrorCodes::HostUnreachable, error.reason());
-                }
-                return error;
-            })
-            .getAsync([this, state, onFinish](StatusWith<RemoteCommandResponse> response) {
-                auto duration = now() - state->start;
-                if (!response.isOK()) {
-                    onFinish(RemoteCommandResponse(response.getStatus(), duration));
-                } else {
-                    const auto& rs = response.getValue();
-                    LOG(2) << "Request " << state->request.id << " finished with response: "
-                           << redact(rs.isOK() ? rs.data.toString() : rs.status.toString());
-                    onFinish(rs);
-                }
-            });
+        _finishCommand(state,
+                       makeReadyFutureWith([&] {
+                           return _onAcquireConn(state,
+                                                 std::move(*future),
+                                                 std::move(*uassertStatusOK(swConn)),
+                                                 baton);
+                       }),
+                       onFinish);
     };
 
     if (baton) {
@@ -291,6 +284,31 @@ Status NetworkInterfaceTL::startCommand(const TaskExecutor::CallbackHandle& cbHa
     return Status::OK();
 }
 
+void NetworkInterfaceTL::_finishCommand(std::shared_ptr<CommandState> state,
+                                        Future<RemoteCommandResponse> future,
+                                        const RemoteCommandCompletionFn& onFinish) {
+    std::move(future)
+        .onError([](Status error) -> StatusWith<RemoteCommandResponse> {
+            // The TransportLayer has, for historical reasons returned SocketException for
+            // network errors, but sharding assumes HostUnreachable on network errors.
+            if (error == ErrorCodes::SocketException) {
+                error = Status(ErrorCodes::HostUnreachable, error.reason());
+            }
+            return error;
+        })
+        .getAsync([this, state, onFinish](StatusWith<RemoteCommandResponse> response) {
+            auto duration = now() - state->start;
+            if (!response.isOK()) {
+                onFinish(RemoteCommandResponse(response.getStatus(), duration));
+            } else {
+                const auto& rs = response.getValue();
+                LOG(2) << "Request " << state->request.id << " finished with response: "
+                       << redact(rs.isOK() ? rs.data.toString() : rs.status.toString());
+                onFinish(rs);
+            }
+        });
+}
+
 // This is only called from within a then() callback on a future, so throwing is equivalent to
 // returning a ready Future with a not-OK status.
 Future<RemoteCommandResponse> NetworkInterfaceTL::_onAcquireConn(
@@ -398,6 +416,189 @@ Future<RemoteCommandResponse> NetworkInterfaceTL::_onAcquireConn(
     return future;
 }
 
+// Coalesced commands wait in _coalescer until a connection to their target is available, and then
+// as many of them as maxCoalescedRemoteCommands allows are written to it back to back. Since the
+// connection is shared, neither a timeout nor a cancellation of one command tears it down. Each
+// command's deadline instead fails just that command, and the connection is only canceled once the
+// deadlines of all of its commands have passed.
+void NetworkInterfaceTL::_coalesceCommand(std::shared_ptr<CommandState> state) {
+    if (state->deadline != RemoteCommandRequest::kNoExpirationDate) {
+        state->timer = _reactor->makeTimer();
+        state->timer->waitUntil(state->deadline).getAsync([this, state](Status status) {
+            if (status == ErrorCodes::CallbackCanceled) {
+                return;
+            }
+
+            if (state->done.swap(true)) {
+                return;
+            }
+
+            if (getTestCommandsEnabled()) {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _counters.timedOut++;
+            }
+
+            LOG(2) << "Request " << state->request.id << " timed out"
+                   << ", deadline was " << state->deadline << ", op was "
+                   << redact(state->request.toString());
+            state->promise.setError(
+                Status(ErrorCodes::NetworkInterfaceExceededTimeLimit, "timed out"));
+        });
+    }
+
+    const auto target = state->request.target;
+    if (_coalescer.add(target, std::move(state))) {
+        _reactor->schedule(transport::Reactor::kPost,
+                           [this, target] { _startCoalescedBatch(target); });
+    }
+}
+
+void NetworkInterfaceTL::_startCoalescedBatch(const HostAndPort& target) {
+    makeReadyFutureWith([&] { return _pool->get(target, RemoteCommandRequest::kNoTimeout); })
+        .getAsync([this, target](StatusWith<ConnectionPool::ConnectionHandle> swConn) {
+            bool more = false;
+            auto states = _coalescer.takeBatch(target, getMaxCoalescedRemoteCommands(), &more);
+            if (more) {
+                _reactor->schedule(transport::Reactor::kPost,
+                                   [this, target] { _startCoalescedBatch(target); });
+            }
+
+            if (!swConn.isOK()) {
+                LOG(2) << "Failed to get connection from pool for " << states.size()
+                       << " coalesced requests to " << target << ": " << swConn.getStatus();
+                for (auto& state : states) {
+                    _completeCoalescedCommand(std::move(state), nullptr, swConn.getStatus());
+                }
+                return;
+            }
+
+            auto conn = std::move(swConn.getValue());
+            auto deleter = conn.get_deleter();
+            _runCoalescedBatch(
+                std::move(states),
+                CommandState::ConnHandle(conn.release(), CommandState::Deleter{deleter, _reactor}));
+        });
+}
+
+void NetworkInterfaceTL::_runCoalescedBatch(std::vector<std::shared_ptr<CommandState>> states,
+                                            CommandState::ConnHandle conn) {
+    // Skip the commands which were canceled or timed out while waiting for the connection
+    states.erase(std::remove_if(states.begin(),
+                                states.end(),
+                                [&](const std::shared_ptr<CommandState>& state) {
+                                    if (!state->done.load()) {
+                                        return false;
+                                    }
+                                    _eraseInUseConn(state->cbHandle);
+                                    return true;
+                                }),
+                 states.end());
+
+    if (states.empty()) {
+        conn->indicateSuccess();
+        return;
+    }
+
+    auto client = checked_cast<connection_pool_tl::TLConnection*>(conn.get())->client();
+
+    auto batch = std::make_shared<CoalescedBatch>();
+    batch->conn = std::move(conn);
+    batch->outstanding = states.size();
+
+    std::vector<RemoteCommandRequest> requests;
+    requests.reserve(states.size());
+    auto deadline = Date_t::min();
+    for (const auto& state : states) {
+        requests.push_back(state->request);
+        deadline = std::max(deadline, state->deadline);
+    }
+
+    if (deadline != RemoteCommandRequest::kNoExpirationDate) {
+        batch->timer = _reactor->makeTimer();
+        batch->timer->waitUntil(deadline).getAsync(
+            [weakBatch = std::weak_ptr<CoalescedBatch>(batch)](Status status) {
+                auto batch = weakBatch.lock();
+                if (!status.isOK() || !batch) {
+                    return;
+                }
+
+                // Canceling the timer does not stop an expiry which is already queued, so only
+                // cancel the connection while it still belongs to this batch.
+                stdx::lock_guard<stdx::mutex> lk(batch->mutex);
+                if (batch->outstanding > 0 && batch->conn) {
+                    checked_cast<connection_pool_tl::TLConnection*>(batch->conn.get())
+                        ->client()
+                        ->cancel();
+                }
+            });
+    }
+
+    LOG(3) << "Sending " << states.size() << " coalesced requests to " << client->remote();
+
+    auto responses = client->runCommandRequests(std::move(requests));
+    for (size_t i = 0; i < states.size(); ++i) {
+        std::move(responses[i])
+            .getAsync([ this, state = states[i], batch ](StatusWith<RemoteCommandResponse> swr) {
+                _completeCoalescedCommand(state, batch, std::move(swr));
+            });
+    }
+}
+
+void NetworkInterfaceTL::_completeCoalescedCommand(std::shared_ptr<CommandState> state,
+                                                   std::shared_ptr<CoalescedBatch> batch,
+                                                   StatusWith<RemoteCommandResponse> swr) {
+    if (_metadataHook && swr.isOK() && swr.getValue().isOK()) {
+        auto& response = swr.getValue();
+        response.status = _metadataHook->readReplyMetadata(
+            nullptr, state->request.target.toString(), response.metadata);
+    }
+
+    if (batch) {
+        stdx::unique_lock<stdx::mutex> lk(batch->mutex);
+        if (!swr.isOK()) {
+            batch->status = swr.getStatus();
+        } else if (!swr.getValue().isOK()) {
+            batch->status = swr.getValue().status;
+        }
+
+        if (--batch->outstanding == 0) {
+            if (batch->timer) {
+                batch->timer->cancel();
+            }
+
+            if (batch->status.isOK()) {
+                batch->conn->indicateUsed();
+                batch->conn->indicateSuccess();
+            } else {
+                batch->conn->indicateFailure(batch->status);
+            }
+
+            auto conn = std::move(batch->conn);
+            lk.unlock();
+        }
+    }
+
+    _eraseInUseConn(state->cbHandle);
+
+    if (state->done.swap(true))
+        return;
+
+    if (getTestCommandsEnabled()) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (swr.isOK() && swr.getValue().status.isOK()) {
+            _counters.succeeded++;
+        } else {
+            _counters.failed++;
+        }
+    }
+
+    if (state->timer) {
+        state->timer->cancel();
+    }
+
+    state->promise.setFromStatusWith(std::move(swr));
+}
+
 void NetworkInterfaceTL::_eraseInUseConn(const TaskExecutor::CallbackHandle& cbHandle) {
     stdx::lock_guard<stdx::mutex> lk(_inProgressMutex);
     _inProgress.erase(cbHandle);
@@ -34,6 +34,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/executor/connection_pool.h"
 #include "mongo/executor/network_interface.h"
+#include "mongo/executor/remote_command_coalescer.h"
 #include "mongo/rpc/metadata/metadata_hook.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/stdx/unordered_map.h"
@@ -110,12 +111,34 @@ private:
         Promise<RemoteCommandResponse> promise;
     };
 
+    /**
+     * Commands which were coalesced into one batch and share a connection. The connection goes
+     * back to the pool once every command in the batch has been answered.
+     */
+    struct CoalescedBatch {
+        stdx::mutex mutex;
+        CommandState::ConnHandle conn;
+        std::unique_ptr<transport::ReactorTimer> timer;
+        size_t outstanding = 0;
+        Status status = Status::OK();
+    };
+
     void _run();
     void _eraseInUseConn(const TaskExecutor::CallbackHandle& handle);
+    void _finishCommand(std::shared_ptr<CommandState> state,
+                        Future<RemoteCommandResponse> future,
+                        const RemoteCommandCompletionFn& onFinish);
     Future<RemoteCommandResponse> _onAcquireConn(std::shared_ptr<CommandState> state,
                                                  Future<RemoteCommandResponse> future,
                                                  CommandState::ConnHandle conn,
                                                  const transport::BatonHandle& baton);
+    void _coalesceCommand(std::shared_ptr<CommandState> state);
+    void _startCoalescedBatch(const HostAndPort& target);
+    void _runCoalescedBatch(std::vector<std::shared_ptr<CommandState>> states,
+                            CommandState::ConnHandle conn);
+    void _completeCoalescedCommand(std::shared_ptr<CommandState> state,
+                                   std::shared_ptr<CoalescedBatch> batch,
+                                   StatusWith<RemoteCommandResponse> swr);
 
     std::string _instanceName;
     ServiceContext* _svcCtx;
@@ -138,6 +161,8 @@ private:
     stdx::unordered_map<TaskExecutor::CallbackHandle, std::shared_ptr<CommandState>> _inProgress;
     stdx::unordered_set<std::shared_ptr<transport::ReactorTimer>> _inProgressAlarms;
 
+    RemoteCommandCoalescer<std::shared_ptr<CommandState>> _coalescer;
+
     stdx::condition_variable _workReadyCond;
     bool _isExecutorRunnable = false;
 };
@@ -0,0 +1,232 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/executor/network_interface_tl.h"
+
+#include "mongo/client/mock_server_session.h"
+#include "mongo/db/server_parameters_test_util.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/executor/connection_pool_stats.h"
+#include "mongo/executor/network_interface_integration_fixture.h"
+#include "mongo/rpc/factory.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/transport/transport_layer_asio.h"
+#include "mongo/transport/transport_layer_mock.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/notification.h"
+
+namespace mongo {
+namespace executor {
+namespace {
+
+const HostAndPort kHost("localhost", 27017);
+
+/**
+ * Connects every session to a MockServerSession, on a real reactor so that timers work.
+ */
+class MockServerTransportLayer : public transport::TransportLayerMock {
+public:
+    MockServerTransportLayer()
+        : _reactor(transport::TransportLayerASIO(transport::TransportLayerASIO::Options(), nullptr)
+                       .getReactor(kNewReactor)) {}
+
+    Future<transport::SessionHandle> asyncConnect(HostAndPort peer,
+                                                  transport::ConnectSSLMode sslMode,
+                                                  const transport::ReactorHandle& reactor,
+                                                  Milliseconds timeout) override {
+        auto session = std::make_shared<MockServerSession>(this, reactor, true);
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _connected.push_back(session);
+        _connectedCV.notify_all();
+        return Future<transport::SessionHandle>::makeReady(std::move(session));
+    }
+
+    transport::ReactorHandle getReactor(WhichReactor which) override {
+        return _reactor;
+    }
+
+    /**
+     * Waits for the given number of sessions to be connected and returns the last of them.
+     */
+    std::shared_ptr<MockServerSession> waitForSession(size_t count) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _connectedCV.wait(lk, [&] { return _connected.size() >= count; });
+        return _connected[count - 1];
+    }
+
+    size_t numSessions() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _connected.size();
+    }
+
+private:
+    const transport::ReactorHandle _reactor;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _connectedCV;
+    std::vector<std::shared_ptr<MockServerSession>> _connected;
+};
+
+class NetworkInterfaceTLCoalescingTest : public ServiceContextTest {
+public:
+    void setUp() override {
+        auto tl = stdx::make_unique<MockServerTransportLayer>();
+        _tl = tl.get();
+        getServiceContext()->setTransportLayer(std::move(tl));
+
+        ConnectionPool::Options options;
+        options.minConnections = 0;
+        _net = stdx::make_unique<NetworkInterfaceTL>(
+            "NetworkInterfaceTLCoalescingTest", options, getServiceContext(), nullptr, nullptr);
+        _net->startup();
+
+        // Open the connection which the tests' commands are coalesced onto.
+        auto warmUp = startCommand(makeCallbackHandle());
+        _session = _tl->waitForSession(1);
+        _session->replyToIsMaster();
+        echo(_session->waitForRequest());
+        ASSERT_OK(warmUp.get().status);
+        assertPooledConnections(0, 1);
+    }
+
+    void tearDown() override {
+        _net->shutdown();
+    }
+
+    Future<RemoteCommandResponse> startCommand(
+        const TaskExecutor::CallbackHandle& cbHandle,
+        Milliseconds timeout = RemoteCommandRequest::kNoTimeout) {
+        RemoteCommandRequest request(
+            kHost, "admin", BSON("echo" << 1 << "n" << _nextN++), nullptr, timeout);
+        return _net->startCommand(cbHandle, request);
+    }
+
+    /**
+     * Holds up the reactor thread until the returned notification is set, so that commands started
+     * in the meantime are coalesced into one batch.
+     */
+    std::shared_ptr<Notification<void>> pauseReactor() {
+        auto resume = std::make_shared<Notification<void>>();
+        _tl->getReactor(transport::TransportLayer::kNewReactor)
+            ->schedule(transport::Reactor::kPost, [resume] { resume->get(); });
+        return resume;
+    }
+
+    void echo(const Message& request) {
+        auto n = rpc::opMsgRequestFromAnyProtocol(request).body["n"].numberInt();
+        _session->reply(request, BSON("ok" << 1 << "n" << n));
+    }
+
+    void assertPooledConnections(size_t inUse, size_t available) {
+        ConnectionPoolStats stats;
+        _net->appendConnectionStats(&stats);
+        ASSERT_EQ(stats.statsByHost[kHost].inUse, inUse);
+        ASSERT_EQ(stats.statsByHost[kHost].available, available);
+    }
+
+protected:
+    ServerParameterControllerForTest _maxCoalesced{"maxCoalescedRemoteCommands", "4"};
+
+    MockServerTransportLayer* _tl;
+    std::unique_ptr<NetworkInterface> _net;
+    std::shared_ptr<MockServerSession> _session;
+
+private:
+    int _nextN = 0;
+};
+
+TEST_F(NetworkInterfaceTLCoalescingTest, ConnectionReturnsToPoolAfterLastReply) {
+    auto resume = pauseReactor();
+    auto first = startCommand(makeCallbackHandle());
+    auto second = startCommand(makeCallbackHandle());
+    resume->set();
+
+    // Both commands are written to the pooled connection before either is answered.
+    auto firstRequest = _session->waitForRequest();
+    auto secondRequest = _session->waitForRequest();
+
+    echo(secondRequest);
+    ASSERT_OK(second.get().status);
+    assertPooledConnections(1, 0);
+
+    echo(firstRequest);
+    ASSERT_OK(first.get().status);
+    assertPooledConnections(0, 1);
+    ASSERT_EQ(_tl->numSessions(), 1U);
+}
+
+TEST_F(NetworkInterfaceTLCoalescingTest, TimeoutFailsOnlyThatCommand) {
+    auto resume = pauseReactor();
+    auto timingOut = startCommand(makeCallbackHandle(), Milliseconds(100));
+    auto other = startCommand(makeCallbackHandle());
+    resume->set();
+
+    auto timingOutRequest = _session->waitForRequest();
+    auto otherRequest = _session->waitForRequest();
+
+    ASSERT_EQ(timingOut.get().status, ErrorCodes::NetworkInterfaceExceededTimeLimit);
+    ASSERT_FALSE(other.isReady());
+    assertPooledConnections(1, 0);
+
+    // The late reply to the command which timed out is read and dropped, and the connection is
+    // still good for the pool afterwards.
+    echo(timingOutRequest);
+    echo(otherRequest);
+    ASSERT_OK(other.get().status);
+    assertPooledConnections(0, 1);
+}
+
+TEST_F(NetworkInterfaceTLCoalescingTest, CancelFailsOnlyThatCommand) {
+    auto canceledHandle = makeCallbackHandle();
+
+    auto resume = pauseReactor();
+    auto canceled = startCommand(canceledHandle);
+    auto other = startCommand(makeCallbackHandle());
+    resume->set();
+
+    auto canceledRequest = _session->waitForRequest();
+    auto otherRequest = _session->waitForRequest();
+
+    _net->cancelCommand(canceledHandle);
+    ASSERT_EQ(canceled.get().status, ErrorCodes::CallbackCanceled);
+    ASSERT_FALSE(other.isReady());
+    assertPooledConnections(1, 0);
+
+    echo(canceledRequest);
+    echo(otherRequest);
+    ASSERT_OK(other.get().status);
+    assertPooledConnections(0, 1);
+}
+
+}  // namespace
+}  // namespace executor
+}  // namespace mongo
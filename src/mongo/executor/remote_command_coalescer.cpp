@@ -0,0 +1,97 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/executor/remote_command_coalescer.h"
+
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+namespace executor {
+namespace {
+
+MONGO_EXPORT_SERVER_PARAMETER(maxCoalescedRemoteCommands, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 64) {
+            return Status(ErrorCodes::BadValue,
+                          "maxCoalescedRemoteCommands must be between 1 and 64");
+        }
+        return Status::OK();
+    });
+
+/**
+ * Returns true if the command may wait on something other than its own work, such as new data, a
+ * lock or replication, before it responds.
+ */
+bool mayBlock(const BSONObj& cmdObj) {
+    const StringData commandName = cmdObj.firstElementFieldName();
+    if (commandName == "getMore" || commandName == "sleep" || commandName == "fsync" ||
+        commandName == "replSetStepDown" || commandName == "_recvChunkStatus" ||
+        commandName == "_flushRoutingTableCacheUpdates") {
+        return true;
+    }
+
+    if (cmdObj.hasField("maxTimeMS") || cmdObj["awaitData"].trueValue() ||
+        cmdObj["tailable"].trueValue()) {
+        return true;
+    }
+
+    // Anything other than an unacknowledged or a plain acknowledged write waits for journaling or
+    // replication.
+    const auto writeConcern = cmdObj["writeConcern"];
+    if (writeConcern.type() == Object) {
+        const auto w = writeConcern.Obj()["w"];
+        if (!w.eoo() && !(w.isNumber() && w.numberLong() <= 1)) {
+            return true;
+        }
+        if (writeConcern.Obj()["j"].trueValue() || writeConcern.Obj()["fsync"].trueValue()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}  // namespace
+
+const int kMaxCoalescedRemoteCommandBytes = 16 * 1024;
+
+bool canCoalesceRemoteCommand(const RemoteCommandRequest& request,
+                              const transport::BatonHandle& baton) {
+    return !baton &&
+        request.cmdObj.objsize() + request.metadata.objsize() <= kMaxCoalescedRemoteCommandBytes &&
+        !mayBlock(request.cmdObj);
+}
+
+size_t getMaxCoalescedRemoteCommands() {
+    return maxCoalescedRemoteCommands.load();
+}
+
+}  // namespace executor
+}  // namespace mongo
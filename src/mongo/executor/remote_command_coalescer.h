@@ -0,0 +1,128 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/executor/remote_command_request.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/transport/baton.h"
+#include "mongo/util/net/hostandport.h"
+
+namespace mongo {
+namespace executor {
+
+/**
+ * Requests whose command object and metadata together are larger than this are never coalesced,
+ * so that the later members of a batch are not held up behind a large write.
+ */
+extern const int kMaxCoalescedRemoteCommandBytes;
+
+/**
+ * Returns true if the given request may be sent to its target as one of a batch of coalesced
+ * requests. Only small requests which are not run on a baton qualify. Since the commands of a
+ * batch run one after another, commands which may block, such as getMore, commands carrying
+ * maxTimeMS or awaitData, and writes waiting for replication, are never coalesced.
+ */
+bool canCoalesceRemoteCommand(const RemoteCommandRequest& request,
+                              const transport::BatonHandle& baton);
+
+/**
+ * Returns the largest number of requests which may currently be sent to a host as one batch, as
+ * set by the maxCoalescedRemoteCommands server parameter. A value of 1 disables coalescing.
+ */
+size_t getMaxCoalescedRemoteCommands();
+
+/**
+ * Collects commands to the same host which are started close together, so that they can be sent
+ * over a single connection checkout instead of each taking its own.
+ *
+ * Commands are queued with add(). The command which finds its host's queue empty makes add()
+ * return true, and the caller is then responsible for calling takeBatch() for that host once it
+ * is ready to send, typically after it has checked a connection out. Every command which arrives
+ * in the meantime joins the same batch. If takeBatch() leaves commands behind, the caller must
+ * call it again for them.
+ *
+ * This class is thread safe.
+ */
+template <typename Command>
+class RemoteCommandCoalescer {
+    MONGO_DISALLOW_COPYING(RemoteCommandCoalescer);
+
+public:
+    RemoteCommandCoalescer() = default;
+
+    /**
+     * Queues a command for the given host. Returns true if the host had no commands queued.
+     */
+    bool add(const HostAndPort& target, Command command) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto& queue = _queues[target];
+        queue.push_back(std::move(command));
+        return queue.size() == 1;
+    }
+
+    /**
+     * Removes up to 'maxBatchSize' of the commands queued for the given host, in the order in
+     * which they were added. Sets 'more' to whether any commands remain queued for the host.
+     */
+    std::vector<Command> takeBatch(const HostAndPort& target, size_t maxBatchSize, bool* more) {
+        std::vector<Command> batch;
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto iter = _queues.find(target);
+        if (iter == _queues.end()) {
+            *more = false;
+            return batch;
+        }
+
+        auto& queue = iter->second;
+        while (!queue.empty() && batch.size() < maxBatchSize) {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+
+        *more = !queue.empty();
+        if (!*more) {
+            _queues.erase(iter);
+        }
+
+        return batch;
+    }
+
+private:
+    stdx::mutex _mutex;
+    stdx::unordered_map<HostAndPort, std::deque<Command>> _queues;
+};
+
+}  // namespace executor
+}  // namespace mongo
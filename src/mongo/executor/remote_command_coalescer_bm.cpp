@@ -0,0 +1,225 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/executor/network_interface_mock.h"
+#include "mongo/executor/remote_command_coalescer.h"
+#include "mongo/executor/thread_pool_task_executor.h"
+#include "mongo/executor/thread_pool_task_executor_test_fixture.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+
+namespace mongo {
+namespace executor {
+namespace {
+
+const HostAndPort kTarget("FakeShardHost", 12345);
+
+// Every benchmark iteration sends a burst of small commands to the host over a limited number of
+// connections. The host answers each round trip after a fixed latency, plus the time to run each
+// of the commands of the round trip, one after another.
+const int kNumCommands = 64;
+const int kNumConnections = 4;
+const Milliseconds kRoundTripLatency(10);
+const Milliseconds kPerCommandLatency(1);
+
+/**
+ * Runs bursts of kNumCommands through a RemoteCommandCoalescer and a TaskExecutor backed by a
+ * NetworkInterfaceMock, sending up to 'batchSize' commands per round trip, which is what
+ * NetworkInterfaceTL does when maxCoalescedRemoteCommands is set to 'batchSize'. Keeps track of
+ * how long, in mock network time, the commands take and how long the whole burst takes.
+ */
+class CoalescingBenchmark {
+public:
+    explicit CoalescingBenchmark(size_t batchSize) : _batchSize(batchSize) {
+        auto net = stdx::make_unique<NetworkInterfaceMock>();
+        _net = net.get();
+        _executor = makeThreadPoolTestExecutor(std::move(net));
+        _executor->startup();
+    }
+
+    ~CoalescingBenchmark() {
+        _executor->shutdown();
+        _net->enterNetwork();
+        _net->runReadyNetworkOperations();
+        _net->exitNetwork();
+        _executor->join();
+    }
+
+    void runBurst() {
+        _remaining.store(kNumCommands);
+        _burstStart = _net->now();
+
+        for (int i = 0; i < kNumCommands; i++) {
+            _coalescer.add(kTarget,
+                           RemoteCommandRequest(kTarget, "admin", BSON("ping" << 1), nullptr));
+        }
+
+        for (int i = 0; i < kNumConnections; i++) {
+            _sendBatch();
+        }
+
+        _net->enterNetwork();
+        while (_remaining.load()) {
+            while (_net->hasReadyRequests()) {
+                auto noi = _net->getNextReadyRequest();
+                const auto sent = [&] {
+                    stdx::lock_guard<stdx::mutex> lk(_mutex);
+                    return _sent.at(noi->getRequest().id);
+                }();
+
+                const auto latency = kRoundTripLatency + kPerCommandLatency * (sent.position + 1);
+                _net->scheduleResponse(noi,
+                                       sent.batch->sentAt + latency,
+                                       RemoteCommandResponse(BSON("ok" << 1), BSONObj(), latency));
+            }
+
+            _net->runUntil(_net->now() + kRoundTripLatency);
+        }
+        _net->exitNetwork();
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _sent.clear();
+    }
+
+    Milliseconds totalCommandLatency() const {
+        return _totalCommandLatency;
+    }
+
+    Milliseconds totalBurstLatency() const {
+        return _totalBurstLatency;
+    }
+
+private:
+    struct Batch {
+        Date_t sentAt;
+        size_t outstanding;
+    };
+
+    struct SentCommand {
+        std::shared_ptr<Batch> batch;
+        int position;
+    };
+
+    /**
+     * Sends the next batch of queued commands, standing in for a connection which has just been
+     * checked out.
+     */
+    void _sendBatch() {
+        bool more = false;
+        auto requests = _coalescer.takeBatch(kTarget, _batchSize, &more);
+        if (requests.empty()) {
+            return;
+        }
+
+        auto batch = std::make_shared<Batch>();
+        batch->sentAt = _net->now();
+        batch->outstanding = requests.size();
+
+        for (size_t i = 0; i < requests.size(); i++) {
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                _sent.emplace(requests[i].id, SentCommand{batch, static_cast<int>(i)});
+            }
+
+            uassertStatusOK(_executor->scheduleRemoteCommand(
+                requests[i], [this, batch](const TaskExecutor::RemoteCommandCallbackArgs& args) {
+                    invariant(args.response.isOK());
+                    _onResponse(batch);
+                }));
+        }
+    }
+
+    void _onResponse(const std::shared_ptr<Batch>& batch) {
+        const auto now = _net->now();
+
+        bool batchDone;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _totalCommandLatency += now - _burstStart;
+            batchDone = --batch->outstanding == 0;
+            if (_remaining.load() == 1) {
+                _totalBurstLatency += now - _burstStart;
+            }
+        }
+
+        // Only once every command of the round trip has been answered is the connection free for
+        // the next batch.
+        if (batchDone) {
+            _sendBatch();
+        }
+
+        _remaining.subtractAndFetch(1);
+    }
+
+    const size_t _batchSize;
+    RemoteCommandCoalescer<RemoteCommandRequest> _coalescer;
+
+    std::unique_ptr<ThreadPoolTaskExecutor> _executor;
+    NetworkInterfaceMock* _net;
+
+    AtomicWord<int> _remaining{0};
+    Date_t _burstStart;
+
+    stdx::mutex _mutex;
+    stdx::unordered_map<RemoteCommandRequest::RequestId, SentCommand> _sent;
+    Milliseconds _totalCommandLatency{0};
+    Milliseconds _totalBurstLatency{0};
+};
+
+/**
+ * Reports the mean latency of a command and of a burst of commands, in mock network time, along
+ * with the throughput in commands per second of mock network time. The wall clock time shows the
+ * cost of the coalescing and executor machinery itself.
+ */
+void BM_CoalescedCommands(benchmark::State& state) {
+    CoalescingBenchmark bm(state.range(0));
+
+    for (auto _ : state) {
+        bm.runBurst();
+    }
+
+    const double numBursts = state.iterations();
+    const double burstMillis = durationCount<Milliseconds>(bm.totalBurstLatency()) / numBursts;
+    state.counters["commandLatencyMillis"] =
+        durationCount<Milliseconds>(bm.totalCommandLatency()) / (numBursts * kNumCommands);
+    state.counters["burstLatencyMillis"] = burstMillis;
+    state.counters["commandsPerNetworkSecond"] = kNumCommands * 1000 / burstMillis;
+    state.SetItemsProcessed(state.iterations() * kNumCommands);
+}
+
+BENCHMARK(BM_CoalescedCommands)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+}  // namespace
+}  // namespace executor
+}  // namespace mongo
@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/executor/remote_command_coalescer.h"
+
+#include "mongo/db/server_parameters_test_util.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace executor {
+namespace {
+
+const HostAndPort kHostA("a", 27017);
+const HostAndPort kHostB("b", 27017);
+
+TEST(RemoteCommandCoalescerTest, FirstCommandPerHostStartsBatch) {
+    RemoteCommandCoalescer<int> coalescer;
+    ASSERT_TRUE(coalescer.add(kHostA, 1));
+    ASSERT_FALSE(coalescer.add(kHostA, 2));
+    ASSERT_TRUE(coalescer.add(kHostB, 3));
+    ASSERT_FALSE(coalescer.add(kHostB, 4));
+}
+
+TEST(RemoteCommandCoalescerTest, TakeBatchKeepsOrderAndHosts) {
+    RemoteCommandCoalescer<int> coalescer;
+    coalescer.add(kHostA, 1);
+    coalescer.add(kHostB, 2);
+    coalescer.add(kHostA, 3);
+
+    bool more = true;
+    ASSERT(coalescer.takeBatch(kHostA, 8, &more) == std::vector<int>({1, 3}));
+    ASSERT_FALSE(more);
+
+    ASSERT(coalescer.takeBatch(kHostB, 8, &more) == std::vector<int>({2}));
+    ASSERT_FALSE(more);
+
+    ASSERT(coalescer.takeBatch(kHostA, 8, &more).empty());
+    ASSERT_FALSE(more);
+
+    // Once a host's queue has been emptied, the next command starts a new batch
+    ASSERT_TRUE(coalescer.add(kHostA, 4));
+}
+
+TEST(RemoteCommandCoalescerTest, TakeBatchHonorsMaxBatchSize) {
+    RemoteCommandCoalescer<int> coalescer;
+    for (int i = 0; i < 5; i++) {
+        coalescer.add(kHostA, i);
+    }
+
+    bool more = false;
+    ASSERT(coalescer.takeBatch(kHostA, 2, &more) == std::vector<int>({0, 1}));
+    ASSERT_TRUE(more);
+
+    // Commands added while others remain queued join them rather than starting a new batch
+    ASSERT_FALSE(coalescer.add(kHostA, 5));
+
+    ASSERT(coalescer.takeBatch(kHostA, 2, &more) == std::vector<int>({2, 3}));
+    ASSERT_TRUE(more);
+    ASSERT(coalescer.takeBatch(kHostA, 2, &more) == std::vector<int>({4, 5}));
+    ASSERT_FALSE(more);
+}
+
+TEST(RemoteCommandCoalescerTest, CanCoalesceOnlySmallRequestsWithoutBaton) {
+    RemoteCommandRequest small(kHostA, "admin", BSON("ping" << 1), nullptr);
+    ASSERT_TRUE(canCoalesceRemoteCommand(small, nullptr));
+
+    RemoteCommandRequest large(kHostA,
+                               "admin",
+                               BSON("ping" << 1 << "padding"
+                                           << std::string(kMaxCoalescedRemoteCommandBytes, 'x')),
+                               nullptr);
+    ASSERT_FALSE(canCoalesceRemoteCommand(large, nullptr));
+}
+
+TEST(RemoteCommandCoalescerTest, CannotCoalescePotentiallyBlockingRequests) {
+    auto canCoalesce = [](const BSONObj& cmdObj) {
+        return canCoalesceRemoteCommand(RemoteCommandRequest(kHostA, "test", cmdObj, nullptr),
+                                        nullptr);
+    };
+
+    ASSERT_TRUE(canCoalesce(BSON("find"
+                                 << "coll")));
+    ASSERT_TRUE(canCoalesce(BSON("insert"
+                                 << "coll"
+                                 << "writeConcern"
+                                 << BSON("w" << 1))));
+
+    ASSERT_FALSE(canCoalesce(BSON("getMore" << 1LL << "collection"
+                                            << "coll")));
+    ASSERT_FALSE(canCoalesce(BSON("find"
+                                  << "coll"
+                                  << "maxTimeMS"
+                                  << 1000)));
+    ASSERT_FALSE(canCoalesce(BSON("find"
+                                  << "coll"
+                                  << "tailable"
+                                  << true
+                                  << "awaitData"
+                                  << true)));
+    ASSERT_FALSE(canCoalesce(BSON("insert"
+                                  << "coll"
+                                  << "writeConcern"
+                                  << BSON("w"
+                                          << "majority"))));
+    ASSERT_FALSE(canCoalesce(BSON("insert"
+                                  << "coll"
+                                  << "writeConcern"
+                                  << BSON("w" << 1 << "j" << true))));
+    ASSERT_FALSE(canCoalesce(BSON("sleep" << 1 << "secs" << 1)));
+}
+
+TEST(RemoteCommandCoalescerTest, MaxCoalescedRemoteCommands) {
+    ASSERT_EQ(getMaxCoalescedRemoteCommands(), 1U);
+
+    {
+        ServerParameterControllerForTest maxCoalesced("maxCoalescedRemoteCommands", "16");
+        ASSERT_EQ(getMaxCoalescedRemoteCommands(), 16U);
+
+        ASSERT_THROWS_CODE(ServerParameterControllerForTest("maxCoalescedRemoteCommands", "0"),
+                           AssertionException,
+                           ErrorCodes::BadValue);
+        ASSERT_THROWS_CODE(ServerParameterControllerForTest("maxCoalescedRemoteCommands", "65"),
+                           AssertionException,
+                           ErrorCodes::BadValue);
+        ASSERT_EQ(getMaxCoalescedRemoteCommands(), 16U);
+    }
+    ASSERT_EQ(getMaxCoalescedRemoteCommands(), 1U);
+}
+
+}  // namespace
+}  // namespace executor
+}  // namespace mongo
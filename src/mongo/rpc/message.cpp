@@ -38,6 +38,31 @@ namespace {
 AtomicWord<int32_t> NextMsgId;
 }  // namespace
 
+size_t Message::firstSegmentSize() const {
+    size_t size = this->size();
+    for (auto&& segment : _segments) {
+        size -= segment.size;
+    }
+    return size;
+}
+
+void Message::_flattenSegments() const {
+    const size_t size = this->size();
+    const size_t firstSize = firstSegmentSize();
+    auto flattened = SharedBuffer::allocate(size);
+    memcpy(flattened.get(), _buf.get(), firstSize);
+
+    size_t offset = firstSize;
+    for (auto&& segment : _segments) {
+        memcpy(flattened.get() + offset, segment.data, segment.size);
+        offset += segment.size;
+    }
+    invariant(offset == size);
+
+    _buf = std::move(flattened);
+    _segments.clear();
+}
+
 int32_t nextMessageId() {
     return NextMsgId.fetchAndAdd(1);
 }
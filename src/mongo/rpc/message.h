@@ -29,12 +29,14 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "mongo/base/data_type_endian.h"
 #include "mongo/base/data_view.h"
 #include "mongo/base/encoded_value_storage.h"
 #include "mongo/base/static_assert.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -393,18 +395,57 @@ inline int ConstView::dataLen() const {
 
 }  // namespace MsgData
 
+/**
+ * A wire protocol message.
+ *
+ * A message is normally held in a single buffer. A message may also be segmented, in which case the
+ * first buffer holds the header and the beginning of the message, and the rest of the message
+ * follows in a chain of segments which may live in buffers owned by someone else. Segmented
+ * messages let large messages be built without reallocating and be sent with gather writes.
+ *
+ * Accessors which expose the contents of the message as one contiguous range (header(),
+ * singleData(), buf() and sharedBuffer()) flatten a segmented message into a single buffer first.
+ * Code that only needs the fixed header fields should use firstSegment() instead.
+ */
 class Message {
 public:
+    /**
+     * A range of bytes in a buffer which is kept alive by owner.
+     */
+    struct Segment {
+        ConstSharedBuffer owner;
+        const char* data;
+        size_t size;
+    };
+
     Message() = default;
     explicit Message(SharedBuffer data) : _buf(std::move(data)) {}
 
+    /**
+     * Constructs a segmented message. The first buffer must hold at least the message header, whose
+     * length covers the first buffer's bytes and all of the segments, and the flags of an OP_MSG.
+     */
+    Message(SharedBuffer first, std::vector<Segment> segments)
+        : _buf(std::move(first)), _segments(std::move(segments)) {}
+
     MsgData::View header() const {
+        verify(!empty());
+        _flatten();
+        return _buf.get();
+    }
+
+    /**
+     * Returns a view of the message's first buffer. Unlike header(), this does not flatten a
+     * segmented message, so only the fixed header fields and the bytes of the first buffer may be
+     * accessed through it.
+     */
+    MsgData::View firstSegment() const {
         verify(!empty());
         return _buf.get();
     }
 
     NetworkOp operation() const {
-        return header().getNetworkOp();
+        return firstSegment().getNetworkOp();
     }
 
     MsgData::View singleData() const {
@@ -427,8 +468,28 @@ public:
         return size() - sizeof(MSGHEADER::Value);
     }
 
+    /**
+     * Returns true if the message is held in more than one buffer.
+     */
+    bool isSegmented() const {
+        return !_segments.empty();
+    }
+
+    /**
+     * Returns the number of bytes of the message which are held in the first buffer.
+     */
+    size_t firstSegmentSize() const;
+
+    /**
+     * Returns the segments which follow the first buffer of a segmented message.
+     */
+    const std::vector<Segment>& segments() const {
+        return _segments;
+    }
+
     void reset() {
         _buf = {};
+        _segments.clear();
     }
 
     // use to set first buffer if empty
@@ -451,23 +512,41 @@ public:
     }
 
     char* buf() {
+        _flatten();
         return _buf.get();
     }
 
     const char* buf() const {
+        _flatten();
         return _buf.get();
     }
 
     SharedBuffer sharedBuffer() {
+        _flatten();
         return _buf;
     }
 
     ConstSharedBuffer sharedBuffer() const {
+        _flatten();
         return _buf;
     }
 
 private:
-    SharedBuffer _buf;
+    /**
+     * Copies a segmented message into a single buffer. Does nothing if the message is not
+     * segmented.
+     */
+    void _flatten() const {
+        if (isSegmented()) {
+            _flattenSegments();
+        }
+    }
+    void _flattenSegments() const;
+
+    // These are mutable so that the const accessors can flatten a segmented message. Like any other
+    // modification, this makes it unsafe to use the same Message from several threads at once.
+    mutable SharedBuffer _buf;
+    mutable std::vector<Segment> _segments;
 };
 
 /**
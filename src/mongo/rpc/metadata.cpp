@@ -32,6 +32,7 @@
 
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/command_generic_argument.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/logical_clock.h"
 #include "mongo/db/logical_time_validator.h"
@@ -51,30 +52,38 @@ BSONObj makeEmptyMetadata() {
 }
 
 void readRequestMetadata(OperationContext* opCtx, const BSONObj& metadataObj, bool requiresAuth) {
-    BSONElement readPreferenceElem;
-    BSONElement auditElem;
-    BSONElement configSvrElem;
-    BSONElement trackingElem;
-    BSONElement clientElem;
-    BSONElement logicalTimeElem;
+    GenericArguments genericArgs;
 
     for (const auto& metadataElem : metadataObj) {
         auto fieldName = metadataElem.fieldNameStringData();
         if (fieldName == "$readPreference") {
-            readPreferenceElem = metadataElem;
+            genericArgs.readPreference = metadataElem;
         } else if (fieldName == AuditMetadata::fieldName()) {
-            auditElem = metadataElem;
+            genericArgs.audit = metadataElem;
         } else if (fieldName == ConfigServerMetadata::fieldName()) {
-            configSvrElem = metadataElem;
+            genericArgs.configServerState = metadataElem;
         } else if (fieldName == ClientMetadata::fieldName()) {
-            clientElem = metadataElem;
+            genericArgs.client = metadataElem;
         } else if (fieldName == TrackingMetadata::fieldName()) {
-            trackingElem = metadataElem;
+            genericArgs.trackingInfo = metadataElem;
         } else if (fieldName == LogicalTimeMetadata::fieldName()) {
-            logicalTimeElem = metadataElem;
+            genericArgs.clusterTime = metadataElem;
         }
     }
 
+    readRequestMetadata(opCtx, genericArgs, requiresAuth);
+}
+
+void readRequestMetadata(OperationContext* opCtx,
+                         const GenericArguments& genericArgs,
+                         bool requiresAuth) {
+    BSONElement readPreferenceElem = genericArgs.readPreference;
+    BSONElement auditElem = genericArgs.audit;
+    BSONElement configSvrElem = genericArgs.configServerState;
+    BSONElement clientElem = genericArgs.client;
+    BSONElement trackingElem = genericArgs.trackingInfo;
+    BSONElement logicalTimeElem = genericArgs.clusterTime;
+
     if (readPreferenceElem) {
         ReadPreferenceSetting::get(opCtx) =
             uassertStatusOK(ReadPreferenceSetting::fromInnerBSON(readPreferenceElem));
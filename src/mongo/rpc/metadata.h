@@ -39,6 +39,7 @@ class BSONObj;
 class BSONObjBuilder;
 class OperationContext;
 class StringData;
+struct GenericArguments;
 
 /**
  * Utilities for converting metadata between the legacy OP_QUERY format and the new
@@ -56,6 +57,14 @@ BSONObj makeEmptyMetadata();
  */
 void readRequestMetadata(OperationContext* opCtx, const BSONObj& metadataObj, bool requiresAuth);
 
+/**
+ * Same as above, but takes the metadata elements from a request body which has already been
+ * scanned.
+ */
+void readRequestMetadata(OperationContext* opCtx,
+                         const GenericArguments& genericArgs,
+                         bool requiresAuth);
+
 /**
  * A legacy command object and a corresponding query flags bitfield. The legacy command object
  * may contain metadata fields, so it cannot safely be passed to a command's run method.
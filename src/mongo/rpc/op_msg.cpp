@@ -45,7 +45,7 @@
 namespace mongo {
 namespace {
 
-auto kAllSupportedFlags = OpMsg::kChecksumPresent | OpMsg::kMoreToCome;
+auto kAllSupportedFlags = OpMsg::kChecksumPresent | OpMsg::kMoreToCome | OpMsg::kExhaustAllowed;
 
 bool containsUnknownRequiredFlags(uint32_t flags) {
     const uint32_t kRequiredFlagMask = 0xffff;  // Low 2 bytes are required, high 2 are optional.
@@ -63,7 +63,8 @@ uint32_t OpMsg::flags(const Message& message) {
     if (message.operation() != dbMsg)
         return 0;  // Other command protocols are the same as no flags set.
 
-    return BufReader(message.singleData().data(), message.dataSize())
+    // The flags are always in the first buffer, so a segmented message need not be flattened.
+    return BufReader(message.firstSegment().data(), message.dataSize())
         .read<LittleEndian<uint32_t>>();
 }
 
@@ -72,7 +73,7 @@ void OpMsg::replaceFlags(Message* message, uint32_t flags) {
     invariant(message->operation() == dbMsg);
     invariant(message->dataSize() >= static_cast<int>(sizeof(uint32_t)));
 
-    DataView(message->singleData().data()).write<LittleEndian<uint32_t>>(flags);
+    DataView(message->firstSegment().data()).write<LittleEndian<uint32_t>>(flags);
 }
 
 OpMsg OpMsg::parse(const Message& message) try {
@@ -183,25 +184,84 @@ void OpMsg::shareOwnershipWith(const ConstSharedBuffer& buffer) {
     }
 }
 
+constexpr int OpMsgBuilder::kSegmentBytes;
+constexpr int OpMsgBuilder::kMinReferencedDocumentBytes;
+
 auto OpMsgBuilder::beginDocSequence(StringData name) -> DocSequenceBuilder {
     invariant(_state == kEmpty || _state == kDocSequence);
     invariant(!_openBuilder);
     _openBuilder = true;
     _state = kDocSequence;
     _buf.appendStruct(Section::kDocSequence);
-    int sizeOffset = _buf.len();
+    _docSequenceStart = _segmentedBytes + _buf.len();
     _buf.skip(sizeof(int32_t));  // section size.
     _buf.appendStr(name, true);
-    return DocSequenceBuilder(this, &_buf, sizeOffset);
+    return DocSequenceBuilder(this, &_buf);
 }
 
 void OpMsgBuilder::finishDocumentStream(DocSequenceBuilder* docSequenceBuilder) {
     invariant(_state == kDocSequence);
     invariant(_openBuilder);
     _openBuilder = false;
-    const int32_t size = _buf.len() - docSequenceBuilder->_sizeOffset;
+    const int32_t size = _segmentedBytes + _buf.len() - _docSequenceStart;
     invariant(size > 0);
-    DataView(_buf.buf()).write<LittleEndian<int32_t>>(size, docSequenceBuilder->_sizeOffset);
+
+    char* sizeField = _docSequenceSizeField;
+    if (!sizeField) {
+        sizeField = _buf.buf() + (_docSequenceStart - _segmentedBytes);
+    }
+    DataView(sizeField).write<LittleEndian<int32_t>>(size);
+    _docSequenceSizeField = nullptr;
+}
+
+void OpMsgBuilder::appendToDocSequence(const BSONObj& obj) {
+    invariant(_state == kDocSequence);
+    invariant(_openBuilder);
+
+    const int size = obj.objsize();
+    if (obj.isOwned() && size >= kMinReferencedDocumentBytes) {
+        // The owner's buffer is immutable and stays alive as long as the message does, so the
+        // message can be sent straight from it.
+        if (_buf.len() > 0) {
+            startNewSegment(0);
+        }
+        _segments.push_back({obj.sharedBuffer(), obj.objdata(), static_cast<size_t>(size)});
+        _segmentedBytes += size;
+        _referencedBytes += size;
+        return;
+    }
+
+    prepareToAppendToDocSequence(size);
+    _buf.appendBuf(obj.objdata(), size);
+}
+
+void OpMsgBuilder::prepareToAppendToDocSequence(int bytesNeeded) {
+    const int len = _buf.len();
+    if (len >= kSegmentBytes || len + bytesNeeded > std::max(_buf.getSize(), kSegmentBytes)) {
+        startNewSegment(std::max(bytesNeeded, kSegmentBytes));
+    }
+}
+
+void OpMsgBuilder::startNewSegment(int capacity) {
+    const int len = _buf.len();
+    if (len > 0) {
+        SharedBuffer buf = _buf.release();
+        if (_openBuilder && !_docSequenceSizeField) {
+            // The open document sequence began in this buffer, which will not move any more.
+            _docSequenceSizeField = buf.get() + (_docSequenceStart - _segmentedBytes);
+        }
+
+        if (!_firstSegment) {
+            _firstSegment = std::move(buf);
+        } else {
+            const char* data = buf.get();
+            _segments.push_back({std::move(buf), data, static_cast<size_t>(len)});
+        }
+        _segmentedBytes += len;
+    }
+
+    _buf.reset();
+    _buf.useSharedBuffer(capacity ? SharedBuffer::allocate(capacity) : SharedBuffer());
 }
 
 BSONObjBuilder OpMsgBuilder::beginBody() {
@@ -238,12 +298,20 @@ Message OpMsgBuilder::finish() {
     invariant(!_openBuilder);
     _state = kDone;
 
-    const auto size = _buf.len();
-    MSGHEADER::View header(_buf.buf());
+    const auto size = _segmentedBytes + _buf.len();
+    if (_firstSegment) {
+        startNewSegment(0);
+    }
+
+    MSGHEADER::View header(_firstSegment ? _firstSegment.get() : _buf.buf());
     header.setMessageLength(size);
     // header.setRequestMsgId(...); // These are currently filled in by the networking layer.
     // header.setResponseToMsgId(...);
     header.setOpCode(dbMsg);
+
+    if (_firstSegment) {
+        return Message(std::move(_firstSegment), std::move(_segments));
+    }
     return Message(_buf.release());
 }
 
@@ -46,6 +46,7 @@ struct OpMsg {
 
     static constexpr uint32_t kChecksumPresent = 1 << 0;
     static constexpr uint32_t kMoreToCome = 1 << 1;
+    static constexpr uint32_t kExhaustAllowed = 1 << 16;
 
     /**
      * Returns the unvalidated flags for the given message if it is an OP_MSG message.
@@ -156,11 +157,27 @@ struct OpMsgRequest : public OpMsg {
  * usage patterns, this class requires that all document sequences (if any) are built before the
  * body. This allows repeatedly appending fields to the body until right before it is ready to be
  * sent.
+ *
+ * Large document sequences make the message segmented (see Message). Once the buffer being built
+ * reaches kSegmentBytes, the builder moves on to a new buffer instead of reallocating, and large
+ * owned documents are sent from the buffers which own them instead of being copied. The body is
+ * always built in a single buffer.
  */
 class OpMsgBuilder {
     MONGO_DISALLOW_COPYING(OpMsgBuilder);
 
 public:
+    /**
+     * The size past which a document sequence continues in a new buffer.
+     */
+    static constexpr int kSegmentBytes = 1024 * 1024;
+
+    /**
+     * Owned documents at least this large are referenced by a document sequence rather than copied
+     * into it.
+     */
+    static constexpr int kMinReferencedDocumentBytes = 16 * 1024;
+
     OpMsgBuilder() {
         skipHeaderAndFlags();
     }
@@ -208,11 +225,25 @@ public:
 
         _buf.reset();
         skipHeaderAndFlags();
+        _firstSegment = {};
+        _segments.clear();
+        _segmentedBytes = 0;
+        _referencedBytes = 0;
+        _docSequenceStart = 0;
+        _docSequenceSizeField = nullptr;
         _bodyStart = 0;
         _state = kEmpty;
         _openBuilder = false;
     }
 
+    /**
+     * Returns the number of bytes of the message which were referenced from the buffers of owned
+     * documents rather than copied into the message.
+     */
+    size_t referencedBytes() const {
+        return _referencedBytes;
+    }
+
     /**
      * Set to true in tests that need to be able to generate duplicate top-level fields to see how
      * the server handles them. Is false by default, although the check only happens in debug
@@ -232,6 +263,22 @@ private:
 
     void finishDocumentStream(DocSequenceBuilder* docSequenceBuilder);
 
+    /**
+     * Appends obj to the open document sequence, referencing it if it is large and owned.
+     */
+    void appendToDocSequence(const BSONObj& obj);
+
+    /**
+     * Moves on to a new buffer if appending bytesNeeded more bytes of the open document sequence to
+     * _buf would grow it past kSegmentBytes.
+     */
+    void prepareToAppendToDocSequence(int bytesNeeded);
+
+    /**
+     * Ends the current buffer and continues the message in a new one with the given capacity.
+     */
+    void startNewSegment(int capacity);
+
     void skipHeaderAndFlags() {
         _buf.skip(sizeof(MSGHEADER::Layout));  // This is filled in by finish().
         _buf.appendNum(uint32_t(0));           // flags (currently always 0).
@@ -239,6 +286,18 @@ private:
 
     // When adding members, remember to update reset().
     BufBuilder _buf;
+
+    // The buffers which precede _buf in a segmented message. _firstSegment holds the header.
+    SharedBuffer _firstSegment;
+    std::vector<Message::Segment> _segments;
+    size_t _segmentedBytes = 0;
+    size_t _referencedBytes = 0;
+
+    // The offset of the open document sequence's size field from the start of the message, and
+    // where that field lives once it is no longer in _buf.
+    size_t _docSequenceStart = 0;
+    char* _docSequenceSizeField = nullptr;
+
     int _bodyStart = 0;
     State _state = kEmpty;
     bool _openBuilder = false;
@@ -264,7 +323,7 @@ class OpMsgBuilder::DocSequenceBuilder {
 
 public:
     DocSequenceBuilder(DocSequenceBuilder&& other)
-        : _buf(other._buf), _msgBuilder(other._msgBuilder), _sizeOffset(other._sizeOffset) {
+        : _buf(other._buf), _msgBuilder(other._msgBuilder) {
         other._buf = nullptr;
     }
 
@@ -284,10 +343,11 @@ public:
     }
 
     /**
-     * Appends a single document to this sequence.
+     * Appends a single document to this sequence. If obj is owned, the message may reference its
+     * buffer rather than copying it.
      */
     void append(const BSONObj& obj) {
-        _buf->appendBuf(obj.objdata(), obj.objsize());
+        _msgBuilder->appendToDocSequence(obj);
     }
 
     /**
@@ -296,18 +356,18 @@ public:
      * is destroyed or done()/doneFast() is called on it.
      */
     BSONObjBuilder appendBuilder() {
+        _msgBuilder->prepareToAppendToDocSequence(0);
         return BSONObjBuilder(*_buf);
     }
 
 private:
     friend OpMsgBuilder;
 
-    DocSequenceBuilder(OpMsgBuilder* msgBuilder, BufBuilder* buf, int sizeOffset)
-        : _buf(buf), _msgBuilder(msgBuilder), _sizeOffset(sizeOffset) {}
+    DocSequenceBuilder(OpMsgBuilder* msgBuilder, BufBuilder* buf)
+        : _buf(buf), _msgBuilder(msgBuilder) {}
 
     BufBuilder* _buf;
     OpMsgBuilder* const _msgBuilder;
-    const int _sizeOffset;
 };
 
 }  // namespace mongo
@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/util/builder.h"
+#include "mongo/rpc/message.h"
+#include "mongo/rpc/op_msg.h"
+
+namespace mongo {
+namespace {
+
+// The size of the document sequence in each reply, about as large as a batch can get.
+const int kReplyBytes = 16 * 1024 * 1024;
+
+std::vector<BSONObj> makeDocs(int docBytes) {
+    const std::string padding(docBytes, 'x');
+    std::vector<BSONObj> docs;
+    for (int i = 0; i * docBytes < kReplyBytes; i++) {
+        docs.push_back(BSON("_id" << i << "padding" << padding));
+    }
+    return docs;
+}
+
+/**
+ * Builds the reply in a single BufBuilder which reallocates as it grows, the way OpMsgBuilder did
+ * before it could build segmented messages. Returns the number of bytes copied. Reallocations are
+ * only counted once the buffer has reached OpMsgBuilder::kSegmentBytes, since OpMsgBuilder grows
+ * its first buffer the same way up to that size.
+ */
+size_t buildContiguousReply(const std::vector<BSONObj>& docs, Message* out) {
+    BufBuilder buf;
+    size_t copied = 0;
+    auto append = [&](const void* data, int size) {
+        const int len = buf.len();
+        const int capacity = buf.getSize();
+        buf.appendBuf(data, size);
+        copied += size;
+        if (buf.getSize() != capacity && len >= OpMsgBuilder::kSegmentBytes) {
+            copied += len;
+        }
+    };
+
+    buf.skip(sizeof(MSGHEADER::Layout));
+    buf.appendNum(uint32_t(0));
+
+    buf.appendChar(1);  // Document sequence section.
+    const int sizeOffset = buf.len();
+    buf.skip(sizeof(int32_t));
+    buf.appendStr("docs");
+    for (auto&& doc : docs) {
+        append(doc.objdata(), doc.objsize());
+    }
+    DataView(buf.buf()).write<LittleEndian<int32_t>>(buf.len() - sizeOffset, sizeOffset);
+
+    const BSONObj body = BSON("ok" << 1.0);
+    buf.appendChar(0);  // Body section.
+    append(body.objdata(), body.objsize());
+
+    MSGHEADER::View header(buf.buf());
+    header.setMessageLength(buf.len());
+    header.setOpCode(dbMsg);
+    *out = Message(buf.release());
+    return copied;
+}
+
+/**
+ * Builds the reply with OpMsgBuilder and returns the number of bytes copied into it.
+ */
+size_t buildSegmentedReply(const std::vector<BSONObj>& docs, Message* out) {
+    OpMsgBuilder builder;
+    {
+        auto seq = builder.beginDocSequence("docs");
+        for (auto&& doc : docs) {
+            seq.append(doc);
+        }
+    }
+    builder.beginBody().append("ok", 1.0);
+
+    *out = builder.finish();
+    return out->size() - builder.referencedBytes();
+}
+
+template <size_t (*build)(const std::vector<BSONObj>&, Message*)>
+void BM_BuildReply(benchmark::State& state) {
+    const auto docs = makeDocs(state.range(0));
+
+    size_t copied = 0;
+    for (auto _ : state) {
+        Message reply;
+        copied = build(docs, &reply);
+        benchmark::DoNotOptimize(reply.firstSegment().view2ptr());
+    }
+
+    state.counters["copiedBytesPerReply"] = copied;
+    state.SetBytesProcessed(state.iterations() * kReplyBytes);
+}
+
+void BM_BuildContiguousReply(benchmark::State& state) {
+    BM_BuildReply<buildContiguousReply>(state);
+}
+
+void BM_BuildSegmentedReply(benchmark::State& state) {
+    BM_BuildReply<buildSegmentedReply>(state);
+}
+
+// Small documents are always copied. Large ones are referenced by a segmented reply.
+BENCHMARK(BM_BuildContiguousReply)
+    ->Arg(1024)
+    ->Arg(OpMsgBuilder::kMinReferencedDocumentBytes * 4)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BuildSegmentedReply)
+    ->Arg(1024)
+    ->Arg(OpMsgBuilder::kMinReferencedDocumentBytes * 4)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace mongo
@@ -824,6 +824,88 @@ TEST(OpMsgSerializer, SetFlagWorks) {
     }
 }
 
+TEST(OpMsgSerializer, LargeSequenceIsSegmented) {
+    const std::string padding(1000, 'x');
+    const int kNumDocs = 3 * OpMsgBuilder::kSegmentBytes / 1000;
+
+    OpMsgBuilder builder;
+    {
+        auto seq = builder.beginDocSequence("docs");
+        for (int i = 0; i < kNumDocs; i++) {
+            seq.append(BSON("a" << i << "padding" << padding));
+        }
+    }
+    builder.beginBody().append("ping", 1);
+
+    auto msg = builder.finish();
+    ASSERT(msg.isSegmented());
+    ASSERT_EQ(builder.referencedBytes(), 0u);
+
+    // Setting flags does not need the message to be flattened.
+    OpMsg::setFlag(&msg, OpMsg::kMoreToCome);
+    ASSERT(msg.isSegmented());
+    ASSERT(OpMsg::isFlagSet(msg, OpMsg::kMoreToCome));
+
+    auto parsed = OpMsg::parse(msg);
+    ASSERT(!msg.isSegmented());
+    ASSERT_BSONOBJ_EQ(parsed.body, BSON("ping" << 1));
+    ASSERT_EQ(parsed.sequences.size(), 1u);
+    ASSERT_EQ(parsed.sequences[0].objs.size(), static_cast<size_t>(kNumDocs));
+    for (int i = 0; i < kNumDocs; i++) {
+        ASSERT_BSONOBJ_EQ(parsed.sequences[0].objs[i], BSON("a" << i << "padding" << padding));
+    }
+}
+
+TEST(OpMsgSerializer, LargeOwnedDocumentsAreReferenced) {
+    const std::string padding(OpMsgBuilder::kMinReferencedDocumentBytes, 'x');
+    const std::vector<BSONObj> docs = {
+        BSON("a" << 1 << "padding" << padding), BSON("a" << 2 << "padding" << padding),
+    };
+
+    OpMsgBuilder builder;
+    {
+        auto seq = builder.beginDocSequence("docs");
+        seq.append(docs[0]);
+        seq.append(BSON("a" << 3));
+        seq.append(docs[1]);
+        seq.appendBuilder().append("a", 4);
+    }
+    builder.beginBody().append("ping", 1);
+
+    auto msg = builder.finish();
+    ASSERT(msg.isSegmented());
+    ASSERT_EQ(builder.referencedBytes(),
+              static_cast<size_t>(docs[0].objsize() + docs[1].objsize()));
+
+    // The large documents are sent from their own buffers.
+    size_t referenced = 0;
+    for (auto&& segment : msg.segments()) {
+        for (auto&& doc : docs) {
+            if (segment.data == doc.objdata()) {
+                ASSERT_EQ(segment.size, static_cast<size_t>(doc.objsize()));
+                referenced++;
+            }
+        }
+    }
+    ASSERT_EQ(referenced, docs.size());
+
+    testSerializer(msg,
+                   OpMsgBytes{
+                       kNoFlags,  //
+                       kDocSequenceSection,
+                       Sized{
+                           "docs",  //
+                           docs[0],
+                           fromjson("{a: 3}"),
+                           docs[1],
+                           fromjson("{a: 4}"),
+                       },
+
+                       kBodySection,
+                       fromjson("{ping: 1}"),
+                   });
+}
+
 TEST(OpMsgRequest, GetDatabaseWorks) {
     OpMsgRequest msg;
     msg.body = fromjson("{$db: 'foo'}");
@@ -33,11 +33,14 @@
 #include "mongo/s/async_requests_sender.h"
 
 #include "mongo/client/remote_command_targeter.h"
+#include "mongo/db/query/cursor_response.h"
+#include "mongo/db/query/killcursors_request.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/grid.h"
+#include "mongo/s/read_hedging_stats.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/transport/baton.h"
 #include "mongo/transport/transport_layer.h"
@@ -49,11 +52,100 @@ namespace mongo {
 
 MONGO_EXPORT_SERVER_PARAMETER(AsyncRequestsSenderUseBaton, bool, true);
 
+MONGO_EXPORT_SERVER_PARAMETER(hedgedReadsEnabled, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(hedgedReadDelayPercentile, int, 95)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || newVal > 100) {
+            return Status(ErrorCodes::BadValue,
+                          "hedgedReadDelayPercentile must be between 1 and 100");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(hedgedReadMinDelayMS, int, 5)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue, "hedgedReadMinDelayMS must be at least 0");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(hedgedReadMaxDelayMS, int, 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue, "hedgedReadMaxDelayMS must be at least 0");
+        }
+        return Status::OK();
+    });
+
 namespace {
 
 // Maximum number of retries for network and replication notMaster errors (per host).
 const int kMaxNumFailedHostRetryAttempts = 3;
 
+// Maximum number of times to ask a shard's targeter for a host to send a hedged request to, other
+// than the host the request was first sent to.
+const int kMaxNumHedgeTargetingAttempts = 3;
+
+/**
+ * Returns whether 'cmdObj' is a read which may be hedged, that is, one which has no side effects
+ * and whose cursor, if any, can be killed if its response is not used.
+ */
+bool isHedgeableCommand(const BSONObj& cmdObj) {
+    const auto commandName = cmdObj.firstElementFieldName();
+    if (commandName != "find"_sd && commandName != "count"_sd && commandName != "distinct"_sd) {
+        return false;
+    }
+
+    // Statements of a transaction must run on the node the transaction started on.
+    return !cmdObj.hasField("txnNumber");
+}
+
+/**
+ * Returns how long to wait for a response from 'host' before hedging a request to it. This is the
+ * configured percentile of the host's recent response times, within the configured bounds. A host
+ * with no recorded response times is given the longest delay.
+ */
+Milliseconds getHedgeDelay(ServiceContext* serviceContext, const HostAndPort& host) {
+    const Milliseconds minDelay(hedgedReadMinDelayMS.load());
+    const Milliseconds maxDelay(std::max(hedgedReadMaxDelayMS.load(), hedgedReadMinDelayMS.load()));
+
+    const auto latency = ReadHedgingStats::get(serviceContext)
+                             ->getLatencyPercentile(host, hedgedReadDelayPercentile.load());
+    if (!latency) {
+        return maxDelay;
+    }
+
+    return std::min(std::max(*latency, minDelay), maxDelay);
+}
+
+/**
+ * Kills the cursor, if any, opened by a request whose response arrived after another request for
+ * the same remote had already responded.
+ */
+void killCursorOfLosingRequest(executor::TaskExecutor* executor,
+                               const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData) {
+    if (!cbData.response.isOK()) {
+        return;
+    }
+
+    auto swCursorResponse = CursorResponse::parseFromBSON(cbData.response.data);
+    if (!swCursorResponse.isOK() || !swCursorResponse.getValue().getCursorId()) {
+        return;
+    }
+
+    const auto& nss = swCursorResponse.getValue().getNSS();
+    executor::RemoteCommandRequest request(
+        cbData.request.target,
+        nss.db().toString(),
+        KillCursorsRequest(nss, {swCursorResponse.getValue().getCursorId()}).toBSON(),
+        nullptr);
+
+    // Send kill request; discard callback handle, if any, or failure report, if not.
+    executor->scheduleRemoteCommand(request, [](auto const&) {}).getStatus().ignore();
+}
+
 }  // namespace
 
 AsyncRequestsSender::AsyncRequestsSender(OperationContext* opCtx,
@@ -67,7 +159,8 @@ AsyncRequestsSender::AsyncRequestsSender(OperationContext* opCtx,
       _baton(opCtx),
       _db(dbName.toString()),
       _readPreference(readPreference),
-      _retryPolicy(retryPolicy) {
+      _retryPolicy(retryPolicy),
+      _hedgeReads(hedgedReadsEnabled.load() && readPreference.pref != ReadPreference::PrimaryOnly) {
     for (const auto& request : requests) {
         _remotes.emplace_back(request.shardId, request.cmdObj);
     }
@@ -113,6 +206,24 @@ AsyncRequestsSender::Response AsyncRequestsSender::next() {
     return *readyResponse;
 }
 
+void AsyncRequestsSender::addRequests(const std::vector<AsyncRequestsSender::Request>& requests) {
+    const size_t firstNewRemote = _remotes.size();
+    for (const auto& request : requests) {
+        _remotes.emplace_back(request.shardId, request.cmdObj);
+    }
+
+    if (!_stopRetrying) {
+        _scheduleRequests();
+        return;
+    }
+
+    for (size_t i = firstNewRemote; i < _remotes.size(); ++i) {
+        _remotes[i].swResponse = !_interruptStatus.isOK()
+            ? _interruptStatus
+            : Status(ErrorCodes::CallbackCanceled, "Request was not sent because retries stopped");
+    }
+}
+
 void AsyncRequestsSender::stopRetrying() {
     _stopRetrying = true;
 }
@@ -130,12 +241,16 @@ void AsyncRequestsSender::_cancelPendingRequests() {
         if (remote.cbHandle.isValid()) {
             _executor->cancel(remote.cbHandle);
         }
+        if (remote.hedgeCbHandle.isValid()) {
+            _executor->cancel(remote.hedgeCbHandle);
+        }
     }
 }
 
 boost::optional<AsyncRequestsSender::Response> AsyncRequestsSender::_ready() {
     if (!_stopRetrying) {
         _scheduleRequests();
+        _scheduleHedgedRequests();
     }
 
     // If we have baton requests, we want to process those before proceeding
@@ -145,23 +260,28 @@ boost::optional<AsyncRequestsSender::Response> AsyncRequestsSender::_ready() {
 
     // Check if any remote is ready.
     invariant(!_remotes.empty());
-    for (auto& remote : _remotes) {
+    for (size_t i = 0; i < _remotes.size(); ++i) {
+        auto& remote = _remotes[i];
         if (remote.swResponse && !remote.done) {
             remote.done = true;
             if (remote.swResponse->isOK()) {
                 invariant(remote.shardHostAndPort);
-                return Response(std::move(remote.shardId),
-                                std::move(remote.swResponse->getValue()),
-                                std::move(*remote.shardHostAndPort));
+                Response response(std::move(remote.shardId),
+                                  std::move(remote.swResponse->getValue()),
+                                  std::move(*remote.shardHostAndPort));
+                response.requestIndex = i;
+                return response;
             } else {
                 // If _interruptStatus is set, promote CallbackCanceled errors to it.
                 if (!_interruptStatus.isOK() &&
                     ErrorCodes::CallbackCanceled == remote.swResponse->getStatus().code()) {
                     remote.swResponse = _interruptStatus;
                 }
-                return Response(std::move(remote.shardId),
-                                std::move(remote.swResponse->getStatus()),
-                                std::move(remote.shardHostAndPort));
+                Response response(std::move(remote.shardId),
+                                  std::move(remote.swResponse->getStatus()),
+                                  std::move(remote.shardHostAndPort));
+                response.requestIndex = i;
+                return response;
             }
         }
     }
@@ -241,6 +361,10 @@ Status AsyncRequestsSender::_scheduleRequest(size_t remoteIndex) {
     executor::RemoteCommandRequest request(
         *remote.shardHostAndPort, _db, remote.cmdObj, _metadataObj, _opCtx);
 
+    if (_hedgeReads && isHedgeableCommand(remote.cmdObj)) {
+        return _scheduleHedgeableRequest(remoteIndex, request);
+    }
+
     auto callbackStatus = _executor->scheduleRemoteCommand(
         request,
         [remoteIndex, this](const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData) {
@@ -260,18 +384,172 @@ Status AsyncRequestsSender::_scheduleRequest(size_t remoteIndex) {
     return Status::OK();
 }
 
+Status AsyncRequestsSender::_scheduleHedgeableRequest(
+    size_t remoteIndex, const executor::RemoteCommandRequest& request) {
+    auto& remote = _remotes[remoteIndex];
+
+    auto hedgeState = std::make_shared<HedgeState>();
+    hedgeState->outstanding = 1;
+
+    // The delay is counted from before the request is sent, so that it is never longer than the
+    // time the request has been outstanding.
+    auto serviceContext = _opCtx->getServiceContext();
+    const auto hedgeDeadline = serviceContext->getPreciseClockSource()->now() +
+        getHedgeDelay(serviceContext, request.target);
+
+    // Neither this request nor its hedged request run on the baton, because whichever of them
+    // responds last may still be outstanding when the ARS is destroyed.
+    auto callbackStatus = _executor->scheduleRemoteCommand(
+        request, _makeHedgeableCallback(remoteIndex, hedgeState, false));
+    if (!callbackStatus.isOK()) {
+        return callbackStatus.getStatus();
+    }
+
+    remote.cbHandle = callbackStatus.getValue();
+    remote.hedgeState = std::move(hedgeState);
+    remote.hedgeDeadline = hedgeDeadline;
+
+    ReadHedgingStats::get(serviceContext)->noteHedgeableOperation();
+    return Status::OK();
+}
+
+void AsyncRequestsSender::_scheduleHedgedRequests() {
+    if (!_hedgeReads) {
+        return;
+    }
+
+    const auto now = _opCtx->getServiceContext()->getPreciseClockSource()->now();
+    for (size_t i = 0; i < _remotes.size(); ++i) {
+        auto& remote = _remotes[i];
+        if (!remote.hedgeDeadline || *remote.hedgeDeadline > now) {
+            continue;
+        }
+
+        remote.hedgeDeadline = boost::none;
+        if (!remote.swResponse && remote.cbHandle.isValid()) {
+            _scheduleHedgedRequest(i);
+        }
+    }
+}
+
+void AsyncRequestsSender::_scheduleHedgedRequest(size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+    invariant(remote.hedgeState);
+
+    const auto shard = remote.getShard();
+    if (!shard) {
+        return;
+    }
+
+    // Targeting picks at random among the hosts which match the read preference, so ask a few
+    // times for a host other than the one which has not yet responded.
+    boost::optional<HostAndPort> hedgeHost;
+    for (int i = 0; i < kMaxNumHedgeTargetingAttempts && !hedgeHost; ++i) {
+        auto swHost = shard->getTargeter()->findHostNoWait(_readPreference);
+        if (swHost.isOK() && swHost.getValue() != *remote.shardHostAndPort) {
+            hedgeHost = std::move(swHost.getValue());
+        }
+    }
+
+    if (!hedgeHost) {
+        LOG(2) << "Not hedging request to " << remote.shardId << " at host "
+               << *remote.shardHostAndPort << " because no other host matches the read preference";
+        return;
+    }
+
+    executor::RemoteCommandRequest request(*hedgeHost, _db, remote.cmdObj, _metadataObj, _opCtx);
+
+    stdx::lock_guard<stdx::mutex> lk(remote.hedgeState->mutex);
+    if (remote.hedgeState->delivered) {
+        return;
+    }
+
+    auto callbackStatus = _executor->scheduleRemoteCommand(
+        request, _makeHedgeableCallback(remoteIndex, remote.hedgeState, true));
+    if (!callbackStatus.isOK()) {
+        return;
+    }
+
+    ++remote.hedgeState->outstanding;
+    remote.hedgeCbHandle = callbackStatus.getValue();
+
+    LOG(2) << "Hedging request to " << remote.shardId << " at host " << *remote.shardHostAndPort
+           << " with a request to host " << *hedgeHost;
+    ReadHedgingStats::get(_opCtx->getServiceContext())->noteHedgedOperation();
+}
+
+executor::TaskExecutor::RemoteCommandCallbackFn AsyncRequestsSender::_makeHedgeableCallback(
+    size_t remoteIndex, std::shared_ptr<HedgeState> hedgeState, bool fromHedgedRequest) {
+    auto executor = _executor;
+    auto serviceContext = _opCtx->getServiceContext();
+    return [this, remoteIndex, hedgeState, fromHedgedRequest, executor, serviceContext](
+        const executor::TaskExecutor::RemoteCommandCallbackArgs& cbData) {
+        if (cbData.response.isOK() && cbData.response.elapsedMillis) {
+            ReadHedgingStats::get(serviceContext)
+                ->recordLatency(cbData.request.target, *cbData.response.elapsedMillis);
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(hedgeState->mutex);
+        --hedgeState->outstanding;
+
+        if (hedgeState->delivered) {
+            // Another request for the remote responded first, and the ARS may no longer exist.
+            killCursorOfLosingRequest(executor, cbData);
+            return;
+        }
+
+        if (!cbData.response.isOK() && hedgeState->outstanding > 0) {
+            // The other request for the remote may still succeed, so wait for it instead.
+            return;
+        }
+
+        hedgeState->delivered = true;
+
+        if (_baton) {
+            _batonRequests++;
+            _baton->schedule([this] { _batonRequests--; });
+        }
+
+        _responseQueue.push(Job{cbData, remoteIndex, fromHedgedRequest});
+    };
+}
+
+boost::optional<Date_t> AsyncRequestsSender::_nextHedgeDeadline() const {
+    boost::optional<Date_t> nextDeadline;
+    for (const auto& remote : _remotes) {
+        if (remote.hedgeDeadline && (!nextDeadline || *remote.hedgeDeadline < *nextDeadline)) {
+            nextDeadline = remote.hedgeDeadline;
+        }
+    }
+    return nextDeadline;
+}
+
 // Passing opCtx means you'd like to opt into opCtx interruption.  During cleanup we actually don't.
 void AsyncRequestsSender::_makeProgress(OperationContext* opCtx) {
     invariant(!opCtx || opCtx == _opCtx);
 
     boost::optional<Job> job;
 
+    // Wake up in time to hedge the requests which have not yet responded.
+    const auto hedgeDeadline = _stopRetrying ? boost::none : _nextHedgeDeadline();
+
     if (_baton) {
         // If we're using a baton, we peek the queue, and block on the baton if it's empty
         if (boost::optional<boost::optional<Job>> tryJob = _responseQueue.tryPop()) {
             job = std::move(*tryJob);
         } else {
-            _baton->run(opCtx, boost::none);
+            _baton->run(opCtx, hedgeDeadline);
+        }
+    } else if (hedgeDeadline) {
+        try {
+            job = opCtx ? _responseQueue.pop(opCtx, *hedgeDeadline)
+                        : _responseQueue.pop(*hedgeDeadline);
+        } catch (const ExceptionFor<ErrorCodes::ExceededTimeLimit>&) {
+            // Unless the operation itself has timed out, it is time to hedge a request.
+            if (opCtx) {
+                opCtx->checkForInterrupt();
+            }
+            return;
         }
     } else {
         // Otherwise we block on the queue
@@ -286,8 +564,20 @@ void AsyncRequestsSender::_makeProgress(OperationContext* opCtx) {
     invariant(!remote.swResponse);
 
     // Clear the callback handle. This indicates that we are no longer waiting on a response from
-    // 'remote'.
+    // 'remote'. If the request was hedged, the request which has not responded is left to finish
+    // on its own.
     remote.cbHandle = executor::TaskExecutor::CallbackHandle();
+    remote.hedgeCbHandle = executor::TaskExecutor::CallbackHandle();
+    remote.hedgeState.reset();
+    remote.hedgeDeadline = boost::none;
+
+    if (job->fromHedgedRequest) {
+        remote.shardHostAndPort = job->cbData.request.target;
+        if (job->cbData.response.isOK()) {
+            ReadHedgingStats::get(_opCtx->getServiceContext())
+                ->noteAdvantageouslyHedgedOperation();
+        }
+    }
 
     // Store the response or error.
     if (job->cbData.response.status.isOK()) {
@@ -39,6 +39,7 @@
 #include "mongo/executor/task_executor.h"
 #include "mongo/s/client/shard.h"
 #include "mongo/s/shard_id.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/producer_consumer_queue.h"
 #include "mongo/util/time_support.h"
@@ -76,6 +77,12 @@ namespace mongo {
  *     }
  * }
  *
+ * If the 'hedgedReadsEnabled' server parameter is set, the requests for a find, count or distinct
+ * command with a read preference other than primary may be hedged: if a host has not responded
+ * within the given percentile of its recent response times, the request is also sent to another
+ * host which matches the read preference. The first response is returned, and a cursor opened by
+ * the other request is killed when it responds.
+ *
  * Does not throw exceptions.
  */
 class AsyncRequestsSender {
@@ -114,6 +121,10 @@ public:
         // The exact host on which the remote command was run. Is unset if the shard could not be
         // found or no shard hosts matching the readPreference could be found.
         boost::optional<HostAndPort> shardHostAndPort;
+
+        // The position of the request among all of the requests given to the sender, in the order
+        // in which they were given.
+        size_t requestIndex = 0;
     };
 
     /**
@@ -150,6 +161,18 @@ public:
      */
     Response next();
 
+    /**
+     * Schedules more requests, whose responses are returned from next() along with those of the
+     * requests already given to the sender. This allows a caller to keep a bounded number of
+     * requests in flight and send more as responses arrive.
+     *
+     * If the operation has been interrupted or stopRetrying() has been called, the new requests
+     * are not sent and are returned from next() with an error.
+     *
+     * Note: Must only be called from the thread which calls next().
+     */
+    void addRequests(const std::vector<AsyncRequestsSender::Request>& requests);
+
     /**
      * Stops the ARS from retrying requests.
      *
@@ -159,6 +182,21 @@ public:
     void stopRetrying();
 
 private:
+    /**
+     * Shared by the ARS with the callbacks of the requests sent for a remote whose request may be
+     * hedged, so that only the first of them to respond is handed to the ARS. The callbacks of the
+     * others may run after the ARS is destroyed, so they must only use this state.
+     */
+    struct HedgeState {
+        stdx::mutex mutex;
+
+        // The number of requests sent for the remote which have not yet responded.
+        int outstanding = 0;
+
+        // Whether a response has been handed to the ARS.
+        bool delivered = false;
+    };
+
     /**
      * We instantiate one of these per remote host.
      */
@@ -199,6 +237,16 @@ private:
         // The callback handle to an outstanding request for this remote.
         executor::TaskExecutor::CallbackHandle cbHandle;
 
+        // Set while the outstanding request for this remote may be hedged.
+        std::shared_ptr<HedgeState> hedgeState;
+
+        // The time at which to send a hedged request if the remote has not yet responded. Is unset
+        // once the hedged request has been sent or if the request may not be hedged.
+        boost::optional<Date_t> hedgeDeadline;
+
+        // The callback handle to an outstanding hedged request for this remote.
+        executor::TaskExecutor::CallbackHandle hedgeCbHandle;
+
         // Whether this remote's result has been returned.
         bool done = false;
     };
@@ -210,6 +258,7 @@ private:
     struct Job {
         executor::TaskExecutor::RemoteCommandCallbackArgs cbData;
         size_t remoteIndex;
+        bool fromHedgedRequest = false;
     };
 
     /**
@@ -278,6 +327,36 @@ private:
      */
     Status _scheduleRequest(size_t remoteIndex);
 
+    /**
+     * Helper for _scheduleRequest which sends a request that may later be hedged, and sets the time
+     * at which to hedge it from the recent response times of the request's target host.
+     */
+    Status _scheduleHedgeableRequest(size_t remoteIndex,
+                                     const executor::RemoteCommandRequest& request);
+
+    /**
+     * Sends the hedged requests of the remotes which have not responded by their hedge deadline.
+     */
+    void _scheduleHedgedRequests();
+
+    /**
+     * Sends a hedged request for the remote at 'remoteIndex' to a host which matches the read
+     * preference, other than the one its request was sent to. Does nothing if there is no such
+     * host or the request cannot be scheduled, since the original request is still outstanding.
+     */
+    void _scheduleHedgedRequest(size_t remoteIndex);
+
+    /**
+     * Returns the callback for a request sent for the remote at 'remoteIndex' which may be hedged.
+     */
+    executor::TaskExecutor::RemoteCommandCallbackFn _makeHedgeableCallback(
+        size_t remoteIndex, std::shared_ptr<HedgeState> hedgeState, bool fromHedgedRequest);
+
+    /**
+     * Returns the earliest hedge deadline of the remotes which are waiting for a response, if any.
+     */
+    boost::optional<Date_t> _nextHedgeDeadline() const;
+
     /**
      * Waits for forward progress in gathering responses from a remote.
      *
@@ -306,6 +385,9 @@ private:
     // The policy to use when deciding whether to retry on an error.
     Shard::RetryPolicy _retryPolicy;
 
+    // Whether requests may be hedged. Only find, count and distinct requests are hedged.
+    bool _hedgeReads = false;
+
     // Is set to a non-OK status if the client operation is interrupted.
     // When waiting for a remote to be ready, we only check for interrupt if the _interruptStatus
     // has not already been set to an error (so we can wait for callbacks for (canceled) outstanding
@@ -0,0 +1,276 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/base/checked_cast.h"
+#include "mongo/client/remote_command_targeter_factory_mock.h"
+#include "mongo/client/remote_command_targeter_mock.h"
+#include "mongo/db/query/cursor_response.h"
+#include "mongo/db/query/killcursors_request.h"
+#include "mongo/db/server_parameters_test_util.h"
+#include "mongo/executor/network_interface_mock.h"
+#include "mongo/s/async_requests_sender.h"
+#include "mongo/s/catalog/type_shard.h"
+#include "mongo/s/read_hedging_stats.h"
+#include "mongo/s/sharding_router_test_fixture.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/clock_source_mock.h"
+
+namespace mongo {
+namespace {
+
+using executor::NetworkInterfaceMock;
+using executor::RemoteCommandResponse;
+
+using InNetworkGuard = NetworkInterfaceMock::InNetworkGuard;
+using NetworkOperationIterator = NetworkInterfaceMock::NetworkOperationIterator;
+
+const NamespaceString kNss("testdb.testcoll");
+const HostAndPort kConfigHost("FakeConfigHost", 12345);
+const ShardId kShardId("FakeShard");
+const HostAndPort kFirstHost("FakeShardHost1", 12345);
+const HostAndPort kSecondHost("FakeShardHost2", 12345);
+
+// No response times are recorded for the first host, so its requests are hedged after the longest
+// delay.
+const Milliseconds kHedgeDelay(100);
+
+class AsyncRequestsSenderHedgingTest : public ShardingTestFixture {
+protected:
+    void setUp() override {
+        ShardingTestFixture::setUp();
+        configTargeter()->setFindHostReturnValue(kConfigHost);
+
+        auto targeter = stdx::make_unique<RemoteCommandTargeterMock>();
+        _targeter = targeter.get();
+        targeter->setConnectionStringReturnValue(ConnectionString(kFirstHost));
+        targeter->setFindHostReturnValue(kFirstHost);
+        targeterFactory()->addTargeterToReturn(ConnectionString(kFirstHost), std::move(targeter));
+
+        ShardType shardType;
+        shardType.setName(kShardId.toString());
+        shardType.setHost(kFirstHost.toString());
+        setupShards({shardType});
+    }
+
+    /**
+     * Sends a find to the shard with a nearest read preference from another thread, and returns
+     * the future of its response.
+     */
+    auto runFind() {
+        return launchAsync([this] {
+            AsyncRequestsSender ars(operationContext(),
+                                    executor(),
+                                    kNss.db(),
+                                    {{kShardId, BSON("find" << kNss.coll())}},
+                                    ReadPreferenceSetting(ReadPreference::Nearest),
+                                    Shard::RetryPolicy::kNoRetry);
+            auto response = ars.next();
+            ASSERT_TRUE(ars.done());
+            return response;
+        });
+    }
+
+    /**
+     * Waits for the next request to be sent, checks its target and command, and leaves it
+     * unanswered.
+     */
+    NetworkOperationIterator expectRequest(const HostAndPort& host, StringData commandName) {
+        InNetworkGuard guard(network());
+        auto noi = network()->getNextReadyRequest();
+        ASSERT_EQ(host, noi->getRequest().target);
+        ASSERT_EQ(commandName, StringData(noi->getRequest().cmdObj.firstElementFieldName()));
+        return noi;
+    }
+
+    /**
+     * Answers the given requests, in order.
+     */
+    void respond(std::vector<std::pair<NetworkOperationIterator, RemoteCommandResponse>> replies) {
+        InNetworkGuard guard(network());
+        for (const auto& reply : replies) {
+            network()->scheduleResponse(reply.first, network()->now(), reply.second);
+        }
+        network()->runReadyNetworkOperations();
+    }
+
+    void assertNoRequestSent() {
+        InNetworkGuard guard(network());
+        ASSERT_FALSE(network()->hasReadyRequests());
+    }
+
+    void advanceClock(Milliseconds ms) {
+        checked_cast<ClockSourceMock*>(getServiceContext()->getPreciseClockSource())->advance(ms);
+    }
+
+    void assertHedgingStats(long long numOperations,
+                            long long numHedgedOperations,
+                            long long numAdvantageouslyHedgedOperations) {
+        BSONObjBuilder builder;
+        ReadHedgingStats::get(getServiceContext())->report(&builder);
+        ASSERT_BSONOBJ_EQ(BSON("numTotalOperations"
+                               << numOperations
+                               << "numTotalHedgedOperations"
+                               << numHedgedOperations
+                               << "numAdvantageouslyHedgedOperations"
+                               << numAdvantageouslyHedgedOperations),
+                          builder.obj());
+    }
+
+    static RemoteCommandResponse cursorResponse(CursorId cursorId) {
+        return RemoteCommandResponse(
+            CursorResponse(kNss, cursorId, {BSON("_id" << 1)})
+                .toBSON(CursorResponse::ResponseType::InitialResponse),
+            BSONObj(),
+            Milliseconds(1));
+    }
+
+    static CursorId getCursorId(const AsyncRequestsSender::Response& response) {
+        ASSERT_OK(response.swResponse.getStatus());
+        const auto& data = response.swResponse.getValue().data;
+        return unittest::assertGet(CursorResponse::parseFromBSON(data)).getCursorId();
+    }
+
+    ServerParameterControllerForTest _hedgingEnabled{"hedgedReadsEnabled", "true"};
+    ServerParameterControllerForTest _maxDelay{"hedgedReadMaxDelayMS",
+                                               std::to_string(kHedgeDelay.count())};
+
+    RemoteCommandTargeterMock* _targeter = nullptr;
+};
+
+TEST_F(AsyncRequestsSenderHedgingTest, RequestIsNotHedgedIfItRespondsWithinTheDelay) {
+    auto future = runFind();
+
+    auto noi = expectRequest(kFirstHost, "find");
+    _targeter->setFindHostReturnValue(kSecondHost);
+    respond({{noi, cursorResponse(1)}});
+
+    auto response = future.timed_get(kFutureTimeout);
+    ASSERT_EQ(kFirstHost, *response.shardHostAndPort);
+    ASSERT_EQ(1, getCursorId(response));
+
+    advanceClock(kHedgeDelay);
+    assertNoRequestSent();
+    assertHedgingStats(1, 0, 0);
+}
+
+TEST_F(AsyncRequestsSenderHedgingTest, HedgesAfterTheDelayAndKillsTheCursorOfTheLosingRequest) {
+    auto future = runFind();
+
+    auto firstNoi = expectRequest(kFirstHost, "find");
+    _targeter->setFindHostReturnValue(kSecondHost);
+
+    // The second host is only contacted once the delay has passed.
+    advanceClock(kHedgeDelay - Milliseconds(1));
+    assertNoRequestSent();
+    advanceClock(Milliseconds(1));
+    auto secondNoi = expectRequest(kSecondHost, "find");
+
+    // The hedged request responds first and wins. The original request responds after it with an
+    // open cursor, which is killed.
+    respond({{secondNoi, cursorResponse(2)}, {firstNoi, cursorResponse(1)}});
+
+    auto response = future.timed_get(kFutureTimeout);
+    ASSERT_EQ(kSecondHost, *response.shardHostAndPort);
+    ASSERT_EQ(2, getCursorId(response));
+
+    auto killNoi = expectRequest(kFirstHost, "killCursors");
+    ASSERT_BSONOBJ_EQ(KillCursorsRequest(kNss, {CursorId(1)}).toBSON(),
+                      killNoi->getRequest().cmdObj);
+    respond({{killNoi, RemoteCommandResponse(BSON("ok" << 1), BSONObj(), Milliseconds(1))}});
+
+    assertHedgingStats(1, 1, 1);
+}
+
+TEST_F(AsyncRequestsSenderHedgingTest, OriginalRequestWinsIfItRespondsFirst) {
+    auto future = runFind();
+
+    auto firstNoi = expectRequest(kFirstHost, "find");
+    _targeter->setFindHostReturnValue(kSecondHost);
+    advanceClock(kHedgeDelay);
+    auto secondNoi = expectRequest(kSecondHost, "find");
+
+    respond({{firstNoi, cursorResponse(1)}, {secondNoi, cursorResponse(2)}});
+
+    auto response = future.timed_get(kFutureTimeout);
+    ASSERT_EQ(kFirstHost, *response.shardHostAndPort);
+    ASSERT_EQ(1, getCursorId(response));
+
+    auto killNoi = expectRequest(kSecondHost, "killCursors");
+    ASSERT_BSONOBJ_EQ(KillCursorsRequest(kNss, {CursorId(2)}).toBSON(),
+                      killNoi->getRequest().cmdObj);
+    respond({{killNoi, RemoteCommandResponse(BSON("ok" << 1), BSONObj(), Milliseconds(1))}});
+
+    assertHedgingStats(1, 1, 0);
+}
+
+TEST_F(AsyncRequestsSenderHedgingTest, ErrorIsHeldBackUntilTheOtherRequestResponds) {
+    auto future = runFind();
+
+    auto firstNoi = expectRequest(kFirstHost, "find");
+    _targeter->setFindHostReturnValue(kSecondHost);
+    advanceClock(kHedgeDelay);
+    auto secondNoi = expectRequest(kSecondHost, "find");
+
+    // The error from the original request is not returned while the hedged request may still
+    // succeed. With retries disabled, returning it would have ended the remote.
+    respond({{firstNoi,
+              RemoteCommandResponse(Status(ErrorCodes::HostUnreachable, "host unreachable"),
+                                    Milliseconds(1))}});
+    respond({{secondNoi, cursorResponse(2)}});
+
+    auto response = future.timed_get(kFutureTimeout);
+    ASSERT_EQ(kSecondHost, *response.shardHostAndPort);
+    ASSERT_EQ(2, getCursorId(response));
+    assertHedgingStats(1, 1, 1);
+}
+
+TEST_F(AsyncRequestsSenderHedgingTest, LastErrorIsReturnedIfBothRequestsFail) {
+    auto future = runFind();
+
+    auto firstNoi = expectRequest(kFirstHost, "find");
+    _targeter->setFindHostReturnValue(kSecondHost);
+    advanceClock(kHedgeDelay);
+    auto secondNoi = expectRequest(kSecondHost, "find");
+
+    respond({{firstNoi,
+              RemoteCommandResponse(Status(ErrorCodes::HostUnreachable, "host unreachable"),
+                                    Milliseconds(1))}});
+    respond({{secondNoi,
+              RemoteCommandResponse(Status(ErrorCodes::NetworkTimeout, "network timeout"),
+                                    Milliseconds(1))}});
+
+    auto response = future.timed_get(kFutureTimeout);
+    ASSERT_EQ(ErrorCodes::NetworkTimeout, response.swResponse.getStatus().code());
+    ASSERT_EQ(kSecondHost, *response.shardHostAndPort);
+}
+
+}  // namespace
+}  // namespace mongo
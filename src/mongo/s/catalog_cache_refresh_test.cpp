@@ -610,5 +610,101 @@ TEST_F(CatalogCacheRefreshTest, IncrementalLoadAfterMoveLastChunk) {
     ASSERT_EQ(version, cm->getVersion({"1"}));
 }
 
+TEST_F(CatalogCacheRefreshTest, IncrementalLoadAfterMoveOfChunkWithMaxShardVersion) {
+    const ShardKeyPattern shardKeyPattern(BSON("_id" << 1));
+
+    auto initialRoutingInfo(
+        makeChunkManager(kNss, shardKeyPattern, nullptr, true, {BSON("_id" << 0)}));
+    ASSERT_EQ(2, initialRoutingInfo->numChunks());
+
+    ChunkVersion version = initialRoutingInfo->getVersion();
+    ChunkVersion expectedSourceShardVersion;
+
+    // Split the chunk on shard "1"
+    auto future = scheduleRoutingInfoRefresh(kNss);
+
+    expectGetCollection(version.epoch(), shardKeyPattern);
+    expectFindSendBSONObjVector(kConfigHostAndPort, [&]() {
+        version.incMajor();
+        expectedSourceShardVersion = version;
+        ChunkType chunk1(kNss, {BSON("_id" << 0), BSON("_id" << 100)}, version, {"1"});
+
+        version.incMinor();
+        ChunkType chunk2(kNss,
+                         {BSON("_id" << 100), shardKeyPattern.getKeyPattern().globalMax()},
+                         version,
+                         {"1"});
+
+        return std::vector<BSONObj>{chunk1.toConfigBSON(), chunk2.toConfigBSON()};
+    }());
+
+    ASSERT_EQ(3, future.timed_get(kFutureTimeout)->cm()->numChunks());
+
+    // Move the chunk with the max version of shard "1" without bumping the version of the chunk
+    // which stays behind
+    future = scheduleRoutingInfoRefresh(kNss);
+
+    expectGetCollection(version.epoch(), shardKeyPattern);
+    expectFindSendBSONObjVector(kConfigHostAndPort, [&]() {
+        version.incMajor();
+        ChunkType chunk(kNss,
+                        {BSON("_id" << 100), shardKeyPattern.getKeyPattern().globalMax()},
+                        version,
+                        {"0"});
+
+        return std::vector<BSONObj>{chunk.toConfigBSON()};
+    }());
+
+    auto routingInfo = future.timed_get(kFutureTimeout);
+    ASSERT(routingInfo->cm());
+    auto cm = routingInfo->cm();
+
+    ASSERT_EQ(3, cm->numChunks());
+    ASSERT_EQ(version, cm->getVersion());
+    ASSERT_EQ(version, cm->getVersion({"0"}));
+    ASSERT_EQ(expectedSourceShardVersion, cm->getVersion({"1"}));
+}
+
+TEST_F(CatalogCacheRefreshTest, OverlappingChunksFoundDuringIncrementalLoad) {
+    const ShardKeyPattern shardKeyPattern(BSON("_id" << 1));
+
+    auto initialRoutingInfo(
+        makeChunkManager(kNss, shardKeyPattern, nullptr, true, {BSON("_id" << 0)}));
+    ASSERT_EQ(2, initialRoutingInfo->numChunks());
+
+    auto future = scheduleRoutingInfoRefresh(kNss);
+
+    ChunkVersion version = initialRoutingInfo->getVersion();
+
+    // Only the lower half of a split of the chunk on shard "1" is returned, so it overlaps the
+    // chunk which it was split from
+    const auto inconsistentChunks = [&]() {
+        version.incMajor();
+        ChunkType chunk(kNss, {BSON("_id" << 0), BSON("_id" << 100)}, version, {"1"});
+
+        return std::vector<BSONObj>{chunk.toConfigBSON()};
+    }();
+
+    // Do it three times, which is how frequently the catalog cache retries
+    expectGetCollection(initialRoutingInfo->getVersion().epoch(), shardKeyPattern);
+    expectFindSendBSONObjVector(kConfigHostAndPort, inconsistentChunks);
+
+    expectGetCollection(initialRoutingInfo->getVersion().epoch(), shardKeyPattern);
+    expectFindSendBSONObjVector(kConfigHostAndPort, inconsistentChunks);
+
+    expectGetCollection(initialRoutingInfo->getVersion().epoch(), shardKeyPattern);
+    expectFindSendBSONObjVector(kConfigHostAndPort, inconsistentChunks);
+
+    try {
+        auto routingInfo = future.timed_get(kFutureTimeout);
+        auto cm = routingInfo->cm();
+
+        FAIL(str::stream() << "Returning overlapping chunks did not fail and returned "
+                           << (cm ? cm->toString() : routingInfo->db().primaryId().toString()));
+    } catch (const DBException& ex) {
+        ASSERT_EQ(ErrorCodes::ConflictingOperationInProgress, ex.code());
+    }
+}
+
 }  // namespace
 }  // namespace mongo
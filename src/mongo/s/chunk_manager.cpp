@@ -32,6 +32,9 @@
 
 #include "mongo/s/chunk_manager.h"
 
+#include <algorithm>
+#include <tuple>
+
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
@@ -68,12 +71,148 @@ std::string extractKeyStringInternal(const BSONObj& shardKeyValue, Ordering orde
 
 }  // namespace
 
+constexpr size_t ChunkInfoMap::kMaxSegmentSize;
+
+ChunkInfoMap::const_iterator ChunkInfoMap::upper_bound(const std::string& key) const {
+    const auto segmentIt = std::upper_bound(_segmentMaxKeys.begin(), _segmentMaxKeys.end(), key);
+    if (segmentIt == _segmentMaxKeys.end())
+        return end();
+
+    const size_t segment = segmentIt - _segmentMaxKeys.begin();
+    const auto& entries = *_segments[segment];
+    const auto entryIt = std::upper_bound(
+        entries.begin(), entries.end(), key, [](const std::string& k, const value_type& entry) {
+            return k < entry.first;
+        });
+
+    return {this, segment, static_cast<size_t>(entryIt - entries.begin())};
+}
+
+ChunkInfoMap::const_iterator ChunkInfoMap::lower_bound(const std::string& key) const {
+    const auto segmentIt = std::lower_bound(_segmentMaxKeys.begin(), _segmentMaxKeys.end(), key);
+    if (segmentIt == _segmentMaxKeys.end())
+        return end();
+
+    const size_t segment = segmentIt - _segmentMaxKeys.begin();
+    const auto& entries = *_segments[segment];
+    const auto entryIt = std::lower_bound(
+        entries.begin(), entries.end(), key, [](const value_type& entry, const std::string& k) {
+            return entry.first < k;
+        });
+
+    return {this, segment, static_cast<size_t>(entryIt - entries.begin())};
+}
+
+void ChunkInfoMap::replaceOverlapping(const std::string& minKey,
+                                      std::string maxKey,
+                                      std::shared_ptr<ChunkInfo> chunk) {
+    if (_segments.empty()) {
+        Segment entries;
+        entries.emplace_back(std::move(maxKey), std::move(chunk));
+        _replaceSegments(0, 0, std::move(entries));
+        return;
+    }
+
+    size_t firstSegment, firstOffset;
+    std::tie(firstSegment, firstOffset) = _insertionPoint(upper_bound(minKey));
+
+    size_t lastSegment, lastOffset;
+    std::tie(lastSegment, lastOffset) = _insertionPoint(upper_bound(maxKey));
+
+    // A segment which is not shared with any other map can be edited in place, which is what
+    // makes building a routing table from scratch one chunk at a time cheap
+    if (firstSegment == lastSegment && _segments[firstSegment].use_count() == 1) {
+        auto& entries = *_segments[firstSegment];
+        _size -= lastOffset - firstOffset;
+        entries.erase(entries.begin() + firstOffset, entries.begin() + lastOffset);
+        entries.emplace(entries.begin() + firstOffset, std::move(maxKey), std::move(chunk));
+        ++_size;
+
+        if (entries.size() <= kMaxSegmentSize) {
+            _segmentMaxKeys[firstSegment] = entries.back().first;
+            return;
+        }
+
+        // Appending to a full segment starts a new one instead of splitting it in half, so that
+        // routing tables loaded in key order end up with full segments
+        if (firstOffset + 1 == entries.size()) {
+            Segment tail;
+            tail.push_back(std::move(entries.back()));
+            entries.pop_back();
+            _segmentMaxKeys[firstSegment] = entries.back().first;
+
+            _size -= 1;
+            _replaceSegments(firstSegment + 1, firstSegment + 1, std::move(tail));
+            return;
+        }
+
+        Segment overflow;
+        overflow.swap(entries);
+        _size -= overflow.size();
+        _replaceSegments(firstSegment, firstSegment + 1, std::move(overflow));
+        return;
+    }
+
+    const auto& first = *_segments[firstSegment];
+    const auto& last = *_segments[lastSegment];
+
+    Segment entries;
+    entries.reserve(firstOffset + 1 + (last.size() - lastOffset));
+    entries.insert(entries.end(), first.begin(), first.begin() + firstOffset);
+    entries.emplace_back(std::move(maxKey), std::move(chunk));
+    entries.insert(entries.end(), last.begin() + lastOffset, last.end());
+
+    _replaceSegments(firstSegment, lastSegment + 1, std::move(entries));
+}
+
+std::pair<size_t, size_t> ChunkInfoMap::_insertionPoint(const const_iterator& it) const {
+    if (it._offset == 0 && it._segment > 0) {
+        return {it._segment - 1, _segments[it._segment - 1]->size()};
+    }
+
+    return {it._segment, it._offset};
+}
+
+void ChunkInfoMap::_replaceSegments(size_t first, size_t last, Segment entries) {
+    for (size_t i = first; i < last; ++i) {
+        _size -= _segments[i]->size();
+    }
+    _size += entries.size();
+
+    const size_t numSegments = (entries.size() + kMaxSegmentSize - 1) / kMaxSegmentSize;
+
+    std::vector<std::shared_ptr<Segment>> segments;
+    segments.reserve(numSegments);
+    std::vector<std::string> segmentMaxKeys;
+    segmentMaxKeys.reserve(numSegments);
+
+    auto it = std::make_move_iterator(entries.begin());
+    for (size_t i = 0; i < numSegments; ++i) {
+        const size_t count =
+            entries.size() * (i + 1) / numSegments - entries.size() * i / numSegments;
+        segments.push_back(std::make_shared<Segment>(it, it + count));
+        segmentMaxKeys.push_back(segments.back()->back().first);
+        it += count;
+    }
+
+    _segments.erase(_segments.begin() + first, _segments.begin() + last);
+    _segments.insert(_segments.begin() + first,
+                     std::make_move_iterator(segments.begin()),
+                     std::make_move_iterator(segments.end()));
+
+    _segmentMaxKeys.erase(_segmentMaxKeys.begin() + first, _segmentMaxKeys.begin() + last);
+    _segmentMaxKeys.insert(_segmentMaxKeys.begin() + first,
+                           std::make_move_iterator(segmentMaxKeys.begin()),
+                           std::make_move_iterator(segmentMaxKeys.end()));
+}
+
 RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
                                          boost::optional<UUID> uuid,
                                          KeyPattern shardKeyPattern,
                                          std::unique_ptr<CollatorInterface> defaultCollator,
                                          bool unique,
                                          ChunkInfoMap chunkMap,
+                                         ShardVersionMap shardVersions,
                                          ChunkVersion collectionVersion)
     : _sequenceNumber(nextCMSequenceNumber.addAndFetch(1)),
       _nss(std::move(nss)),
@@ -83,8 +222,7 @@ RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
       _defaultCollator(std::move(defaultCollator)),
       _unique(unique),
       _chunkMap(std::move(chunkMap)),
-      _shardVersions(
-          _constructShardVersionMap(collectionVersion.epoch(), _chunkMap, _shardKeyOrdering)),
+      _shardVersions(std::move(shardVersions)),
       _collectionVersion(collectionVersion) {}
 
 Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj& collation) const {
@@ -381,7 +519,7 @@ ChunkVersion RoutingTableHistory::getVersion(const ShardId& shardName) const {
         return ChunkVersion(0, 0, _collectionVersion.epoch());
     }
 
-    return it->second;
+    return it->second.version;
 }
 
 std::string RoutingTableHistory::toString() const {
@@ -395,7 +533,7 @@ std::string RoutingTableHistory::toString() const {
 
     sb << "Shard versions:\n";
     for (const auto& entry : _shardVersions) {
-        sb << "\t" << entry.first << ": " << entry.second.toString() << '\n';
+        sb << "\t" << entry.first << ": " << entry.second.version.toString() << '\n';
     }
 
     return sb.str();
@@ -418,25 +556,27 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap(const OID& epoch,
         if (shardVersionIt == shardVersions.end()) {
             shardVersionIt = shardVersions
                                  .emplace(firstChunkInRange->getShardIdAt(boost::none),
-                                          ChunkVersion(0, 0, epoch))
+                                          ShardVersionInfo{ChunkVersion(0, 0, epoch)})
                                  .first;
         }
 
-        auto& maxShardVersion = shardVersionIt->second;
+        auto& shardVersion = shardVersionIt->second;
+        auto& maxShardVersion = shardVersion.version;
 
         current = std::find_if(
             current,
             chunkMap.cend(),
-            [&firstChunkInRange, &maxShardVersion](const ChunkInfoMap::value_type& chunkMapEntry) {
+            [&firstChunkInRange, &shardVersion](const ChunkInfoMap::value_type& chunkMapEntry) {
                 const auto& currentChunk = chunkMapEntry.second;
 
                 if (currentChunk->getShardIdAt(boost::none) !=
                     firstChunkInRange->getShardIdAt(boost::none))
                     return true;
 
-                if (currentChunk->getLastmod() > maxShardVersion)
-                    maxShardVersion = currentChunk->getLastmod();
+                if (currentChunk->getLastmod() > shardVersion.version)
+                    shardVersion.version = currentChunk->getLastmod();
 
+                ++shardVersion.numChunks;
                 return false;
             });
 
@@ -485,6 +625,38 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap(const OID& epoch,
     return shardVersions;
 }
 
+void RoutingTableHistory::_checkChangedRanges(const ChunkInfoMap& chunkMap,
+                                              const std::vector<std::string>& changedKeys) {
+    invariant(!chunkMap.empty());
+
+    const auto checkContiguous = [](const ChunkInfo& left, const ChunkInfo& right) {
+        uassert(ErrorCodes::ConflictingOperationInProgress,
+                str::stream() << "Gap or an overlap between ranges "
+                              << ChunkRange(left.getMin(), left.getMax()).toString()
+                              << " and "
+                              << ChunkRange(right.getMin(), right.getMax()).toString(),
+                SimpleBSONObjComparator::kInstance.evaluate(left.getMax() == right.getMin()));
+    };
+
+    // The ranges which were not touched by the update were contiguous before it, so any gap or
+    // overlap must be next to one of the changed chunks, or to the chunk which replaced it.
+    for (const auto& key : changedKeys) {
+        const auto it = chunkMap.lower_bound(key);
+        if (it == chunkMap.end())
+            continue;
+
+        if (it != chunkMap.begin())
+            checkContiguous(*std::prev(it)->second, *it->second);
+
+        const auto next = std::next(it);
+        if (next != chunkMap.end())
+            checkContiguous(*it->second, *next->second);
+    }
+
+    checkAllElementsAreOfType(MinKey, chunkMap.begin()->second->getMin());
+    checkAllElementsAreOfType(MaxKey, std::prev(chunkMap.end())->second->getMax());
+}
+
 std::string RoutingTableHistory::_extractKeyString(const BSONObj& shardKeyValue) const {
     return extractKeyStringInternal(shardKeyValue, _shardKeyOrdering);
 }
@@ -503,6 +675,7 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeNew(
                                std::move(defaultCollator),
                                std::move(unique),
                                {},
+                               {},
                                {0, 0, epoch})
         .makeUpdated(chunks);
 }
@@ -513,6 +686,15 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
     const auto startingCollectionVersion = getVersion();
     auto chunkMap = _chunkMap;
 
+    // A routing table built from scratch gets its shard versions and is checked with one pass over
+    // all of its chunks, whereas an incremental update derives them from the changed chunks.
+    const bool isIncremental = !_chunkMap.empty();
+    auto shardVersions = isIncremental ? _shardVersions : ShardVersionMap{};
+    std::vector<std::string> changedKeys;
+
+    // Shards which lost the chunk with their max version and did not receive a newer chunk since
+    std::set<ShardId> shardsToRecompute;
+
     ChunkVersion collectionVersion = startingCollectionVersion;
     for (const auto& chunk : changedChunks) {
         const auto& chunkVersion = chunk.getVersion();
@@ -529,20 +711,35 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
 
         const auto chunkMinKeyString = _extractKeyString(chunk.getMin());
         const auto chunkMaxKeyString = _extractKeyString(chunk.getMax());
+        auto chunkInfo = std::make_shared<ChunkInfo>(chunk);
+
+        if (isIncremental) {
+            const auto overlapEnd = chunkMap.upper_bound(chunkMaxKeyString);
+            for (auto it = chunkMap.upper_bound(chunkMinKeyString); it != overlapEnd; ++it) {
+                const auto& shardId = it->second->getShardIdAt(boost::none);
+                auto shardVersionIt = shardVersions.find(shardId);
+                invariant(shardVersionIt != shardVersions.end());
+
+                auto& shardVersion = shardVersionIt->second;
+                --shardVersion.numChunks;
+                if (it->second->getLastmod() == shardVersion.version)
+                    shardsToRecompute.insert(shardId);
+            }
 
-        // Returns the first chunk with a max key that is > min - implies that the chunk overlaps
-        // min
-        const auto low = chunkMap.upper_bound(chunkMinKeyString);
-
-        // Returns the first chunk with a max key that is > max - implies that the next chunk cannot
-        // not overlap max
-        const auto high = chunkMap.upper_bound(chunkMaxKeyString);
+            // The chunks come in version order, so the new chunk has the max version of its shard
+            const auto& shardId = chunkInfo->getShardIdAt(boost::none);
+            auto& shardVersion = shardVersions[shardId];
+            shardVersion.version = chunkVersion;
+            ++shardVersion.numChunks;
+            shardsToRecompute.erase(shardId);
 
-        // Erase all chunks from the map, which overlap the chunk we got from the persistent store
-        chunkMap.erase(low, high);
+            changedKeys.push_back(chunkMaxKeyString);
+        }
 
-        // Insert only the chunk itself
-        chunkMap.insert(std::make_pair(chunkMaxKeyString, std::make_shared<ChunkInfo>(chunk)));
+        // Replace all chunks in the map, which overlap the chunk we got from the persistent store,
+        // with the chunk itself. The copy of the map shares all the segments this doesn't touch
+        // with the map of the routing table being updated.
+        chunkMap.replaceOverlapping(chunkMinKeyString, chunkMaxKeyString, std::move(chunkInfo));
     }
 
     // If at least one diff was applied, the metadata is correct, but it might not have changed so
@@ -556,6 +753,42 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         return shared_from_this();
     }
 
+    if (isIncremental) {
+        _checkChangedRanges(chunkMap, changedKeys);
+
+        for (auto it = shardVersions.begin(); it != shardVersions.end();) {
+            if (it->second.numChunks == 0) {
+                shardsToRecompute.erase(it->first);
+                it = shardVersions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // The max version of a shard which still owns chunks, but not the one with its max version,
+        // can only be found by looking at all of them. Migrations always bump the version of a
+        // chunk left on the donor shard, so this is rare.
+        if (!shardsToRecompute.empty()) {
+            for (const auto& shardId : shardsToRecompute) {
+                shardVersions[shardId].version = ChunkVersion(0, 0, collectionVersion.epoch());
+            }
+
+            for (const auto& entry : chunkMap) {
+                const auto& chunkInfo = entry.second;
+                const auto& shardId = chunkInfo->getShardIdAt(boost::none);
+                if (!shardsToRecompute.count(shardId))
+                    continue;
+
+                auto& shardVersion = shardVersions[shardId];
+                if (chunkInfo->getLastmod() > shardVersion.version)
+                    shardVersion.version = chunkInfo->getLastmod();
+            }
+        }
+    } else {
+        shardVersions =
+            _constructShardVersionMap(collectionVersion.epoch(), chunkMap, _shardKeyOrdering);
+    }
+
     return std::shared_ptr<RoutingTableHistory>(
         new RoutingTableHistory(_nss,
                                 _uuid,
@@ -563,6 +796,7 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
                                 CollatorInterface::cloneCollator(getDefaultCollator()),
                                 isUnique(),
                                 std::move(chunkMap),
+                                std::move(shardVersions),
                                 collectionVersion));
 }
 
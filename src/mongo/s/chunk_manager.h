@@ -28,7 +28,9 @@
 
 #pragma once
 
+#include <iterator>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -49,11 +51,155 @@ struct QuerySolutionNode;
 class OperationContext;
 class ChunkManager;
 
-// Ordered map from the max for each chunk to an entry describing the chunk
-using ChunkInfoMap = std::map<std::string, std::shared_ptr<ChunkInfo>>;
+/**
+ * Ordered map from the max for each chunk to an entry describing the chunk.
+ *
+ * The entries are kept in contiguous sorted segments of at most kMaxSegmentSize chunks each, with
+ * the max key of every segment in a separate contiguous array, so that a lookup is two binary
+ * searches over flat arrays instead of a walk down a node-based tree. Segments are immutable once
+ * they are shared between two maps: copying a ChunkInfoMap only copies the segment pointers, and
+ * an update rewrites just the segments which it touches, so an incremental refresh shares all the
+ * unchanged segments with the routing table it was derived from.
+ */
+class ChunkInfoMap {
+public:
+    using value_type = std::pair<std::string, std::shared_ptr<ChunkInfo>>;
+
+    // Maximum number of chunks stored in a single segment
+    static constexpr size_t kMaxSegmentSize = 512;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = ChunkInfoMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator() = default;
+
+        reference operator*() const {
+            return (*_map->_segments[_segment])[_offset];
+        }
+        pointer operator->() const {
+            return &operator*();
+        }
+
+        const_iterator& operator++() {
+            if (++_offset == _map->_segments[_segment]->size()) {
+                ++_segment;
+                _offset = 0;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto result = *this;
+            operator++();
+            return result;
+        }
+
+        const_iterator& operator--() {
+            if (_offset == 0) {
+                --_segment;
+                _offset = _map->_segments[_segment]->size();
+            }
+            --_offset;
+            return *this;
+        }
+        const_iterator operator--(int) {
+            auto result = *this;
+            operator--();
+            return result;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return _map == other._map && _segment == other._segment && _offset == other._offset;
+        }
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class ChunkInfoMap;
+
+        const_iterator(const ChunkInfoMap* map, size_t segment, size_t offset)
+            : _map(map), _segment(segment), _offset(offset) {}
+
+        const ChunkInfoMap* _map{nullptr};
+        size_t _segment{0};
+        size_t _offset{0};
+    };
+
+    const_iterator begin() const {
+        return {this, 0, 0};
+    }
+    const_iterator end() const {
+        return {this, _segments.size(), 0};
+    }
+    const_iterator cbegin() const {
+        return begin();
+    }
+    const_iterator cend() const {
+        return end();
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * Returns the first entry whose max key sorts after (upper_bound) or not before (lower_bound)
+     * the given key, or end() if there is no such entry.
+     */
+    const_iterator upper_bound(const std::string& key) const;
+    const_iterator lower_bound(const std::string& key) const;
+
+    /**
+     * Removes all the entries in the range [upper_bound(minKey), upper_bound(maxKey)), which are
+     * the chunks overlapping [minKey, maxKey), and inserts 'chunk' under 'maxKey' in their place.
+     * Only the segments containing the removed entries are rewritten.
+     */
+    void replaceOverlapping(const std::string& minKey,
+                            std::string maxKey,
+                            std::shared_ptr<ChunkInfo> chunk);
+
+private:
+    using Segment = std::vector<value_type>;
 
-// Map from a shard is to the max chunk version on that shard
-using ShardVersionMap = std::map<ShardId, ChunkVersion>;
+    /**
+     * Returns the segment and offset within it at which an entry at 'it' would be inserted. The
+     * end position is reported as one past the last entry of the last segment, so that appends
+     * go into the last segment while it has room.
+     */
+    std::pair<size_t, size_t> _insertionPoint(const const_iterator& it) const;
+
+    /**
+     * Replaces the segments in [first, last) with 'entries', split into as few evenly sized
+     * segments as fit.
+     */
+    void _replaceSegments(size_t first, size_t last, Segment entries);
+
+    // Sorted, non-empty segments and the max key of the last entry of each of them. A segment is
+    // only modified in place while this map holds the sole reference to it.
+    std::vector<std::shared_ptr<Segment>> _segments;
+    std::vector<std::string> _segmentMaxKeys;
+
+    // Total number of entries across all segments
+    size_t _size{0};
+};
+
+// Max chunk version on a shard and the number of chunks which it owns
+struct ShardVersionInfo {
+    ChunkVersion version;
+    size_t numChunks{0};
+};
+
+// Map from a shard id to the max chunk version on that shard
+using ShardVersionMap = std::map<ShardId, ShardVersionInfo>;
 
 /**
  * In-memory representation of the routing table for a single sharded collection at various points
@@ -89,6 +235,11 @@ public:
      *
      * The changes in "changedChunks" must be sorted in ascending order by chunk version, and adhere
      * to the requirements of the routing table update algorithm.
+     *
+     * The new routing table shares all the chunks which did not change with this one, and its
+     * shard versions and the consistency checks of its ranges are derived from the changed chunks
+     * only, so the cost of an incremental update is proportional to the number of changes rather
+     * than to the number of chunks in the collection.
      */
     std::shared_ptr<RoutingTableHistory> makeUpdated(const std::vector<ChunkType>& changedChunks);
 
@@ -157,12 +308,21 @@ private:
                                                      const ChunkInfoMap& chunkMap,
                                                      Ordering shardKeyOrdering);
 
+    /**
+     * Checks that the chunks around each of the "changedKeys", which are the max keys of chunks
+     * applied by an incremental update, are contiguous and that the chunkMap still covers the
+     * complete space from [MinKey, MaxKey).
+     */
+    static void _checkChangedRanges(const ChunkInfoMap& chunkMap,
+                                    const std::vector<std::string>& changedKeys);
+
     RoutingTableHistory(NamespaceString nss,
                         boost::optional<UUID> uuid,
                         KeyPattern shardKeyPattern,
                         std::unique_ptr<CollatorInterface> defaultCollator,
                         bool unique,
                         ChunkInfoMap chunkMap,
+                        ShardVersionMap shardVersions,
                         ChunkVersion collectionVersion);
 
     std::string _extractKeyString(const BSONObj& shardKeyValue) const;
@@ -487,5 +487,49 @@ TEST_F(ChunkManagerQueryTest, SimpleCollationNumbersMultiShard) {
         {ShardId("0")});
 }
 
+TEST_F(ChunkManagerQueryTest, FindIntersectingChunkAcrossSegmentsAfterIncrementalUpdate) {
+    const int nSplitPoints = 2 * ChunkInfoMap::kMaxSegmentSize;
+
+    std::vector<BSONObj> splitPoints;
+    for (int i = 0; i < nSplitPoints; ++i) {
+        splitPoints.push_back(BSON("a" << i));
+    }
+
+    auto chunkManager =
+        makeChunkManager(kNss, ShardKeyPattern(BSON("a" << 1)), nullptr, false, splitPoints);
+    ASSERT_EQ(nSplitPoints + 1, chunkManager->numChunks());
+
+    for (int i = 0; i < nSplitPoints; ++i) {
+        auto chunk = chunkManager->findIntersectingChunkWithSimpleCollation(BSON("a" << i));
+        ASSERT_BSONOBJ_EQ(BSON("a" << i), chunk.getMin());
+        ASSERT_EQ(ShardId(str::stream() << (i + 1)), chunk.getShardId());
+    }
+
+    // Merge a range of chunks spanning more than one segment and move it to a different shard
+    auto version = chunkManager->getVersion();
+    version.incMajor();
+    auto updatedChunkManager = std::make_shared<ChunkManager>(
+        chunkManager->getRoutingHistory()->makeUpdated(
+            {ChunkType(kNss, {BSON("a" << 100), BSON("a" << 700)}, version, ShardId("0"))}),
+        boost::none);
+    ASSERT_EQ(nSplitPoints + 1 - 599, updatedChunkManager->numChunks());
+
+    auto mergedChunk =
+        updatedChunkManager->findIntersectingChunkWithSimpleCollation(BSON("a" << 512));
+    ASSERT_BSONOBJ_EQ(BSON("a" << 100), mergedChunk.getMin());
+    ASSERT_BSONOBJ_EQ(BSON("a" << 700), mergedChunk.getMax());
+    ASSERT_EQ(ShardId("0"), mergedChunk.getShardId());
+
+    auto nextChunk =
+        updatedChunkManager->findIntersectingChunkWithSimpleCollation(BSON("a" << 700));
+    ASSERT_BSONOBJ_EQ(BSON("a" << 700), nextChunk.getMin());
+    ASSERT_EQ(ShardId("701"), nextChunk.getShardId());
+
+    // The routing table which was updated is not affected
+    auto originalChunk = chunkManager->findIntersectingChunkWithSimpleCollation(BSON("a" << 512));
+    ASSERT_BSONOBJ_EQ(BSON("a" << 512), originalChunk.getMin());
+    ASSERT_EQ(nSplitPoints + 1, chunkManager->numChunks());
+}
+
 }  // namespace
 }  // namespace mongo
@@ -120,7 +120,37 @@ void BM_IncrementalRefreshOfPessimalBalancedDistribution(benchmark::State& state
     }
 }
 
-BENCHMARK(BM_IncrementalRefreshOfPessimalBalancedDistribution)->Args({2, 50000});
+BENCHMARK(BM_IncrementalRefreshOfPessimalBalancedDistribution)
+    ->Args({2, 50000})
+    ->Args({2, 1000000});
+
+void BM_IncrementalRefreshWithScatteredMoves(benchmark::State& state) {
+    const int nShards = state.range(0);
+    const int nChunks = state.range(1);
+    const int nMoves = state.range(2);
+    auto cm = makeChunkManagerWithOptimalBalancedDistribution(nShards, nChunks);
+
+    auto postMoveVersion = cm->getChunkManager()->getVersion();
+    const auto collName = NamespaceString(cm->getChunkManager()->getns());
+    std::vector<ChunkType> newChunks;
+    for (int i = 0; i < nMoves; ++i) {
+        postMoveVersion.incMajor();
+        newChunks.emplace_back(collName,
+                               getRangeForChunk(1 + int64_t(i) * (nChunks - 2) / nMoves, nChunks),
+                               postMoveVersion,
+                               ShardId(str::stream() << "shard" << (i % nShards)));
+    }
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(runIncrementalUpdate(*cm, newChunks));
+    }
+}
+
+BENCHMARK(BM_IncrementalRefreshWithScatteredMoves)
+    ->Args({10, 50000, 100})
+    ->Args({10, 1000000, 10})
+    ->Args({10, 1000000, 100})
+    ->Args({10, 1000000, 1000});
 
 template <typename ShardSelectorFn>
 auto BM_FullBuildOfChunkManager(benchmark::State& state, ShardSelectorFn selectShard) {
@@ -346,6 +376,7 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             ->Args({10, 50000})
             ->Args({100, 50000})
             ->Args({1000, 50000})
+            ->Args({10, 1000000})
             ->Args({2, 2});
     }
 
@@ -44,8 +44,10 @@
 #include "mongo/s/commands/cluster_explain.h"
 #include "mongo/s/commands/strategy.h"
 #include "mongo/s/grid.h"
+#include "mongo/s/query/cluster_query_result_cache.h"
 #include "mongo/s/stale_exception.h"
 #include "mongo/s/write_ops/cluster_write.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -178,6 +180,9 @@ public:
         const BSONObj shardKey = getShardKey(opCtx, *chunkMgr, query);
         auto chunk = chunkMgr->findIntersectingChunk(shardKey, collation);
 
+        // Query results cached for the collection must not outlive the write, even if it fails.
+        ON_BLOCK_EXIT([&] { ClusterQueryResultCache::get(opCtx)->invalidate(nss); });
+
         _runCommand(opCtx,
                     chunk.getShardId(),
                     chunkMgr->getVersion(chunk.getShardId()),
@@ -38,6 +38,7 @@
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/killcursors_request.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
 #include "mongo/util/assert_util.h"
@@ -53,6 +54,9 @@ namespace {
 // Maximum number of retries for network and replication notMaster errors (per host).
 const int kMaxNumFailedHostRetryAttempts = 3;
 
+// The largest number of fields an Ordering, and so a KeyString encoded sort key, can describe.
+const int kMaxEncodedSortKeyFields = 32;
+
 /**
  * Returns the sort key out of the $sortKey metadata field in 'obj'. This object is of the form
  * {'': 'firstSortKey', '': 'secondSortKey', ...}.
@@ -98,6 +102,10 @@ AsyncResultsMerger::AsyncResultsMerger(OperationContext* opCtx,
         invariant(params.getSessionId());
     }
 
+    if (_params.getSort() && _params.getSort()->nFields() <= kMaxEncodedSortKeyFields) {
+        _sortKeyOrdering = Ordering::make(*_params.getSort());
+    }
+
     size_t remoteIndex = 0;
     for (const auto& remote : _params.getRemotes()) {
         _remotes.emplace_back(remote.getHostAndPort(),
@@ -225,7 +233,7 @@ bool AsyncResultsMerger::_readySortedTailable(WithLock) {
     }
 
     auto smallestRemote = _mergeQueue.top();
-    auto smallestResult = _remotes[smallestRemote].docBuffer.front();
+    const auto& smallestResult = _remotes[smallestRemote].docBuffer.front().result;
     auto keyWeWantToReturn =
         extractSortKey(*smallestResult.getResult(), _params.getCompareWholeSortKey());
     for (const auto& remote : _remotes) {
@@ -291,7 +299,7 @@ ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
     invariant(!_remotes[smallestRemote].docBuffer.empty());
     invariant(_remotes[smallestRemote].status.isOK());
 
-    ClusterQueryResult front = _remotes[smallestRemote].docBuffer.front();
+    ClusterQueryResult front = std::move(_remotes[smallestRemote].docBuffer.front().result);
     _remotes[smallestRemote].docBuffer.pop();
 
     // Re-populate the merging queue with the next result from 'smallestRemote', if it has a
@@ -310,7 +318,8 @@ ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
         invariant(_remotes[_gettingFromRemote].status.isOK());
 
         if (_remotes[_gettingFromRemote].hasNext()) {
-            ClusterQueryResult front = _remotes[_gettingFromRemote].docBuffer.front();
+            ClusterQueryResult front =
+                std::move(_remotes[_gettingFromRemote].docBuffer.front().result);
             _remotes[_gettingFromRemote].docBuffer.pop();
 
             if (_tailableMode == TailableModeEnum::kTailable &&
@@ -567,7 +576,7 @@ void AsyncResultsMerger::_cleanUpFailedBatch(WithLock lk, Status status, size_t
         remote.status = Status::OK();
 
         // Clear the results buffer and cursor id.
-        std::queue<ClusterQueryResult> emptyBuffer;
+        std::queue<BufferedResult> emptyBuffer;
         std::swap(remote.docBuffer, emptyBuffer);
         remote.cursorId = 0;
     }
@@ -620,6 +629,10 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
                                            const CursorResponse& response) {
     auto& remote = _remotes[remoteIndex];
     updateRemoteMetadata(&remote, response);
+
+    // Each sort key is encoded once as its result is buffered, rather than every time the result is
+    // compared against the front of another remote's buffer.
+    KeyString sortKeyString(KeyString::Version::V1);
     for (const auto& obj : response.getBatch()) {
         // If there's a sort, we're expecting the remote node to have given us back a sort key.
         if (_params.getSort()) {
@@ -641,8 +654,13 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
             }
         }
 
-        ClusterQueryResult result(obj);
-        remote.docBuffer.push(result);
+        BufferedResult buffered{ClusterQueryResult(obj), {}};
+        if (_sortKeyOrdering) {
+            sortKeyString.resetToKey(extractSortKey(obj, _params.getCompareWholeSortKey()),
+                                     *_sortKeyOrdering);
+            buffered.sortKey.assign(sortKeyString.getBuffer(), sortKeyString.getSize());
+        }
+        remote.docBuffer.push(std::move(buffered));
         ++remote.fetchedCount;
     }
 
@@ -761,11 +779,16 @@ bool AsyncResultsMerger::RemoteCursorData::exhausted() const {
 //
 
 bool AsyncResultsMerger::MergingComparator::operator()(const size_t& lhs, const size_t& rhs) {
-    const ClusterQueryResult& leftDoc = _remotes[lhs].docBuffer.front();
-    const ClusterQueryResult& rightDoc = _remotes[rhs].docBuffer.front();
+    const BufferedResult& leftDoc = _remotes[lhs].docBuffer.front();
+    const BufferedResult& rightDoc = _remotes[rhs].docBuffer.front();
+
+    // The sort keys are either encoded for all of the buffered results or for none of them.
+    if (!leftDoc.sortKey.empty()) {
+        return leftDoc.sortKey.compare(rightDoc.sortKey) > 0;
+    }
 
-    return compareSortKeys(extractSortKey(*leftDoc.getResult(), _compareWholeSortKey),
-                           extractSortKey(*rightDoc.getResult(), _compareWholeSortKey),
+    return compareSortKeys(extractSortKey(*leftDoc.result.getResult(), _compareWholeSortKey),
+                           extractSortKey(*rightDoc.result.getResult(), _compareWholeSortKey),
                            _sort) > 0;
 }
 
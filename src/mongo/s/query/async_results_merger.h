@@ -30,11 +30,13 @@
 
 #include <boost/optional.hpp>
 #include <queue>
+#include <string>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status_with.h"
 #include "mongo/bson/bsonobj.h"
+#include "mongo/bson/ordering.h"
 #include "mongo/db/cursor_id.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/s/query/async_results_merger_params_gen.h"
@@ -244,6 +246,17 @@ public:
     void blockingKill(OperationContext*);
 
 private:
+    /**
+     * A result which has been retrieved from a remote but not yet returned. When merging in sorted
+     * order, 'sortKey' holds the result's sort key encoded as a KeyString, so that the merge can
+     * order results by comparing bytes rather than by re-extracting and comparing the $sortKey
+     * BSON each time the merge queue is reordered. It is empty if the sort keys are not encoded.
+     */
+    struct BufferedResult {
+        ClusterQueryResult result;
+        std::string sortKey;
+    };
+
     /**
      * We instantiate one of these per remote host. It contains the buffer of results we've
      * retrieved from the host but not yet returned, as well as the cursor id, and any error
@@ -289,7 +302,7 @@ private:
         HostAndPort shardHostAndPort;
 
         // The buffer of results that have been retrieved but not yet returned to the caller.
-        std::queue<ClusterQueryResult> docBuffer;
+        std::queue<BufferedResult> docBuffer;
 
         // Is valid if there is currently a pending request to this remote.
         executor::TaskExecutor::CallbackHandle cbHandle;
@@ -438,6 +451,10 @@ private:
     // Data tracking the state of our communication with each of the remote nodes.
     std::vector<RemoteCursorData> _remotes;
 
+    // Set if there is a sort whose keys can be encoded as KeyStrings. The keys of sort patterns
+    // with more fields than an Ordering can describe are compared as BSON instead.
+    boost::optional<Ordering> _sortKeyOrdering;
+
     // The top of this priority queue is the index into '_remotes' for the remote host that has the
     // next document to return, according to the sort order. Used only if there is a sort.
     std::priority_queue<size_t, std::vector<size_t>, MergingComparator> _mergeQueue;
@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/query/cursor_response.h"
+#include "mongo/s/query/async_results_merger.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("testdb.testcoll");
+
+/**
+ * Returns the documents of one shard's exhausted cursor for a merge of 'numShards' shards which
+ * hold 'docsPerShard' documents each. The shards' sort keys interleave, so that the shard with the
+ * next result to return changes on every call to nextReady().
+ */
+std::vector<BSONObj> makeShardBatch(int shard, int numShards, int docsPerShard, bool compound) {
+    const std::string padding(64, 'x');
+
+    std::vector<BSONObj> batch;
+    batch.reserve(docsPerShard);
+    for (int i = 0; i < docsPerShard; i++) {
+        const int value = i * numShards + shard;
+
+        BSONObjBuilder bob;
+        bob.append("_id", value);
+        bob.append("padding", padding);
+        if (compound) {
+            // Sorted by {a: 1, b: -1}, so the second key field counts down.
+            bob.append(AsyncResultsMerger::kSortKeyField,
+                       BSON("" << value / numShards << "" << double(numShards - shard)));
+        } else {
+            bob.append(AsyncResultsMerger::kSortKeyField, BSON("" << value));
+        }
+        batch.push_back(bob.obj());
+    }
+
+    return batch;
+}
+
+/**
+ * Merges the results of 'numShards' exhausted shard cursors in sorted order. Building the merger is
+ * timed along with draining it, since that is where the sort keys of the buffered results are
+ * prepared for the merge.
+ */
+void runSortedMerge(benchmark::State& state, bool compound) {
+    const int numShards = state.range(0);
+    const int docsPerShard = state.range(1);
+
+    std::vector<std::vector<BSONObj>> batches;
+    for (int shard = 0; shard < numShards; shard++) {
+        batches.push_back(makeShardBatch(shard, numShards, docsPerShard, compound));
+    }
+
+    const BSONObj sort = compound ? BSON("a" << 1 << "b" << -1) : BSON("a" << 1);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        AsyncResultsMergerParams params;
+        params.setNss(kNss);
+        params.setSort(sort);
+
+        std::vector<RemoteCursor> remotes;
+        for (int shard = 0; shard < numShards; shard++) {
+            RemoteCursor remote;
+            remote.setShardId(ShardId(str::stream() << "shard" << shard));
+            remote.setHostAndPort(HostAndPort(str::stream() << "FakeShardHost" << shard, 12345));
+            remote.setCursorResponse(CursorResponse(kNss, CursorId(0), batches[shard]));
+            remotes.push_back(std::move(remote));
+        }
+        params.setRemotes(std::move(remotes));
+        state.ResumeTiming();
+
+        // Every remote cursor is already exhausted, so the merger never needs an executor.
+        AsyncResultsMerger arm(nullptr, nullptr, std::move(params));
+
+        int numReturned = 0;
+        while (true) {
+            invariant(arm.ready());
+            auto next = uassertStatusOK(arm.nextReady());
+            if (next.isEOF()) {
+                break;
+            }
+            benchmark::DoNotOptimize(next);
+            ++numReturned;
+        }
+        invariant(numReturned == numShards * docsPerShard);
+    }
+
+    state.SetItemsProcessed(state.iterations() * numShards * docsPerShard);
+}
+
+void BM_SortedMerge(benchmark::State& state) {
+    runSortedMerge(state, false);
+}
+
+void BM_SortedMergeCompoundKey(benchmark::State& state) {
+    runSortedMerge(state, true);
+}
+
+BENCHMARK(BM_SortedMerge)
+    ->Args({2, 10000})
+    ->Args({10, 10000})
+    ->Args({50, 1000})
+    ->Args({50, 10000});
+BENCHMARK(BM_SortedMergeCompoundKey)
+    ->Args({2, 10000})
+    ->Args({10, 10000})
+    ->Args({50, 1000})
+    ->Args({50, 10000});
+
+}  // namespace
+}  // namespace mongo
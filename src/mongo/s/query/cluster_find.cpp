@@ -58,6 +58,7 @@
 #include "mongo/s/query/cluster_client_cursor_impl.h"
 #include "mongo/s/query/cluster_cursor_manager.h"
 #include "mongo/s/query/cluster_query_knobs.h"
+#include "mongo/s/query/cluster_query_result_cache.h"
 #include "mongo/s/query/establish_cursors.h"
 #include "mongo/s/query/store_possible_cursor.h"
 #include "mongo/s/stale_exception.h"
@@ -436,8 +437,27 @@ CursorId ClusterFind::runQuery(OperationContext* opCtx,
 
         auto routingInfo = uassertStatusOK(routingInfoStatus);
 
+        auto const resultCache = ClusterQueryResultCache::get(opCtx);
+        auto cacheKey = resultCache->makeKey(opCtx, query, readPref, routingInfo);
+        if (cacheKey) {
+            const auto now = opCtx->getServiceContext()->getFastClockSource()->now();
+            if (auto cachedResults = resultCache->lookup(cacheKey.get_ptr(), now)) {
+                *results = std::move(*cachedResults);
+                CurOp::get(opCtx)->debug().nShards = 0;
+                CurOp::get(opCtx)->debug().nreturned = results->size();
+                CurOp::get(opCtx)->debug().cursorExhausted = true;
+                return CursorId(0);
+            }
+        }
+
         try {
-            return runQueryWithoutRetrying(opCtx, query, readPref, routingInfo, results);
+            const auto cursorId =
+                runQueryWithoutRetrying(opCtx, query, readPref, routingInfo, results);
+            if (cacheKey && cursorId == 0) {
+                resultCache->insert(
+                    *cacheKey, *results, opCtx->getServiceContext()->getFastClockSource()->now());
+            }
+            return cursorId;
         } catch (DBException& ex) {
             if (retries >= kMaxRetries) {
                 // Check if there are no retries remaining, so the last received error can be
@@ -32,8 +32,10 @@
 #include "mongo/db/logical_clock.h"
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/query/query_request.h"
+#include "mongo/db/server_parameters_test_util.h"
 #include "mongo/s/catalog_cache_test_fixture.h"
 #include "mongo/s/query/cluster_find.h"
+#include "mongo/s/query/cluster_query_result_cache.h"
 #include "mongo/unittest/unittest.h"
 
 namespace mongo {
@@ -146,6 +148,16 @@ protected:
         future.timed_get(kFutureTimeout);
     }
 
+    void runFindCommandFromResultCache(BSONObj cmd) {
+        // No response is scheduled, so the query fails with a timeout if it is sent to a shard.
+        auto future = launchAsync([&] {
+            auto result = runFindCommand(cmd);
+            ASSERT_EQ(1, result["cursor"]["firstBatch"].Array().size());
+        });
+
+        future.timed_get(kFutureTimeout);
+    }
+
     void runFindCommandOneError(BSONObj cmd, ErrorCodes::Error code, bool isTargeted) {
         auto future = launchAsync([&] {
             // Shouldn't throw.
@@ -280,5 +292,67 @@ TEST_F(ClusterFindTest, SnapshotReadConcernWithAfterClusterTime) {
                                   false);
 }
 
+TEST_F(ClusterFindTest, RepeatedPointReadsServedFromResultCache) {
+    ServerParameterControllerForTest cacheSize("clusterQueryResultCacheSizeMB", "1");
+    ServerParameterControllerForTest maxStaleness("clusterQueryResultCacheLocalMaxStalenessMS",
+                                                  "1000000");
+
+    loadRoutingTableWithTwoChunksAndTwoShards(kNss);
+
+    // A query's results are cached the second time it misses the cache.
+    runFindCommandSuccessful(kFindCmdTargeted, true);
+    runFindCommandSuccessful(kFindCmdTargeted, true);
+    runFindCommandFromResultCache(kFindCmdTargeted);
+    runFindCommandFromResultCache(kFindCmdTargeted);
+
+    // Queries which do not match the full shard key by equality are never cached.
+    runFindCommandSuccessful(kFindCmdScatterGather, false);
+    runFindCommandSuccessful(kFindCmdScatterGather, false);
+    runFindCommandSuccessful(kFindCmdScatterGather, false);
+
+    // A write to the collection invalidates its cached results.
+    ClusterQueryResultCache::get(operationContext())->invalidate(kNss);
+    runFindCommandSuccessful(kFindCmdTargeted, true);
+    runFindCommandFromResultCache(kFindCmdTargeted);
+
+    BSONObjBuilder builder;
+    ClusterQueryResultCache::get(operationContext())->report(&builder);
+    const auto report = builder.obj();
+    ASSERT_EQ(3, report["hits"].numberLong());
+    ASSERT_EQ(3, report["misses"].numberLong());
+    ASSERT_EQ(1, report["invalidations"].numberLong());
+    ASSERT_EQ(1, report["entries"].numberLong());
+}
+
+TEST_F(ClusterFindTest, DisablingResultCacheFreesCachedResults) {
+    ServerParameterControllerForTest cacheSize("clusterQueryResultCacheSizeMB", "1");
+    ServerParameterControllerForTest maxStaleness("clusterQueryResultCacheLocalMaxStalenessMS",
+                                                  "1000000");
+
+    loadRoutingTableWithTwoChunksAndTwoShards(kNss);
+
+    runFindCommandSuccessful(kFindCmdTargeted, true);
+    runFindCommandSuccessful(kFindCmdTargeted, true);
+    runFindCommandFromResultCache(kFindCmdTargeted);
+
+    {
+        ServerParameterControllerForTest disabled("clusterQueryResultCacheSizeMB", "0");
+
+        BSONObjBuilder builder;
+        ClusterQueryResultCache::get(operationContext())->report(&builder);
+        const auto report = builder.obj();
+        ASSERT_EQ(0, report["entries"].numberLong());
+        ASSERT_EQ(0, report["sizeBytes"].numberLong());
+        ASSERT_EQ(1, report["evictions"].numberLong());
+
+        runFindCommandSuccessful(kFindCmdTargeted, true);
+    }
+
+    // The query has to miss the cache twice again before its results are cached.
+    runFindCommandSuccessful(kFindCmdTargeted, true);
+    runFindCommandSuccessful(kFindCmdTargeted, true);
+    runFindCommandFromResultCache(kFindCmdTargeted);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -0,0 +1,381 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/query/cluster_query_result_cache.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/client/read_preference.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/repl/read_concern_args.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/service_context.h"
+#include "mongo/s/catalog_cache.h"
+
+namespace mongo {
+
+namespace {
+
+AtomicInt32 clusterQueryResultCacheSizeMB(0);
+
+class ClusterQueryResultCacheSizeParameter
+    : public ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime> {
+public:
+    ClusterQueryResultCacheSizeParameter()
+        : ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>(
+              ServerParameterSet::getGlobal(),
+              "clusterQueryResultCacheSizeMB",
+              &clusterQueryResultCacheSizeMB) {}
+
+    Status set(const int& newValue) override {
+        auto status =
+            ExportedServerParameter<int, ServerParameterType::kStartupAndRuntime>::set(newValue);
+        if (status.isOK() && hasGlobalServiceContext()) {
+            ClusterQueryResultCache::get(getGlobalServiceContext())->evictToMaxSize();
+        }
+        return status;
+    }
+
+    Status validate(const int& potentialNewValue) override {
+        if (potentialNewValue < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "clusterQueryResultCacheSizeMB must be at least 0");
+        }
+        return Status::OK();
+    }
+
+} clusterQueryResultCacheSizeParameter;
+
+}  // namespace
+
+MONGO_EXPORT_SERVER_PARAMETER(clusterQueryResultCacheLocalMaxStalenessMS, int, 100)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "clusterQueryResultCacheLocalMaxStalenessMS must be at least 0");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(clusterQueryResultCacheMajorityMaxStalenessMS, int, 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "clusterQueryResultCacheMajorityMaxStalenessMS must be at least 0");
+        }
+        return Status::OK();
+    });
+
+namespace {
+
+const auto getClusterQueryResultCache =
+    ServiceContext::declareDecoration<ClusterQueryResultCache>();
+
+// The results of a single query may take up at most this fraction of the cache.
+const size_t kMaxEntryFractionOfCache = 16;
+
+// The number of recently missed keys to remember before forgetting all of them.
+const size_t kMaxRecentMisses = 64 * 1024;
+
+// The bookkeeping cost of an entry, besides its key and results.
+const size_t kPerEntryOverheadBytes = 128;
+
+// The number of namespaces without cached results whose write generations are kept before all of
+// them are forgotten.
+const size_t kMaxNamespacesWithoutEntries = 1024;
+
+size_t getMaxSizeBytes() {
+    return static_cast<size_t>(clusterQueryResultCacheSizeMB.load()) * 1024 * 1024;
+}
+
+}  // namespace
+
+ClusterQueryResultCache* ClusterQueryResultCache::get(ServiceContext* serviceContext) {
+    return &getClusterQueryResultCache(serviceContext);
+}
+
+ClusterQueryResultCache* ClusterQueryResultCache::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+boost::optional<ClusterQueryResultCache::Key> ClusterQueryResultCache::makeKey(
+    OperationContext* opCtx,
+    const CanonicalQuery& query,
+    const ReadPreferenceSetting& readPref,
+    const CachedCollectionRoutingInfo& routingInfo) {
+    if (clusterQueryResultCacheSizeMB.load() == 0) {
+        return boost::none;
+    }
+
+    // Only queries on sharded collections which compare strings with the simple collation are
+    // cached, so that the shard key extracted from the query identifies the chunk it targets.
+    const auto cm = routingInfo.cm();
+    const auto& qr = query.getQueryRequest();
+    if (!cm || cm->getDefaultCollator() || !qr.getCollation().isEmpty()) {
+        return boost::none;
+    }
+
+    if (qr.isTailable() || qr.isAllowPartialResults() || opCtx->getTxnNumber()) {
+        return boost::none;
+    }
+
+    // Reads which must observe a particular point in time are never answered from the cache.
+    const auto& readConcernArgs = repl::ReadConcernArgs::get(opCtx);
+    if (readConcernArgs.getArgsOpTime() || readConcernArgs.getArgsAfterClusterTime() ||
+        readConcernArgs.getArgsAtClusterTime()) {
+        return boost::none;
+    }
+
+    Milliseconds maxStaleness;
+    switch (readConcernArgs.getLevel()) {
+        case repl::ReadConcernLevel::kLocalReadConcern:
+        case repl::ReadConcernLevel::kAvailableReadConcern:
+            maxStaleness = Milliseconds(clusterQueryResultCacheLocalMaxStalenessMS.load());
+            break;
+        case repl::ReadConcernLevel::kMajorityReadConcern:
+            maxStaleness = Milliseconds(clusterQueryResultCacheMajorityMaxStalenessMS.load());
+            break;
+        default:
+            return boost::none;
+    }
+
+    if (maxStaleness <= Milliseconds(0)) {
+        return boost::none;
+    }
+
+    const auto shardKey = cm->getShardKeyPattern().extractShardKeyFromQuery(query);
+    if (shardKey.isEmpty()) {
+        return boost::none;
+    }
+
+    BSONObjBuilder keyBuilder;
+    {
+        // Options which do not affect the results are left out of the key.
+        BSONObjBuilder findBuilder(keyBuilder.subobjStart("find"));
+        for (auto&& elem : qr.asFindCommand()) {
+            const auto fieldName = elem.fieldNameStringData();
+            if (fieldName == QueryRequest::cmdOptionMaxTimeMS || fieldName == "comment"_sd ||
+                fieldName == repl::ReadConcernArgs::kReadConcernFieldName) {
+                continue;
+            }
+            findBuilder.append(elem);
+        }
+    }
+    keyBuilder.append("ns", query.nss().ns());
+    keyBuilder.append("readPreference", readPref.toInnerBSON());
+    keyBuilder.append("readConcernLevel", static_cast<int>(readConcernArgs.getLevel()));
+    const auto keyObj = keyBuilder.done();
+
+    Key key;
+    key.key.assign(keyObj.objdata(), keyObj.objsize());
+    key.nss = query.nss();
+    key.chunkVersion = cm->findIntersectingChunkWithSimpleCollation(shardKey).getLastmod();
+    key.maxStaleness = maxStaleness;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        key.writeGeneration = _getWriteGeneration(lk, key.nss);
+    }
+    return key;
+}
+
+boost::optional<std::vector<BSONObj>> ClusterQueryResultCache::lookup(Key* key, Date_t now) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    auto indexIt = _index.find(key->key);
+    if (indexIt != _index.end()) {
+        auto entryIt = indexIt->second;
+        if (entryIt->chunkVersion == key->chunkVersion &&
+            entryIt->writeGeneration == _getWriteGeneration(lk, key->nss) &&
+            now - entryIt->cachedAt <= key->maxStaleness) {
+            _entries.splice(_entries.begin(), _entries, entryIt);
+            _numHits.addAndFetch(1);
+            return entryIt->results;
+        }
+
+        _erase(lk, entryIt);
+        _numInvalidations.addAndFetch(1);
+    }
+
+    _numMisses.addAndFetch(1);
+
+    if (_recentMisses.size() >= kMaxRecentMisses) {
+        _recentMisses.clear();
+    }
+    key->admit = !_recentMisses.insert(std::hash<std::string>()(key->key)).second;
+    return boost::none;
+}
+
+void ClusterQueryResultCache::insert(const Key& key,
+                                     const std::vector<BSONObj>& results,
+                                     Date_t now) {
+    if (!key.admit) {
+        return;
+    }
+
+    size_t sizeBytes = key.key.size() + kPerEntryOverheadBytes;
+    for (const auto& result : results) {
+        sizeBytes += result.objsize();
+    }
+
+    const auto maxSizeBytes = getMaxSizeBytes();
+    if (sizeBytes > maxSizeBytes / kMaxEntryFractionOfCache) {
+        return;
+    }
+
+    // The results may point into a larger buffer, such as a shard's reply, which the cache should
+    // not keep alive.
+    std::vector<BSONObj> ownedResults;
+    ownedResults.reserve(results.size());
+    for (const auto& result : results) {
+        ownedResults.push_back(result.getOwned());
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    // A write to the collection may have completed after the query read its results.
+    if (key.writeGeneration != _getWriteGeneration(lk, key.nss)) {
+        return;
+    }
+
+    auto indexIt = _index.find(key.key);
+    if (indexIt != _index.end()) {
+        _erase(lk, indexIt->second);
+    }
+
+    auto nsIt = _namespaces.find(key.nss.ns());
+    if (nsIt == _namespaces.end()) {
+        nsIt = _namespaces.emplace(key.nss.ns(), NamespaceState{key.writeGeneration, 0}).first;
+    } else if (nsIt->second.numEntries == 0) {
+        _numNamespacesWithoutEntries--;
+    }
+    nsIt->second.numEntries++;
+
+    _entries.push_front(Entry{key.key,
+                              key.nss,
+                              key.chunkVersion,
+                              key.writeGeneration,
+                              now,
+                              std::move(ownedResults),
+                              sizeBytes});
+    _index[key.key] = _entries.begin();
+    _sizeBytes += sizeBytes;
+
+    while (_sizeBytes > maxSizeBytes) {
+        _erase(lk, std::prev(_entries.end()));
+        _numEvictions.addAndFetch(1);
+    }
+
+    _pruneNamespaces(lk, kMaxNamespacesWithoutEntries);
+}
+
+void ClusterQueryResultCache::invalidate(const NamespaceString& nss) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    auto it = _namespaces.find(nss.ns());
+    if (it == _namespaces.end()) {
+        it = _namespaces.emplace(nss.ns(), NamespaceState{0, 0}).first;
+        _numNamespacesWithoutEntries++;
+    }
+    it->second.writeGeneration = ++_lastWriteGeneration;
+
+    _pruneNamespaces(lk, kMaxNamespacesWithoutEntries);
+}
+
+void ClusterQueryResultCache::evictToMaxSize() {
+    const auto maxSizeBytes = getMaxSizeBytes();
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    while (_sizeBytes > maxSizeBytes) {
+        _erase(lk, std::prev(_entries.end()));
+        _numEvictions.addAndFetch(1);
+    }
+
+    if (maxSizeBytes == 0) {
+        _recentMisses.clear();
+        _pruneNamespaces(lk, 0);
+    } else {
+        _pruneNamespaces(lk, kMaxNamespacesWithoutEntries);
+    }
+}
+
+void ClusterQueryResultCache::report(BSONObjBuilder* builder) const {
+    const long long numHits = _numHits.load();
+    const long long numMisses = _numMisses.load();
+
+    builder->append("hits", numHits);
+    builder->append("misses", numMisses);
+    builder->append("hitRate",
+                    numHits + numMisses ? double(numHits) / double(numHits + numMisses) : 0.0);
+    builder->append("invalidations", _numInvalidations.load());
+    builder->append("evictions", _numEvictions.load());
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    builder->append("entries", static_cast<long long>(_entries.size()));
+    builder->append("sizeBytes", static_cast<long long>(_sizeBytes));
+}
+
+void ClusterQueryResultCache::_erase(WithLock, EntryList::iterator it) {
+    auto nsIt = _namespaces.find(it->nss.ns());
+    invariant(nsIt != _namespaces.end());
+    if (--nsIt->second.numEntries == 0) {
+        _numNamespacesWithoutEntries++;
+    }
+
+    _sizeBytes -= it->sizeBytes;
+    _index.erase(it->key);
+    _entries.erase(it);
+}
+
+uint64_t ClusterQueryResultCache::_getWriteGeneration(WithLock,
+                                                      const NamespaceString& nss) const {
+    auto it = _namespaces.find(nss.ns());
+    return it == _namespaces.end() ? _prunedWriteGeneration : it->second.writeGeneration;
+}
+
+void ClusterQueryResultCache::_pruneNamespaces(WithLock, size_t maxNamespacesWithoutEntries) {
+    if (_numNamespacesWithoutEntries <= maxNamespacesWithoutEntries) {
+        return;
+    }
+
+    for (auto it = _namespaces.begin(); it != _namespaces.end();) {
+        if (it->second.numEntries == 0) {
+            it = _namespaces.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    _numNamespacesWithoutEntries = 0;
+
+    // A query on a forgotten namespace may have read its results before the write which
+    // advanced its generation, so the forgotten namespaces take on the latest generation.
+    _prunedWriteGeneration = _lastWriteGeneration;
+}
+
+}  // namespace mongo
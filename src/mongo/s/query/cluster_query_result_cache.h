@@ -0,0 +1,198 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/s/chunk_version.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/stdx/unordered_set.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class CachedCollectionRoutingInfo;
+class CanonicalQuery;
+class OperationContext;
+class ServiceContext;
+struct ReadPreferenceSetting;
+
+/**
+ * Decoration on ServiceContext which caches the results of read-only queries on mongos, so that
+ * repeated point reads can be answered without a round trip to a shard. Caching is enabled by
+ * setting the 'clusterQueryResultCacheSizeMB' server parameter.
+ *
+ * Only the results of queries which match the full shard key of a sharded collection by equality,
+ * and which fit in a single batch, are cached. A cached result is not used once the chunk which
+ * owns its shard key has changed version, once a write through this mongos has been made to its
+ * collection, or once it is older than the staleness bound of the query's read concern. The least
+ * recently used results are evicted to stay within the configured size.
+ */
+class ClusterQueryResultCache {
+    MONGO_DISALLOW_COPYING(ClusterQueryResultCache);
+
+public:
+    /**
+     * Identifies the cached results of a query and the routing state the results are valid for.
+     */
+    struct Key {
+        // The query, read preference and read concern level, serialized.
+        std::string key;
+
+        NamespaceString nss;
+
+        // The version of the chunk which owns the query's shard key.
+        ChunkVersion chunkVersion;
+
+        // How old the cached results may be for the query's read concern.
+        Milliseconds maxStaleness;
+
+        // The write generation of the collection when the key was made. Results are only inserted
+        // if no write to the collection has completed since.
+        uint64_t writeGeneration = 0;
+
+        // Set by lookup() if the query missed the cache before, in which case its results are
+        // admitted by insert(). This keeps queries which run only once from evicting hot results.
+        bool admit = false;
+    };
+
+    ClusterQueryResultCache() = default;
+
+    static ClusterQueryResultCache* get(ServiceContext* serviceContext);
+    static ClusterQueryResultCache* get(OperationContext* opCtx);
+
+    /**
+     * Returns the key under which the results of 'query' may be cached, or boost::none if caching
+     * is disabled or the query's results may not be cached.
+     */
+    boost::optional<Key> makeKey(OperationContext* opCtx,
+                                 const CanonicalQuery& query,
+                                 const ReadPreferenceSetting& readPref,
+                                 const CachedCollectionRoutingInfo& routingInfo);
+
+    /**
+     * Returns the cached results for 'key' if they are still valid at time 'now', and removes them
+     * from the cache if they are not.
+     */
+    boost::optional<std::vector<BSONObj>> lookup(Key* key, Date_t now);
+
+    /**
+     * Caches 'results' under 'key', evicting the least recently used results as needed.
+     */
+    void insert(const Key& key, const std::vector<BSONObj>& results, Date_t now);
+
+    /**
+     * Invalidates the cached results for 'nss'. Called after a write to 'nss' through this mongos.
+     */
+    void invalidate(const NamespaceString& nss);
+
+    /**
+     * Evicts the least recently used results until the cache fits in its configured size. Called
+     * when 'clusterQueryResultCacheSizeMB' is set, so that disabling the cache frees everything it
+     * holds.
+     */
+    void evictToMaxSize();
+
+    /**
+     * Appends the cache's hit and miss counts and its size to 'builder'.
+     */
+    void report(BSONObjBuilder* builder) const;
+
+private:
+    struct Entry {
+        std::string key;
+        NamespaceString nss;
+        ChunkVersion chunkVersion;
+        uint64_t writeGeneration;
+        Date_t cachedAt;
+        std::vector<BSONObj> results;
+        size_t sizeBytes;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    /**
+     * Removes the entry at 'it' from the cache.
+     */
+    void _erase(WithLock, EntryList::iterator it);
+
+    /**
+     * Returns the write generation of 'nss'.
+     */
+    uint64_t _getWriteGeneration(WithLock, const NamespaceString& nss) const;
+
+    /**
+     * Forgets the write generations of the namespaces which have no cached results once there are
+     * more than 'maxNamespacesWithoutEntries' of them. Queries on those namespaces which are in
+     * progress will not insert their results.
+     */
+    void _pruneNamespaces(WithLock, size_t maxNamespacesWithoutEntries);
+
+    mutable stdx::mutex _mutex;
+
+    // The cached results, most recently used first, and an index of them by key.
+    EntryList _entries;
+    stdx::unordered_map<std::string, EntryList::iterator> _index;
+    size_t _sizeBytes = 0;
+
+    // The hashes of the keys which recently missed the cache. Cleared when it grows too large.
+    stdx::unordered_set<size_t> _recentMisses;
+
+    struct NamespaceState {
+        // Advanced by each write to the namespace.
+        uint64_t writeGeneration;
+        size_t numEntries;
+    };
+
+    // The namespaces which have cached results or were written to since they were last pruned.
+    stdx::unordered_map<std::string, NamespaceState> _namespaces;
+    size_t _numNamespacesWithoutEntries = 0;
+
+    // The last write generation given to a namespace, and the write generation of the namespaces
+    // which are not in '_namespaces'.
+    uint64_t _lastWriteGeneration = 0;
+    uint64_t _prunedWriteGeneration = 0;
+
+    AtomicInt64 _numHits;
+    AtomicInt64 _numMisses;
+    AtomicInt64 _numInvalidations;
+    AtomicInt64 _numEvictions;
+};
+
+}  // namespace mongo
@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/read_hedging_stats.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/service_context.h"
+
+namespace mongo {
+namespace {
+
+const auto getReadHedgingStats = ServiceContext::declareDecoration<ReadHedgingStats>();
+
+}  // namespace
+
+constexpr size_t ReadHedgingStats::kLatencySamplesPerHost;
+
+ReadHedgingStats* ReadHedgingStats::get(ServiceContext* serviceContext) {
+    return &getReadHedgingStats(serviceContext);
+}
+
+void ReadHedgingStats::recordLatency(const HostAndPort& host, Milliseconds latency) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    auto& hostLatencies = _latencies[host];
+    hostLatencies.samples[hostLatencies.nextSample] = latency;
+    hostLatencies.nextSample = (hostLatencies.nextSample + 1) % kLatencySamplesPerHost;
+    hostLatencies.numSamples = std::min(hostLatencies.numSamples + 1, kLatencySamplesPerHost);
+}
+
+boost::optional<Milliseconds> ReadHedgingStats::getLatencyPercentile(const HostAndPort& host,
+                                                                     int percentile) const {
+    std::array<Milliseconds, kLatencySamplesPerHost> samples;
+    size_t numSamples;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto it = _latencies.find(host);
+        if (it == _latencies.end()) {
+            return boost::none;
+        }
+        samples = it->second.samples;
+        numSamples = it->second.numSamples;
+    }
+
+    const size_t clampedPercentile = std::min(std::max(percentile, 0), 100);
+    const auto nth = samples.begin() + (numSamples - 1) * clampedPercentile / 100;
+    std::nth_element(samples.begin(), nth, samples.begin() + numSamples);
+    return *nth;
+}
+
+void ReadHedgingStats::noteHedgeableOperation() {
+    _numTotalOperations.addAndFetch(1);
+}
+
+void ReadHedgingStats::noteHedgedOperation() {
+    _numTotalHedgedOperations.addAndFetch(1);
+}
+
+void ReadHedgingStats::noteAdvantageouslyHedgedOperation() {
+    _numAdvantageouslyHedgedOperations.addAndFetch(1);
+}
+
+void ReadHedgingStats::report(BSONObjBuilder* builder) const {
+    builder->append("numTotalOperations", _numTotalOperations.load());
+    builder->append("numTotalHedgedOperations", _numTotalHedgedOperations.load());
+    builder->append("numAdvantageouslyHedgedOperations",
+                    _numAdvantageouslyHedgedOperations.load());
+}
+
+}  // namespace mongo
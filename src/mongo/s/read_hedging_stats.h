@@ -0,0 +1,105 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+#include <boost/optional.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/net/hostandport.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class ServiceContext;
+
+/**
+ * Decoration on ServiceContext which keeps the recent round trip times of the remote commands sent
+ * to each host, from which the AsyncRequestsSender decides how long to wait for a response before
+ * hedging a read, along with counts of how hedging has fared.
+ */
+class ReadHedgingStats {
+    MONGO_DISALLOW_COPYING(ReadHedgingStats);
+
+public:
+    ReadHedgingStats() = default;
+
+    static ReadHedgingStats* get(ServiceContext* serviceContext);
+
+    /**
+     * Records the round trip time of a remote command which was run on 'host'. Only the most recent
+     * kLatencySamplesPerHost samples of each host are kept.
+     */
+    void recordLatency(const HostAndPort& host, Milliseconds latency);
+
+    /**
+     * Returns the given percentile of the recent round trip times to 'host', or boost::none if no
+     * remote command to 'host' has been recorded yet.
+     */
+    boost::optional<Milliseconds> getLatencyPercentile(const HostAndPort& host,
+                                                       int percentile) const;
+
+    /**
+     * Counts a request which was eligible to be hedged, a request for which a hedged request was
+     * sent, and a request whose hedged request responded first, respectively.
+     */
+    void noteHedgeableOperation();
+    void noteHedgedOperation();
+    void noteAdvantageouslyHedgedOperation();
+
+    /**
+     * Appends the hedging counts to 'builder'.
+     */
+    void report(BSONObjBuilder* builder) const;
+
+    static constexpr size_t kLatencySamplesPerHost = 64;
+
+private:
+    /**
+     * A ring buffer of a host's most recent round trip times.
+     */
+    struct HostLatencies {
+        std::array<Milliseconds, kLatencySamplesPerHost> samples;
+        size_t numSamples = 0;
+        size_t nextSample = 0;
+    };
+
+    mutable stdx::mutex _mutex;
+    stdx::unordered_map<HostAndPort, HostLatencies> _latencies;
+
+    AtomicInt64 _numTotalOperations;
+    AtomicInt64 _numTotalHedgedOperations;
+    AtomicInt64 _numAdvantageouslyHedgedOperations;
+};
+
+}  // namespace mongo
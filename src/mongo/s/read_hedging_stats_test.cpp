@@ -0,0 +1,78 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/s/read_hedging_stats.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const HostAndPort kHost("FakeHost1", 12345);
+const HostAndPort kOtherHost("FakeHost2", 12345);
+
+TEST(ReadHedgingStatsTest, NoLatencyForUnknownHost) {
+    ReadHedgingStats stats;
+    stats.recordLatency(kOtherHost, Milliseconds(10));
+    ASSERT_FALSE(stats.getLatencyPercentile(kHost, 95));
+}
+
+TEST(ReadHedgingStatsTest, LatencyPercentiles) {
+    ReadHedgingStats stats;
+    for (int i = 100; i >= 1; --i) {
+        stats.recordLatency(kHost, Milliseconds(i));
+    }
+    stats.recordLatency(kOtherHost, Milliseconds(1000));
+
+    // Only the most recent samples are kept, which are 1 to 64ms.
+    ASSERT_EQ(Milliseconds(1), *stats.getLatencyPercentile(kHost, 0));
+    ASSERT_EQ(Milliseconds(32), *stats.getLatencyPercentile(kHost, 50));
+    ASSERT_EQ(Milliseconds(60), *stats.getLatencyPercentile(kHost, 95));
+    ASSERT_EQ(Milliseconds(64), *stats.getLatencyPercentile(kHost, 100));
+    ASSERT_EQ(Milliseconds(1000), *stats.getLatencyPercentile(kOtherHost, 50));
+}
+
+TEST(ReadHedgingStatsTest, Report) {
+    ReadHedgingStats stats;
+    stats.noteHedgeableOperation();
+    stats.noteHedgeableOperation();
+    stats.noteHedgedOperation();
+    stats.noteAdvantageouslyHedgedOperation();
+
+    BSONObjBuilder builder;
+    stats.report(&builder);
+    ASSERT_BSONOBJ_EQ(BSON("numTotalOperations" << 2LL << "numTotalHedgedOperations" << 1LL
+                                                << "numAdvantageouslyHedgedOperations"
+                                                << 1LL),
+                      builder.obj());
+}
+
+}  // namespace
+}  // namespace mongo
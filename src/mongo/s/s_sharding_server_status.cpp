@@ -34,6 +34,8 @@
 #include "mongo/s/catalog_cache.h"
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/grid.h"
+#include "mongo/s/query/cluster_query_result_cache.h"
+#include "mongo/s/read_hedging_stats.h"
 
 namespace mongo {
 namespace {
@@ -87,5 +89,39 @@ public:
 
 } shardingStatisticsServerStatus;
 
+class HedgingMetricsServerStatus final : public ServerStatusSection {
+public:
+    HedgingMetricsServerStatus() : ServerStatusSection("hedgingMetrics") {}
+
+    bool includeByDefault() const override {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx,
+                            const BSONElement& configElement) const override {
+        BSONObjBuilder result;
+        ReadHedgingStats::get(opCtx->getServiceContext())->report(&result);
+        return result.obj();
+    }
+
+} hedgingMetricsServerStatus;
+
+class ClusterQueryResultCacheServerStatus final : public ServerStatusSection {
+public:
+    ClusterQueryResultCacheServerStatus() : ServerStatusSection("queryResultCache") {}
+
+    bool includeByDefault() const override {
+        return true;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx,
+                            const BSONElement& configElement) const override {
+        BSONObjBuilder result;
+        ClusterQueryResultCache::get(opCtx)->report(&result);
+        return result.obj();
+    }
+
+} clusterQueryResultCacheServerStatus;
+
 }  // namespace
 }  // namespace mongo
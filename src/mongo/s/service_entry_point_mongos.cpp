@@ -170,4 +170,11 @@ DbResponse ServiceEntryPointMongos::handleRequest(OperationContext* opCtx, const
     return dbResponse;
 }
 
+void ServiceEntryPointMongos::preparePipelinedClient(OperationContext* opCtx,
+                                                     Client* connectionClient) {
+    uassertStatusOK(AuthorizationSession::get(opCtx->getClient())
+                        ->inheritAuthenticatedUsers(opCtx,
+                                                    AuthorizationSession::get(connectionClient)));
+}
+
 }  // namespace mongo
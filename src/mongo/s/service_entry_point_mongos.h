@@ -44,6 +44,7 @@ class ServiceEntryPointMongos final : public ServiceEntryPointImpl {
 public:
     using ServiceEntryPointImpl::ServiceEntryPointImpl;
     DbResponse handleRequest(OperationContext* opCtx, const Message& request) override;
+    void preparePipelinedClient(OperationContext* opCtx, Client* connectionClient) override;
 };
 
 }  // namespace mongo
@@ -123,7 +123,7 @@ ShardingTestFixture::ShardingTestFixture() {
 
     auto netForPool = stdx::make_unique<executor::NetworkInterfaceMock>();
     netForPool->setEgressMetadataHook(makeMetadataHookList());
-    auto _mockNetworkForPool = netForPool.get();
+    _mockNetworkForPool = netForPool.get();
     auto execForPool = makeShardingTestExecutor(std::move(netForPool));
     _networkTestEnvForPool =
         stdx::make_unique<NetworkTestEnv>(execForPool.get(), _mockNetworkForPool);
@@ -224,6 +224,12 @@ executor::TaskExecutor* ShardingTestFixture::executor() const {
     return _executor;
 }
 
+executor::NetworkInterfaceMock* ShardingTestFixture::networkForPoolExecutor() const {
+    invariant(_mockNetworkForPool);
+
+    return _mockNetworkForPool;
+}
+
 DistLockManagerMock* ShardingTestFixture::distLock() const {
     invariant(_distLockManager);
 
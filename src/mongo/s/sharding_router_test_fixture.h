@@ -62,6 +62,7 @@ public:
     ShardRegistry* shardRegistry() const;
     RemoteCommandTargeterFactoryMock* targeterFactory() const;
     executor::TaskExecutor* executor() const;
+    executor::NetworkInterfaceMock* networkForPoolExecutor() const;
     DistLockManagerMock* distLock() const;
     RemoteCommandTargeterMock* configTargeter() const;
 
@@ -193,6 +194,7 @@ private:
     executor::TaskExecutor* _executor;
 
     // For the Grid's arbitrary executor in its executorPool.
+    executor::NetworkInterfaceMock* _mockNetworkForPool = nullptr;
     std::unique_ptr<executor::NetworkTestEnv> _networkTestEnvForPool;
 
     DistLockManagerMock* _distLockManager = nullptr;
@@ -32,12 +32,16 @@
 
 #include "mongo/s/write_ops/batch_write_exec.h"
 
+#include <deque>
+
 #include "mongo/base/error_codes.h"
 #include "mongo/base/owned_pointer_map.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/connection_string.h"
 #include "mongo/client/remote_command_targeter.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/executor/task_executor_pool.h"
 #include "mongo/s/async_requests_sender.h"
 #include "mongo/s/client/shard_registry.h"
@@ -45,10 +49,34 @@
 #include "mongo/s/write_ops/batch_write_op.h"
 #include "mongo/s/write_ops/write_error_detail.h"
 #include "mongo/util/log.h"
+#include "mongo/util/transitional_tools_do_not_use/vector_spooling.h"
 
 namespace mongo {
 namespace {
 
+// The number of child batches of an unordered write which may be in flight to the same shard at a
+// time. With a value greater than 1 the writes to each shard are split into batches of at most
+// 'pipelinedWriteBatchMaxOps' operations and sent as soon as the shard has room for them, instead
+// of in rounds which wait on the slowest shard. A value of 1 keeps the round-based execution.
+MONGO_EXPORT_SERVER_PARAMETER(maxInFlightWriteBatchesPerShard, int, 1)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1) {
+            return Status(ErrorCodes::BadValue,
+                          "maxInFlightWriteBatchesPerShard must be greater than or equal to 1");
+        }
+        return Status::OK();
+    });
+
+MONGO_EXPORT_SERVER_PARAMETER(pipelinedWriteBatchMaxOps, int, 1000)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 1 || static_cast<size_t>(newVal) > write_ops::kMaxWriteBatchSize) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << "pipelinedWriteBatchMaxOps must be between 1 and "
+                                        << write_ops::kMaxWriteBatchSize);
+        }
+        return Status::OK();
+    });
+
 const ReadPreferenceSetting kPrimaryOnlyReadPreference(ReadPreference::PrimaryOnly);
 
 //
@@ -79,6 +107,273 @@ void noteStaleResponses(const std::vector<ShardError>& staleErrors, NSTargeter*
 // applies when no writes are occurring and metadata is not changing on reload.
 const int kMaxRoundsWithoutProgress(5);
 
+/**
+ * Builds the command to send a child batch to its shard.
+ */
+BSONObj buildChildBatchRequest(OperationContext* opCtx,
+                               const BatchWriteOp& batchOp,
+                               const TargetedWriteBatch& batch) {
+    const auto shardBatchRequest(batchOp.buildBatchRequest(batch));
+
+    BSONObjBuilder requestBuilder;
+    shardBatchRequest.serialize(&requestBuilder);
+
+    {
+        OperationSessionInfo sessionInfo;
+
+        if (opCtx->getLogicalSessionId()) {
+            sessionInfo.setSessionId(*opCtx->getLogicalSessionId());
+        }
+
+        sessionInfo.setTxnNumber(opCtx->getTxnNumber());
+        sessionInfo.serialize(&requestBuilder);
+    }
+
+    return requestBuilder.obj();
+}
+
+/**
+ * Records the response to a child batch, or the failure to get one, in the batch op.
+ */
+void noteChildBatchResponse(const AsyncRequestsSender::Response& response,
+                            const TargetedWriteBatch& batch,
+                            BatchWriteOp* batchOp,
+                            NSTargeter* targeter,
+                            BatchWriteExecStats* stats) {
+    // First check if we were able to target a shard host.
+    if (!response.shardHostAndPort) {
+        invariant(!response.swResponse.isOK());
+
+        // Record a resolve failure
+        batchOp->noteBatchError(batch, errorFromStatus(response.swResponse.getStatus()));
+
+        // TODO: It may be necessary to refresh the cache if stale, or maybe just cancel and
+        // retarget the batch
+        LOG(4) << "Unable to send write batch to " << batch.getEndpoint().shardName
+               << causedBy(response.swResponse.getStatus());
+        return;
+    }
+
+    const auto& shardHost = *response.shardHostAndPort;
+
+    // Then check if we successfully got a response.
+    Status responseStatus = response.swResponse.getStatus();
+    BatchedCommandResponse batchedCommandResponse;
+    if (responseStatus.isOK()) {
+        std::string errMsg;
+        if (!batchedCommandResponse.parseBSON(response.swResponse.getValue().data, &errMsg) ||
+            !batchedCommandResponse.isValid(&errMsg)) {
+            responseStatus = {ErrorCodes::FailedToParse, errMsg};
+        }
+    }
+
+    if (responseStatus.isOK()) {
+        TrackedErrors trackedErrors;
+        trackedErrors.startTracking(ErrorCodes::StaleShardVersion);
+        trackedErrors.startTracking(ErrorCodes::CannotImplicitlyCreateCollection);
+
+        LOG(4) << "Write results received from " << shardHost.toString() << ": "
+               << redact(batchedCommandResponse.toString());
+
+        // Dispatch was ok, note response
+        batchOp->noteBatchResponse(batch, batchedCommandResponse, &trackedErrors);
+
+        // Note if anything was stale
+        const auto& staleErrors = trackedErrors.getErrors(ErrorCodes::StaleShardVersion);
+        if (!staleErrors.empty()) {
+            noteStaleResponses(staleErrors, targeter);
+            ++stats->numStaleBatches;
+        }
+
+        const auto& cannotImplicitlyCreateErrors =
+            trackedErrors.getErrors(ErrorCodes::CannotImplicitlyCreateCollection);
+        if (!cannotImplicitlyCreateErrors.empty()) {
+            // This forces the chunk manager to reload so we can attach the correct version on
+            // retry and make sure we route to the correct shard.
+            targeter->noteCouldNotTarget();
+        }
+
+        // Remember that we successfully wrote to this shard
+        // NOTE: This will record lastOps for shards where we actually didn't update or delete
+        // any documents, which preserves old behavior but is conservative
+        stats->noteWriteAt(
+            shardHost,
+            batchedCommandResponse.isLastOpSet() ? batchedCommandResponse.getLastOp()
+                                                 : repl::OpTime(),
+            batchedCommandResponse.isElectionIdSet() ? batchedCommandResponse.getElectionId()
+                                                     : OID());
+    } else {
+        // Error occurred dispatching, note it
+        const Status status = responseStatus.withContext(str::stream()
+                                                         << "Write results unavailable from "
+                                                         << shardHost);
+
+        batchOp->noteBatchError(batch, errorFromStatus(status));
+
+        LOG(4) << "Unable to receive write results from " << shardHost
+               << causedBy(redact(status));
+    }
+}
+
+/**
+ * Sends the child batches of one round, at most one per shard at a time, and waits for all of
+ * their responses.
+ */
+void sendChildBatches(OperationContext* opCtx,
+                      const BatchedCommandRequest& clientRequest,
+                      std::map<ShardId, TargetedWriteBatch*>& childBatches,
+                      BatchWriteOp* batchOp,
+                      NSTargeter* targeter,
+                      BatchWriteExecStats* stats) {
+    const size_t numToSend = childBatches.size();
+    size_t numSent = 0;
+
+    while (numSent != numToSend) {
+        // Collect batches out on the network, mapped by endpoint
+        OwnedShardBatchMap ownedPendingBatches;
+        OwnedShardBatchMap::MapType& pendingBatches = ownedPendingBatches.mutableMap();
+
+        //
+        // Construct the requests.
+        //
+
+        std::vector<AsyncRequestsSender::Request> requests;
+
+        // Get as many batches as we can at once
+        for (auto& childBatch : childBatches) {
+            TargetedWriteBatch* const nextBatch = childBatch.second;
+
+            // If the batch is nullptr, we sent it previously, so skip
+            if (!nextBatch)
+                continue;
+
+            // If we already have a batch for this shard, wait until the next time
+            const auto& targetShardId = nextBatch->getEndpoint().shardName;
+
+            if (pendingBatches.count(targetShardId))
+                continue;
+
+            stats->noteTargetedShard(targetShardId);
+
+            const auto request = buildChildBatchRequest(opCtx, *batchOp, *nextBatch);
+
+            LOG(4) << "Sending write batch to " << targetShardId << ": " << redact(request);
+
+            requests.emplace_back(targetShardId, request);
+
+            // Indicate we're done by setting the batch to nullptr. We'll only get duplicate
+            // hostEndpoints if we have broadcast and non-broadcast endpoints for the same host, so
+            // this should be pretty efficient without moving stuff around.
+            childBatch.second = nullptr;
+
+            // Recv-side is responsible for cleaning up the nextBatch when used
+            pendingBatches.emplace(targetShardId, nextBatch);
+        }
+
+        AsyncRequestsSender ars(opCtx,
+                                Grid::get(opCtx)->getExecutorPool()->getArbitraryExecutor(),
+                                clientRequest.getTargetingNS().db().toString(),
+                                requests,
+                                kPrimaryOnlyReadPreference,
+                                opCtx->getTxnNumber() ? Shard::RetryPolicy::kIdempotent
+                                                      : Shard::RetryPolicy::kNoRetry);
+        numSent += pendingBatches.size();
+
+        //
+        // Receive the responses.
+        //
+
+        while (!ars.done()) {
+            // Block until a response is available.
+            auto response = ars.next();
+
+            // Get the TargetedWriteBatch to find where to put the response
+            dassert(pendingBatches.find(response.shardId) != pendingBatches.end());
+            TargetedWriteBatch* batch = pendingBatches.find(response.shardId)->second;
+
+            noteChildBatchResponse(response, *batch, batchOp, targeter, stats);
+        }
+    }
+}
+
+/**
+ * Sends the child batches of one round, keeping up to 'maxInFlightPerShard' of them on the network
+ * for each shard. As soon as a shard responds to a batch, the next batch queued for that shard is
+ * sent, so that no shard waits on the responses of another.
+ */
+void sendChildBatchesPipelined(OperationContext* opCtx,
+                               const BatchedCommandRequest& clientRequest,
+                               std::vector<std::unique_ptr<TargetedWriteBatch>> childBatches,
+                               size_t maxInFlightPerShard,
+                               BatchWriteOp* batchOp,
+                               NSTargeter* targeter,
+                               BatchWriteExecStats* stats) {
+    // The batches which have not been sent yet, in targeting order for each shard
+    std::map<ShardId, std::deque<std::unique_ptr<TargetedWriteBatch>>> queuedBatches;
+    for (auto& childBatch : childBatches) {
+        const auto shardId = childBatch->getEndpoint().shardName;
+        queuedBatches[shardId].push_back(std::move(childBatch));
+    }
+
+    std::map<ShardId, size_t> numInFlight;
+
+    // The batches which have been sent, indexed by the position of their request in the sender
+    std::vector<std::unique_ptr<TargetedWriteBatch>> sentBatches;
+
+    const auto nextRequests = [&] {
+        std::vector<AsyncRequestsSender::Request> requests;
+
+        for (auto& shardQueue : queuedBatches) {
+            const auto& targetShardId = shardQueue.first;
+            auto& shardBatches = shardQueue.second;
+            auto& shardNumInFlight = numInFlight[targetShardId];
+
+            while (!shardBatches.empty() && shardNumInFlight < maxInFlightPerShard) {
+                auto nextBatch = std::move(shardBatches.front());
+                shardBatches.pop_front();
+
+                stats->noteTargetedShard(targetShardId);
+
+                auto request = buildChildBatchRequest(opCtx, *batchOp, *nextBatch);
+
+                LOG(4) << "Sending write batch to " << targetShardId << ": " << redact(request);
+
+                requests.emplace_back(targetShardId, std::move(request));
+                sentBatches.push_back(std::move(nextBatch));
+                ++shardNumInFlight;
+            }
+        }
+
+        return requests;
+    };
+
+    AsyncRequestsSender ars(opCtx,
+                            Grid::get(opCtx)->getExecutorPool()->getArbitraryExecutor(),
+                            clientRequest.getTargetingNS().db().toString(),
+                            nextRequests(),
+                            kPrimaryOnlyReadPreference,
+                            opCtx->getTxnNumber() ? Shard::RetryPolicy::kIdempotent
+                                                  : Shard::RetryPolicy::kNoRetry);
+
+    while (!ars.done()) {
+        // Block until a response is available.
+        auto response = ars.next();
+
+        invariant(response.requestIndex < sentBatches.size());
+        auto batch = std::move(sentBatches[response.requestIndex]);
+        invariant(batch);
+
+        --numInFlight[batch->getEndpoint().shardName];
+
+        noteChildBatchResponse(response, *batch, batchOp, targeter, stats);
+
+        auto requests = nextRequests();
+        if (!requests.empty()) {
+            ars.addRequests(requests);
+        }
+    }
+}
+
 }  // namespace
 
 void BatchWriteExec::executeBatch(OperationContext* opCtx,
@@ -93,6 +388,10 @@ void BatchWriteExec::executeBatch(OperationContext* opCtx,
 
     BatchWriteOp batchOp(opCtx, clientRequest);
 
+    // Ordered writes must be sent one round at a time to preserve their order
+    const bool pipelined = !clientRequest.getWriteCommandBase().getOrdered() &&
+        maxInFlightWriteBatchesPerShard.load() > 1;
+
     // Current batch status
     bool refreshedTargeter = false;
     int rounds = 0;
@@ -127,189 +426,42 @@ void BatchWriteExec::executeBatch(OperationContext* opCtx,
         OwnedPointerMap<ShardId, TargetedWriteBatch> childBatchesOwned;
         std::map<ShardId, TargetedWriteBatch*>& childBatches = childBatchesOwned.mutableMap();
 
+        OwnedPointerVector<TargetedWriteBatch> pipelinedBatchesOwned;
+        std::vector<TargetedWriteBatch*>& pipelinedBatches = pipelinedBatchesOwned.mutableVector();
+
         // If we've already had a targeting error, we've refreshed the metadata once and can
         // record target errors definitively.
         bool recordTargetErrors = refreshedTargeter;
-        Status targetStatus = batchOp.targetBatch(targeter, recordTargetErrors, &childBatches);
+        Status targetStatus = pipelined
+            ? batchOp.targetPipelinedBatches(targeter,
+                                             recordTargetErrors,
+                                             static_cast<size_t>(pipelinedWriteBatchMaxOps.load()),
+                                             &pipelinedBatches)
+            : batchOp.targetBatch(targeter, recordTargetErrors, &childBatches);
         if (!targetStatus.isOK()) {
             // Don't do anything until a targeter refresh
             targeter.noteCouldNotTarget();
             refreshedTargeter = true;
             ++stats->numTargetErrors;
             dassert(childBatches.size() == 0u);
+            dassert(pipelinedBatches.size() == 0u);
         }
 
         //
         // Send all child batches
         //
 
-        const size_t numToSend = childBatches.size();
-        size_t numSent = 0;
-
-        while (numSent != numToSend) {
-            // Collect batches out on the network, mapped by endpoint
-            OwnedShardBatchMap ownedPendingBatches;
-            OwnedShardBatchMap::MapType& pendingBatches = ownedPendingBatches.mutableMap();
-
-            //
-            // Construct the requests.
-            //
-
-            std::vector<AsyncRequestsSender::Request> requests;
-
-            // Get as many batches as we can at once
-            for (auto& childBatch : childBatches) {
-                TargetedWriteBatch* const nextBatch = childBatch.second;
-
-                // If the batch is nullptr, we sent it previously, so skip
-                if (!nextBatch)
-                    continue;
-
-                // If we already have a batch for this shard, wait until the next time
-                const auto& targetShardId = nextBatch->getEndpoint().shardName;
-
-                if (pendingBatches.count(targetShardId))
-                    continue;
-
-                stats->noteTargetedShard(targetShardId);
-
-                const auto request = [&] {
-                    const auto shardBatchRequest(batchOp.buildBatchRequest(*nextBatch));
-
-                    BSONObjBuilder requestBuilder;
-                    shardBatchRequest.serialize(&requestBuilder);
-
-                    {
-                        OperationSessionInfo sessionInfo;
-
-                        if (opCtx->getLogicalSessionId()) {
-                            sessionInfo.setSessionId(*opCtx->getLogicalSessionId());
-                        }
-
-                        sessionInfo.setTxnNumber(opCtx->getTxnNumber());
-                        sessionInfo.serialize(&requestBuilder);
-                    }
-
-                    return requestBuilder.obj();
-                }();
-
-                LOG(4) << "Sending write batch to " << targetShardId << ": " << redact(request);
-
-                requests.emplace_back(targetShardId, request);
-
-                // Indicate we're done by setting the batch to nullptr. We'll only get duplicate
-                // hostEndpoints if we have broadcast and non-broadcast endpoints for the same host,
-                // so this should be pretty efficient without moving stuff around.
-                childBatch.second = nullptr;
-
-                // Recv-side is responsible for cleaning up the nextBatch when used
-                pendingBatches.emplace(targetShardId, nextBatch);
-            }
-
-            AsyncRequestsSender ars(opCtx,
-                                    Grid::get(opCtx)->getExecutorPool()->getArbitraryExecutor(),
-                                    clientRequest.getTargetingNS().db().toString(),
-                                    requests,
-                                    kPrimaryOnlyReadPreference,
-                                    opCtx->getTxnNumber() ? Shard::RetryPolicy::kIdempotent
-                                                          : Shard::RetryPolicy::kNoRetry);
-            numSent += pendingBatches.size();
-
-            //
-            // Receive the responses.
-            //
-
-            while (!ars.done()) {
-                // Block until a response is available.
-                auto response = ars.next();
-
-                // Get the TargetedWriteBatch to find where to put the response
-                dassert(pendingBatches.find(response.shardId) != pendingBatches.end());
-                TargetedWriteBatch* batch = pendingBatches.find(response.shardId)->second;
-
-                // First check if we were able to target a shard host.
-                if (!response.shardHostAndPort) {
-                    invariant(!response.swResponse.isOK());
-
-                    // Record a resolve failure
-                    batchOp.noteBatchError(*batch,
-                                           errorFromStatus(response.swResponse.getStatus()));
-
-                    // TODO: It may be necessary to refresh the cache if stale, or maybe just cancel
-                    // and retarget the batch
-                    LOG(4) << "Unable to send write batch to " << batch->getEndpoint().shardName
-                           << causedBy(response.swResponse.getStatus());
-
-                    // We're done with this batch. Clean up when we can't resolve a host.
-                    auto it = childBatches.find(batch->getEndpoint().shardName);
-                    invariant(it != childBatches.end());
-                    delete it->second;
-                    it->second = nullptr;
-                    continue;
-                }
-
-                const auto shardHost(std::move(*response.shardHostAndPort));
-
-                // Then check if we successfully got a response.
-                Status responseStatus = response.swResponse.getStatus();
-                BatchedCommandResponse batchedCommandResponse;
-                if (responseStatus.isOK()) {
-                    std::string errMsg;
-                    if (!batchedCommandResponse.parseBSON(response.swResponse.getValue().data,
-                                                          &errMsg) ||
-                        !batchedCommandResponse.isValid(&errMsg)) {
-                        responseStatus = {ErrorCodes::FailedToParse, errMsg};
-                    }
-                }
-
-                if (responseStatus.isOK()) {
-                    TrackedErrors trackedErrors;
-                    trackedErrors.startTracking(ErrorCodes::StaleShardVersion);
-                    trackedErrors.startTracking(ErrorCodes::CannotImplicitlyCreateCollection);
-
-                    LOG(4) << "Write results received from " << shardHost.toString() << ": "
-                           << redact(batchedCommandResponse.toString());
-
-                    // Dispatch was ok, note response
-                    batchOp.noteBatchResponse(*batch, batchedCommandResponse, &trackedErrors);
-
-                    // Note if anything was stale
-                    const auto& staleErrors =
-                        trackedErrors.getErrors(ErrorCodes::StaleShardVersion);
-                    if (!staleErrors.empty()) {
-                        noteStaleResponses(staleErrors, &targeter);
-                        ++stats->numStaleBatches;
-                    }
-
-                    const auto& cannotImplicitlyCreateErrors =
-                        trackedErrors.getErrors(ErrorCodes::CannotImplicitlyCreateCollection);
-                    if (!cannotImplicitlyCreateErrors.empty()) {
-                        // This forces the chunk manager to reload so we can attach the correct
-                        // version on retry and make sure we route to the correct shard.
-                        targeter.noteCouldNotTarget();
-                    }
-
-                    // Remember that we successfully wrote to this shard
-                    // NOTE: This will record lastOps for shards where we actually didn't update
-                    // or delete any documents, which preserves old behavior but is conservative
-                    stats->noteWriteAt(shardHost,
-                                       batchedCommandResponse.isLastOpSet()
-                                           ? batchedCommandResponse.getLastOp()
-                                           : repl::OpTime(),
-                                       batchedCommandResponse.isElectionIdSet()
-                                           ? batchedCommandResponse.getElectionId()
-                                           : OID());
-                } else {
-                    // Error occurred dispatching, note it
-                    const Status status = responseStatus.withContext(
-                        str::stream() << "Write results unavailable from " << shardHost);
-
-                    batchOp.noteBatchError(*batch, errorFromStatus(status));
-
-                    LOG(4) << "Unable to receive write results from " << shardHost
-                           << causedBy(redact(status));
-                }
-            }
+        if (pipelined) {
+            sendChildBatchesPipelined(opCtx,
+                                      clientRequest,
+                                      transitional_tools_do_not_use::spool_vector(
+                                          pipelinedBatchesOwned.release()),
+                                      static_cast<size_t>(maxInFlightWriteBatchesPerShard.load()),
+                                      &batchOp,
+                                      &targeter,
+                                      stats);
+        } else {
+            sendChildBatches(opCtx, clientRequest, childBatches, &batchOp, &targeter, stats);
         }
 
         ++rounds;
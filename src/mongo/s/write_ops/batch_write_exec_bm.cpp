@@ -0,0 +1,228 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/client/remote_command_targeter_factory_mock.h"
+#include "mongo/client/remote_command_targeter_mock.h"
+#include "mongo/db/server_parameters_test_util.h"
+#include "mongo/executor/network_interface_mock.h"
+#include "mongo/s/catalog/type_shard.h"
+#include "mongo/s/sharding_router_test_fixture.h"
+#include "mongo/s/write_ops/batch_write_exec.h"
+#include "mongo/s/write_ops/batched_command_request.h"
+#include "mongo/s/write_ops/batched_command_response.h"
+#include "mongo/s/write_ops/mock_ns_targeter.h"
+#include "mongo/stdx/chrono.h"
+#include "mongo/stdx/memory.h"
+
+namespace mongo {
+namespace {
+
+using executor::RemoteCommandResponse;
+
+const NamespaceString kNss("TestDB", "TestColl");
+
+// Every shard answers a child batch after a fixed round trip, which differs from shard to shard,
+// plus the time to apply the batch's writes.
+const Milliseconds kFastestShardLatency(1);
+const Milliseconds kSlowestShardLatency(10);
+const Microseconds kPerWriteLatency(2);
+
+// Half of the documents go to the first shard and the rest are spread evenly over the others, so
+// that the writes to the first shard take more than one batch of the maximum BSON size.
+const int kNumDocs = 40'000;
+const int kDocSizeBytes = 1024;
+
+/**
+ * Runs an unordered insert of kNumDocs documents through BatchWriteExec against a number of mock
+ * shards with different latencies. The responses are given in step with the wall clock, so the
+ * time the benchmark reports includes the time the writes spend waiting on the shards.
+ */
+class BatchWriteExecBenchmark : public ShardingTestFixture {
+public:
+    BatchWriteExecBenchmark(benchmark::State& state, int numShards)
+        : _state(state), _numShards(numShards) {}
+
+private:
+    void setUp() override {
+        ShardingTestFixture::setUp();
+        setRemote(HostAndPort("ClientHost", 12345));
+        configTargeter()->setFindHostReturnValue(HostAndPort("FakeConfigHost", 12345));
+
+        std::vector<ShardType> shards;
+        std::vector<MockRange> ranges;
+        for (int i = 0; i < _numShards; i++) {
+            const ShardId shardId(str::stream() << "shard" << i);
+            const HostAndPort host(str::stream() << "FakeShardHost" << i, 12345);
+
+            auto targeter = stdx::make_unique<RemoteCommandTargeterMock>();
+            targeter->setConnectionStringReturnValue(ConnectionString(host));
+            targeter->setFindHostReturnValue(host);
+            targeterFactory()->addTargeterToReturn(ConnectionString(host), std::move(targeter));
+
+            ShardType shardType;
+            shardType.setName(shardId.toString());
+            shardType.setHost(host.toString());
+            shards.push_back(shardType);
+
+            ranges.emplace_back(ShardEndpoint(shardId, ChunkVersion::IGNORED()),
+                                i == 0 ? BSON("x" << MINKEY) : BSON("x" << _docForShard(i)),
+                                i + 1 == _numShards ? BSON("x" << MAXKEY)
+                                                    : BSON("x" << _docForShard(i + 1)));
+
+            _latencies[host] = kFastestShardLatency +
+                (kSlowestShardLatency - kFastestShardLatency) * i / std::max(_numShards - 1, 1);
+        }
+
+        setupShards(shards);
+        _nsTargeter.init(kNss, std::move(ranges));
+    }
+
+    void _doTest() override {
+        const std::string padding(kDocSizeBytes, 'x');
+
+        std::vector<BSONObj> docs;
+        docs.reserve(kNumDocs);
+        for (int i = 0; i < kNumDocs; i++) {
+            docs.push_back(BSON("x" << i << "padding" << padding));
+        }
+
+        const BatchedCommandRequest request([&] {
+            write_ops::Insert insertOp(kNss);
+            insertOp.setWriteCommandBase([] {
+                write_ops::WriteCommandBase writeCommandBase;
+                writeCommandBase.setOrdered(false);
+                return writeCommandBase;
+            }());
+            insertOp.setDocuments(docs);
+            return insertOp;
+        }());
+
+        for (auto _ : _state) {
+            _runBatch(request);
+        }
+    }
+
+    /**
+     * Returns the first document which the given shard owns.
+     */
+    int _docForShard(int shard) const {
+        if (shard == 0) {
+            return 0;
+        }
+
+        return kNumDocs / 2 + (kNumDocs / 2) * (shard - 1) / std::max(_numShards - 1, 1);
+    }
+
+    void _runBatch(const BatchedCommandRequest& request) {
+        AtomicWord<bool> done{false};
+        auto future = launchAsync([&] {
+            BatchedCommandResponse response;
+            BatchWriteExecStats stats;
+            BatchWriteExec::executeBatch(
+                operationContext(), _nsTargeter, request, &response, &stats);
+            invariant(response.getOk());
+            invariant(response.getN() == kNumDocs);
+            done.store(true);
+        });
+
+        auto net = networkForPoolExecutor();
+        net->enterNetwork();
+
+        const auto wallStart = stdx::chrono::steady_clock::now();
+        const auto virtualStart = net->now();
+
+        while (!done.load()) {
+            while (net->hasReadyRequests()) {
+                auto noi = net->getNextReadyRequest();
+                const auto& remoteRequest = noi->getRequest();
+
+                const auto insertRequest(BatchedCommandRequest::parseInsert(
+                    OpMsgRequest::fromDBAndBody(remoteRequest.dbname, remoteRequest.cmdObj)));
+                const auto numWrites = static_cast<long long>(insertRequest.sizeWriteOps());
+
+                BatchedCommandResponse response;
+                response.setStatus(Status::OK());
+                response.setN(numWrites);
+
+                const auto latency = _latencies[remoteRequest.target] +
+                    duration_cast<Milliseconds>(kPerWriteLatency * numWrites);
+                net->scheduleResponse(noi,
+                                      net->now() + latency,
+                                      RemoteCommandResponse(response.toBSON(), BSONObj(), latency));
+            }
+
+            const Milliseconds wallElapsed(
+                stdx::chrono::duration_cast<stdx::chrono::milliseconds>(
+                    stdx::chrono::steady_clock::now() - wallStart)
+                    .count());
+            if (virtualStart + wallElapsed > net->now()) {
+                net->runUntil(virtualStart + wallElapsed);
+            } else {
+                net->runReadyNetworkOperations();
+            }
+        }
+
+        net->exitNetwork();
+        future.timed_get(kFutureTimeout);
+    }
+
+    benchmark::State& _state;
+    const int _numShards;
+
+    MockNSTargeter _nsTargeter;
+    std::map<HostAndPort, Milliseconds> _latencies;
+};
+
+void BM_UnorderedInsert(benchmark::State& state) {
+    const int numShards = state.range(0);
+    const int maxInFlightPerShard = state.range(1);
+
+    ServerParameterControllerForTest maxInFlight("maxInFlightWriteBatchesPerShard",
+                                                 std::to_string(maxInFlightPerShard));
+
+    BatchWriteExecBenchmark(state, numShards).run();
+
+    state.SetItemsProcessed(state.iterations() * kNumDocs);
+}
+
+BENCHMARK(BM_UnorderedInsert)
+    ->Args({4, 1})
+    ->Args({4, 2})
+    ->Args({4, 4})
+    ->Args({20, 1})
+    ->Args({20, 2})
+    ->Args({20, 4})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mongo
@@ -32,6 +32,7 @@
 #include "mongo/client/remote_command_targeter_mock.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/logical_session_id.h"
+#include "mongo/db/server_parameters_test_util.h"
 #include "mongo/s/catalog/type_shard.h"
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/sharding_router_test_fixture.h"
@@ -271,6 +272,43 @@ TEST_F(BatchWriteExecTest, MultiOpLarge) {
     future.timed_get(kFutureTimeout);
 }
 
+TEST_F(BatchWriteExecTest, MultiOpPipelinedUnordered) {
+    ServerParameterControllerForTest maxInFlight("maxInFlightWriteBatchesPerShard", "2");
+    ServerParameterControllerForTest maxOps("pipelinedWriteBatchMaxOps", "2");
+
+    const std::vector<BSONObj> docsToInsert{
+        BSON("x" << 1), BSON("x" << 2), BSON("x" << 3), BSON("x" << 4), BSON("x" << 5)};
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setWriteCommandBase([] {
+            write_ops::WriteCommandBase writeCommandBase;
+            writeCommandBase.setOrdered(false);
+            return writeCommandBase;
+        }());
+        insertOp.setDocuments(docsToInsert);
+        return insertOp;
+    }());
+    request.setWriteConcern(BSONObj());
+
+    // All the writes are targeted at once and sent in batches of two, at most two at a time
+    auto future = launchAsync([&] {
+        BatchedCommandResponse response;
+        BatchWriteExecStats stats;
+        BatchWriteExec::executeBatch(operationContext(), nsTargeter, request, &response, &stats);
+
+        ASSERT(response.getOk());
+        ASSERT_EQUALS(response.getN(), 5);
+        ASSERT_EQUALS(stats.numRounds, 1);
+    });
+
+    expectInsertsReturnSuccess(docsToInsert.begin(), docsToInsert.begin() + 2);
+    expectInsertsReturnSuccess(docsToInsert.begin() + 2, docsToInsert.begin() + 4);
+    expectInsertsReturnSuccess(docsToInsert.begin() + 4, docsToInsert.end());
+
+    future.timed_get(kFutureTimeout);
+}
+
 TEST_F(BatchWriteExecTest, SingleOpError) {
     BatchedCommandResponse errResponse;
     errResponse.setStatus({ErrorCodes::UnknownError, "mock error"});
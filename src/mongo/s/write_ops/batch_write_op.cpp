@@ -125,6 +125,25 @@ bool isNewBatchRequiredUnordered(const std::vector<TargetedWrite*>& writes,
     return false;
 }
 
+/**
+ * Helper to determine whether a write of the given size can be added to a targeted batch.
+ */
+bool wouldMakeBatchTooBig(const TargetedWriteBatch& batch,
+                          int writeSizeBytes,
+                          size_t maxOpsPerBatch) {
+    if (batch.getNumOps() >= maxOpsPerBatch) {
+        // Too many items in batch
+        return true;
+    }
+
+    if (batch.getEstimatedSizeBytes() + writeSizeBytes > BSONObjMaxUserSize) {
+        // Batch would be too big
+        return true;
+    }
+
+    return false;
+}
+
 /**
  * Helper to determine whether a number of targeted writes require a new targeted batch.
  */
@@ -138,15 +157,7 @@ bool wouldMakeBatchesTooBig(const std::vector<TargetedWrite*>& writes,
             continue;
         }
 
-        const auto& batch = it->second;
-
-        if (batch->getNumOps() >= write_ops::kMaxWriteBatchSize) {
-            // Too many items in batch
-            return true;
-        }
-
-        if (batch->getEstimatedSizeBytes() + writeSizeBytes > BSONObjMaxUserSize) {
-            // Batch would be too big
+        if (wouldMakeBatchTooBig(*it->second, writeSizeBytes, write_ops::kMaxWriteBatchSize)) {
             return true;
         }
     }
@@ -383,6 +394,85 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
     return Status::OK();
 }
 
+Status BatchWriteOp::targetPipelinedBatches(const NSTargeter& targeter,
+                                            bool recordTargetErrors,
+                                            size_t maxOpsPerBatch,
+                                            std::vector<TargetedWriteBatch*>* targetedBatches) {
+    invariant(!_clientRequest.getWriteCommandBase().getOrdered());
+    invariant(maxOpsPerBatch > 0);
+
+    // The batch currently being filled for each endpoint. Batches which cannot take any more
+    // writes are moved to 'fullBatches' and a new batch is started for their endpoint.
+    TargetedBatchMap batchMap;
+    std::vector<TargetedWriteBatch*> fullBatches;
+
+    for (auto& writeOp : _writeOps) {
+        // Only target _Ready ops
+        if (writeOp.getWriteState() != WriteOpState_Ready)
+            continue;
+
+        OwnedPointerVector<TargetedWrite> writesOwned;
+        vector<TargetedWrite*>& writes = writesOwned.mutableVector();
+
+        Status targetStatus = writeOp.targetWrites(_opCtx, targeter, &writes);
+
+        if (!targetStatus.isOK()) {
+            WriteErrorDetail targetError;
+            buildTargetError(targetStatus, &targetError);
+
+            if (!recordTargetErrors) {
+                // Cancel current batch state with an error
+                for (auto batch : fullBatches) {
+                    _cancelBatches(targetError, TargetedBatchMap{{&batch->getEndpoint(), batch}});
+                }
+                _cancelBatches(targetError, std::move(batchMap));
+                return targetStatus;
+            }
+
+            writeOp.setOpError(targetError);
+            continue;
+        }
+
+        // Account the array overhead once for the actual updates array and once for the statement
+        // ids array, if retryable writes are used
+        const int writeSizeBytes = getWriteSizeBytes(writeOp) + kBSONArrayPerElementOverheadBytes +
+            (_batchTxnNum ? kBSONArrayPerElementOverheadBytes + 4 : 0);
+
+        for (const auto write : writes) {
+            TargetedBatchMap::iterator batchIt = batchMap.find(&write->endpoint);
+            if (batchIt != batchMap.end() &&
+                wouldMakeBatchTooBig(*batchIt->second, writeSizeBytes, maxOpsPerBatch)) {
+                fullBatches.push_back(batchIt->second);
+                batchMap.erase(batchIt);
+                batchIt = batchMap.end();
+            }
+
+            if (batchIt == batchMap.end()) {
+                TargetedWriteBatch* newBatch = new TargetedWriteBatch(write->endpoint);
+                batchIt = batchMap.emplace(&newBatch->getEndpoint(), newBatch).first;
+            }
+
+            batchIt->second->addWrite(write, writeSizeBytes);
+        }
+
+        // Relinquish ownership of TargetedWrites, now the TargetedBatches own them
+        writesOwned.mutableVector().clear();
+    }
+
+    for (const auto& entry : batchMap) {
+        fullBatches.push_back(entry.second);
+    }
+
+    // Send back our targeted batches, in the order in which they were filled
+    for (auto batch : fullBatches) {
+        // Remember targeted batch for reporting
+        _targeted.insert(batch);
+        targetedBatches->push_back(batch);
+    }
+
+    return Status::OK();
+}
+
 BatchedCommandRequest BatchWriteOp::buildBatchRequest(
     const TargetedWriteBatch& targetedBatch) const {
     const auto batchType = _clientRequest.getBatchType();
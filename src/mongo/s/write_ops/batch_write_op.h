@@ -141,6 +141,20 @@ public:
                        bool recordTargetErrors,
                        std::map<ShardId, TargetedWriteBatch*>* targetedBatches);
 
+    /**
+     * Targets all of the remaining write ops of an unordered batch op for pipelined execution.
+     * Unlike targetBatch, a shard endpoint may receive more than one TargetedWriteBatch, each of
+     * which holds at most 'maxOpsPerBatch' write ops, so that the caller can keep several batches
+     * to the same shard in flight and the writes to one shard do not have to wait on another.
+     *
+     * Targeting errors are handled as in targetBatch. Returned TargetedWriteBatches are owned by
+     * the caller.
+     */
+    Status targetPipelinedBatches(const NSTargeter& targeter,
+                                  bool recordTargetErrors,
+                                  size_t maxOpsPerBatch,
+                                  std::vector<TargetedWriteBatch*>* targetedBatches);
+
     /**
      * Fills a BatchCommandRequest from a TargetedWriteBatch for this BatchWriteOp.
      */
@@ -29,6 +29,7 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/base/owned_pointer_map.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/s/write_ops/batch_write_op.h"
 #include "mongo/s/write_ops/batched_command_request.h"
@@ -519,6 +520,56 @@ TEST_F(BatchWriteOpTest, MultiOpTwoShardsUnordered) {
     ASSERT_EQUALS(clientResponse.getN(), 2);
 }
 
+// Multi-op (unordered) pipelined targeting test where the writes to one shard do not fit in one
+// batch. All writes should be targeted at once, into as many batches per shard as needed.
+TEST_F(BatchWriteOpTest, MultiOpTwoShardsPipelinedUnordered) {
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpointA(ShardId("shardA"), ChunkVersion::IGNORED());
+    ShardEndpoint endpointB(ShardId("shardB"), ChunkVersion::IGNORED());
+    MockNSTargeter targeter;
+    initTargeterSplitRange(nss, endpointA, endpointB, &targeter);
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setWriteCommandBase([] {
+            write_ops::WriteCommandBase wcb;
+            wcb.setOrdered(false);
+            return wcb;
+        }());
+        insertOp.setDocuments(
+            {BSON("x" << -1), BSON("x" << 1), BSON("x" << -2), BSON("x" << 2), BSON("x" << -3)});
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerVector<TargetedWriteBatch> targetedOwned;
+    std::vector<TargetedWriteBatch*>& targeted = targetedOwned.mutableVector();
+    ASSERT_OK(batchOp.targetPipelinedBatches(targeter, false, 2, &targeted));
+    ASSERT_EQUALS(targeted.size(), 3u);
+    ASSERT_EQUALS(targeted[0]->getEndpoint().shardName, endpointA.shardName);
+    ASSERT_EQUALS(targeted[0]->getWrites().size(), 2u);
+    ASSERT_EQUALS(targeted[1]->getEndpoint().shardName, endpointA.shardName);
+    ASSERT_EQUALS(targeted[1]->getWrites().size(), 1u);
+    ASSERT_EQUALS(targeted[2]->getEndpoint().shardName, endpointB.shardName);
+    ASSERT_EQUALS(targeted[2]->getWrites().size(), 2u);
+
+    // Respond to the targeted batches out of order
+    for (auto it = targeted.rbegin(); it != targeted.rend(); ++it) {
+        ASSERT(!batchOp.isFinished());
+
+        BatchedCommandResponse response;
+        buildResponse((*it)->getWrites().size(), &response);
+        batchOp.noteBatchResponse(**it, response, NULL);
+    }
+    ASSERT(batchOp.isFinished());
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), 5);
+}
+
 // Multi-op (ordered) targeting test where each op goes to both shards. There should be two sets of
 // two batches to each shard (two for each delete op).
 TEST_F(BatchWriteOpTest, MultiOpTwoShardsEachOrdered) {
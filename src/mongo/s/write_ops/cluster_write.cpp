@@ -44,10 +44,12 @@
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/config_server_client.h"
 #include "mongo/s/grid.h"
+#include "mongo/s/query/cluster_query_result_cache.h"
 #include "mongo/s/shard_util.h"
 #include "mongo/s/write_ops/chunk_manager_targeter.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -185,6 +187,11 @@ void ClusterWriter::write(OperationContext* opCtx,
     if (nss.db() == NamespaceString::kAdminDb) {
         Grid::get(opCtx)->catalogClient()->writeConfigServerDirect(opCtx, request, response);
     } else {
+        // Query results cached for the collection must not outlive the write, even if it fails.
+        ON_BLOCK_EXIT([&] {
+            ClusterQueryResultCache::get(opCtx)->invalidate(request.getTargetingNS());
+        });
+
         TargeterStats targeterStats;
 
         {
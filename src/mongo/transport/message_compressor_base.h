@@ -32,6 +32,7 @@
 #include "mongo/base/status_with.h"
 #include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/duration.h"
 
 #include <type_traits>
 
@@ -40,6 +41,7 @@ enum class MessageCompressor : uint8_t {
     kNoop = 0,
     kSnappy = 1,
     kZlib = 2,
+    kZstd = 3,
     kExtended = 255,
 };
 
@@ -114,6 +116,68 @@ public:
         return _decompressBytesOut.loadRelaxed();
     }
 
+    /*
+     * This returns the time spent in compressData
+     */
+    Microseconds getCompressorTime() const {
+        return Microseconds(_compressMicros.loadRelaxed());
+    }
+
+    /*
+     * This returns the time spent in decompressData
+     */
+    Microseconds getDecompressorTime() const {
+        return Microseconds(_decompressMicros.loadRelaxed());
+    }
+
+    /*
+     * This returns the number of messages, and the bytes in them, which were sent uncompressed
+     * instead of with this compressor because they were too small or would not compress well
+     */
+    int64_t getSkippedMessages() const {
+        return _skippedMessages.loadRelaxed();
+    }
+
+    int64_t getSkippedBytes() const {
+        return _skippedBytes.loadRelaxed();
+    }
+
+    /*
+     * This returns the number of bytes saved on the wire by the messages sent compressed
+     */
+    int64_t getBytesSaved() const {
+        return _bytesSaved.loadRelaxed();
+    }
+
+    /*
+     * Called by the MessageCompressorManager to account for the time it spent compressing and
+     * decompressing with this compressor
+     */
+    void counterHitCompressTime(Microseconds elapsed) {
+        _compressMicros.addAndFetch(durationCount<Microseconds>(elapsed));
+    }
+
+    void counterHitDecompressTime(Microseconds elapsed) {
+        _decompressMicros.addAndFetch(durationCount<Microseconds>(elapsed));
+    }
+
+    /*
+     * Called by the MessageCompressorManager when it sends a message uncompressed instead of with
+     * this compressor
+     */
+    void counterHitSkip(int64_t bytes) {
+        _skippedMessages.addAndFetch(1);
+        _skippedBytes.addAndFetch(bytes);
+    }
+
+    /*
+     * Called by the MessageCompressorManager with the number of bytes which this compressor saved
+     * on a message that it sent compressed
+     */
+    void counterHitSavings(int64_t bytesSaved) {
+        _bytesSaved.addAndFetch(bytesSaved);
+    }
+
 
 protected:
     /*
@@ -148,5 +212,12 @@ private:
 
     AtomicInt64 _decompressBytesIn;
     AtomicInt64 _decompressBytesOut;
+
+    AtomicInt64 _compressMicros;
+    AtomicInt64 _decompressMicros;
+
+    AtomicInt64 _skippedMessages;
+    AtomicInt64 _skippedBytes;
+    AtomicInt64 _bytesSaved;
 };
 }  // namespace mongo
@@ -0,0 +1,231 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/base/init.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/timestamp.h"
+#include "mongo/config.h"
+#include "mongo/platform/random.h"
+#include "mongo/rpc/message.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/transport/message_compressor_snappy.h"
+#include "mongo/transport/message_compressor_zlib.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/uuid.h"
+
+#ifdef MONGO_CONFIG_HAVE_ZSTD
+#include "mongo/transport/message_compressor_zstd.h"
+#endif
+
+namespace mongo {
+namespace {
+
+const auto kOrdersNs = "app.orders"_sd;
+
+const std::vector<std::string> kWords{
+    "pending",  "shipped", "delivered", "returned", "express", "standard", "warehouse",
+    "customer", "invoice", "discount",  "gift",     "priority", "europe",   "america",
+    "asia",     "mobile",  "desktop",   "coupon",   "refund",  "backorder"};
+
+std::string makeSentence(PseudoRandom& random, int numWords) {
+    std::string sentence;
+    for (int i = 0; i < numWords; ++i) {
+        if (i > 0) {
+            sentence += ' ';
+        }
+        sentence += kWords[random.nextInt32(kWords.size())];
+    }
+    return sentence;
+}
+
+/**
+ * Builds an order document of the kind an application would insert, with a mix of repetitive
+ * field names, low cardinality strings, random identifiers and numbers.
+ */
+BSONObj makeOrder(PseudoRandom& random, int id) {
+    BSONObjBuilder builder;
+    builder.append("_id", OID::gen());
+    builder.append("orderNumber", id);
+    builder.append("customerId", random.nextInt64(1'000'000));
+    builder.append("status", kWords[random.nextInt32(4)]);
+    builder.appendDate("createdAt", Date_t::fromMillisSinceEpoch(1'500'000'000'000 + id * 1000));
+
+    BSONArrayBuilder items(builder.subarrayStart("items"));
+    const int numItems = 1 + random.nextInt32(5);
+    for (int i = 0; i < numItems; ++i) {
+        const auto sku = "SKU-" + std::to_string(random.nextInt32(10000));
+        const auto qty = 1 + random.nextInt32(10);
+        const auto price = random.nextInt32(100000) / 100.0;
+        items.append(BSON("sku" << sku << "qty" << qty << "price" << price));
+    }
+    items.doneFast();
+
+    const auto street = makeSentence(random, 3);
+    const auto& city = kWords[random.nextInt32(kWords.size())];
+    const auto zip = std::to_string(10000 + random.nextInt32(89999));
+    builder.append("shippingAddress", BSON("street" << street << "city" << city << "zip" << zip));
+    builder.append("note", makeSentence(random, 8));
+    return builder.obj();
+}
+
+/**
+ * A getMore reply from a sync source carrying a batch of insert oplog entries.
+ */
+Message makeOplogBatch() {
+    PseudoRandom random(1);
+    const auto uuid = UUID::gen();
+
+    OpMsgBuilder builder;
+    auto body = builder.beginBody();
+    {
+        BSONObjBuilder cursor(body.subobjStart("cursor"));
+        BSONArrayBuilder batch(cursor.subarrayStart("nextBatch"));
+        for (int i = 0; i < 500; ++i) {
+            BSONObjBuilder entry(batch.subobjStart());
+            entry.append("ts", Timestamp(1'500'000'000 + i / 10, i % 10));
+            entry.append("t", 1LL);
+            entry.append("h", random.nextInt64());
+            entry.append("v", 2);
+            entry.append("op", "i");
+            entry.append("ns", kOrdersNs);
+            uuid.appendToBuilder(&entry, "ui");
+            entry.appendDate("wall", Date_t::fromMillisSinceEpoch(1'500'000'000'000 + i));
+            entry.append("o", makeOrder(random, i));
+        }
+        batch.doneFast();
+        cursor.append("id", 12345678LL);
+        cursor.append("ns", "local.oplog.rs");
+    }
+    body.append("ok", 1.0);
+    body.doneFast();
+    return builder.finish();
+}
+
+/**
+ * A reply to a find which returns a first batch of 101 documents.
+ */
+Message makeFindReply() {
+    PseudoRandom random(2);
+
+    OpMsgBuilder builder;
+    auto body = builder.beginBody();
+    {
+        BSONObjBuilder cursor(body.subobjStart("cursor"));
+        BSONArrayBuilder batch(cursor.subarrayStart("firstBatch"));
+        for (int i = 0; i < 101; ++i) {
+            batch.append(makeOrder(random, i));
+        }
+        batch.doneFast();
+        cursor.append("id", 87654321LL);
+        cursor.append("ns", kOrdersNs);
+    }
+    body.append("ok", 1.0);
+    body.doneFast();
+    return builder.finish();
+}
+
+/**
+ * Compresses the part of the message after its header, which is what MessageCompressorManager
+ * hands to the compressor, and reports the compression ratio along with the throughput.
+ */
+template <typename Compressor>
+void BM_Compress(benchmark::State& state, Message (*makeMessage)()) {
+    Compressor compressor;
+    const auto message = makeMessage();
+    const ConstDataRange input(message.singleData().data(), message.singleData().dataLen());
+
+    std::vector<char> output(compressor.getMaxCompressedSize(input.length()));
+    size_t compressedSize = 0;
+    for (auto _ : state) {
+        compressedSize = uassertStatusOK(
+            compressor.compressData(input, DataRange(output.data(), output.size())));
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * input.length());
+    state.counters["ratio"] = double(input.length()) / compressedSize;
+}
+
+template <typename Compressor>
+void BM_Decompress(benchmark::State& state, Message (*makeMessage)()) {
+    Compressor compressor;
+    const auto message = makeMessage();
+    const ConstDataRange input(message.singleData().data(), message.singleData().dataLen());
+
+    std::vector<char> compressed(compressor.getMaxCompressedSize(input.length()));
+    const auto compressedSize = uassertStatusOK(
+        compressor.compressData(input, DataRange(compressed.data(), compressed.size())));
+
+    std::vector<char> output(input.length());
+    for (auto _ : state) {
+        uassertStatusOK(compressor.decompressData(ConstDataRange(compressed.data(), compressedSize),
+                                                  DataRange(output.data(), output.size())));
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * input.length());
+    state.counters["ratio"] = double(input.length()) / compressedSize;
+}
+
+template <typename Compressor>
+void registerBenchmarks(const std::string& codec) {
+    const std::vector<std::pair<std::string, Message (*)()>> workloads{
+        {"OplogBatch", makeOplogBatch}, {"FindReply", makeFindReply}};
+
+    for (const auto& workload : workloads) {
+        benchmark::RegisterBenchmark(
+            ("BM_Compress/" + codec + "/" + workload.first).c_str(),
+            [](benchmark::State& state, Message (*makeMessage)()) {
+                BM_Compress<Compressor>(state, makeMessage);
+            },
+            workload.second);
+        benchmark::RegisterBenchmark(
+            ("BM_Decompress/" + codec + "/" + workload.first).c_str(),
+            [](benchmark::State& state, Message (*makeMessage)()) {
+                BM_Decompress<Compressor>(state, makeMessage);
+            },
+            workload.second);
+    }
+}
+
+MONGO_INITIALIZER(RegisterMessageCompressorBenchmarks)(InitializerContext* context) {
+    registerBenchmarks<SnappyMessageCompressor>("snappy");
+    registerBenchmarks<ZlibMessageCompressor>("zlib");
+#ifdef MONGO_CONFIG_HAVE_ZSTD
+    registerBenchmarks<ZstdMessageCompressor>("zstd");
+#endif
+    return Status::OK();
+}
+
+}  // namespace
+}  // namespace mongo
@@ -36,14 +36,54 @@
 #include "mongo/base/data_type_endian.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/rpc/message.h"
 #include "mongo/transport/message_compressor_registry.h"
 #include "mongo/transport/session.h"
 #include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 namespace {
 
+// Messages whose body is smaller than this many bytes are sent uncompressed. Zero compresses
+// every message.
+MONGO_EXPORT_SERVER_PARAMETER(networkMessageCompressionMinSizeBytes, int, 512)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0) {
+            return Status(ErrorCodes::BadValue,
+                          "networkMessageCompressionMinSizeBytes must be greater than or equal "
+                          "to 0");
+        }
+        return Status::OK();
+    });
+
+// A compressed message which is not at least this many percent smaller than the original is
+// replaced with the original, and the connection backs off from compressing for a while. Zero
+// keeps every compressed message.
+MONGO_EXPORT_SERVER_PARAMETER(networkMessageCompressionMinSavingsPercent, int, 5)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 100) {
+            return Status(ErrorCodes::BadValue,
+                          "networkMessageCompressionMinSavingsPercent must be between 0 and 100");
+        }
+        return Status::OK();
+    });
+
+// Messages at least this large have a sample from their middle compressed first, so that a large
+// incompressible payload is detected without compressing all of it.
+const int kSampleThresholdBytes = 64 * 1024;
+const int kSampleSizeBytes = 4 * 1024;
+
+// Upper bound on the number of messages a connection sends uncompressed after compression failed
+// to pay off.
+const int kMaxSkipCompressionBackoff = 64;
+
+bool savesEnough(size_t originalSize, size_t compressedSize) {
+    const auto minSavingsPercent = networkMessageCompressionMinSavingsPercent.load();
+    return compressedSize * 100 <= originalSize * (100 - minSavingsPercent);
+}
+
 // TODO(JBR): This should be changed so it 's closer to the MSGHEADER View/ConstView classes
 // than this little struct.
 struct CompressionHeader {
@@ -102,6 +142,12 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
         return {msg};
     }
 
+    if (!_shouldCompress(compressor, msg)) {
+        LOG(3) << "Sending message uncompressed instead of with " << compressor->getName();
+        compressor->counterHitSkip(msg.size());
+        return {msg};
+    }
+
     LOG(3) << "Compressing message with " << compressor->getName();
 
     auto inputHeader = msg.header();
@@ -129,12 +175,29 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
     compressionHeader.serialize(&output);
     ConstDataRange input(inputHeader.data(), inputHeader.data() + inputHeader.dataLen());
 
+    Timer timer;
     auto sws = compressor->compressData(input, output);
+    compressor->counterHitCompressTime(timer.elapsed());
 
     if (!sws.isOK())
         return sws.getStatus();
 
     auto realCompressedSize = sws.getValue();
+    if (!_isAdaptive(compressor)) {
+        // Always send what the compressor produced.
+    } else if (!savesEnough(msg.dataSize(), realCompressedSize + CompressionHeader::size())) {
+        LOG(3) << "Compressing message with " << compressor->getName()
+               << " did not save enough space, returning original uncompressed message";
+        _backOff();
+        compressor->counterHitSkip(msg.size());
+        return {msg};
+    } else {
+        _skipCompressionBackoff = 1;
+    }
+
+    compressor->counterHitSavings(static_cast<int64_t>(msg.dataSize()) -
+                                  static_cast<int64_t>(realCompressedSize) -
+                                  static_cast<int64_t>(CompressionHeader::size()));
     outMessage.setLen(realCompressedSize + CompressionHeader::size() + MsgData::MsgDataHeaderSize);
 
     return {Message(outputMessageBuffer)};
@@ -176,7 +239,9 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
 
     DataRangeCursor output(outMessage.data(), outMessage.data() + outMessage.dataLen());
 
+    Timer timer;
     auto sws = compressor->decompressData(input, output);
+    compressor->counterHitDecompressTime(timer.elapsed());
 
     if (!sws.isOK())
         return sws.getStatus();
@@ -293,6 +358,58 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
     }
 }
 
+bool MessageCompressorManager::_isAdaptive(MessageCompressorBase* compressor) const {
+    // The noop compressor exists to exercise the compression path, so it compresses everything.
+    return compressor->getId() != static_cast<MessageCompressorId>(MessageCompressor::kNoop);
+}
+
+bool MessageCompressorManager::_shouldCompress(MessageCompressorBase* compressor,
+                                               const Message& msg) {
+    if (!_isAdaptive(compressor)) {
+        return true;
+    }
+
+    if (msg.dataSize() < networkMessageCompressionMinSizeBytes.load()) {
+        return false;
+    }
+
+    if (_skipCompressionCount > 0) {
+        _skipCompressionCount--;
+        return false;
+    }
+
+    if (msg.dataSize() < kSampleThresholdBytes ||
+        networkMessageCompressionMinSavingsPercent.load() == 0) {
+        return true;
+    }
+
+    // Compress a slice from the middle of the message, which skips over the command name and
+    // other short fields at the start, and back off if even that doesn't compress.
+    const char* sampleStart = msg.buf() + MsgData::MsgDataHeaderSize + msg.dataSize() / 2;
+    ConstDataRange sample(sampleStart, sampleStart + kSampleSizeBytes);
+
+    auto scratchSize = compressor->getMaxCompressedSize(kSampleSizeBytes);
+    auto scratch = SharedBuffer::allocate(scratchSize);
+    DataRange output(scratch.get(), scratch.get() + scratchSize);
+
+    Timer timer;
+    auto sws = compressor->compressData(sample, output);
+    compressor->counterHitCompressTime(timer.elapsed());
+
+    if (!sws.isOK() || savesEnough(kSampleSizeBytes, sws.getValue())) {
+        return true;
+    }
+
+    LOG(3) << "Sample of message did not compress with " << compressor->getName();
+    _backOff();
+    return false;
+}
+
+void MessageCompressorManager::_backOff() {
+    _skipCompressionCount = _skipCompressionBackoff;
+    _skipCompressionBackoff = std::min(_skipCompressionBackoff * 2, kMaxSkipCompressionBackoff);
+}
+
 MessageCompressorManager& MessageCompressorManager::forSession(
     const transport::SessionHandle& session) {
     return getForSession(session.get());
@@ -98,6 +98,9 @@ public:
      * If _negotiated is empty (meaning compression was not negotiated or is not supported), then
      * it will return a ref-count bumped copy of the input message.
      *
+     * If the message is too small to be worth compressing, or it or recent messages on this
+     * connection did not compress well, then it will also return the input message.
+     *
      * If an error occurs in the compressor, it will return a Status error.
      */
     StatusWith<Message> compressMessage(const Message& msg,
@@ -126,8 +129,29 @@ public:
     static MessageCompressorManager& forSession(const transport::SessionHandle& session);
 
 private:
+    /*
+     * Returns whether the adaptive compression policy applies to messages sent with 'compressor'.
+     */
+    bool _isAdaptive(MessageCompressorBase* compressor) const;
+
+    /*
+     * Returns false if 'msg' should be sent uncompressed, either because it is too small to be
+     * worth compressing, because compression recently failed to pay off on this connection, or
+     * because a sample of it does not compress.
+     */
+    bool _shouldCompress(MessageCompressorBase* compressor, const Message& msg);
+
+    /*
+     * Sends the next few messages uncompressed after one failed to compress well. The number of
+     * skipped messages doubles each time compression fails again, and resets once it succeeds.
+     */
+    void _backOff();
+
     std::vector<MessageCompressorBase*> _negotiated;
     MessageCompressorRegistry* _registry;
+
+    int _skipCompressionCount = 0;
+    int _skipCompressionBackoff = 1;
 };
 
 }  // namespace mongo
@@ -31,6 +31,9 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/config.h"
+#include "mongo/db/server_parameters_test_util.h"
+#include "mongo/platform/random.h"
 #include "mongo/rpc/message.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/transport/message_compressor_manager.h"
@@ -41,6 +44,10 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
 
+#ifdef MONGO_CONFIG_HAVE_ZSTD
+#include "mongo/transport/message_compressor_zstd.h"
+#endif
+
 #include <string>
 #include <vector>
 
@@ -52,6 +59,13 @@ const auto assertOk = [](auto&& sw) {
     return sw.getValue();
 };
 
+// Makes the compressor managers compress every message, however small or incompressible, while
+// it is in scope.
+struct AdaptiveCompressionDisabled {
+    ServerParameterControllerForTest minSize{"networkMessageCompressionMinSizeBytes", "0"};
+    ServerParameterControllerForTest minSavings{"networkMessageCompressionMinSavingsPercent", "0"};
+};
+
 MessageCompressorRegistry buildRegistry() {
     MessageCompressorRegistry ret;
     auto compressor = stdx::make_unique<NoopMessageCompressor>();
@@ -94,6 +108,8 @@ void checkServerNegotiation(const BSONObj& input, const std::vector<std::string>
 }
 
 void checkFidelity(const Message& msg, std::unique_ptr<MessageCompressorBase> compressor) {
+    AdaptiveCompressionDisabled adaptiveCompressionDisabled;
+
     MessageCompressorRegistry registry;
     const auto originalView = msg.singleData();
     const auto compressorName = compressor->getName();
@@ -166,8 +182,7 @@ void checkOverflow(std::unique_ptr<MessageCompressorBase> compressor) {
         compressor->decompressData(tooSmallRange, DataRange(scratch.data(), scratch.size())));
 }
 
-Message buildMessage() {
-    const auto data = std::string{"Hello, world!"};
+Message buildMessage(const std::string& data = "Hello, world!") {
     const auto bufferSize = MsgData::MsgDataHeaderSize + data.size();
     auto buf = SharedBuffer::allocate(bufferSize);
     MsgData::View testView(buf.get());
@@ -241,10 +256,22 @@ TEST(ZlibMessageCompressor, Overflow) {
     checkOverflow(stdx::make_unique<ZlibMessageCompressor>());
 }
 
+#ifdef MONGO_CONFIG_HAVE_ZSTD
+TEST(ZstdMessageCompressor, Fidelity) {
+    auto testMessage = buildMessage();
+    checkFidelity(testMessage, stdx::make_unique<ZstdMessageCompressor>());
+}
+
+TEST(ZstdMessageCompressor, Overflow) {
+    checkOverflow(stdx::make_unique<ZstdMessageCompressor>());
+}
+#endif
+
 TEST(MessageCompressorManager, SERVER_28008) {
 
     // Create a client and server that will negotiate the same compressors,
     // but with a different ordering for the preferred compressor.
+    AdaptiveCompressionDisabled adaptiveCompressionDisabled;
 
     std::unique_ptr<MessageCompressorBase> zlibCompressor =
         stdx::make_unique<ZlibMessageCompressor>();
@@ -294,6 +321,89 @@ TEST(MessageCompressorManager, SERVER_28008) {
     ASSERT_EQ(compressorId, zlibId);
 }
 
+std::string buildRandomData(size_t size) {
+    PseudoRandom random(1);
+    std::string data(size, '\0');
+    for (auto& c : data) {
+        c = static_cast<char>(random.nextInt32());
+    }
+    return data;
+}
+
+MessageCompressorManager negotiateSnappy(MessageCompressorRegistry* registry) {
+    auto compressor = stdx::make_unique<SnappyMessageCompressor>();
+    registry->setSupportedCompressors({compressor->getName()});
+    registry->registerImplementation(std::move(compressor));
+    ASSERT_OK(registry->finalizeSupportedCompressors());
+
+    MessageCompressorManager manager(registry);
+    BSONObjBuilder negotiatorOut;
+    manager.serverNegotiate(BSON("isMaster" << 1 << "compression" << BSON_ARRAY("snappy")),
+                            &negotiatorOut);
+    return manager;
+}
+
+TEST(MessageCompressorManager, SmallMessageSentUncompressed) {
+    MessageCompressorRegistry registry;
+    auto manager = negotiateSnappy(&registry);
+    auto compressor = registry.getCompressor("snappy");
+
+    auto msg = assertOk(manager.compressMessage(buildMessage()));
+    ASSERT_EQ(msg.operation(), dbQuery);
+    ASSERT_EQ(compressor->getSkippedMessages(), 1);
+    ASSERT_EQ(compressor->getSkippedBytes(), msg.size());
+    ASSERT_EQ(compressor->getCompressorBytesIn(), 0);
+
+    msg = assertOk(manager.compressMessage(buildMessage(std::string(1024, 'x'))));
+    ASSERT_EQ(msg.operation(), dbCompressed);
+    ASSERT_EQ(compressor->getSkippedMessages(), 1);
+    ASSERT_GT(compressor->getBytesSaved(), 0);
+}
+
+TEST(MessageCompressorManager, IncompressibleMessagesBackOff) {
+    MessageCompressorRegistry registry;
+    auto manager = negotiateSnappy(&registry);
+    auto compressor = registry.getCompressor("snappy");
+
+    const auto incompressible = buildMessage(buildRandomData(1024));
+    const auto compressible = buildMessage(std::string(1024, 'x'));
+
+    // The first incompressible message is compressed, sent uncompressed, and makes the manager
+    // skip the next message.
+    ASSERT_EQ(assertOk(manager.compressMessage(incompressible)).operation(), dbQuery);
+    auto bytesIn = compressor->getCompressorBytesIn();
+    ASSERT_GT(bytesIn, 0);
+    ASSERT_EQ(assertOk(manager.compressMessage(incompressible)).operation(), dbQuery);
+    ASSERT_EQ(compressor->getCompressorBytesIn(), bytesIn);
+
+    // Failing again doubles the number of messages skipped, compressible or not.
+    ASSERT_EQ(assertOk(manager.compressMessage(incompressible)).operation(), dbQuery);
+    ASSERT_EQ(assertOk(manager.compressMessage(compressible)).operation(), dbQuery);
+    ASSERT_EQ(assertOk(manager.compressMessage(compressible)).operation(), dbQuery);
+    ASSERT_EQ(assertOk(manager.compressMessage(compressible)).operation(), dbCompressed);
+    ASSERT_EQ(compressor->getSkippedMessages(), 5);
+
+    // A message which compresses well resets the back off.
+    ASSERT_EQ(assertOk(manager.compressMessage(incompressible)).operation(), dbQuery);
+    ASSERT_EQ(assertOk(manager.compressMessage(compressible)).operation(), dbQuery);
+    ASSERT_EQ(assertOk(manager.compressMessage(compressible)).operation(), dbCompressed);
+}
+
+TEST(MessageCompressorManager, LargeIncompressibleMessageDetectedBySampling) {
+    MessageCompressorRegistry registry;
+    auto manager = negotiateSnappy(&registry);
+    auto compressor = registry.getCompressor("snappy");
+
+    const auto data = buildRandomData(1024 * 1024);
+    auto msg = assertOk(manager.compressMessage(buildMessage(data)));
+    ASSERT_EQ(msg.operation(), dbQuery);
+    ASSERT_EQ(compressor->getSkippedMessages(), 1);
+
+    // Only the sample was compressed, not the whole message.
+    ASSERT_GT(compressor->getCompressorBytesIn(), 0);
+    ASSERT_LT(compressor->getCompressorBytesIn(), 64 * 1024);
+}
+
 TEST(MessageCompressorManager, MessageSizeTooLarge) {
     auto registry = buildRegistry();
     MessageCompressorManager compManager(&registry);
@@ -35,6 +35,8 @@ namespace mongo {
 namespace {
 const auto kBytesIn = "bytesIn"_sd;
 const auto kBytesOut = "bytesOut"_sd;
+const auto kBytesSaved = "bytesSaved"_sd;
+const auto kTimeMicros = "timeMicros"_sd;
 }  // namespace
 
 void appendMessageCompressionStats(BSONObjBuilder* b) {
@@ -51,13 +53,21 @@ void appendMessageCompressionStats(BSONObjBuilder* b) {
 
         BSONObjBuilder compressorSection(base.subobjStart("compressor"));
         compressorSection << kBytesIn << compressor->getCompressorBytesIn() << kBytesOut
-                          << compressor->getCompressorBytesOut();
+                          << compressor->getCompressorBytesOut() << kBytesSaved
+                          << compressor->getBytesSaved() << kTimeMicros
+                          << durationCount<Microseconds>(compressor->getCompressorTime());
         compressorSection.doneFast();
 
         BSONObjBuilder decompressorSection(base.subobjStart("decompressor"));
         decompressorSection << kBytesIn << compressor->getDecompressorBytesIn() << kBytesOut
-                            << compressor->getDecompressorBytesOut();
+                            << compressor->getDecompressorBytesOut() << kTimeMicros
+                            << durationCount<Microseconds>(compressor->getDecompressorTime());
         decompressorSection.doneFast();
+
+        BSONObjBuilder skippedSection(base.subobjStart("skipped"));
+        skippedSection << "messages" << compressor->getSkippedMessages() << "bytes"
+                       << compressor->getSkippedBytes();
+        skippedSection.doneFast();
         base.doneFast();
     }
     compressionSection.doneFast();
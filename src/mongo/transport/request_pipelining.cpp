@@ -0,0 +1,96 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/request_pipelining.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+// The most requests a client which negotiates pipelining may have in flight on one connection.
+// Zero turns pipelining off.
+MONGO_EXPORT_SERVER_PARAMETER(maxPipelinedRequestsPerConnection, int, 0)
+    ->withValidator([](const int& newVal) {
+        if (newVal < 0 || newVal > 1024) {
+            return Status(ErrorCodes::BadValue,
+                          "maxPipelinedRequestsPerConnection must be between 0 and 1024");
+        }
+        return Status::OK();
+    });
+
+const auto getMaxPipelinedRequests = Session::declareDecoration<AtomicWord<int>>();
+
+}  // namespace
+
+void negotiatePipelining(const SessionHandle& session,
+                         const BSONObj& isMasterRequest,
+                         BSONObjBuilder* isMasterResponse) {
+    auto& maxInFlight = getMaxPipelinedRequests(session.get());
+
+    auto elem = isMasterRequest["pipelining"];
+    if (!elem.eoo()) {
+        int requested = 0;
+        if (elem.isNumber()) {
+            requested = std::max(elem.numberInt(), 0);
+        } else if (elem.trueValue()) {
+            requested = std::numeric_limits<int>::max();
+        }
+
+        // Replies to pipelined requests are sent while the next request is being read, which not
+        // every Session can do.
+        const int allowed =
+            session->canSinkWhileSourcing() ? maxPipelinedRequestsPerConnection.load() : 0;
+
+        maxInFlight.store(std::min(requested, allowed));
+        LOG(3) << "Negotiated up to " << maxInFlight.load() << " pipelined requests";
+    }
+
+    if (maxInFlight.load() > 0) {
+        isMasterResponse->append("pipelining", maxInFlight.load());
+    }
+}
+
+int maxPipelinedRequests(const SessionHandle& session) {
+    return getMaxPipelinedRequests(session.get()).load();
+}
+
+}  // namespace transport
+}  // namespace mongo
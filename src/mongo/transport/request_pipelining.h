@@ -0,0 +1,63 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/transport/session.h"
+
+namespace mongo {
+
+class BSONObj;
+class BSONObjBuilder;
+
+namespace transport {
+
+/**
+ * Negotiates request pipelining for 'session' from the "pipelining" field of an isMaster request,
+ * and reports the outcome in the "pipelining" field of the isMaster response.
+ *
+ * A client asks for pipelining with "pipelining: true", or with the number of requests it wants
+ * to have in flight at once. Once negotiated, the server reads further requests from the
+ * connection while earlier ones run, runs independent requests concurrently and sends each reply
+ * as soon as it is ready, so the client must match replies to requests by their responseTo.
+ *
+ * Like compression, an isMaster without the field leaves the negotiated state as it is, and one
+ * with the field renegotiates it.
+ */
+void negotiatePipelining(const SessionHandle& session,
+                         const BSONObj& isMasterRequest,
+                         BSONObjBuilder* isMasterResponse);
+
+/**
+ * Returns how many requests the client on 'session' may have in flight at once, or 0 if it has
+ * not negotiated pipelining.
+ */
+int maxPipelinedRequests(const SessionHandle& session);
+
+}  // namespace transport
+}  // namespace mongo
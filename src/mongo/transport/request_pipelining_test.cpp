@@ -0,0 +1,112 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/request_pipelining.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/server_parameters_test_util.h"
+#include "mongo/transport/mock_session.h"
+#include "mongo/transport/transport_layer_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+class PipeliningSession : public MockSession {
+public:
+    using MockSession::MockSession;
+
+    bool canSinkWhileSourcing() const override {
+        return true;
+    }
+};
+
+class RequestPipeliningTest : public unittest::Test {
+public:
+    BSONObj negotiate(const SessionHandle& session, const BSONObj& isMasterRequest) {
+        BSONObjBuilder isMasterResponse;
+        negotiatePipelining(session, isMasterRequest, &isMasterResponse);
+        return isMasterResponse.obj();
+    }
+
+    ServerParameterControllerForTest maxPipelined{"maxPipelinedRequestsPerConnection", "8"};
+    TransportLayerMock tl;
+    SessionHandle session = std::make_shared<PipeliningSession>(&tl);
+};
+
+TEST_F(RequestPipeliningTest, NotRequested) {
+    ASSERT_BSONOBJ_EQ(negotiate(session, BSON("isMaster" << 1)), BSONObj());
+    ASSERT_EQ(maxPipelinedRequests(session), 0);
+}
+
+TEST_F(RequestPipeliningTest, RequestedWithoutLimit) {
+    ASSERT_BSONOBJ_EQ(negotiate(session, BSON("isMaster" << 1 << "pipelining" << true)),
+                      BSON("pipelining" << 8));
+    ASSERT_EQ(maxPipelinedRequests(session), 8);
+
+    // An isMaster without the field reports what was negotiated before.
+    ASSERT_BSONOBJ_EQ(negotiate(session, BSON("isMaster" << 1)), BSON("pipelining" << 8));
+}
+
+TEST_F(RequestPipeliningTest, RequestedWithLimit) {
+    ASSERT_BSONOBJ_EQ(negotiate(session, BSON("isMaster" << 1 << "pipelining" << 4)),
+                      BSON("pipelining" << 4));
+    ASSERT_EQ(maxPipelinedRequests(session), 4);
+
+    ASSERT_BSONOBJ_EQ(negotiate(session, BSON("isMaster" << 1 << "pipelining" << 100)),
+                      BSON("pipelining" << 8));
+    ASSERT_EQ(maxPipelinedRequests(session), 8);
+}
+
+TEST_F(RequestPipeliningTest, Renegotiated) {
+    negotiate(session, BSON("isMaster" << 1 << "pipelining" << true));
+    ASSERT_BSONOBJ_EQ(negotiate(session, BSON("isMaster" << 1 << "pipelining" << false)),
+                      BSONObj());
+    ASSERT_EQ(maxPipelinedRequests(session), 0);
+}
+
+TEST_F(RequestPipeliningTest, DisabledOnServer) {
+    ServerParameterControllerForTest disabled("maxPipelinedRequestsPerConnection", "0");
+    ASSERT_BSONOBJ_EQ(negotiate(session, BSON("isMaster" << 1 << "pipelining" << true)),
+                      BSONObj());
+    ASSERT_EQ(maxPipelinedRequests(session), 0);
+}
+
+TEST_F(RequestPipeliningTest, UnsupportedBySession) {
+    auto plainSession = MockSession::create(&tl);
+    ASSERT_BSONOBJ_EQ(negotiate(plainSession, BSON("isMaster" << 1 << "pipelining" << true)),
+                      BSONObj());
+    ASSERT_EQ(maxPipelinedRequests(plainSession), 0);
+}
+
+}  // namespace
+}  // namespace transport
+}  // namespace mongo
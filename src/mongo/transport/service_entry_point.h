@@ -34,6 +34,8 @@
 
 namespace mongo {
 
+class Client;
+
 /**
  * This is the entrypoint from the transport layer into mongod or mongos.
  *
@@ -100,6 +102,13 @@ public:
      */
     virtual DbResponse handleRequest(OperationContext* opCtx, const Message& request) = 0;
 
+    /**
+     * Prepares the Client of 'opCtx', which runs a request pipelined on the connection of
+     * 'connectionClient', to act with the same authority as 'connectionClient'. Called before
+     * each pipelined request.
+     */
+    virtual void preparePipelinedClient(OperationContext* opCtx, Client* connectionClient) {}
+
     /**
      * set max Conection
      */
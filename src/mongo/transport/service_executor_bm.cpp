@@ -0,0 +1,211 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/service_context.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/transport/service_executor_adaptive.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
+#include "mongo/transport/transport_layer_asio.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace {
+
+using transport::ServiceExecutor;
+using transport::ServiceExecutorTaskName;
+
+// Each simulated session sends this many requests per iteration.
+const int kRequestsPerSession = 100;
+
+// The CPU time each request takes, and how long the occasional blocking request waits.
+const Microseconds kWorkPerRequest(20);
+const Milliseconds kBlockingTime(2);
+
+/**
+ * Drives a number of simulated sessions through a ServiceExecutor the way ServiceStateMachine
+ * does. Each request arrives as a network completion on the reactor, is processed in a task
+ * scheduled with MayRecurse, and is followed by a deferred task which waits for the next one.
+ * Records how long each request waits between arriving and being processed.
+ */
+class SessionSimulator {
+public:
+    SessionSimulator(ServiceExecutor* executor,
+                     transport::ReactorHandle reactor,
+                     int numSessions,
+                     int blockingPercent)
+        : _executor(executor),
+          _reactor(std::move(reactor)),
+          _blockingPercent(blockingPercent),
+          _sessions(numSessions) {}
+
+    /**
+     * Runs kRequestsPerSession requests on every session, and returns the time each request
+     * waited to be processed.
+     */
+    std::vector<int64_t> run() {
+        _remaining = _sessions.size();
+        for (size_t i = 0; i < _sessions.size(); i++) {
+            auto& session = _sessions[i];
+            session.id = i;
+            session.requestsLeft = kRequestsPerSession;
+            session.waitMicros.clear();
+            _waitForRequest(&session);
+        }
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return _remaining == 0; });
+
+        std::vector<int64_t> waitMicros;
+        for (auto& session : _sessions) {
+            waitMicros.insert(
+                waitMicros.end(), session.waitMicros.begin(), session.waitMicros.end());
+        }
+        return waitMicros;
+    }
+
+private:
+    struct Session {
+        size_t id;
+        int requestsLeft;
+        Timer sinceArrival;
+        std::vector<int64_t> waitMicros;
+    };
+
+    void _waitForRequest(Session* session) {
+        _reactor->schedule(transport::Reactor::kPost, [this, session] {
+            session->sinceArrival.reset();
+            _schedule([this, session] { _processRequest(session); },
+                      ServiceExecutor::kMayRecurse,
+                      ServiceExecutorTaskName::kSSMProcessMessage);
+        });
+    }
+
+    void _processRequest(Session* session) {
+        session->waitMicros.push_back(session->sinceArrival.micros());
+
+        Timer work;
+        while (work.micros() < kWorkPerRequest.count()) {
+        }
+
+        if (static_cast<int>((session->id * 7 + session->requestsLeft) % 100) <
+            _blockingPercent) {
+            sleepFor(kBlockingTime);
+        }
+
+        if (--session->requestsLeft == 0) {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (--_remaining == 0) {
+                _cv.notify_all();
+            }
+            return;
+        }
+
+        _schedule([this, session] { _waitForRequest(session); },
+                  ServiceExecutor::kDeferredTask | ServiceExecutor::kMayYieldBeforeSchedule,
+                  ServiceExecutorTaskName::kSSMSourceMessage);
+    }
+
+    template <typename Task>
+    void _schedule(Task task, ServiceExecutor::ScheduleFlags flags, ServiceExecutorTaskName taskName) {
+        invariant(_executor->schedule(std::move(task), flags, taskName).isOK());
+    }
+
+    ServiceExecutor* const _executor;
+    const transport::ReactorHandle _reactor;
+    const int _blockingPercent;
+
+    std::vector<Session> _sessions;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    size_t _remaining = 0;
+};
+
+/**
+ * Runs the simulated sessions through the executor 'makeExecutor' returns, and reports the
+ * request throughput and the 99th percentile time a request waited to be processed.
+ */
+template <typename MakeExecutor>
+void runServiceExecutorBenchmark(benchmark::State& state, MakeExecutor makeExecutor) {
+    const int numSessions = state.range(0);
+    const int blockingPercent = state.range(1);
+
+    auto serviceContext = ServiceContext::make();
+
+    transport::TransportLayerASIO::Options opts;
+    opts.mode = transport::TransportLayerASIO::Options::kEgress;
+    transport::TransportLayerASIO tl(opts, nullptr);
+    auto reactor = tl.getReactor(transport::TransportLayer::kNewReactor);
+
+    std::unique_ptr<ServiceExecutor> executor = makeExecutor(serviceContext.get(), reactor);
+    invariant(executor->start().isOK());
+
+    SessionSimulator simulator(executor.get(), reactor, numSessions, blockingPercent);
+    std::vector<int64_t> waitMicros;
+    for (auto _ : state) {
+        auto iterationWaitMicros = simulator.run();
+        waitMicros.insert(waitMicros.end(), iterationWaitMicros.begin(), iterationWaitMicros.end());
+    }
+
+    invariant(executor->shutdown(Seconds{10}).isOK());
+
+    std::sort(waitMicros.begin(), waitMicros.end());
+    state.counters["p99WaitMicros"] = waitMicros[(waitMicros.size() - 1) * 99 / 100];
+    state.SetItemsProcessed(state.iterations() * numSessions * kRequestsPerSession);
+}
+
+void BM_Adaptive(benchmark::State& state) {
+    runServiceExecutorBenchmark(state, [](ServiceContext* ctx, transport::ReactorHandle reactor) {
+        return stdx::make_unique<transport::ServiceExecutorAdaptive>(ctx, std::move(reactor));
+    });
+}
+
+void BM_ThreadPerCore(benchmark::State& state) {
+    runServiceExecutorBenchmark(state, [](ServiceContext* ctx, transport::ReactorHandle reactor) {
+        return stdx::make_unique<transport::ServiceExecutorThreadPerCore>(ctx, std::move(reactor));
+    });
+}
+
+// Arguments are the number of sessions and the percentage of requests which block.
+void serviceExecutorArgs(benchmark::internal::Benchmark* b) {
+    b->Args({16, 0})->Args({256, 0})->Args({4096, 0})->Args({256, 1})->Args({4096, 1});
+    b->UseRealTime();
+}
+
+BENCHMARK(BM_Adaptive)->Apply(serviceExecutorArgs);
+BENCHMARK(BM_ThreadPerCore)->Apply(serviceExecutorArgs);
+
+}  // namespace
+}  // namespace mongo
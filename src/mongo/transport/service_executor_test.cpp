@@ -35,6 +35,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/transport/service_executor_task_names.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
@@ -82,6 +83,36 @@ struct TestOptions : public ServiceExecutorAdaptive::Options {
     }
 };
 
+struct TestThreadPerCoreOptions : public ServiceExecutorThreadPerCore::Options {
+    int workerThreads() const final {
+        return 2;
+    }
+
+    bool pinWorkerThreads() const final {
+        return false;
+    }
+
+    Milliseconds pollInterval() const final {
+        return Milliseconds{10};
+    }
+
+    Microseconds stealThreshold() const final {
+        return duration_cast<Microseconds>(Milliseconds{1});
+    }
+
+    Milliseconds blockedThreshold() const final {
+        return Milliseconds{100};
+    }
+
+    int auxiliaryThreads() const final {
+        return 2;
+    }
+
+    int recursionLimit() const final {
+        return 0;
+    }
+};
+
 /* This implements the portions of the transport::Reactor based on ASIO, but leaves out
  * the methods not needed by ServiceExecutors.
  *
@@ -175,6 +206,21 @@ protected:
     std::unique_ptr<ServiceExecutorSynchronous> executor;
 };
 
+class ServiceExecutorThreadPerCoreFixture : public unittest::Test {
+protected:
+    void setUp() override {
+        auto scOwned = ServiceContext::make();
+        setGlobalServiceContext(std::move(scOwned));
+
+        executor = stdx::make_unique<ServiceExecutorThreadPerCore>(
+            getGlobalServiceContext(),
+            std::make_shared<ASIOReactor>(),
+            stdx::make_unique<TestThreadPerCoreOptions>());
+    }
+
+    std::unique_ptr<ServiceExecutorThreadPerCore> executor;
+};
+
 void scheduleBasicTask(ServiceExecutor* exec, bool expectSuccess) {
     stdx::condition_variable cond;
     stdx::mutex mutex;
@@ -216,6 +262,51 @@ TEST_F(ServiceExecutorSynchronousFixture, ScheduleFailsBeforeStartup) {
     scheduleBasicTask(executor.get(), false);
 }
 
+TEST_F(ServiceExecutorThreadPerCoreFixture, BasicTaskRuns) {
+    ASSERT_OK(executor->start());
+    auto guard = MakeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    scheduleBasicTask(executor.get(), true);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ScheduleFailsBeforeStartup) {
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, TaskQueuedBehindLongRunningTaskRuns) {
+    ASSERT_OK(executor->start());
+    auto guard = MakeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    stdx::mutex mutex;
+    stdx::condition_variable cond;
+    bool queuedTaskRan = false;
+    bool outerTaskDone = false;
+
+    // The outer task queues another one behind itself on its worker and then doesn't return until
+    // that one has run, which it can only do if another thread takes it.
+    auto outerTask = [&] {
+        ASSERT_OK(executor->schedule(
+            [&] {
+                stdx::lock_guard<stdx::mutex> lk(mutex);
+                queuedTaskRan = true;
+                cond.notify_all();
+            },
+            ServiceExecutor::kEmptyFlags,
+            ServiceExecutorTaskName::kSSMProcessMessage));
+
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        cond.wait_for(lk, Seconds{5}.toSystemDuration(), [&] { return queuedTaskRan; });
+        outerTaskDone = true;
+        cond.notify_all();
+    };
+
+    ASSERT_OK(executor->schedule(
+        outerTask, ServiceExecutor::kEmptyFlags, ServiceExecutorTaskName::kSSMStartSession));
+
+    stdx::unique_lock<stdx::mutex> lk(mutex);
+    cond.wait(lk, [&] { return outerTaskDone; });
+    ASSERT_TRUE(queuedTaskRan);
+}
 
 }  // namespace
 }  // namespace mongo
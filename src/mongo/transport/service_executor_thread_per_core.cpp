@@ -0,0 +1,614 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kExecutor;
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/service_executor_thread_per_core.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mongo/db/server_parameters.h"
+#include "mongo/transport/service_entry_point_utils.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+// The number of worker threads. If the value is -1 (the default) then it will be set to the number
+// of cores.
+MONGO_EXPORT_SERVER_PARAMETER(threadPerCoreServiceExecutorWorkerThreads, int, -1);
+
+// Whether each worker thread is pinned to one of the cores the process may run on.
+MONGO_EXPORT_SERVER_PARAMETER(threadPerCoreServiceExecutorPinWorkerThreads, bool, true);
+
+// The longest an idle worker will wait on the reactor before checking its run queue again.
+MONGO_EXPORT_SERVER_PARAMETER(threadPerCoreServiceExecutorPollIntervalMillis, int, 10);
+
+// Idle workers may take the queued tasks of a worker which has been running a single task for
+// longer than this.
+MONGO_EXPORT_SERVER_PARAMETER(threadPerCoreServiceExecutorStealThresholdMicros, int, 500);
+
+// Workers which have been running a single task for longer than this are considered blocked, and
+// the tasks queued behind them are moved to the auxiliary thread pool.
+MONGO_EXPORT_SERVER_PARAMETER(threadPerCoreServiceExecutorBlockedThresholdMillis, int, 50);
+
+// The maximum number of threads in the auxiliary thread pool.
+MONGO_EXPORT_SERVER_PARAMETER(threadPerCoreServiceExecutorMaxAuxiliaryThreads, int, 64);
+
+// Tasks scheduled with MayRecurse may be called recursively if the recursion depth is below this
+// value.
+MONGO_EXPORT_SERVER_PARAMETER(threadPerCoreServiceExecutorRecursionLimit, int, 8);
+
+constexpr auto kTotalQueued = "totalQueued"_sd;
+constexpr auto kTotalExecuted = "totalExecuted"_sd;
+constexpr auto kTotalStolen = "totalStolen"_sd;
+constexpr auto kTotalHandedOff = "totalHandedOffToAuxiliary"_sd;
+constexpr auto kThreadsRunning = "threadsRunning"_sd;
+constexpr auto kAuxiliaryThreads = "auxiliaryThreadsRunning"_sd;
+constexpr auto kExecutorLabel = "executor"_sd;
+constexpr auto kExecutorName = "threadPerCore"_sd;
+
+struct ServerParameterOptions : public ServiceExecutorThreadPerCore::Options {
+    int workerThreads() const final {
+        int value = threadPerCoreServiceExecutorWorkerThreads.load();
+        if (value == -1) {
+            value = std::max(static_cast<int>(ProcessInfo::getNumAvailableCores()), 1);
+            threadPerCoreServiceExecutorWorkerThreads.store(value);
+            log() << "No thread count configured for executor. Using number of cores: " << value;
+        }
+        return value;
+    }
+
+    bool pinWorkerThreads() const final {
+        return threadPerCoreServiceExecutorPinWorkerThreads.load();
+    }
+
+    Milliseconds pollInterval() const final {
+        return Milliseconds{threadPerCoreServiceExecutorPollIntervalMillis.load()};
+    }
+
+    Microseconds stealThreshold() const final {
+        return Microseconds{threadPerCoreServiceExecutorStealThresholdMicros.load()};
+    }
+
+    Milliseconds blockedThreshold() const final {
+        return Milliseconds{threadPerCoreServiceExecutorBlockedThresholdMillis.load()};
+    }
+
+    int auxiliaryThreads() const final {
+        return threadPerCoreServiceExecutorMaxAuxiliaryThreads.load();
+    }
+
+    int recursionLimit() const final {
+        return threadPerCoreServiceExecutorRecursionLimit.load();
+    }
+};
+
+ThreadPool::Options makeAuxiliaryPoolOptions(const ServiceExecutorThreadPerCore::Options& config) {
+    ThreadPool::Options options;
+    options.poolName = "ServiceExecutorAuxiliary";
+    options.threadNamePrefix = "worker-aux-";
+    options.minThreads = 0;
+    options.maxThreads = std::max(config.auxiliaryThreads(), 1);
+    return options;
+}
+
+template <typename Duration>
+TickSource::Tick durationToTicks(Duration duration, TickSource* tickSource) {
+    return duration_cast<Microseconds>(duration).count() * tickSource->getTicksPerSecond() /
+        1000000;
+}
+
+/**
+ * Returns the CPUs this process may run on, or nothing if they can't be determined.
+ */
+std::vector<int> getAllowedCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+void pinThreadToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    const int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) {
+        warning() << "Failed to pin worker thread to CPU " << cpu << ": "
+                  << errnoWithDescription(ret);
+    }
+#endif
+}
+
+}  // namespace
+
+thread_local ServiceExecutorThreadPerCore::Worker* ServiceExecutorThreadPerCore::_localWorker =
+    nullptr;
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                                           ReactorHandle reactor)
+    : ServiceExecutorThreadPerCore(
+          ctx, std::move(reactor), stdx::make_unique<ServerParameterOptions>()) {}
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                                           ReactorHandle reactor,
+                                                           std::unique_ptr<Options> config)
+    : _reactorHandle(reactor),
+      _config(std::move(config)),
+      _tickSource(ctx->getTickSource()),
+      _auxiliaryPool(makeAuxiliaryPoolOptions(*_config)) {}
+
+ServiceExecutorThreadPerCore::~ServiceExecutorThreadPerCore() {
+    invariant(!_isRunning.load());
+}
+
+Status ServiceExecutorThreadPerCore::start() {
+    invariant(!_isRunning.load());
+
+    _stealThresholdTicks = durationToTicks(_config->stealThreshold(), _tickSource);
+    _blockedThresholdTicks = durationToTicks(_config->blockedThreshold(), _tickSource);
+
+    const auto numWorkers = _config->workerThreads();
+    std::vector<int> cpus;
+    if (_config->pinWorkerThreads()) {
+        cpus = getAllowedCpus();
+    }
+
+    // Every worker has to exist before any of them starts looking for work to steal.
+    for (int i = 0; i < numWorkers; i++) {
+        _workers.push_back(stdx::make_unique<Worker>(this, i));
+    }
+
+    _auxiliaryPool.startup();
+    _isRunning.store(true);
+
+    for (auto& worker : _workers) {
+        boost::optional<int> cpu;
+        if (!cpus.empty()) {
+            cpu = cpus[worker->id % cpus.size()];
+        }
+
+        _threadsRunning.addAndFetch(1);
+        const auto launchResult = launchServiceWorkerThread(
+            [ this, worker = worker.get(), cpu ] { _workerThreadRoutine(worker, cpu); });
+        if (!launchResult.isOK()) {
+            warning() << "Failed to launch new worker thread: " << launchResult;
+            _threadsRunning.subtractAndFetch(1);
+            return launchResult;
+        }
+    }
+
+    _controllerThread =
+        stdx::thread(&ServiceExecutorThreadPerCore::_controllerThreadRoutine, this);
+
+    return Status::OK();
+}
+
+Status ServiceExecutorThreadPerCore::shutdown(Milliseconds timeout) {
+    if (!_isRunning.load())
+        return Status::OK();
+
+    _isRunning.store(false);
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_controllerMutex);
+        _controllerCondition.notify_one();
+    }
+    if (_controllerThread.joinable()) {
+        _controllerThread.join();
+    }
+
+    for (auto& worker : _workers) {
+        stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+        worker->cv.notify_one();
+    }
+    _reactorHandle->stop();
+    _auxiliaryPool.shutdown();
+
+    stdx::unique_lock<stdx::mutex> lk(_threadsMutex);
+    bool result = _deathCondition.wait_for(
+        lk, timeout.toSystemDuration(), [&] { return _threadsRunning.load() == 0; });
+    lk.unlock();
+
+    if (!result) {
+        return Status(ErrorCodes::Error::ExceededTimeLimit,
+                      "thread per core executor couldn't shutdown all worker threads within time "
+                      "limit.");
+    }
+
+    _auxiliaryPool.join();
+    return Status::OK();
+}
+
+Status ServiceExecutorThreadPerCore::schedule(Task task,
+                                              ScheduleFlags flags,
+                                              ServiceExecutorTaskName taskName) {
+    if (!_isRunning.load()) {
+        return {ErrorCodes::ShutdownInProgress, "Executor is not running"};
+    }
+
+    _totalQueued.addAndFetch(1);
+
+    auto worker = _localWorker;
+    if (worker && worker->executor == this) {
+        if ((flags & kMayRecurse) && (worker->recursionDepth < _config->recursionLimit())) {
+            _runTask(worker, task);
+            return Status::OK();
+        }
+
+        // A worker which is waiting on the reactor has to get back to it quickly, so it gives the
+        // task to a sleeping worker, or else leaves it to whichever thread is running the reactor.
+        if (worker->polling.load()) {
+            if (!_handToSleepingWorker(&task)) {
+                _reactorHandle->schedule(Reactor::kPost, [ this, task = std::move(task) ] {
+                    _runTask(_localWorker, task);
+                });
+            }
+            return Status::OK();
+        }
+
+        // Otherwise the task stays on this core, to run after the current one.
+        _enqueue(worker, std::move(task));
+        return Status::OK();
+    }
+
+    if (_handToSleepingWorker(&task)) {
+        return Status::OK();
+    }
+
+    if (_pollerActive.load()) {
+        _reactorHandle->schedule(Reactor::kPost, [ this, task = std::move(task) ] {
+            _runTask(_localWorker, task);
+        });
+        return Status::OK();
+    }
+
+    if (auto target = _findUnblockedWorker()) {
+        _enqueue(target, std::move(task));
+        return Status::OK();
+    }
+
+    return _scheduleAuxiliary(std::move(task));
+}
+
+void ServiceExecutorThreadPerCore::appendStats(BSONObjBuilder* bob) const {
+    BSONObjBuilder section(bob->subobjStart("serviceExecutorTaskStats"));
+    section << kExecutorLabel << kExecutorName                //
+            << kTotalQueued << _totalQueued.load()            //
+            << kTotalExecuted << _totalExecuted.load()        //
+            << kTotalStolen << _totalStolen.load()            //
+            << kTotalHandedOff << _totalHandedOff.load()      //
+            << kThreadsRunning << _threadsRunning.load()      //
+            << kAuxiliaryThreads << static_cast<int>(_auxiliaryPool.getStats().numThreads);
+}
+
+void ServiceExecutorThreadPerCore::_workerThreadRoutine(Worker* worker, boost::optional<int> cpu) {
+    _localWorker = worker;
+    {
+        std::string threadName = str::stream() << "worker-" << worker->id;
+        setThreadName(threadName);
+    }
+
+    if (cpu) {
+        pinThreadToCpu(*cpu);
+    }
+
+    log() << "Started new database worker thread " << worker->id;
+
+    const auto guard = MakeGuard([this, worker] {
+        if (worker->holdsPollerToken) {
+            worker->holdsPollerToken = false;
+            _pollerActive.store(false);
+        }
+        _localWorker = nullptr;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_threadsMutex);
+            _threadsRunning.subtractAndFetch(1);
+        }
+        _deathCondition.notify_all();
+    });
+
+    while (_isRunning.load()) {
+        if (auto task = _popTask(worker)) {
+            _runTask(worker, *task);
+            continue;
+        }
+
+        if (auto task = _stealTask(worker)) {
+            _totalStolen.addAndFetch(1);
+            _runTask(worker, *task);
+            continue;
+        }
+
+        // With nothing to run, wait on the reactor for network I/O, unless another worker already
+        // is. The worker keeps the poller token until it has a task to run.
+        if (worker->holdsPollerToken || !_pollerActive.swap(true)) {
+            worker->holdsPollerToken = true;
+            worker->polling.store(true);
+            _reactorHandle->runFor(_config->pollInterval());
+            worker->polling.store(false);
+            continue;
+        }
+
+        stdx::unique_lock<stdx::mutex> lk(worker->mutex);
+        if (!worker->queue.empty() || !_isRunning.load()) {
+            continue;
+        }
+
+        worker->sleeping = true;
+        _sleepingWorkers.addAndFetch(1);
+
+        // The poller may have let go of the token before it could see this worker was sleeping.
+        if (!_pollerActive.load()) {
+            worker->sleeping = false;
+            _sleepingWorkers.subtractAndFetch(1);
+            continue;
+        }
+
+        auto wakeup = [&] { return !worker->sleeping || !_isRunning.load(); };
+        if (_queuedTasks.load() > 0) {
+            // Other workers have queued tasks, so check back in case one of them can be stolen.
+            worker->cv.wait_for(lk, _config->stealThreshold().toSystemDuration(), wakeup);
+        } else {
+            worker->cv.wait(lk, wakeup);
+        }
+        if (worker->sleeping) {
+            worker->sleeping = false;
+            _sleepingWorkers.subtractAndFetch(1);
+        }
+    }
+}
+
+/*
+ * The controller thread looks for workers which have been running a single task for longer than
+ * the blocked threshold, which is usually a task waiting on a lock or on another node. The tasks
+ * queued behind a blocked worker are moved to the auxiliary pool, and if every worker is blocked
+ * an auxiliary thread polls the reactor so that other sessions can still make progress.
+ *
+ * It also wakes a sleeping worker whenever tasks are queued, since the worker they're queued on
+ * may have become busy enough for them to be stolen.
+ */
+void ServiceExecutorThreadPerCore::_controllerThreadRoutine() {
+    setThreadName("worker-controller"_sd);
+
+    const auto interval = std::min(_config->pollInterval(), _config->blockedThreshold() / 2);
+    while (_isRunning.load()) {
+        {
+            stdx::unique_lock<stdx::mutex> lk(_controllerMutex);
+            _controllerCondition.wait_for(
+                lk, interval.toSystemDuration(), [this] { return !_isRunning.load(); });
+        }
+
+        if (!_isRunning.load())
+            break;
+
+        const auto now = _tickSource->getTicks();
+        bool allBlocked = true;
+        for (auto& worker : _workers) {
+            if (!_isBlocked(*worker, now)) {
+                allBlocked = false;
+                continue;
+            }
+
+            std::deque<Task> stranded;
+            {
+                stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+                stranded.swap(worker->queue);
+            }
+            if (stranded.empty()) {
+                continue;
+            }
+
+            _queuedTasks.subtractAndFetch(stranded.size());
+            LOG(1) << "Worker thread " << worker->id << " is blocked, moving " << stranded.size()
+                   << " queued tasks to the auxiliary pool";
+            for (auto& task : stranded) {
+                auto status = _scheduleAuxiliary(std::move(task));
+                if (!status.isOK()) {
+                    warning() << "Failed to hand task to the auxiliary pool: " << status;
+                }
+            }
+        }
+
+        if (allBlocked && !_auxiliaryPollerActive.swap(true)) {
+            LOG(1) << "All worker threads are blocked, polling for network I/O on an auxiliary "
+                      "thread";
+            auto status = _auxiliaryPool.schedule([this] {
+                _reactorHandle->runFor(_config->blockedThreshold());
+                _auxiliaryPollerActive.store(false);
+            });
+            if (!status.isOK()) {
+                _auxiliaryPollerActive.store(false);
+            }
+        }
+
+        if (_queuedTasks.load() > 0) {
+            _handToSleepingWorker(nullptr);
+        }
+    }
+}
+
+void ServiceExecutorThreadPerCore::_runTask(Worker* worker, const Task& task) {
+    if (!worker) {
+        task();
+        _totalExecuted.addAndFetch(1);
+        return;
+    }
+
+    // The task may run for a long time, so let another worker take over waiting on the reactor.
+    if (worker->holdsPollerToken) {
+        _releasePollerToken(worker);
+    }
+
+    if (worker->recursionDepth++ == 0) {
+        worker->executingSince.store(_tickSource->getTicks());
+    }
+    const auto guard = MakeGuard([this, worker] {
+        if (--worker->recursionDepth == 0) {
+            worker->executingSince.store(0);
+        }
+        _totalExecuted.addAndFetch(1);
+    });
+
+    task();
+}
+
+boost::optional<ServiceExecutor::Task> ServiceExecutorThreadPerCore::_popTask(Worker* worker) {
+    stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+    if (worker->queue.empty()) {
+        return boost::none;
+    }
+
+    auto task = std::move(worker->queue.front());
+    worker->queue.pop_front();
+    _queuedTasks.subtractAndFetch(1);
+    return std::move(task);
+}
+
+boost::optional<ServiceExecutor::Task> ServiceExecutorThreadPerCore::_stealTask(Worker* thief) {
+    if (_queuedTasks.load() == 0) {
+        return boost::none;
+    }
+
+    const auto now = _tickSource->getTicks();
+    for (size_t i = 1; i < _workers.size(); i++) {
+        auto victim = _workers[(thief->id + i) % _workers.size()].get();
+
+        // Leave the tasks of a worker which is between tasks, or running a short one, where they
+        // are. They'll run soon on the core that scheduled them.
+        const auto since = victim->executingSince.load();
+        const bool stealable =
+            victim->polling.load() || (since != 0 && now - since >= _stealThresholdTicks);
+        if (!stealable) {
+            continue;
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(victim->mutex);
+        if (victim->queue.empty()) {
+            continue;
+        }
+
+        auto task = std::move(victim->queue.front());
+        victim->queue.pop_front();
+        _queuedTasks.subtractAndFetch(1);
+        return std::move(task);
+    }
+
+    return boost::none;
+}
+
+void ServiceExecutorThreadPerCore::_releasePollerToken(Worker* worker) {
+    worker->holdsPollerToken = false;
+    _pollerActive.store(false);
+    _handToSleepingWorker(nullptr);
+}
+
+void ServiceExecutorThreadPerCore::_enqueue(Worker* worker, Task task) {
+    stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+    worker->queue.push_back(std::move(task));
+    _queuedTasks.addAndFetch(1);
+    if (worker->sleeping) {
+        worker->sleeping = false;
+        _sleepingWorkers.subtractAndFetch(1);
+        worker->cv.notify_one();
+    }
+}
+
+bool ServiceExecutorThreadPerCore::_handToSleepingWorker(Task* task) {
+    if (_sleepingWorkers.load() == 0) {
+        return false;
+    }
+
+    const auto start = _nextWorker.fetchAndAdd(1);
+    for (size_t i = 0; i < _workers.size(); i++) {
+        auto worker = _workers[(start + i) % _workers.size()].get();
+        stdx::lock_guard<stdx::mutex> lk(worker->mutex);
+        if (!worker->sleeping) {
+            continue;
+        }
+
+        worker->sleeping = false;
+        _sleepingWorkers.subtractAndFetch(1);
+        if (task) {
+            worker->queue.push_back(std::move(*task));
+            _queuedTasks.addAndFetch(1);
+        }
+        worker->cv.notify_one();
+        return true;
+    }
+
+    return false;
+}
+
+ServiceExecutorThreadPerCore::Worker* ServiceExecutorThreadPerCore::_findUnblockedWorker() {
+    const auto now = _tickSource->getTicks();
+    const auto start = _nextWorker.fetchAndAdd(1);
+    for (size_t i = 0; i < _workers.size(); i++) {
+        auto worker = _workers[(start + i) % _workers.size()].get();
+        if (!_isBlocked(*worker, now)) {
+            return worker;
+        }
+    }
+
+    return nullptr;
+}
+
+bool ServiceExecutorThreadPerCore::_isBlocked(const Worker& worker, TickSource::Tick now) const {
+    const auto since = worker.executingSince.load();
+    return since != 0 && now - since >= _blockedThresholdTicks;
+}
+
+Status ServiceExecutorThreadPerCore::_scheduleAuxiliary(Task task) {
+    _totalHandedOff.addAndFetch(1);
+    return _auxiliaryPool.schedule([ this, task = std::move(task) ] {
+        task();
+        _totalExecuted.addAndFetch(1);
+    });
+}
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,195 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "mongo/db/service_context.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/transport/service_executor_task_names.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/tick_source.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A ServiceExecutor with a fixed set of worker threads, one per core, each with its own run queue.
+ *
+ * A task scheduled from a worker thread goes on that worker's queue, so a session keeps running on
+ * the same core from the time its network I/O completes until it waits on the network again.
+ * Tasks scheduled from elsewhere go to an idle worker, or are spread over the busy ones. Idle
+ * workers take turns waiting on the reactor for network I/O, so only one thread at a time polls
+ * it.
+ *
+ * A worker which has run a single task for longer than the steal threshold lets idle workers take
+ * the tasks queued behind it. Once it passes the blocked threshold its queue is handed to an
+ * auxiliary thread pool instead, and if every worker is blocked an auxiliary thread polls the
+ * reactor so that network I/O keeps completing.
+ */
+class ServiceExecutorThreadPerCore final : public ServiceExecutor {
+public:
+    struct Options {
+        virtual ~Options() = default;
+        // The number of worker threads. Each one is pinned to a core if pinWorkerThreads() is set.
+        virtual int workerThreads() const = 0;
+
+        virtual bool pinWorkerThreads() const = 0;
+
+        // The longest an idle worker waits on the reactor or for a task before checking on the
+        // other workers.
+        virtual Milliseconds pollInterval() const = 0;
+
+        // Idle workers steal the queued tasks of a worker which has been running a single task for
+        // longer than this.
+        virtual Microseconds stealThreshold() const = 0;
+
+        // A worker which has been running a single task for longer than this is considered blocked,
+        // and the tasks queued behind it are moved to the auxiliary pool.
+        virtual Milliseconds blockedThreshold() const = 0;
+
+        // The maximum number of threads in the auxiliary pool.
+        virtual int auxiliaryThreads() const = 0;
+
+        // The maximum allowable depth of recursion for tasks scheduled with the MayRecurse flag
+        // before stack unwinding is forced.
+        virtual int recursionLimit() const = 0;
+    };
+
+    explicit ServiceExecutorThreadPerCore(ServiceContext* ctx, ReactorHandle reactor);
+    explicit ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                          ReactorHandle reactor,
+                                          std::unique_ptr<Options> config);
+
+    ~ServiceExecutorThreadPerCore();
+
+    Status start() final;
+    Status shutdown(Milliseconds timeout) final;
+    Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) final;
+
+    Mode transportMode() const final {
+        return Mode::kAsynchronous;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const final;
+
+    int threadsRunning() {
+        return _threadsRunning.load();
+    }
+
+private:
+    struct Worker {
+        Worker(ServiceExecutorThreadPerCore* executor, int id) : executor(executor), id(id) {}
+
+        ServiceExecutorThreadPerCore* const executor;
+        const int id;
+
+        stdx::mutex mutex;
+        stdx::condition_variable cv;
+        std::deque<Task> queue;
+        bool sleeping = false;
+
+        // When the worker started its outermost running task, or 0 if it isn't running one.
+        AtomicWord<TickSource::Tick> executingSince{0};
+
+        // Whether the worker is inside a call to run the reactor.
+        AtomicWord<bool> polling{false};
+
+        // Only touched by the worker's own thread.
+        bool holdsPollerToken = false;
+        int recursionDepth = 0;
+    };
+
+    void _workerThreadRoutine(Worker* worker, boost::optional<int> cpu);
+    void _controllerThreadRoutine();
+
+    void _runTask(Worker* worker, const Task& task);
+    boost::optional<Task> _popTask(Worker* worker);
+    boost::optional<Task> _stealTask(Worker* thief);
+    void _releasePollerToken(Worker* worker);
+
+    void _enqueue(Worker* worker, Task task);
+    bool _handToSleepingWorker(Task* task);
+    Worker* _findUnblockedWorker();
+    bool _isBlocked(const Worker& worker, TickSource::Tick now) const;
+    Status _scheduleAuxiliary(Task task);
+
+    ReactorHandle _reactorHandle;
+
+    std::unique_ptr<Options> _config;
+
+    TickSource* const _tickSource;
+    TickSource::Tick _stealThresholdTicks = 0;
+    TickSource::Tick _blockedThresholdTicks = 0;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    ThreadPool _auxiliaryPool;
+
+    AtomicWord<bool> _isRunning{false};
+
+    // Held by the one worker which is waiting on the reactor for network I/O.
+    AtomicWord<bool> _pollerActive{false};
+    // Set while an auxiliary thread is polling the reactor on behalf of blocked workers.
+    AtomicWord<bool> _auxiliaryPollerActive{false};
+
+    AtomicWord<int> _sleepingWorkers{0};
+    // The number of tasks waiting in the workers' queues.
+    AtomicWord<int> _queuedTasks{0};
+    AtomicWord<size_t> _nextWorker{0};
+
+    stdx::thread _controllerThread;
+    stdx::mutex _controllerMutex;
+    stdx::condition_variable _controllerCondition;
+
+    // Threads signal this condition variable when they exit so we can gracefully shutdown
+    // the executor.
+    mutable stdx::mutex _threadsMutex;
+    stdx::condition_variable _deathCondition;
+    AtomicWord<int> _threadsRunning{0};
+
+    static thread_local Worker* _localWorker;
+
+    // These counters are only used for reporting in serverStatus.
+    AtomicWord<int64_t> _totalQueued{0};
+    AtomicWord<int64_t> _totalExecuted{0};
+    AtomicWord<int64_t> _totalStolen{0};
+    AtomicWord<int64_t> _totalHandedOff{0};
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -32,13 +32,19 @@
 
 #include "mongo/transport/service_state_machine.h"
 
+#include <algorithm>
+#include <deque>
+
 #include "mongo/config.h"
 #include "mongo/db/client.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/rpc/message.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/transport/message_compressor_manager.h"
+#include "mongo/transport/request_pipelining.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor_task_names.h"
 #include "mongo/transport/session.h"
@@ -46,6 +52,7 @@
 #include "mongo/util/assert_util.h"
 #include "mongo/util/concurrency/idle_thread_block.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
@@ -87,11 +94,89 @@ bool setExhaustMessage(Message* m, const DbResponse& dbresponse) {
     return true;
 }
 
+// Builds the request for the next batch of an OP_MSG exhaust cursor, which the server runs as if
+// the client had sent it in response to the reply with id 'responseId'
+Message makeExhaustMessage(int32_t responseId, const BSONObj& nextInvocation) {
+    OpMsgRequest request;
+    request.body = nextInvocation;
+
+    auto message = request.serialize();
+    OpMsg::setFlag(&message, OpMsg::kExhaustAllowed);
+    message.header().setId(responseId);
+    return message;
+}
+
+// Commands which read or change the state of the connection. Even once the client has negotiated
+// pipelining, they wait for the requests before them and run on the connection's own Client.
+const StringData kConnectionStateCommands[] = {"authenticate",
+                                               "getLastError",
+                                               "getlasterror",
+                                               "getnonce",
+                                               "getPrevError",
+                                               "getpreverror",
+                                               "isMaster",
+                                               "ismaster",
+                                               "logout",
+                                               "resetError",
+                                               "reseterror",
+                                               "saslContinue",
+                                               "saslStart"};
+
+// Returns whether 'message' can run concurrently with the requests around it once the client has
+// negotiated pipelining. Besides the requests which read or change the state of the connection,
+// those that stream replies or belong to a transaction or a retryable write must run in order.
+bool canPipeline(const Message& message) {
+    if (message.operation() != dbMsg || OpMsg::isFlagSet(message, OpMsg::kMoreToCome) ||
+        OpMsg::isFlagSet(message, OpMsg::kExhaustAllowed)) {
+        return false;
+    }
+
+    try {
+        const auto request = OpMsgRequest::parse(message);
+        return std::find(std::begin(kConnectionStateCommands),
+                         std::end(kConnectionStateCommands),
+                         request.getCommandName()) == std::end(kConnectionStateCommands) &&
+            !request.body.hasField("txnNumber");
+    } catch (const DBException&) {
+        // Let the request fail the same way it would without pipelining.
+        return false;
+    }
+}
+
 }  // namespace
 
 using transport::ServiceExecutor;
 using transport::TransportLayer;
 
+struct ServiceStateMachine::Pipeline {
+    struct Reply {
+        Message message;
+        boost::optional<MessageCompressorId> compressorId;
+    };
+
+    stdx::mutex mutex;
+    stdx::condition_variable waitCondition;
+
+    // What the ServiceStateMachine waits for, if anything.
+    PipelineWait wait = PipelineWait::kNone;
+
+    // The number of pipelined requests which haven't queued their reply yet.
+    int inFlight = 0;
+
+    // Replies waiting to be sunk, and whether a thread is sinking them. Once sinking a reply has
+    // failed, the remaining ones are dropped.
+    std::deque<Reply> replies;
+    bool sinking = false;
+    bool sinkFailed = false;
+
+    // The Clients of finished pipelined requests, for later ones to reuse.
+    std::vector<ServiceContext::UniqueClient> idleClients;
+
+    // The synchronous service executor runs all the tasks of a connection on the connection's own
+    // thread, so with the synchronous transport pipelined requests run on these threads instead.
+    std::unique_ptr<ThreadPool> workers;
+};
+
 /*
  * This class wraps up the logic for swapping/unswapping the Client during runNext().
  *
@@ -231,6 +316,8 @@ ServiceStateMachine::ServiceStateMachine(ServiceContext* svcContext,
       _dbClient{svcContext->makeClient(_threadName, std::move(session))},
       _dbClientPtr{_dbClient.get()} {}
 
+ServiceStateMachine::~ServiceStateMachine() = default;
+
 const transport::SessionHandle& ServiceStateMachine::_session() const {
     return _sessionHandle;
 }
@@ -239,6 +326,11 @@ void ServiceStateMachine::_sourceMessage(ThreadGuard guard) {
     invariant(_inMessage.empty());
     invariant(_state.load() == State::Source);
     _state.store(State::SourceWait);
+
+    // The batches of an exhaust cursor are compressed like the request which opened the stream,
+    // which is the last one sourced.
+    _compressorId = boost::none;
+
     guard.release();
 
     auto sourceMsgImpl = [&] {
@@ -359,7 +451,6 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
 
     auto& compressorMgr = MessageCompressorManager::forSession(_session());
 
-    _compressorId = boost::none;
     if (_inMessage.operation() == dbCompressed) {
         MessageCompressorId compressorId;
         auto swm = compressorMgr.decompressMessage(_inMessage, &compressorId);
@@ -368,6 +459,34 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
         _compressorId = compressorId;
     }
 
+    // Once the client has negotiated pipelining, the requests which don't depend on the others
+    // run concurrently with the ServiceStateMachine, which goes back to sourcing the next request
+    // right away. Any other request waits for the ones before it, and then runs on the
+    // connection's own Client as it would without pipelining.
+    const auto maxPipelinedRequests = transport::maxPipelinedRequests(_session());
+    if (maxPipelinedRequests > 0) {
+        if (!_pipeline) {
+            _pipeline = stdx::make_unique<Pipeline>();
+            if (_transportMode == transport::Mode::kSynchronous) {
+                ThreadPool::Options options;
+                options.poolName = str::stream() << _threadName << "-pipeline";
+                options.minThreads = 0;
+                options.maxThreads = maxPipelinedRequests;
+                _pipeline->workers = stdx::make_unique<ThreadPool>(std::move(options));
+                _pipeline->workers->startup();
+            }
+        }
+
+        const bool pipelined = canPipeline(_inMessage);
+        if (!_waitForPipeline(guard, pipelined ? PipelineWait::kRoom : PipelineWait::kDrained)) {
+            return;
+        }
+
+        if (pipelined) {
+            return _dispatchPipelinedMessage(std::move(guard));
+        }
+    }
+
     networkCounter.hitLogicalIn(_inMessage.size());
 
     // Pass sourced Message to handler to generate response.
@@ -385,12 +504,19 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
     Message& toSink = dbresponse.response;
     if (!toSink.empty()) {
         invariant(!OpMsg::isFlagSet(_inMessage, OpMsg::kMoreToCome));
-        toSink.header().setId(nextMessageId());
-        toSink.header().setResponseToMsgId(_inMessage.header().getId());
+        toSink.firstSegment().setId(nextMessageId());
+        toSink.firstSegment().setResponseToMsgId(_inMessage.header().getId());
 
         // If this is an exhaust cursor, don't source more Messages
         if (dbresponse.exhaustNS.size() > 0 && setExhaustMessage(&_inMessage, dbresponse)) {
             _inExhaust = true;
+        } else if (!dbresponse.nextInvocation.isEmpty()) {
+            // Stream the next batch once this one has been written to the socket, so that a slow
+            // client holds back the cursor instead of letting replies pile up in memory.
+            OpMsg::setFlag(&toSink, OpMsg::kMoreToCome);
+            _inMessage =
+                makeExhaustMessage(toSink.firstSegment().getId(), dbresponse.nextInvocation);
+            _inExhaust = true;
         } else {
             _inExhaust = false;
             _inMessage.reset();
@@ -407,6 +533,7 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
 
     } else {
         _state.store(State::Source);
+        _inExhaust = false;
         _inMessage.reset();
         return _scheduleNextWithGuard(std::move(guard),
                                       ServiceExecutor::kDeferredTask,
@@ -414,6 +541,216 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
     }
 }
 
+bool ServiceStateMachine::_waitForPipeline(ThreadGuard& guard, PipelineWait what) {
+    stdx::unique_lock<stdx::mutex> lk(_pipeline->mutex);
+    if (_pipelineReady_inlock(what)) {
+        return true;
+    }
+
+    _pipeline->wait = what;
+    if (_transportMode == transport::Mode::kSynchronous) {
+        _pipeline->waitCondition.wait(lk, [&] { return _pipeline->wait == PipelineWait::kNone; });
+        return true;
+    }
+
+    // Release the ServiceStateMachine while still holding the lock, so that it is free by the
+    // time the pipelined request which ends the wait reschedules it.
+    guard.release();
+    return false;
+}
+
+bool ServiceStateMachine::_pipelineReady_inlock(PipelineWait what) const {
+    switch (what) {
+        case PipelineWait::kNone:
+            return true;
+        case PipelineWait::kRoom: {
+            // Replies count until they have been sent, so that a client which doesn't read them
+            // stops the connection from taking more requests rather than letting them pile up.
+            const auto pending = _pipeline->inFlight + static_cast<int>(_pipeline->replies.size()) +
+                (_pipeline->sinking ? 1 : 0);
+            return pending < std::max(transport::maxPipelinedRequests(_session()), 1);
+        }
+        case PipelineWait::kDrained:
+            return !_pipeline->inFlight && _pipeline->replies.empty() && !_pipeline->sinking;
+    }
+    MONGO_UNREACHABLE;
+}
+
+void ServiceStateMachine::_notifyPipelineWaiter(stdx::unique_lock<stdx::mutex> lk) {
+    if (_pipeline->wait == PipelineWait::kNone || !_pipelineReady_inlock(_pipeline->wait)) {
+        return;
+    }
+
+    _pipeline->wait = PipelineWait::kNone;
+    if (_transportMode == transport::Mode::kSynchronous) {
+        // Notify while holding the lock, since the ServiceStateMachine may clean up the pipeline
+        // as soon as it wakes up.
+        _pipeline->waitCondition.notify_one();
+        return;
+    }
+
+    lk.unlock();
+    _scheduleNextWithGuard(ThreadGuard(this),
+                           ServiceExecutor::kEmptyFlags,
+                           transport::ServiceExecutorTaskName::kSSMProcessMessage);
+}
+
+void ServiceStateMachine::_dispatchPipelinedMessage(ThreadGuard guard) {
+    auto task = [ ssm = shared_from_this(), request = _inMessage, compressorId = _compressorId ] {
+        ssm->_processPipelinedMessage(request, compressorId);
+    };
+    _inMessage.reset();
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_pipeline->mutex);
+        _pipeline->inFlight++;
+    }
+
+    Status status = _transportMode == transport::Mode::kSynchronous
+        ? _pipeline->workers->schedule(std::move(task))
+        : _serviceContext->getServiceExecutor()->schedule(
+              std::move(task),
+              ServiceExecutor::kEmptyFlags,
+              transport::ServiceExecutorTaskName::kSSMProcessMessage);
+    if (!status.isOK()) {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_pipeline->mutex);
+            _pipeline->inFlight--;
+        }
+        _terminateAndLogIfError(status);
+        return _cleanupSession(std::move(guard));
+    }
+
+    _state.store(State::Source);
+    _scheduleNextWithGuard(std::move(guard),
+                           ServiceExecutor::kDeferredTask,
+                           transport::ServiceExecutorTaskName::kSSMSourceMessage);
+}
+
+void ServiceStateMachine::_processPipelinedMessage(
+    const Message& request, boost::optional<MessageCompressorId> compressorId) {
+    auto& pipeline = *_pipeline;
+
+    ServiceContext::UniqueClient client;
+    {
+        stdx::lock_guard<stdx::mutex> lk(pipeline.mutex);
+        if (!pipeline.idleClients.empty()) {
+            client = std::move(pipeline.idleClients.back());
+            pipeline.idleClients.pop_back();
+        }
+    }
+    if (!client) {
+        client = _serviceContext->makeClient(_threadName, _session());
+    }
+
+    const auto oldThreadName = getThreadName().toString();
+    setThreadName(_threadName);
+    Client::setCurrent(std::move(client));
+
+    networkCounter.hitLogicalIn(request.size());
+
+    Message toSink;
+    try {
+        auto opCtx = Client::getCurrent()->makeOperationContext();
+        _sep->preparePipelinedClient(opCtx.get(), _dbClientPtr);
+        toSink = _sep->handleRequest(opCtx.get(), request).response;
+    } catch (const DBException& e) {
+        log() << "DBException handling pipelined request, closing client connection: "
+              << redact(e);
+        terminate();
+    }
+
+    client = Client::releaseCurrent();
+    setThreadName(oldThreadName);
+
+    if (!toSink.empty()) {
+        toSink.firstSegment().setId(nextMessageId());
+        toSink.firstSegment().setResponseToMsgId(request.header().getId());
+        networkCounter.hitLogicalOut(toSink.size());
+    }
+
+    stdx::unique_lock<stdx::mutex> lk(pipeline.mutex);
+    pipeline.idleClients.push_back(std::move(client));
+    pipeline.inFlight--;
+    if (!toSink.empty()) {
+        pipeline.replies.push_back({std::move(toSink), compressorId});
+    }
+
+    // Let the ServiceStateMachine go on before sinking, which may take a while if the client is
+    // slow to read its replies.
+    const bool sink = !pipeline.sinking && !pipeline.replies.empty();
+    if (sink) {
+        pipeline.sinking = true;
+    }
+    _notifyPipelineWaiter(std::move(lk));
+
+    if (sink) {
+        _sinkPipelinedReplies();
+    }
+}
+
+void ServiceStateMachine::_sinkPipelinedReplies(Status lastSinkStatus) {
+    auto& pipeline = *_pipeline;
+
+    stdx::unique_lock<stdx::mutex> lk(pipeline.mutex);
+    invariant(pipeline.sinking);
+
+    while (true) {
+        if (!lastSinkStatus.isOK() && !pipeline.sinkFailed) {
+            log() << "Error sending response to client: " << lastSinkStatus
+                  << ". Ending connection from " << _session()->remote()
+                  << " (connection id: " << _session()->id() << ")";
+            pipeline.sinkFailed = true;
+            terminate();
+        }
+
+        if (pipeline.sinkFailed) {
+            pipeline.replies.clear();
+        }
+
+        if (pipeline.replies.empty()) {
+            pipeline.sinking = false;
+            return _notifyPipelineWaiter(std::move(lk));
+        }
+
+        auto reply = std::move(pipeline.replies.front());
+        pipeline.replies.pop_front();
+
+        // The reply before this one has been sent, which may have made room for another request.
+        _notifyPipelineWaiter(std::move(lk));
+
+        auto sunk = [&]() -> Future<void> {
+            // Compressing updates the state of the connection's MessageCompressorManager, which is
+            // why only the thread sinking the replies compresses them.
+            if (reply.compressorId) {
+                auto swm = MessageCompressorManager::forSession(_session())
+                               .compressMessage(reply.message, &reply.compressorId.value());
+                if (!swm.isOK()) {
+                    return swm.getStatus();
+                }
+                reply.message = std::move(swm.getValue());
+            }
+
+            if (_transportMode == transport::Mode::kSynchronous) {
+                return Future<void>::makeReady(_session()->sinkMessage(std::move(reply.message)));
+            } else {
+                invariant(_transportMode == transport::Mode::kAsynchronous);
+                return _session()->asyncSinkMessage(std::move(reply.message));
+            }
+        }();
+
+        // Carry on from the continuation if the reply hasn't been sent yet, rather than waiting.
+        if (!sunk.isReady()) {
+            return std::move(sunk).getAsync([ssm = shared_from_this()](Status status) {
+                ssm->_sinkPipelinedReplies(std::move(status));
+            });
+        }
+
+        lastSinkStatus = sunk.getNoThrow();
+        lk = stdx::unique_lock<stdx::mutex>(pipeline.mutex);
+    }
+}
+
 void ServiceStateMachine::runNext() {
     return _runNextInGuard(ThreadGuard(this));
 }
@@ -534,6 +871,22 @@ void ServiceStateMachine::_terminateAndLogIfError(Status status) {
 }
 
 void ServiceStateMachine::_cleanupSession(ThreadGuard guard) {
+    // Pipelined requests use the Session and the Client of the connection until they finish. End
+    // the Session first, so that none of them stays blocked sinking its reply.
+    if (_pipeline) {
+        _state.store(State::EndSession);
+        _session()->end();
+        if (!_waitForPipeline(guard, PipelineWait::kDrained)) {
+            return;
+        }
+
+        if (_pipeline->workers) {
+            _pipeline->workers->shutdown();
+            _pipeline->workers->join();
+        }
+        _pipeline->idleClients.clear();
+    }
+
     _state.store(State::Ended);
 
     _inMessage.reset();
@@ -74,6 +74,8 @@ public:
                         transport::SessionHandle session,
                         transport::Mode transportMode);
 
+    ~ServiceStateMachine();
+
     /*
      * Any state may transition to EndSession in case of an error, otherwise the valid state
      * transitions are:
@@ -158,6 +160,21 @@ private:
     class ThreadGuard;
     friend class ThreadGuard;
 
+    /*
+     * The requests that run concurrently with the ServiceStateMachine once the client has
+     * negotiated pipelining, and their replies.
+     */
+    struct Pipeline;
+
+    /*
+     * What the ServiceStateMachine waits for before it can handle the current message.
+     */
+    enum class PipelineWait {
+        kNone,
+        kRoom,     // Fewer pipelined requests whose replies are unsent than the client may have
+        kDrained,  // No pipelined requests in flight, and all of their replies sunk
+    };
+
     /*
      * Terminates the associated transport Session if status indicate error.
      *
@@ -213,6 +230,39 @@ private:
      */
     void _cleanupSession(ThreadGuard guard);
 
+    /*
+     * Returns true if the pipeline is in the state 'what' describes. Otherwise, the synchronous
+     * transport blocks until it is, while the asynchronous transport releases the ThreadGuard and
+     * returns false; the pipelined request which ends the wait reschedules the current state.
+     */
+    bool _waitForPipeline(ThreadGuard& guard, PipelineWait what);
+    bool _pipelineReady_inlock(PipelineWait what) const;
+
+    /*
+     * Wakes up or reschedules the ServiceStateMachine if the pipeline state it waits for has been
+     * reached. 'lk' must hold the pipeline's mutex.
+     */
+    void _notifyPipelineWaiter(stdx::unique_lock<stdx::mutex> lk);
+
+    /*
+     * Hands the current message off to run concurrently with the ServiceStateMachine, which goes
+     * back to sourcing the next one right away.
+     */
+    void _dispatchPipelinedMessage(ThreadGuard guard);
+
+    /*
+     * Runs a pipelined request on a Client of its own, and queues its reply to be sunk.
+     */
+    void _processPipelinedMessage(const Message& request,
+                                  boost::optional<MessageCompressorId> compressorId);
+
+    /*
+     * Sinks the queued replies of pipelined requests in the order they were queued, until there
+     * are none left. Only one thread does this at a time; 'lastSinkStatus' is the outcome of the
+     * previous asynchronous sink when this continues from it.
+     */
+    void _sinkPipelinedReplies(Status lastSinkStatus = Status::OK());
+
     AtomicWord<State> _state{State::Created};
 
     ServiceEntryPoint* _sep;
@@ -223,13 +273,15 @@ private:
     transport::SessionHandle _sessionHandle;
     const std::string _threadName;
     ServiceContext::UniqueClient _dbClient;
-    const Client* _dbClientPtr;
+    Client* const _dbClientPtr;
     stdx::function<void()> _cleanupHook;
 
     bool _inExhaust = false;
     boost::optional<MessageCompressorId> _compressorId;
     Message _inMessage;
 
+    std::unique_ptr<Pipeline> _pipeline;
+
     AtomicWord<Ownership> _owned{Ownership::kUnowned};
 #if MONGO_CONFIG_DEBUG_BUILD
     AtomicWord<stdx::thread::id> _owningThread;
@@ -0,0 +1,294 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/command_generic_argument.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/logical_session_id.h"
+#include "mongo/db/query/query_request.h"
+#include "mongo/db/repl/read_concern_args.h"
+#include "mongo/db/service_context.h"
+#include "mongo/rpc/metadata.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/transport/mock_session.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/transport/service_state_machine.h"
+#include "mongo/transport/transport_layer_mock.h"
+#include "mongo/util/clock_source_mock.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/tick_source_mock.h"
+
+namespace mongo {
+namespace {
+
+using namespace transport;
+
+/**
+ * How the entry point finds the generic arguments of a request.
+ */
+enum class Decode {
+    // One lookup per argument, as execCommandDatabase did before GenericArguments.
+    kPerArgument,
+    // A single pass with GenericArguments::parse(), as execCommandDatabase does now.
+    kSinglePass,
+};
+
+/**
+ * Does the command-independent work of dispatching a request: reading the request metadata, the
+ * database, maxTimeMS and readConcern. Answers every request with a single-document find reply.
+ */
+class BenchmarkSEP : public ServiceEntryPoint {
+public:
+    explicit BenchmarkSEP(Decode decode) : _decode(decode) {}
+
+    void startSession(SessionHandle session) override {}
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& message) override {
+        const auto request = OpMsgRequest::parse(message);
+        invariant(_commands.find(request.getCommandName()) != _commands.end());
+
+        if (_decode == Decode::kSinglePass) {
+            decodeSinglePass(opCtx, request);
+        } else {
+            decodePerArgument(opCtx, request);
+        }
+
+        OpMsgBuilder builder;
+        {
+            auto body = builder.beginBody();
+            BSONObjBuilder cursor(body.subobjStart("cursor"));
+            cursor.append("firstBatch", BSON_ARRAY(BSON("_id" << 1 << "x" << 1)));
+            cursor.append("id", 0LL);
+            cursor.append("ns", "test.coll");
+            cursor.doneFast();
+            body.append("ok", 1.0);
+        }
+
+        _handled++;
+        return DbResponse{builder.finish()};
+    }
+
+    void endAllSessions(Session::TagMask tags) override {}
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    Stats sessionStats() const override {
+        return {};
+    }
+
+    size_t numOpenSessions() const override {
+        return 0;
+    }
+
+    int64_t handled() const {
+        return _handled;
+    }
+
+private:
+    static void decodePerArgument(OperationContext* opCtx, const OpMsgRequest& request) {
+        rpc::readRequestMetadata(opCtx, request.body, true);
+        benchmark::DoNotOptimize(request.body.hasField("customerCmd"));
+        benchmark::DoNotOptimize(request.getDatabase());
+
+        BSONElement cmdOptionMaxTimeMSField;
+        BSONElement allowImplicitCollectionCreationField;
+        BSONElement helpField;
+
+        StringMap<int> topLevelFields;
+        for (auto&& element : request.body) {
+            StringData fieldName = element.fieldNameStringData();
+            if (fieldName == QueryRequest::cmdOptionMaxTimeMS) {
+                cmdOptionMaxTimeMSField = element;
+            } else if (fieldName == "allowImplicitCollectionCreation") {
+                allowImplicitCollectionCreationField = element;
+            } else if (fieldName == "help") {
+                helpField = element;
+            } else if (fieldName == QueryRequest::queryOptionMaxTimeMS) {
+                uasserted(ErrorCodes::InvalidOptions,
+                          "no such command option $maxTimeMs; use maxTimeMS instead");
+            }
+
+            uassert(ErrorCodes::FailedToParse,
+                    str::stream() << "Parsed command object contains duplicate top level key: "
+                                  << fieldName,
+                    topLevelFields[fieldName]++ == 0);
+        }
+        benchmark::DoNotOptimize(allowImplicitCollectionCreationField);
+        benchmark::DoNotOptimize(helpField);
+
+        benchmark::DoNotOptimize(
+            uassertStatusOK(QueryRequest::parseMaxTimeMS(cmdOptionMaxTimeMSField)));
+
+        repl::ReadConcernArgs readConcernArgs;
+        uassertStatusOK(readConcernArgs.initialize(request.body));
+        benchmark::DoNotOptimize(readConcernArgs);
+    }
+
+    static void decodeSinglePass(OperationContext* opCtx, const OpMsgRequest& request) {
+        const auto genericArgs = GenericArguments::parse(request.body);
+        uassert(ErrorCodes::InvalidOptions,
+                "no such command option $maxTimeMs; use maxTimeMS instead",
+                !genericArgs.queryOptionMaxTimeMS);
+
+        rpc::readRequestMetadata(opCtx, genericArgs, true);
+        benchmark::DoNotOptimize(genericArgs.customerCmd);
+        benchmark::DoNotOptimize(request.getDatabase());
+        benchmark::DoNotOptimize(genericArgs.allowImplicitCollectionCreation);
+        benchmark::DoNotOptimize(genericArgs.help);
+
+        benchmark::DoNotOptimize(
+            uassertStatusOK(QueryRequest::parseMaxTimeMS(genericArgs.maxTimeMS)));
+
+        repl::ReadConcernArgs readConcernArgs;
+        uassertStatusOK(readConcernArgs.initialize(genericArgs.readConcern));
+        benchmark::DoNotOptimize(readConcernArgs);
+    }
+
+    const Decode _decode;
+    const StringMap<int> _commands = {{"find", 1}, {"insert", 1}, {"getMore", 1}, {"ping", 1}};
+    int64_t _handled = 0;
+};
+
+/**
+ * Sources the same request over and over again and drops the replies.
+ */
+class BenchmarkTL : public TransportLayerMock {
+public:
+    class Session : public MockSession {
+    public:
+        using MockSession::MockSession;
+
+        StatusWith<Message> sourceMessage() override {
+            auto status = MockSession::sourceMessage();
+            if (status.isOK()) {
+                status.getValue() = checked_cast<BenchmarkTL*>(getTransportLayer())->_request;
+            }
+            return status;
+        }
+    };
+
+    explicit BenchmarkTL(Message request) : _request(std::move(request)) {
+        createSessionHook = [](TransportLayer* tl) { return std::make_shared<Session>(tl); };
+    }
+
+private:
+    const Message _request;
+};
+
+/**
+ * Leaves each task to the next call to ServiceStateMachine::runNext().
+ */
+class InlineServiceExecutor : public ServiceExecutor {
+public:
+    Status start() override {
+        return Status::OK();
+    }
+
+    Status shutdown(Milliseconds timeout) override {
+        return Status::OK();
+    }
+
+    Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) override {
+        return Status::OK();
+    }
+
+    Mode transportMode() const override {
+        return Mode::kSynchronous;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const override {}
+};
+
+/**
+ * Returns a point read by _id of about 100 bytes, with the generic arguments a driver sends.
+ */
+Message makePointRead() {
+    OpMsgBuilder builder;
+    auto body = builder.beginBody();
+    body.append("find", "coll");
+    body.append("filter", BSON("_id" << 1));
+    body.append("limit", 1);
+    body.append("singleBatch", true);
+    body.append("lsid", makeLogicalSessionIdForTest().toBSON());
+    body.append("$readPreference", BSON("mode" << "primaryPreferred"));
+    body.append("$db", "test");
+    body.doneFast();
+    return builder.finish();
+}
+
+void BM_IngressPointRead(benchmark::State& state) {
+    const auto decode = static_cast<Decode>(state.range(0));
+
+    auto serviceContext = ServiceContext::make();
+    serviceContext->setTickSource(stdx::make_unique<TickSourceMock>());
+    serviceContext->setFastClockSource(stdx::make_unique<ClockSourceMock>());
+
+    auto sep = stdx::make_unique<BenchmarkSEP>(decode);
+    auto sepPtr = sep.get();
+    serviceContext->setServiceEntryPoint(std::move(sep));
+    serviceContext->setServiceExecutor(stdx::make_unique<InlineServiceExecutor>());
+
+    auto tl = stdx::make_unique<BenchmarkTL>(makePointRead());
+    auto tlPtr = tl.get();
+    serviceContext->setTransportLayer(std::move(tl));
+    invariant(tlPtr->start());
+
+    auto ssm = ServiceStateMachine::create(
+        serviceContext.get(), tlPtr->createSession(), Mode::kSynchronous);
+
+    for (auto _ : state) {
+        // Source, process and sink one request.
+        const auto handled = sepPtr->handled();
+        while (sepPtr->handled() == handled ||
+               ssm->state() != ServiceStateMachine::State::Source) {
+            ssm->runNext();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+
+    ssm->terminate();
+    tlPtr->shutdown();
+}
+
+BENCHMARK(BM_IngressPointRead)
+    ->Arg(static_cast<int>(Decode::kPerArgument))
+    ->Arg(static_cast<int>(Decode::kSinglePass));
+
+}  // namespace
+}  // namespace mongo
@@ -30,15 +30,22 @@
 
 #include "mongo/platform/basic.h"
 
+#include <deque>
+#include <set>
+
 #include "mongo/base/checked_cast.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/client.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/db/server_parameters_test_util.h"
 #include "mongo/db/service_context.h"
 #include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/transport/mock_session.h"
+#include "mongo/transport/request_pipelining.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor.h"
 #include "mongo/transport/service_executor_task_names.h"
@@ -47,6 +54,10 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/concurrency/notification.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/future.h"
 #include "mongo/util/log.h"
 #include "mongo/util/tick_source_mock.h"
 
@@ -69,8 +80,14 @@ public:
         _ranHandler = true;
         ASSERT_TRUE(haveClient());
 
+        _lastRequestId = request.header().getId();
+
         auto req = OpMsgRequest::parse(request);
-        ASSERT_BSONOBJ_EQ(BSON("ping" << 1), req.body);
+        if (OpMsg::isFlagSet(request, OpMsg::kExhaustAllowed)) {
+            ASSERT_BSONOBJ_EQ(BSON("getMore" << 1), req.body);
+        } else {
+            ASSERT_BSONOBJ_EQ(BSON("ping" << 1), req.body);
+        }
 
         // Build out a dummy reply
         OpMsgBuilder builder;
@@ -79,7 +96,13 @@ public:
         if (_uassertInHandler)
             uassert(40469, "Synthetic uassert failure", false);
 
-        return DbResponse{builder.finish()};
+        DbResponse dbResponse{builder.finish()};
+        if (_exhaustBatches > 0) {
+            --_exhaustBatches;
+            dbResponse.nextInvocation = BSON("getMore" << 1);
+        }
+
+        return dbResponse;
     }
 
     void endAllSessions(transport::Session::TagMask tags) override {}
@@ -100,6 +123,14 @@ public:
         _uassertInHandler = true;
     }
 
+    void setExhaustBatches(int exhaustBatches) {
+        _exhaustBatches = exhaustBatches;
+    }
+
+    int32_t lastRequestId() const {
+        return _lastRequestId;
+    }
+
     bool ranHandler() {
         bool ret = _ranHandler;
         _ranHandler = false;
@@ -109,6 +140,8 @@ public:
 private:
     bool _uassertInHandler = false;
     bool _ranHandler = false;
+    int _exhaustBatches = 0;
+    int32_t _lastRequestId = 0;
 };
 
 using namespace transport;
@@ -339,6 +372,28 @@ TEST_F(ServiceStateMachineFixture, TestOkaySimpleCommand) {
     checkPingOk();
 }
 
+TEST_F(ServiceStateMachineFixture, TestOpMsgExhaust) {
+    _sep->setExhaustBatches(2);
+
+    runPingTest(State::Process, State::Process);
+    auto reply = _tl->getLastSunk();
+    ASSERT_TRUE(OpMsg::isFlagSet(reply, OpMsg::kMoreToCome));
+
+    // Each batch is produced without sourcing a request, in response to the previous reply
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Process);
+    ASSERT_EQ(reply.header().getId(), _sep->lastRequestId());
+    reply = _tl->getLastSunk();
+    ASSERT_TRUE(OpMsg::isFlagSet(reply, OpMsg::kMoreToCome));
+
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Source);
+    ASSERT_EQ(reply.header().getId(), _sep->lastRequestId());
+    reply = _tl->getLastSunk();
+    ASSERT_FALSE(OpMsg::isFlagSet(reply, OpMsg::kMoreToCome));
+    ASSERT_BSONOBJ_EQ(OpMsg::parse(reply).body, BSON("ok" << 1));
+}
+
 TEST_F(ServiceStateMachineFixture, TestThrowHandling) {
     _sep->setUassertInHandler();
 
@@ -572,5 +627,571 @@ TEST_F(ServiceStateMachineFixture, SSMRunsRecursively) {
     ASSERT_EQ(_ssm->state(), State::Ended);
 }
 
+
+/**
+ * Negotiates pipelining in isMaster, and runs every other request until the test releases it by
+ * the request's "n". Replies carry the "n" of their request.
+ */
+class PipeliningSEP : public ServiceEntryPoint {
+public:
+    void startSession(transport::SessionHandle session) override {}
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        auto req = OpMsgRequest::parse(request);
+        BSONObjBuilder reply;
+        if (req.getCommandName() == "isMaster") {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            _isMasterRanConcurrently = _isMasterRanConcurrently || _running > 0;
+            transport::negotiatePipelining(opCtx->getClient()->session(), req.body, &reply);
+        } else {
+            const int n = req.body["n"].numberInt();
+            if (_onStart) {
+                _onStart(n);
+            }
+
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            ++_running;
+            _started.insert(n);
+            _cv.notify_all();
+            _cv.wait(lk, [&] { return _releaseAll || _released.count(n); });
+            --_running;
+            reply.append("n", n);
+        }
+        reply.append("ok", 1);
+
+        OpMsgBuilder builder;
+        builder.setBody(reply.obj());
+        return DbResponse{builder.finish()};
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {}
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    Stats sessionStats() const override {
+        return {};
+    }
+
+    size_t numOpenSessions() const override {
+        return 0ULL;
+    }
+
+    void waitForStarted(int n) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return _started.count(n); });
+    }
+
+    void release(int n) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _released.insert(n);
+        _cv.notify_all();
+    }
+
+    void releaseAll() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _releaseAll = true;
+        _cv.notify_all();
+    }
+
+    bool isMasterRanConcurrently() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _isMasterRanConcurrently;
+    }
+
+    /**
+     * Sets a hook to call with the "n" of each request as it starts, before the first request.
+     */
+    void setOnStart(stdx::function<void(int)> onStart) {
+        _onStart = std::move(onStart);
+    }
+
+private:
+    stdx::function<void(int)> _onStart;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    std::set<int> _started;
+    std::set<int> _released;
+    bool _releaseAll = false;
+    int _running = 0;
+    bool _isMasterRanConcurrently = false;
+};
+
+/**
+ * A session which can sink while sourcing, on which the test plays the client. The test sends
+ * requests with send() and reads the replies with waitForReply(). It can also hold up the sinking
+ * of replies, as a client which doesn't read them would.
+ *
+ * Asynchronous operations complete on 'networkThreads' rather than on the thread which completes
+ * them, as they would with a real transport layer.
+ */
+class PipeliningSession : public MockSession {
+public:
+    PipeliningSession(TransportLayer* tl, ThreadPool* networkThreads)
+        : MockSession(tl), _networkThreads(networkThreads) {}
+
+    bool canSinkWhileSourcing() const override {
+        return true;
+    }
+
+    StatusWith<Message> sourceMessage() override {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return _ended || !_incoming.empty(); });
+        if (_ended) {
+            return TransportLayer::TicketSessionClosedStatus;
+        }
+        return _popIncoming(lk);
+    }
+
+    Future<Message> asyncSourceMessage(const transport::BatonHandle& baton = nullptr) override {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        if (_ended) {
+            return TransportLayer::TicketSessionClosedStatus;
+        }
+        if (!_incoming.empty()) {
+            return _popIncoming(lk);
+        }
+
+        invariant(!_pendingSource);
+        auto pf = makePromiseFuture<Message>();
+        _pendingSource.emplace(std::move(pf.promise));
+        return std::move(pf.future);
+    }
+
+    Status sinkMessage(Message message) override {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        if (_holdSinks) {
+            _sinkHeld = true;
+            _cv.notify_all();
+            _cv.wait(lk, [&] { return !_holdSinks; });
+            _sinkHeld = false;
+            if (!_heldSinkStatus.isOK()) {
+                return _heldSinkStatus;
+            }
+        }
+
+        _sunk.push_back(std::move(message));
+        _cv.notify_all();
+        return Status::OK();
+    }
+
+    Future<void> asyncSinkMessage(Message message,
+                                  const transport::BatonHandle& baton = nullptr) override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_holdSinks) {
+            invariant(!_heldSink);
+            _sinkHeld = true;
+            _cv.notify_all();
+
+            auto pf = makePromiseFuture<void>();
+            _heldSink.emplace(HeldSink{std::move(message), std::move(pf.promise)});
+            return std::move(pf.future);
+        }
+
+        _sunk.push_back(std::move(message));
+        _cv.notify_all();
+        return Future<void>::makeReady();
+    }
+
+    void end() override {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _ended = true;
+        _cv.notify_all();
+        if (_pendingSource) {
+            _complete(lk, [promise = _takePendingSource().share()]() mutable {
+                promise.setError(TransportLayer::TicketSessionClosedStatus);
+            });
+        }
+    }
+
+    /**
+     * Sends a request with the given body and returns its message id.
+     */
+    int32_t send(const BSONObj& body) {
+        OpMsgBuilder builder;
+        builder.setBody(body);
+        auto request = builder.finish();
+        const auto id = nextMessageId();
+        request.header().setId(id);
+
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        if (_pendingSource) {
+            _complete(lk, [ promise = _takePendingSource().share(), request ]() mutable {
+                promise.emplaceValue(request);
+            });
+        } else {
+            _incoming.push_back(std::move(request));
+            _cv.notify_all();
+        }
+        return id;
+    }
+
+    Message waitForReply() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return !_sunk.empty(); });
+        auto reply = std::move(_sunk.front());
+        _sunk.pop_front();
+        ++_repliesRead;
+        return reply;
+    }
+
+    /**
+     * Returns the number of replies sunk so far, whether the test has read them or not.
+     */
+    size_t numSunk() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        return _repliesRead + _sunk.size();
+    }
+
+    void holdSinks() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _holdSinks = true;
+    }
+
+    void waitForHeldSink() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cv.wait(lk, [&] { return _sinkHeld; });
+    }
+
+    /**
+     * Stops holding up sinks. The sink which is being held, if any, completes with 'status'.
+     */
+    void releaseSinks(Status status = Status::OK()) {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _holdSinks = false;
+        _heldSinkStatus = status;
+        _cv.notify_all();
+
+        if (!_heldSink) {
+            return;
+        }
+
+        auto held = std::move(*_heldSink);
+        _heldSink = boost::none;
+        _sinkHeld = false;
+        if (status.isOK()) {
+            _sunk.push_back(std::move(held.message));
+        }
+        _complete(lk, [ promise = held.promise.share(), status ]() mutable {
+            if (status.isOK()) {
+                promise.emplaceValue();
+            } else {
+                promise.setError(status);
+            }
+        });
+    }
+
+private:
+    struct HeldSink {
+        Message message;
+        Promise<void> promise;
+    };
+
+    Message _popIncoming(WithLock) {
+        auto message = std::move(_incoming.front());
+        _incoming.pop_front();
+        return message;
+    }
+
+    Promise<Message> _takePendingSource() {
+        auto promise = std::move(*_pendingSource);
+        _pendingSource = boost::none;
+        return promise;
+    }
+
+    void _complete(stdx::unique_lock<stdx::mutex>& lk, ThreadPool::Task task) {
+        lk.unlock();
+        invariant(_networkThreads->schedule(std::move(task)));
+    }
+
+    ThreadPool* const _networkThreads;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+    bool _ended = false;
+
+    std::deque<Message> _incoming;
+    boost::optional<Promise<Message>> _pendingSource;
+
+    std::deque<Message> _sunk;
+    size_t _repliesRead = 0;
+    bool _holdSinks = false;
+    bool _sinkHeld = false;
+    Status _heldSinkStatus = Status::OK();
+    boost::optional<HeldSink> _heldSink;
+};
+
+/**
+ * Runs every task on a thread pool, whichever transport mode it reports.
+ */
+class ThreadPoolServiceExecutor : public ServiceExecutor {
+public:
+    explicit ThreadPoolServiceExecutor(Mode mode) : _mode(mode), _pool([] {
+        ThreadPool::Options options;
+        options.poolName = "ThreadPoolServiceExecutor";
+        options.minThreads = 0;
+        options.maxThreads = 16;
+        return options;
+    }()) {}
+
+    Status start() override {
+        _pool.startup();
+        return Status::OK();
+    }
+
+    Status shutdown(Milliseconds timeout) override {
+        _pool.shutdown();
+        _pool.join();
+        return Status::OK();
+    }
+
+    Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) override {
+        return _pool.schedule(std::move(task));
+    }
+
+    Mode transportMode() const override {
+        return _mode;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const override {}
+
+private:
+    const Mode _mode;
+    ThreadPool _pool;
+};
+
+class ServiceStateMachinePipeliningTest : public unittest::Test {
+protected:
+    /**
+     * Starts a ServiceStateMachine in the given transport mode, and negotiates pipelining with
+     * up to 'maxPipelined' requests in flight.
+     */
+    void start(transport::Mode mode, int maxPipelined = 4) {
+        auto scOwned = ServiceContext::make();
+        auto sc = scOwned.get();
+        setGlobalServiceContext(std::move(scOwned));
+
+        auto sep = stdx::make_unique<PipeliningSEP>();
+        _sep = sep.get();
+        sc->setServiceEntryPoint(std::move(sep));
+
+        auto se = stdx::make_unique<ThreadPoolServiceExecutor>(mode);
+        _sexec = se.get();
+        sc->setServiceExecutor(std::move(se));
+        ASSERT_OK(_sexec->start());
+
+        _networkThreads.startup();
+        auto tl = stdx::make_unique<TransportLayerMock>();
+        tl->createSessionHook = [this](TransportLayer* transportLayer) {
+            return std::make_shared<PipeliningSession>(transportLayer, &_networkThreads);
+        };
+        _session = std::static_pointer_cast<PipeliningSession>(tl->createSession());
+        sc->setTransportLayer(std::move(tl));
+
+        _ssm = ServiceStateMachine::create(sc, _session, mode);
+        _ssm->setCleanupHook([this] { _ended.set(); });
+        _ssm->start(ServiceStateMachine::Ownership::kOwned);
+
+        _session->send(BSON("isMaster" << 1 << "pipelining" << maxPipelined));
+        auto reply = OpMsg::parse(_session->waitForReply()).body;
+        ASSERT_EQ(reply["pipelining"].numberInt(), maxPipelined);
+    }
+
+    void tearDown() override {
+        if (!_ssm) {
+            return;
+        }
+
+        _sep->releaseAll();
+        _session->releaseSinks();
+        _ssm->terminate();
+        _ended.get();
+
+        ASSERT_OK(_sexec->shutdown(Seconds(10)));
+        _networkThreads.shutdown();
+        _networkThreads.join();
+    }
+
+    int32_t sendBlocking(int n) {
+        return _session->send(BSON("block" << 1 << "n" << n));
+    }
+
+    void assertReply(const Message& reply, int32_t requestId, int n) {
+        ASSERT_EQ(reply.header().getResponseToMsgId(), requestId);
+        ASSERT_EQ(OpMsg::parse(reply).body["n"].numberInt(), n);
+    }
+
+    void runRepliesMatchedByResponseTo(transport::Mode mode);
+    void runNonPipelinedCommandWaitsForPipeline(transport::Mode mode);
+    void runUnsentRepliesCountAgainstLimit(transport::Mode mode);
+    void runFailedSinkDropsQueuedReplies(transport::Mode mode);
+    void runSessionEndWaitsForRequestsInFlight(transport::Mode mode);
+
+    ServerParameterControllerForTest _maxPipelined{"maxPipelinedRequestsPerConnection", "4"};
+
+    ThreadPool _networkThreads{[] {
+        ThreadPool::Options options;
+        options.poolName = "PipeliningSessionNetwork";
+        options.minThreads = 0;
+        return options;
+    }()};
+
+    PipeliningSEP* _sep = nullptr;
+    ThreadPoolServiceExecutor* _sexec = nullptr;
+    std::shared_ptr<PipeliningSession> _session;
+    std::shared_ptr<ServiceStateMachine> _ssm;
+    Notification<void> _ended;
+};
+
+void ServiceStateMachinePipeliningTest::runRepliesMatchedByResponseTo(transport::Mode mode) {
+    start(mode);
+
+    auto first = sendBlocking(1);
+    auto second = sendBlocking(2);
+    _sep->waitForStarted(1);
+    _sep->waitForStarted(2);
+
+    // Each reply is sent as soon as its request finishes, whatever order they were sent in.
+    _sep->release(2);
+    assertReply(_session->waitForReply(), second, 2);
+    _sep->release(1);
+    assertReply(_session->waitForReply(), first, 1);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, RepliesMatchedByResponseToSynchronous) {
+    runRepliesMatchedByResponseTo(transport::Mode::kSynchronous);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, RepliesMatchedByResponseToAsynchronous) {
+    runRepliesMatchedByResponseTo(transport::Mode::kAsynchronous);
+}
+
+void ServiceStateMachinePipeliningTest::runNonPipelinedCommandWaitsForPipeline(
+    transport::Mode mode) {
+    start(mode);
+
+    auto pipelined = sendBlocking(1);
+    _sep->waitForStarted(1);
+    auto isMaster = _session->send(BSON("isMaster" << 1));
+
+    _sep->release(1);
+    assertReply(_session->waitForReply(), pipelined, 1);
+
+    auto reply = _session->waitForReply();
+    ASSERT_EQ(reply.header().getResponseToMsgId(), isMaster);
+    ASSERT_FALSE(_sep->isMasterRanConcurrently());
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, NonPipelinedCommandWaitsForPipelineSynchronous) {
+    runNonPipelinedCommandWaitsForPipeline(transport::Mode::kSynchronous);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, NonPipelinedCommandWaitsForPipelineAsynchronous) {
+    runNonPipelinedCommandWaitsForPipeline(transport::Mode::kAsynchronous);
+}
+
+void ServiceStateMachinePipeliningTest::runUnsentRepliesCountAgainstLimit(transport::Mode mode) {
+    start(mode, 2);
+
+    size_t sunkWhenThirdStarted = 0;
+    _sep->setOnStart([&](int n) {
+        if (n == 3) {
+            sunkWhenThirdStarted = _session->numSunk();
+        }
+    });
+    const auto sunkBefore = _session->numSunk();
+
+    // The client stops reading replies, so the first one is stuck being sent and the second one
+    // is queued behind it. Neither request is in flight anymore, but the third one still has to
+    // wait for a reply to go out.
+    _session->holdSinks();
+    auto first = sendBlocking(1);
+    auto second = sendBlocking(2);
+    _sep->waitForStarted(1);
+    _sep->waitForStarted(2);
+    _sep->release(1);
+    _session->waitForHeldSink();
+    _sep->release(2);
+    auto third = sendBlocking(3);
+
+    _session->releaseSinks();
+    _sep->waitForStarted(3);
+    ASSERT_GT(sunkWhenThirdStarted, sunkBefore);
+
+    _sep->release(3);
+    assertReply(_session->waitForReply(), first, 1);
+    assertReply(_session->waitForReply(), second, 2);
+    assertReply(_session->waitForReply(), third, 3);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, UnsentRepliesCountAgainstLimitSynchronous) {
+    runUnsentRepliesCountAgainstLimit(transport::Mode::kSynchronous);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, UnsentRepliesCountAgainstLimitAsynchronous) {
+    runUnsentRepliesCountAgainstLimit(transport::Mode::kAsynchronous);
+}
+
+void ServiceStateMachinePipeliningTest::runFailedSinkDropsQueuedReplies(transport::Mode mode) {
+    start(mode);
+
+    _session->holdSinks();
+    for (int n = 1; n <= 3; ++n) {
+        sendBlocking(n);
+        _sep->waitForStarted(n);
+    }
+
+    _sep->release(1);
+    _session->waitForHeldSink();
+    _sep->release(2);
+    _sep->release(3);
+    _session->releaseSinks(Status(ErrorCodes::HostUnreachable, "Connection reset by client"));
+
+    // The connection is closed, and the replies of the other requests are never sent, whether
+    // they were queued before the sink failed or after.
+    _ended.get();
+    ASSERT_EQ(_ssm->state(), State::Ended);
+    ASSERT_EQ(_session->numSunk(), 1U);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, FailedSinkDropsQueuedRepliesSynchronous) {
+    runFailedSinkDropsQueuedReplies(transport::Mode::kSynchronous);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, FailedSinkDropsQueuedRepliesAsynchronous) {
+    runFailedSinkDropsQueuedReplies(transport::Mode::kAsynchronous);
+}
+
+void ServiceStateMachinePipeliningTest::runSessionEndWaitsForRequestsInFlight(
+    transport::Mode mode) {
+    start(mode);
+
+    sendBlocking(1);
+    sendBlocking(2);
+    _sep->waitForStarted(1);
+    _sep->waitForStarted(2);
+
+    // The client goes away while both requests run. The ServiceStateMachine can't finish until
+    // they have, since they use the connection's Session and Client.
+    _session->end();
+    ASSERT_FALSE(_ended);
+
+    _sep->release(1);
+    ASSERT_FALSE(_ended);
+    _sep->release(2);
+    _ended.get();
+    ASSERT_EQ(_ssm->state(), State::Ended);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, SessionEndWaitsForRequestsInFlightSynchronous) {
+    runSessionEndWaitsForRequestsInFlight(transport::Mode::kSynchronous);
+}
+
+TEST_F(ServiceStateMachinePipeliningTest, SessionEndWaitsForRequestsInFlightAsynchronous) {
+    runSessionEndWaitsForRequestsInFlight(transport::Mode::kAsynchronous);
+}
+
 }  // namespace
 }  // namespace mongo
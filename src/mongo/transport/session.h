@@ -142,6 +142,14 @@ public:
      */
     virtual bool isConnected() = 0;
 
+    /**
+     * Returns whether a Message may be sunk on this Session while another thread is sourcing one,
+     * which pipelined requests rely on.
+     */
+    virtual bool canSinkWhileSourcing() const {
+        return false;
+    }
+
     virtual const HostAndPort& remote() const = 0;
     virtual const HostAndPort& local() const = 0;
 
@@ -139,7 +139,7 @@ public:
     Status sinkMessage(Message message) override {
         ensureSync();
 
-        return write(asio::buffer(message.buf(), message.size()))
+        return writeMessage(message)
             .then([this, &message] {
                 if (_isIngressSession) {
                     networkCounter.hitPhysicalOut(message.size());
@@ -151,7 +151,7 @@ public:
     Future<void> asyncSinkMessage(Message message,
                                   const transport::BatonHandle& baton = nullptr) override {
         ensureAsync();
-        return write(asio::buffer(message.buf(), message.size()), baton)
+        return writeMessage(message, baton)
             .then([this, message /*keep the buffer alive*/]() {
                 if (_isIngressSession) {
                     networkCounter.hitPhysicalOut(message.size());
@@ -205,6 +205,15 @@ public:
         return false;
     }
 
+    bool canSinkWhileSourcing() const override {
+#ifdef MONGO_CONFIG_SSL
+        // An SSL stream can't read and write from different threads at once.
+        return !_sslSocket;
+#else
+        return true;
+#endif
+    }
+
 protected:
     friend class TransportLayerASIO;
     friend TransportLayerASIO::BatonASIO;
@@ -411,6 +420,61 @@ private:
         return opportunisticRead(_socket, buffers, baton);
     }
 
+    /**
+     * A ConstBufferSequence over the buffers of a segmented message. Like asio::const_buffer, it
+     * can be advanced past the bytes which have already been written.
+     */
+    class MessageBuffers {
+    public:
+        using value_type = asio::const_buffer;
+        using const_iterator = std::vector<asio::const_buffer>::const_iterator;
+
+        explicit MessageBuffers(const Message& message) {
+            _buffers.reserve(message.segments().size() + 1);
+            _buffers.emplace_back(message.firstSegment().view2ptr(), message.firstSegmentSize());
+            for (auto&& segment : message.segments()) {
+                _buffers.emplace_back(segment.data, segment.size);
+            }
+        }
+
+        const_iterator begin() const {
+            return _buffers.begin() + _first;
+        }
+
+        const_iterator end() const {
+            return _buffers.end();
+        }
+
+        MessageBuffers& operator+=(std::size_t bytes) {
+            while (bytes > 0) {
+                auto& buffer = _buffers[_first];
+                if (bytes < buffer.size()) {
+                    buffer += bytes;
+                    break;
+                }
+                bytes -= buffer.size();
+                ++_first;
+            }
+            return *this;
+        }
+
+    private:
+        std::vector<asio::const_buffer> _buffers;
+        std::size_t _first = 0;
+    };
+
+    /**
+     * Writes a message. A segmented message is sent with gather writes rather than being copied
+     * into a single buffer first.
+     */
+    Future<void> writeMessage(const Message& message,
+                              const transport::BatonHandle& baton = nullptr) {
+        if (message.isSegmented()) {
+            return write(MessageBuffers(message), baton);
+        }
+        return write(asio::buffer(message.buf(), message.size()), baton);
+    }
+
     template <typename ConstBufferSequence>
     Future<void> write(const ConstBufferSequence& buffers,
                        const transport::BatonHandle& baton = nullptr) {
@@ -522,14 +586,14 @@ private:
 
         if (MONGO_FAIL_POINT(transportLayerASIOshortOpportunisticReadWrite) &&
             _blockingMode == Async) {
-            asio::const_buffer localBuffer = buffers;
+            asio::const_buffer localBuffer = *asio::buffer_sequence_begin(buffers);
 
-            if (buffers.size()) {
-                localBuffer = asio::const_buffer(buffers.data(), 1);
+            if (localBuffer.size()) {
+                localBuffer = asio::const_buffer(localBuffer.data(), 1);
             }
 
             size = asio::write(stream, localBuffer, ec);
-            if (!ec && buffers.size() > 1) {
+            if (!ec && asio::buffer_size(buffers) > 1) {
                 ec = asio::error::would_block;
             }
         } else {
@@ -0,0 +1,308 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <benchmark/benchmark.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "mongo/config.h"
+#include "mongo/db/server_options.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_layer_asio.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
+
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+#include "mongo/transport/transport_layer_io_uring.h"
+#endif
+
+namespace mongo {
+namespace {
+
+// The number of threads which run the transport layer's ingress reactor, standing in for the
+// adaptive ServiceExecutor's workers.
+const int kReactorThreads = 4;
+
+// The number of client threads. Each one owns an equal share of the connections.
+const int kClientThreads = 8;
+
+/**
+ * Echoes every message on every session back to its sender, sourcing and sinking asynchronously
+ * on the transport layer's ingress reactor.
+ */
+class EchoSEP : public ServiceEntryPoint {
+public:
+    void startSession(transport::SessionHandle session) override {
+        _echo(std::move(session));
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {}
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    Stats sessionStats() const override {
+        return {};
+    }
+
+    size_t numOpenSessions() const override {
+        return 0;
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+private:
+    void _echo(transport::SessionHandle session) {
+        session->asyncSourceMessage()
+            .then([session](Message msg) { return session->asyncSinkMessage(std::move(msg)); })
+            .getAsync([this, session](Status status) {
+                if (status.isOK()) {
+                    _echo(std::move(session));
+                }
+            });
+    }
+};
+
+/**
+ * Raises the soft limit on open files far enough for 'fds' descriptors, and returns whether it
+ * could.
+ */
+bool ensureFileLimit(rlim_t fds) {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return false;
+    }
+    if (limit.rlim_cur >= fds) {
+        return true;
+    }
+    if (limit.rlim_max < fds) {
+        return false;
+    }
+    limit.rlim_cur = fds;
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+int connectToLoopback(int port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    invariant(fd >= 0);
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    invariant(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+
+    const int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+void sendAll(int fd, const char* buf, size_t len) {
+    while (len) {
+        const auto ret = ::send(fd, buf, len, MSG_NOSIGNAL);
+        invariant(ret > 0);
+        buf += ret;
+        len -= ret;
+    }
+}
+
+void recvAll(int fd, char* buf, size_t len) {
+    while (len) {
+        const auto ret = ::recv(fd, buf, len, 0);
+        invariant(ret > 0);
+        buf += ret;
+        len -= ret;
+    }
+}
+
+/**
+ * Drives a round trip on every connection per iteration. Each client thread writes a ping to
+ * each of its connections and then reads back all of the replies, so the server has as many
+ * messages in flight as there are connections. Reports the 99th percentile time of a round.
+ */
+template <typename TransportLayerType>
+void runEchoBenchmark(benchmark::State& state, typename TransportLayerType::Options options) {
+    const int numConnections = state.range(0);
+
+    // Each connection takes a descriptor on both ends.
+    if (!ensureFileLimit(2 * numConnections + 1024)) {
+        state.SkipWithError("Cannot raise the open file limit high enough");
+        return;
+    }
+
+    serverGlobalParams.listenBacklog = SOMAXCONN;
+
+    EchoSEP sep;
+    TransportLayerType tl(options, &sep);
+    invariant(tl.setup().isOK());
+    invariant(tl.start().isOK());
+
+    auto reactor = tl.getReactor(transport::TransportLayer::kIngress);
+    std::vector<stdx::thread> reactorThreads;
+    for (int i = 0; i < kReactorThreads; i++) {
+        reactorThreads.emplace_back([&] { reactor->run(); });
+    }
+
+    std::vector<std::vector<int>> connections(kClientThreads);
+    for (int i = 0; i < numConnections; i++) {
+        connections[i % kClientThreads].push_back(connectToLoopback(tl.listenerPort()));
+    }
+
+    const Message ping = [] {
+        OpMsgBuilder builder;
+        builder.setBody(BSON("ping" << 1));
+        auto msg = builder.finish();
+        msg.header().setId(0);
+        msg.header().setResponseToMsgId(0);
+        return msg;
+    }();
+
+    // The client threads start a round whenever 'round' goes up, and the benchmark thread waits
+    // for all of them to finish it.
+    stdx::mutex mutex;
+    stdx::condition_variable cv;
+    int64_t round = 0;
+    int finished = 0;
+    bool done = false;
+
+    std::vector<stdx::thread> clientThreads;
+    for (int i = 0; i < kClientThreads; i++) {
+        clientThreads.emplace_back([&, i] {
+            std::vector<char> reply(ping.size());
+            int64_t lastRound = 0;
+            while (true) {
+                {
+                    stdx::unique_lock<stdx::mutex> lk(mutex);
+                    cv.wait(lk, [&] { return done || round != lastRound; });
+                    if (done) {
+                        return;
+                    }
+                    lastRound = round;
+                }
+
+                for (auto fd : connections[i]) {
+                    sendAll(fd, ping.buf(), ping.size());
+                }
+                for (auto fd : connections[i]) {
+                    recvAll(fd, reply.data(), reply.size());
+                }
+
+                stdx::lock_guard<stdx::mutex> lk(mutex);
+                if (++finished == kClientThreads) {
+                    cv.notify_all();
+                }
+            }
+        });
+    }
+
+    std::vector<int64_t> roundMicros;
+    for (auto _ : state) {
+        Timer timer;
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        finished = 0;
+        round++;
+        cv.notify_all();
+        cv.wait(lk, [&] { return finished == kClientThreads; });
+        roundMicros.push_back(timer.micros());
+    }
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        done = true;
+        cv.notify_all();
+    }
+    for (auto& thread : clientThreads) {
+        thread.join();
+    }
+
+    for (auto& fds : connections) {
+        for (auto fd : fds) {
+            ::close(fd);
+        }
+    }
+
+    tl.shutdown();
+    reactor->stop();
+    for (auto& thread : reactorThreads) {
+        thread.join();
+    }
+
+    std::sort(roundMicros.begin(), roundMicros.end());
+    state.counters["p99Micros"] = roundMicros[(roundMicros.size() - 1) * 99 / 100];
+    state.SetItemsProcessed(state.iterations() * numConnections);
+}
+
+template <typename TransportLayerType>
+typename TransportLayerType::Options makeOptions() {
+    ServerGlobalParams params;
+    params.noUnixSocket = true;
+    typename TransportLayerType::Options opts(&params);
+    opts.port = 0;
+    return opts;
+}
+
+void BM_EchoASIO(benchmark::State& state) {
+    auto options = makeOptions<transport::TransportLayerASIO>();
+    options.transportMode = transport::Mode::kAsynchronous;
+    runEchoBenchmark<transport::TransportLayerASIO>(state, options);
+}
+
+BENCHMARK(BM_EchoASIO)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime();
+
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+void BM_EchoIOUring(benchmark::State& state) {
+    auto status = transport::TransportLayerIOUring::checkKernelSupport();
+    if (!status.isOK()) {
+        state.SkipWithError(status.reason().c_str());
+        return;
+    }
+
+    runEchoBenchmark<transport::TransportLayerIOUring>(
+        state, makeOptions<transport::TransportLayerIOUring>());
+}
+
+BENCHMARK(BM_EchoIOUring)->Arg(100)->Arg(1000)->Arg(10000)->UseRealTime();
+#endif
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,1326 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#include <deque>
+#include <linux/io_uring.h>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mongo/config.h"
+#include "mongo/db/server_options.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/hostandport.h"
+#include "mongo/util/net/socket_utils.h"
+#include "mongo/util/net/ssl_options.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+// The user data of the completions for the reactor's wakeup poll and for requests whose result
+// nobody waits for. Every other completion carries a pointer to its Operation.
+constexpr uint64_t kWakeupUserData = 1;
+constexpr uint64_t kNoOperationUserData = 0;
+
+const Status kConnectionClosedStatus{ErrorCodes::HostUnreachable, "Connection was closed"};
+
+Status errnoToStatus(int err) {
+    switch (err) {
+        case ECANCELED:
+            return {ErrorCodes::CallbackCanceled, "Callback was canceled"};
+        case EAGAIN:
+            return {ErrorCodes::NetworkTimeout, "Socket operation timed out"};
+        case ECONNRESET:
+        case ENETRESET:
+        case EPIPE:
+            return kConnectionClosedStatus;
+        default:
+            return {ErrorCodes::SocketException, errnoWithDescription(err)};
+    }
+}
+
+/**
+ * A request handed to the kernel. The reactor calls complete() with the result of each of its
+ * completion queue entries and destroys it after the last one, which for a multishot request is
+ * the first one without IORING_CQE_F_MORE set.
+ */
+class Operation {
+public:
+    virtual ~Operation() = default;
+
+    virtual void complete(int result, uint32_t flags) = 0;
+};
+
+template <typename Callback>
+class CallbackOperation final : public Operation {
+public:
+    explicit CallbackOperation(Callback callback) : _callback(std::move(callback)) {}
+
+    void complete(int result, uint32_t flags) override {
+        _callback(result, flags);
+    }
+
+private:
+    Callback _callback;
+};
+
+template <typename Callback>
+std::unique_ptr<Operation> makeOperation(Callback&& callback) {
+    return std::make_unique<CallbackOperation<std::decay_t<Callback>>>(
+        std::forward<Callback>(callback));
+}
+
+}  // namespace
+
+/**
+ * Owns an io_uring instance and its mapped submission and completion queues. It does no locking
+ * of its own.
+ */
+class TransportLayerIOUring::IOUring {
+    MONGO_DISALLOW_COPYING(IOUring);
+
+public:
+    explicit IOUring(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        // Keep submitting the rest of a batch when one entry in it fails.
+        params.flags = IORING_SETUP_SUBMIT_ALL;
+
+        _fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (_fd < 0) {
+            uasserted(ErrorCodes::InternalError,
+                      str::stream() << "io_uring_setup failed: " << errnoWithDescription());
+        }
+        auto guard = MakeGuard([this] { _release(); });
+
+        _features = params.features;
+        uassert(ErrorCodes::InternalError,
+                "io_uring does not support mapping both queues at once",
+                _features & IORING_FEAT_SINGLE_MMAP);
+
+        _ringSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                             params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        _ring = _map(_ringSize, IORING_OFF_SQ_RING);
+
+        _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe*>(_map(_sqesSize, IORING_OFF_SQES));
+
+        auto ring = static_cast<char*>(_ring);
+        _sqHead = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+        _sqTail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+        _sqMask = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+        _sqEntries = params.sq_entries;
+        _cqHead = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+        _cqTail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+        _cqMask = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+
+        // Submission queue entries are always used in order, so the indirection array never
+        // changes.
+        auto sqArray = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+        for (unsigned i = 0; i < _sqEntries; i++) {
+            sqArray[i] = i;
+        }
+        _sqLocalTail = *_sqTail;
+
+        guard.Dismiss();
+    }
+
+    ~IOUring() {
+        _release();
+    }
+
+    uint32_t features() const {
+        return _features;
+    }
+
+    bool supportsOpcode(uint8_t opcode) const {
+        std::vector<char> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+        auto probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+        return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    /**
+     * Returns a zeroed submission queue entry, or nullptr if the queue is full.
+     */
+    io_uring_sqe* getSqe() {
+        if (_sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries) {
+            return nullptr;
+        }
+
+        auto sqe = &_sqes[_sqLocalTail & _sqMask];
+        memset(sqe, 0, sizeof(*sqe));
+        _sqLocalTail++;
+        _unsubmitted++;
+        return sqe;
+    }
+
+    /**
+     * Makes every entry from getSqe() visible to the kernel and returns how many it has yet to be
+     * told about. The caller must pass exactly that many to enter(), and hand back the ones
+     * enter() didn't submit through putBack().
+     */
+    unsigned takeUnsubmitted() {
+        __atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+        return std::exchange(_unsubmitted, 0);
+    }
+
+    void putBack(unsigned unsubmitted) {
+        _unsubmitted += unsubmitted;
+    }
+
+    unsigned unsubmitted() const {
+        return _unsubmitted;
+    }
+
+    /**
+     * Submits 'toSubmit' entries and, if 'wait' is set, then waits until there is a completion or
+     * until 'timeout' passes. Returns the number of entries submitted.
+     *
+     * This only touches the queues through the kernel, so it may be called without holding the
+     * lock which guards the other methods.
+     */
+    unsigned enter(unsigned toSubmit, bool wait, boost::optional<Milliseconds> timeout) {
+        unsigned flags = 0;
+        io_uring_getevents_arg eventsArg;
+        __kernel_timespec ts;
+        void* arg = nullptr;
+        size_t argSize = 0;
+        if (wait) {
+            flags |= IORING_ENTER_GETEVENTS;
+            if (timeout) {
+                ts.tv_sec = durationCount<Seconds>(*timeout);
+                ts.tv_nsec = durationCount<Nanoseconds>(*timeout - Seconds(ts.tv_sec));
+                memset(&eventsArg, 0, sizeof(eventsArg));
+                eventsArg.ts = reinterpret_cast<uint64_t>(&ts);
+                flags |= IORING_ENTER_EXT_ARG;
+                arg = &eventsArg;
+                argSize = sizeof(eventsArg);
+            }
+        }
+
+        auto ret = syscall(__NR_io_uring_enter, _fd, toSubmit, wait ? 1 : 0, flags, arg, argSize);
+        if (ret >= 0) {
+            return ret;
+        }
+
+        // The wait timed out or was interrupted, or the completion queue is backed up and has to
+        // be reaped before more can be submitted.
+        const auto err = errno;
+        if (err == ETIME || err == EINTR || err == EBUSY || err == EAGAIN) {
+            return 0;
+        }
+
+        severe() << "io_uring_enter failed: " << errnoWithDescription(err);
+        fassertFailed(51250);
+    }
+
+    /**
+     * Calls 'callback' on each completion queue entry the kernel has posted, and returns how many
+     * there were.
+     */
+    template <typename Callback>
+    unsigned reap(Callback&& callback) {
+        unsigned head = *_cqHead;
+        const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        const unsigned count = tail - head;
+        for (; head != tail; head++) {
+            callback(_cqes[head & _cqMask]);
+        }
+        __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+private:
+    void* _map(size_t size, off_t offset) {
+        auto ptr =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+        if (ptr == MAP_FAILED) {
+            uasserted(ErrorCodes::InternalError,
+                      str::stream() << "Failed to map io_uring queues: " << errnoWithDescription());
+        }
+        return ptr;
+    }
+
+    void _release() {
+        if (_sqes) {
+            munmap(_sqes, _sqesSize);
+        }
+        if (_ring) {
+            munmap(_ring, _ringSize);
+        }
+        ::close(_fd);
+    }
+
+    int _fd = -1;
+    uint32_t _features = 0;
+
+    void* _ring = nullptr;
+    size_t _ringSize = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned _sqMask = 0;
+    unsigned _sqEntries = 0;
+    unsigned _sqLocalTail = 0;
+    unsigned _unsubmitted = 0;
+
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned _cqMask = 0;
+    io_uring_cqe* _cqes = nullptr;
+};
+
+/**
+ * A Reactor that waits for completions on an io_uring rather than for readiness on an epoll set.
+ *
+ * Any number of threads may run it. One of them at a time waits in the kernel for completions;
+ * the rest run scheduled tasks or wait for the first to hand them over. Timers are kept in a
+ * sorted map and bound how long the waiting thread sleeps.
+ */
+class TransportLayerIOUring::IOUringReactor final : public Reactor {
+public:
+    using TimerKey = std::pair<Date_t, uint64_t>;
+
+    explicit IOUringReactor(unsigned queueDepth) : _ring(queueDepth) {
+        _wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wakeupFd < 0) {
+            uasserted(ErrorCodes::InternalError,
+                      str::stream() << "Failed to create eventfd: " << errnoWithDescription());
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _armWakeup(lk);
+    }
+
+    ~IOUringReactor() {
+        // Cancel whatever the kernel still holds, and destroy the operations without completing
+        // them, as asio does with the handlers left in an io_context.
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        auto sqe = _getSqe(lk);
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+        sqe->user_data = kNoOperationUserData;
+        _outstanding++;
+
+        while (_outstanding) {
+            auto toSubmit = _ring.takeUnsubmitted();
+            _ring.putBack(toSubmit - _ring.enter(toSubmit, true, Milliseconds(100)));
+            _ring.reap([&](const io_uring_cqe& cqe) {
+                if (cqe.user_data == kWakeupUserData) {
+                    return;
+                }
+                if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                    delete reinterpret_cast<Operation*>(cqe.user_data);
+                    _outstanding--;
+                }
+            });
+        }
+
+        ::close(_wakeupFd);
+    }
+
+    void run() noexcept override {
+        _run(boost::none);
+    }
+
+    void runFor(Milliseconds time) noexcept override {
+        _run(now() + time);
+    }
+
+    void stop() override {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _stopped = true;
+        _cv.notify_all();
+        if (_polling) {
+            _wakeup(lk);
+        }
+    }
+
+    void drain() override {
+        ThreadIdGuard threadIdGuard(this);
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        while (true) {
+            if (!_tasks.empty()) {
+                _runTask(lk);
+                continue;
+            }
+
+            auto toSubmit = _ring.takeUnsubmitted();
+            _ring.putBack(toSubmit - _ring.enter(toSubmit, false, boost::none));
+            if (!_reapAndRun(lk)) {
+                break;
+            }
+            LOG(2) << "Draining remaining work in reactor.";
+        }
+        _stopped = true;
+    }
+
+    std::unique_ptr<ReactorTimer> makeTimer() override;
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+
+    void schedule(ScheduleMode mode, Task task) override {
+        if (mode == kDispatch && onReactorThread()) {
+            task();
+            return;
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _tasks.push_back(std::move(task));
+        _notifyWork(lk);
+    }
+
+    bool onReactorThread() const override {
+        return this == _reactorForThread;
+    }
+
+    /**
+     * Queues 'op' for the kernel, with 'prep' filling in its submission queue entry. Operations
+     * queued from a reactor thread are submitted together when that thread next goes back to the
+     * ring. Any others are submitted right away.
+     */
+    template <typename Prep>
+    void submit(std::unique_ptr<Operation> op, Prep&& prep) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto sqe = _getSqe(lk);
+        prep(sqe);
+        sqe->user_data = reinterpret_cast<uint64_t>(op.release());
+        _outstanding++;
+
+        if (!onReactorThread()) {
+            _submit(lk);
+        }
+    }
+
+    /**
+     * Like submit(), for requests with no Operation to complete, like cancellations.
+     */
+    template <typename Prep>
+    void submitWithoutCompletion(Prep&& prep) {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        auto sqe = _getSqe(lk);
+        prep(sqe);
+        sqe->user_data = kNoOperationUserData;
+        _outstanding++;
+
+        if (!onReactorThread()) {
+            _submit(lk);
+        }
+    }
+
+    Future<void> addTimer(Date_t expiration, boost::optional<TimerKey>* key) {
+        auto pf = makePromiseFuture<void>();
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        *key = TimerKey(expiration, _nextTimerId++);
+        const bool isFirst = _timers.empty() || *key < _timers.begin()->first;
+        _timers.emplace(**key, std::move(pf.promise));
+        if (isFirst) {
+            _notifyWork(lk);
+        }
+        return std::move(pf.future);
+    }
+
+    void cancelTimer(boost::optional<TimerKey>* key) {
+        boost::optional<Promise<void>> promise;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (!*key) {
+                return;
+            }
+
+            auto it = _timers.find(**key);
+            key->reset();
+            if (it == _timers.end()) {
+                return;
+            }
+            promise.emplace(std::move(it->second));
+            _timers.erase(it);
+        }
+
+        promise->setError({ErrorCodes::CallbackCanceled, "Callback was canceled"});
+    }
+
+private:
+    class ThreadIdGuard {
+    public:
+        ThreadIdGuard(IOUringReactor* reactor) {
+            _reactorForThread = reactor;
+        }
+
+        ~ThreadIdGuard() {
+            _reactorForThread = nullptr;
+        }
+    };
+
+    struct Completion {
+        Operation* op;
+        int result;
+        uint32_t flags;
+    };
+
+    void _run(boost::optional<Date_t> deadline) noexcept {
+        ThreadIdGuard threadIdGuard(this);
+        try {
+            stdx::unique_lock<stdx::mutex> lk(_mutex);
+            while (!_stopped) {
+                if (_fireTimers(lk)) {
+                    continue;
+                }
+
+                if (!_tasks.empty()) {
+                    _runTask(lk);
+                    continue;
+                }
+
+                const auto now = Date_t::now();
+                if (deadline && now >= *deadline) {
+                    break;
+                }
+
+                auto wakeAt = deadline.value_or(Date_t::max());
+                if (!_timers.empty()) {
+                    wakeAt = std::min(wakeAt, _timers.begin()->first.first);
+                }
+
+                if (_polling) {
+                    // Another thread is waiting on the ring. Hand it what this one queued, then
+                    // wait for a task or for that thread to come back with completions.
+                    _submit(lk);
+                    _idleThreads++;
+                    if (wakeAt == Date_t::max()) {
+                        _cv.wait(lk);
+                    } else {
+                        _cv.wait_until(lk, wakeAt.toSystemTimePoint());
+                    }
+                    _idleThreads--;
+                    continue;
+                }
+
+                _polling = true;
+                auto toSubmit = _ring.takeUnsubmitted();
+                lk.unlock();
+
+                boost::optional<Milliseconds> timeout;
+                if (wakeAt != Date_t::max()) {
+                    timeout = std::max(wakeAt - now, Milliseconds(0));
+                }
+                const auto submitted = _ring.enter(toSubmit, true, timeout);
+
+                lk.lock();
+                _ring.putBack(toSubmit - submitted);
+                _polling = false;
+                _reapAndRun(lk);
+            }
+
+            // Don't strand what this thread queued when it returns.
+            _submit(lk);
+        } catch (...) {
+            severe() << "Uncaught exception in reactor: " << exceptionToStatus();
+            fassertFailed(51251);
+        }
+    }
+
+    void _runTask(stdx::unique_lock<stdx::mutex>& lk) {
+        auto task = std::move(_tasks.front());
+        _tasks.pop_front();
+        lk.unlock();
+        task();
+        lk.lock();
+    }
+
+    /**
+     * Fulfills the promises of the timers which have expired, and returns whether there were any.
+     */
+    bool _fireTimers(stdx::unique_lock<stdx::mutex>& lk) {
+        if (_timers.empty()) {
+            return false;
+        }
+
+        const auto now = Date_t::now();
+        std::vector<Promise<void>> expired;
+        while (!_timers.empty() && _timers.begin()->first.first <= now) {
+            expired.push_back(std::move(_timers.begin()->second));
+            _timers.erase(_timers.begin());
+        }
+        if (expired.empty()) {
+            return false;
+        }
+
+        lk.unlock();
+        for (auto& promise : expired) {
+            promise.emplaceValue();
+        }
+        lk.lock();
+        return true;
+    }
+
+    /**
+     * Takes every completion the kernel has posted and runs them, and returns how many operations
+     * were completed.
+     */
+    size_t _reapAndRun(stdx::unique_lock<stdx::mutex>& lk) {
+        std::vector<Completion> completions;
+        _ring.reap([&](const io_uring_cqe& cqe) {
+            if (cqe.user_data == kWakeupUserData) {
+                uint64_t count;
+                while (::read(_wakeupFd, &count, sizeof(count)) > 0) {
+                }
+                _wakeupPending = false;
+                if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                    _armWakeup(lk);
+                }
+                return;
+            }
+
+            if (cqe.user_data == kNoOperationUserData) {
+                _outstanding--;
+                return;
+            }
+
+            completions.push_back(
+                {reinterpret_cast<Operation*>(cqe.user_data), cqe.res, cqe.flags});
+        });
+
+        // Let another thread wait on the ring while this one runs the completions.
+        if (_idleThreads) {
+            _cv.notify_one();
+        }
+
+        if (completions.empty()) {
+            return 0;
+        }
+
+        size_t finished = 0;
+        lk.unlock();
+        for (const auto& completion : completions) {
+            completion.op->complete(completion.result, completion.flags);
+            if (!(completion.flags & IORING_CQE_F_MORE)) {
+                delete completion.op;
+                finished++;
+            }
+        }
+        lk.lock();
+
+        _outstanding -= finished;
+        return completions.size();
+    }
+
+    io_uring_sqe* _getSqe(WithLock lk) {
+        while (true) {
+            if (auto sqe = _ring.getSqe()) {
+                return sqe;
+            }
+
+            // The submission queue is full, so hand the kernel what's in it to make room.
+            _submit(lk);
+        }
+    }
+
+    void _submit(WithLock) {
+        if (!_ring.unsubmitted()) {
+            return;
+        }
+
+        auto toSubmit = _ring.takeUnsubmitted();
+        _ring.putBack(toSubmit - _ring.enter(toSubmit, false, boost::none));
+    }
+
+    /**
+     * Makes a thread run scheduled tasks or timers, either by waking one that is idle or by
+     * interrupting the one waiting on the ring.
+     */
+    void _notifyWork(WithLock lk) {
+        if (_idleThreads) {
+            _cv.notify_one();
+        } else if (_polling) {
+            _wakeup(lk);
+        }
+    }
+
+    void _wakeup(WithLock) {
+        if (_wakeupPending) {
+            return;
+        }
+
+        _wakeupPending = true;
+        uint64_t one = 1;
+        if (::write(_wakeupFd, &one, sizeof(one)) < 0) {
+            warning() << "Failed to wake up io_uring reactor: " << errnoWithDescription();
+        }
+    }
+
+    void _armWakeup(WithLock lk) {
+        auto sqe = _getSqe(lk);
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = _wakeupFd;
+        sqe->poll32_events = POLLIN;
+        sqe->len = IORING_POLL_ADD_MULTI;
+        sqe->user_data = kWakeupUserData;
+        _submit(lk);
+    }
+
+    static thread_local IOUringReactor* _reactorForThread;
+
+    stdx::mutex _mutex;
+    stdx::condition_variable _cv;
+
+    IOUring _ring;
+    int _wakeupFd = -1;
+
+    bool _stopped = false;
+    bool _polling = false;
+    bool _wakeupPending = false;
+    size_t _idleThreads = 0;
+
+    // The number of requests the kernel has yet to post a final completion for.
+    size_t _outstanding = 0;
+
+    std::deque<Task> _tasks;
+
+    std::map<TimerKey, Promise<void>> _timers;
+    uint64_t _nextTimerId = 0;
+};
+
+thread_local TransportLayerIOUring::IOUringReactor*
+    TransportLayerIOUring::IOUringReactor::_reactorForThread = nullptr;
+
+class TransportLayerIOUring::IOUringTimer final : public ReactorTimer {
+public:
+    explicit IOUringTimer(IOUringReactor* reactor) : _reactor(reactor) {}
+
+    ~IOUringTimer() {
+        // Fill the outstanding promise, as ASIOReactorTimer does.
+        cancel();
+    }
+
+    void cancel(const BatonHandle& baton = nullptr) override {
+        _reactor->cancelTimer(&_key);
+    }
+
+    Future<void> waitFor(Milliseconds timeout, const BatonHandle& baton = nullptr) override {
+        return waitUntil(_reactor->now() + timeout, baton);
+    }
+
+    Future<void> waitUntil(Date_t expiration, const BatonHandle& baton = nullptr) override {
+        cancel();
+        return _reactor->addTimer(expiration, &_key);
+    }
+
+private:
+    IOUringReactor* const _reactor;
+    boost::optional<IOUringReactor::TimerKey> _key;
+};
+
+std::unique_ptr<ReactorTimer> TransportLayerIOUring::IOUringReactor::makeTimer() {
+    return std::make_unique<IOUringTimer>(this);
+}
+
+class TransportLayerIOUring::IOUringSession final : public Session {
+    MONGO_DISALLOW_COPYING(IOUringSession);
+
+public:
+    // Takes ownership of 'fd', and closes it even if the constructor throws.
+    IOUringSession(TransportLayerIOUring* tl, int fd) : _tl(tl), _fd(fd) {
+        auto guard = MakeGuard([fd] { ::close(fd); });
+
+        sockaddr_storage storage;
+        socklen_t size = sizeof(storage);
+        if (::getsockname(_fd, reinterpret_cast<sockaddr*>(&storage), &size) != 0) {
+            uasserted(ErrorCodes::SocketException, errnoWithDescription());
+        }
+        SockAddr localAddr(storage, size);
+
+        size = sizeof(storage);
+        if (::getpeername(_fd, reinterpret_cast<sockaddr*>(&storage), &size) != 0) {
+            uasserted(ErrorCodes::SocketException, errnoWithDescription());
+        }
+        SockAddr remoteAddr(storage, size);
+
+        const auto family = localAddr.getType();
+        if (family == AF_INET || family == AF_INET6) {
+            const int on = 1;
+            ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            ::setsockopt(_fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+            setSocketKeepAliveParams(_fd);
+        }
+
+        _local = HostAndPort(localAddr);
+        _remote = HostAndPort(remoteAddr);
+
+        guard.Dismiss();
+    }
+
+    ~IOUringSession() {
+        ::close(_fd);
+    }
+
+    TransportLayer* getTransportLayer() const override {
+        return _tl;
+    }
+
+    const HostAndPort& remote() const override {
+        return _remote;
+    }
+
+    const HostAndPort& local() const override {
+        return _local;
+    }
+
+    void end() override {
+        if (_ended.swap(true)) {
+            return;
+        }
+
+        if (_blockingMode == Async) {
+            cancelAsyncOperations();
+        }
+        if (::shutdown(_fd, SHUT_RDWR) != 0 && errno != ENOTCONN) {
+            error() << "Error shutting down socket: " << errnoWithDescription();
+        }
+    }
+
+    StatusWith<Message> sourceMessage() override {
+        ensureSync();
+        return sourceMessageImpl().getNoThrow();
+    }
+
+    Future<Message> asyncSourceMessage(const transport::BatonHandle& baton = nullptr) override {
+        ensureAsync();
+        return sourceMessageImpl();
+    }
+
+    Status sinkMessage(Message message) override {
+        ensureSync();
+        return write(message.buf(), message.size())
+            .then([&message] { networkCounter.hitPhysicalOut(message.size()); })
+            .getNoThrow();
+    }
+
+    Future<void> asyncSinkMessage(Message message,
+                                  const transport::BatonHandle& baton = nullptr) override {
+        ensureAsync();
+        return write(message.buf(), message.size())
+            .then([message /*keep the buffer alive*/]() {
+                networkCounter.hitPhysicalOut(message.size());
+            });
+    }
+
+    void cancelAsyncOperations(const transport::BatonHandle& baton = nullptr) override {
+        LOG(3) << "Cancelling outstanding I/O operations on connection to " << _remote;
+        _tl->_ingressReactor->submit(makeOperation([self = shared_from_this()](int, uint32_t) {}),
+                                     [&](io_uring_sqe* sqe) {
+                                         sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                                         sqe->fd = _fd;
+                                         sqe->cancel_flags =
+                                             IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+                                     });
+    }
+
+    void setTimeout(boost::optional<Milliseconds> timeout) override {
+        invariant(!timeout || timeout->count() > 0);
+        _configuredTimeout = timeout;
+    }
+
+    bool isConnected() override {
+        if (_ended.load()) {
+            return false;
+        }
+
+        pollfd pfd = {_fd, POLLIN, 0};
+        const auto ret = ::poll(&pfd, 1, 0);
+        if (ret == 0) {
+            return true;
+        } else if (ret < 0) {
+            warning() << "Failed to poll socket for connectivity check: " << errnoWithDescription();
+            return false;
+        }
+
+        if (pfd.revents & POLLIN) {
+            char testByte;
+            const auto size = ::recv(_fd, &testByte, sizeof(testByte), MSG_PEEK);
+            if (size == sizeof(testByte)) {
+                return true;
+            } else if (size == -1) {
+                warning() << "Failed to check socket connectivity: " << errnoWithDescription();
+            }
+            // If size == 0 then we got disconnected and we should return false.
+        }
+
+        return false;
+    }
+
+private:
+    void ensureSync() {
+        _blockingMode = Sync;
+
+        if (_socketTimeout != _configuredTimeout) {
+            // Change boost::none (which means no timeout) into a zero value for the socket option,
+            // which also means no timeout.
+            const auto timeout = _configuredTimeout.value_or(Milliseconds{0});
+            timeval tv;
+            tv.tv_sec = durationCount<Seconds>(timeout);
+            tv.tv_usec = durationCount<Microseconds>(timeout - Seconds(tv.tv_sec));
+            for (auto option : {SO_SNDTIMEO, SO_RCVTIMEO}) {
+                if (::setsockopt(_fd, SOL_SOCKET, option, &tv, sizeof(tv)) != 0) {
+                    uasserted(ErrorCodes::SocketException, errnoWithDescription());
+                }
+            }
+
+            _socketTimeout = _configuredTimeout;
+        }
+    }
+
+    void ensureAsync() {
+        // Socket timeouts currently only effect synchronous calls, so make sure the caller isn't
+        // expecting a socket timeout when they do an async operation.
+        invariant(!_configuredTimeout);
+
+        // The socket stays in blocking mode: io_uring never blocks on it.
+        _blockingMode = Async;
+    }
+
+    Future<Message> sourceMessageImpl() {
+        static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+        auto headerBuffer = SharedBuffer::allocate(kHeaderSize);
+        auto ptr = headerBuffer.get();
+        return read(ptr, kHeaderSize)
+            .then([ headerBuffer = std::move(headerBuffer), this ]() mutable {
+                const auto msgLen = size_t(MSGHEADER::View(headerBuffer.get()).getMessageLength());
+                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+                    StringBuilder sb;
+                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
+                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+                    const auto str = sb.str();
+                    LOG(0) << str;
+
+                    return Future<Message>::makeReady(Status(ErrorCodes::ProtocolError, str));
+                }
+
+                if (msgLen == kHeaderSize) {
+                    networkCounter.hitPhysicalIn(msgLen);
+                    return Future<Message>::makeReady(Message(std::move(headerBuffer)));
+                }
+
+                auto buffer = SharedBuffer::allocate(msgLen);
+                memcpy(buffer.get(), headerBuffer.get(), kHeaderSize);
+
+                MsgData::View msgView(buffer.get());
+                return read(msgView.data(), msgView.dataLen())
+                    .then([ buffer = std::move(buffer), msgLen ]() mutable {
+                        networkCounter.hitPhysicalIn(msgLen);
+                        return Message(std::move(buffer));
+                    });
+            });
+    }
+
+    Future<void> read(char* buf, size_t len) {
+        if (_blockingMode == Sync) {
+            return Future<void>::makeReady(syncTransfer(buf, len, [this](char* buf, size_t len) {
+                return ::recv(_fd, buf, len, 0);
+            }));
+        }
+
+        return asyncTransfer(buf, len, [this](io_uring_sqe* sqe, char* buf, size_t len) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = _fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = len;
+        });
+    }
+
+    Future<void> write(const char* buf, size_t len) {
+        // send(2) doesn't write through the pointer, it is only non-const to share the transfer
+        // loops with read().
+        auto mutableBuf = const_cast<char*>(buf);
+        if (_blockingMode == Sync) {
+            return Future<void>::makeReady(
+                syncTransfer(mutableBuf, len, [this](char* buf, size_t len) {
+                    return ::send(_fd, buf, len, MSG_NOSIGNAL);
+                }));
+        }
+
+        return asyncTransfer(mutableBuf, len, [this](io_uring_sqe* sqe, char* buf, size_t len) {
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = _fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = len;
+            sqe->msg_flags = MSG_NOSIGNAL;
+        });
+    }
+
+    template <typename Transfer>
+    Status syncTransfer(char* buf, size_t len, const Transfer& transfer) {
+        while (len) {
+            const auto ret = transfer(buf, len);
+            if (ret > 0) {
+                buf += ret;
+                len -= ret;
+            } else if (ret == 0) {
+                return kConnectionClosedStatus;
+            } else if (errno != EINTR) {
+                return errnoToStatus(errno);
+            }
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Submits a receive or send of 'len' bytes at 'buf', and keeps resubmitting the remainder
+     * until all of it has been transferred.
+     */
+    template <typename Prep>
+    Future<void> asyncTransfer(char* buf, size_t len, Prep prep) {
+        auto pf = makePromiseFuture<int>();
+        _tl->_ingressReactor->submit(
+            makeOperation([ promise = std::move(pf.promise), self = shared_from_this() ](
+                int result, uint32_t) mutable { promise.emplaceValue(result); }),
+            [&](io_uring_sqe* sqe) { prep(sqe, buf, len); });
+
+        return std::move(pf.future).then([this, buf, len, prep](int result) -> Future<void> {
+            if (result < 0) {
+                return errnoToStatus(-result);
+            } else if (result == 0) {
+                return kConnectionClosedStatus;
+            } else if (static_cast<size_t>(result) < len) {
+                return asyncTransfer(buf + result, len - result, prep);
+            }
+            return Status::OK();
+        });
+    }
+
+    enum BlockingMode { Unknown, Sync, Async };
+
+    TransportLayerIOUring* const _tl;
+    const int _fd;
+    AtomicWord<bool> _ended{false};
+
+    HostAndPort _remote;
+    HostAndPort _local;
+
+    BlockingMode _blockingMode = Unknown;
+    boost::optional<Milliseconds> _configuredTimeout;
+    boost::optional<Milliseconds> _socketTimeout;
+};
+
+TransportLayerIOUring::Options::Options(const ServerGlobalParams* params)
+    : port(params->port),
+      ipList(params->bind_ips),
+      useUnixSockets(!params->noUnixSocket),
+      enableIPv6(params->enableIPv6) {}
+
+TransportLayerIOUring::TransportLayerIOUring(const Options& opts, ServiceEntryPoint* sep)
+    : _ingressReactor(std::make_shared<IOUringReactor>(opts.queueDepth)),
+      _acceptorReactor(std::make_shared<IOUringReactor>(opts.queueDepth)),
+      _sep(sep),
+      _listenerOptions(opts) {}
+
+TransportLayerIOUring::~TransportLayerIOUring() {
+    for (auto& acceptor : _acceptors) {
+        ::close(acceptor.fd);
+    }
+}
+
+Status TransportLayerIOUring::checkKernelSupport() try {
+    IOUring ring(8);
+
+    const uint32_t requiredFeatures = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    // IORING_OP_SOCKET arrived in the same release as multishot accept and fd-wide cancellation.
+    const uint8_t requiredOpcodes[] = {IORING_OP_ACCEPT,
+                                       IORING_OP_RECV,
+                                       IORING_OP_SEND,
+                                       IORING_OP_POLL_ADD,
+                                       IORING_OP_ASYNC_CANCEL,
+                                       IORING_OP_SOCKET};
+
+    bool supported = (ring.features() & requiredFeatures) == requiredFeatures;
+    for (auto opcode : requiredOpcodes) {
+        supported = supported && ring.supportsOpcode(opcode);
+    }
+
+    if (!supported) {
+        return {ErrorCodes::InvalidOptions,
+                "The io_uring transport layer requires Linux 5.19 or newer"};
+    }
+    return Status::OK();
+} catch (const DBException& ex) {
+    return ex.toStatus().withContext("The io_uring transport layer is not available");
+}
+
+StatusWith<SessionHandle> TransportLayerIOUring::connect(HostAndPort peer,
+                                                         ConnectSSLMode sslMode,
+                                                         Milliseconds timeout) {
+    return {ErrorCodes::IllegalOperation,
+            "The io_uring transport layer does not make outgoing connections"};
+}
+
+Future<SessionHandle> TransportLayerIOUring::asyncConnect(HostAndPort peer,
+                                                          ConnectSSLMode sslMode,
+                                                          const ReactorHandle& reactor,
+                                                          Milliseconds timeout) {
+    return Status(ErrorCodes::IllegalOperation,
+                  "The io_uring transport layer does not make outgoing connections");
+}
+
+Status TransportLayerIOUring::setup() {
+#ifdef MONGO_CONFIG_SSL
+    if (getSSLGlobalParams().sslMode.load() != SSLParams::SSLMode_disabled) {
+        return {ErrorCodes::InvalidOptions, "The io_uring transport layer does not support TLS"};
+    }
+#endif
+
+    std::vector<std::string> listenAddrs;
+    if (_listenerOptions.ipList.empty()) {
+        listenAddrs = {"127.0.0.1"};
+        if (_listenerOptions.enableIPv6) {
+            listenAddrs.emplace_back("::1");
+        }
+    } else {
+        listenAddrs = _listenerOptions.ipList;
+    }
+
+    if (_listenerOptions.useUnixSockets) {
+        listenAddrs.emplace_back(makeUnixSockPath(_listenerOptions.port));
+    }
+
+    _listenerPort = _listenerOptions.port;
+
+    for (auto& ip : listenAddrs) {
+        if (ip.empty()) {
+            warning() << "Skipping empty bind address";
+            continue;
+        }
+
+        const auto addrs = SockAddr::createAll(
+            ip, _listenerPort, _listenerOptions.enableIPv6 ? AF_UNSPEC : AF_INET);
+        if (addrs.empty()) {
+            warning() << "Found no addresses for " << ip;
+            continue;
+        }
+
+        for (auto& addr : addrs) {
+            const auto family = addr.getType();
+            if (family == AF_UNIX) {
+                if (::unlink(addr.getAddr().c_str()) == -1 && errno != ENOENT) {
+                    return {ErrorCodes::SocketException,
+                            str::stream() << "Failed to unlink socket file " << addr.getAddr()
+                                          << " "
+                                          << errnoWithDescription()};
+                }
+            }
+
+            if (family == AF_INET6 && !_listenerOptions.enableIPv6) {
+                return {ErrorCodes::InvalidOptions,
+                        "Specified ipv6 bind address, but ipv6 is disabled"};
+            }
+
+            const int fd = ::socket(family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to create socket: " << errnoWithDescription()};
+            }
+            _acceptors.push_back({addr, fd});
+
+            const int on = 1;
+            if (family != AF_UNIX) {
+                ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            }
+            if (family == AF_INET6) {
+                ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+            }
+
+            if (::bind(fd, addr.raw(), addr.addressSize) != 0) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to bind to " << addr.toString() << ": "
+                                      << errnoWithDescription()};
+            }
+
+            if (family == AF_UNIX) {
+                if (::chmod(addr.getAddr().c_str(), serverGlobalParams.unixSocketPermissions) ==
+                    -1) {
+                    return {ErrorCodes::SocketException,
+                            str::stream() << "Failed to chmod socket file " << addr.getAddr()
+                                          << " "
+                                          << errnoWithDescription()};
+                }
+            }
+
+            if (_listenerOptions.port == 0 && (family == AF_INET || family == AF_INET6)) {
+                if (_listenerPort != _listenerOptions.port) {
+                    return Status(ErrorCodes::BadValue,
+                                  "Port 0 (ephemeral port) is not allowed when"
+                                  " listening on multiple IP interfaces");
+                }
+
+                sockaddr_storage storage;
+                socklen_t size = sizeof(storage);
+                if (::getsockname(fd, reinterpret_cast<sockaddr*>(&storage), &size) != 0) {
+                    return {ErrorCodes::SocketException, errnoWithDescription()};
+                }
+                _listenerPort = SockAddr(storage, size).getPort();
+            }
+        }
+    }
+
+    if (_acceptors.empty()) {
+        return Status(ErrorCodes::SocketException, "No available addresses/ports to bind to");
+    }
+
+    return Status::OK();
+}
+
+Status TransportLayerIOUring::start() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _running.store(true);
+
+    for (auto& acceptor : _acceptors) {
+        if (::listen(acceptor.fd, serverGlobalParams.listenBacklog) != 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to listen on " << acceptor.addr.toString() << ": "
+                                  << errnoWithDescription()};
+        }
+        _acceptConnections(acceptor);
+    }
+
+    _listenerThread = stdx::thread([this] {
+        setThreadName("listener");
+        while (_running.load()) {
+            _acceptorReactor->run();
+        }
+    });
+
+    log() << "waiting for connections on port " << _listenerPort << " using io_uring";
+    return Status::OK();
+}
+
+void TransportLayerIOUring::shutdown() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _running.store(false);
+
+    // Cancel the accepts on the listening sockets. This will prevent new connections from being
+    // opened.
+    for (auto& acceptor : _acceptors) {
+        _acceptorReactor->submitWithoutCompletion([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = acceptor.fd;
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        });
+
+        auto& addr = acceptor.addr;
+        if (addr.getType() == AF_UNIX && !addr.isAnonymousUNIXSocket()) {
+            auto path = addr.getAddr();
+            log() << "removing socket file: " << path;
+            if (::unlink(path.c_str()) != 0) {
+                const auto ewd = errnoWithDescription();
+                warning() << "Unable to remove UNIX socket " << path << ": " << ewd;
+            }
+        }
+    }
+
+    if (_listenerThread.joinable()) {
+        _acceptorReactor->stop();
+        _listenerThread.join();
+    }
+}
+
+ReactorHandle TransportLayerIOUring::getReactor(WhichReactor which) {
+    switch (which) {
+        case TransportLayer::kIngress:
+            return _ingressReactor;
+        case TransportLayer::kEgress:
+            // There is no egress networking here; it belongs to the paired TransportLayerASIO.
+            return nullptr;
+        case TransportLayer::kNewReactor:
+            return std::make_shared<IOUringReactor>(_listenerOptions.queueDepth);
+    }
+
+    MONGO_UNREACHABLE;
+}
+
+void TransportLayerIOUring::_acceptConnections(const Acceptor& acceptor) {
+    auto acceptCb = [this, &acceptor](int result, uint32_t flags) {
+        if (result >= 0) {
+            if (!_running.load()) {
+                ::close(result);
+                return;
+            }
+
+            try {
+                _sep->startSession(std::make_shared<IOUringSession>(this, result));
+            } catch (const DBException& e) {
+                warning() << "Error accepting new connection " << e;
+            }
+        } else if (result != -ECANCELED) {
+            log() << "Error accepting new connection on " << acceptor.addr.toString() << ": "
+                  << errnoWithDescription(-result);
+        }
+
+        // The kernel ends a multishot accept when it fails, so start another one.
+        if (!(flags & IORING_CQE_F_MORE) && _running.load()) {
+            _acceptConnections(acceptor);
+        }
+    };
+
+    _acceptorReactor->submit(makeOperation(std::move(acceptCb)), [&](io_uring_sqe* sqe) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = acceptor.fd;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    });
+}
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,139 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/db/server_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/util/net/sockaddr.h"
+
+namespace mongo {
+
+class ServiceEntryPoint;
+
+namespace transport {
+
+/**
+ * An experimental, ingress-only TransportLayer for Linux built directly on io_uring.
+ *
+ * Accepted connections come from one multishot accept per listening socket. Asynchronous reads
+ * and writes are queued as submission queue entries, and the ones queued from a reactor thread
+ * while it runs completions are handed to the kernel together in a single io_uring_enter(2).
+ * Synchronous reads and writes are plain blocking syscalls, as they are in TransportLayerASIO.
+ *
+ * It cannot make outgoing connections and does not support TLS, so it has to be paired with an
+ * egress TransportLayerASIO. It requires Linux 5.19 or newer.
+ */
+class TransportLayerIOUring final : public TransportLayer {
+    MONGO_DISALLOW_COPYING(TransportLayerIOUring);
+
+public:
+    struct Options {
+        explicit Options(const ServerGlobalParams* params);
+        Options() = default;
+
+        int port = ServerGlobalParams::DefaultDBPort;  // port to bind to
+        std::vector<std::string> ipList;               // addresses to bind to
+        bool useUnixSockets = true;                    // whether to allow UNIX sockets in ipList
+        bool enableIPv6 = false;                       // whether to allow IPv6 sockets in ipList
+        unsigned queueDepth = 4096;                    // number of entries in each submission queue
+    };
+
+    TransportLayerIOUring(const Options& opts, ServiceEntryPoint* sep);
+
+    ~TransportLayerIOUring();
+
+    /**
+     * Returns an error if the running kernel lacks any of the io_uring features this transport
+     * layer relies on.
+     */
+    static Status checkKernelSupport();
+
+    StatusWith<SessionHandle> connect(HostAndPort peer,
+                                      ConnectSSLMode sslMode,
+                                      Milliseconds timeout) final;
+
+    Future<SessionHandle> asyncConnect(HostAndPort peer,
+                                       ConnectSSLMode sslMode,
+                                       const ReactorHandle& reactor,
+                                       Milliseconds timeout) final;
+
+    Status setup() final;
+
+    ReactorHandle getReactor(WhichReactor which) final;
+
+    Status start() final;
+
+    void shutdown() final;
+
+    int listenerPort() const {
+        return _listenerPort;
+    }
+
+private:
+    class IOUring;
+    class IOUringReactor;
+    class IOUringSession;
+    class IOUringTimer;
+
+    struct Acceptor {
+        SockAddr addr;
+        int fd;
+    };
+
+    void _acceptConnections(const Acceptor& acceptor);
+
+    stdx::mutex _mutex;
+
+    // Accepted sessions do their asynchronous I/O on the _ingressReactor, which, as with
+    // TransportLayerASIO, is only run by the ServiceExecutor. The _acceptorReactor holds the
+    // multishot accepts for the listening sockets and is run by the listener thread.
+    std::shared_ptr<IOUringReactor> _ingressReactor;
+    std::shared_ptr<IOUringReactor> _acceptorReactor;
+
+    std::vector<Acceptor> _acceptors;
+
+    stdx::thread _listenerThread;
+
+    ServiceEntryPoint* const _sep = nullptr;
+    AtomicWord<bool> _running{false};
+    Options _listenerOptions;
+    // The real incoming port in case of _listenerOptions.port==0 (ephemeral).
+    int _listenerPort = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,241 @@
+/**
+ *    Copyright (C) 2018 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#include "mongo/db/server_options.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/sock.h"
+
+#include "asio.hpp"
+
+namespace mongo {
+namespace {
+
+class TestSEP : public ServiceEntryPoint {
+public:
+    void endAllSessions(transport::Session::TagMask tags) override {
+        MONGO_UNREACHABLE;
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    Stats sessionStats() const override {
+        return {};
+    }
+
+    size_t numOpenSessions() const override {
+        return 0;
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+    void waitForComplete() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _cond.wait(lk, [this] { return _finished; });
+        _finished = false;
+    }
+
+protected:
+    void notifyComplete() {
+        stdx::unique_lock<stdx::mutex> lk(_mutex);
+        _finished = true;
+        _cond.notify_one();
+    }
+
+private:
+    stdx::mutex _mutex;
+    stdx::condition_variable _cond;
+    bool _finished = false;
+};
+
+class Connector {
+public:
+    explicit Connector(int port)
+        : _ctx(), _sock(_ctx), _endpoint(asio::ip::address_v4::loopback(), port) {
+        std::error_code ec;
+        _sock.connect(_endpoint, ec);
+        ASSERT_EQ(ec, std::error_code());
+    }
+
+    Message makeMessage() {
+        OpMsgBuilder builder;
+        builder.setBody(BSON("ping" << 1));
+        Message msg = builder.finish();
+        msg.header().setResponseToMsgId(0);
+        msg.header().setId(0);
+        return msg;
+    }
+
+    void sendMessage(const Message& msg) {
+        std::error_code ec;
+        asio::write(_sock, asio::buffer(msg.buf(), msg.size()), ec);
+        ASSERT_FALSE(ec);
+    }
+
+    std::string receive(size_t size) {
+        std::string buf(size, '\0');
+        std::error_code ec;
+        asio::read(_sock, asio::buffer(&buf[0], size), ec);
+        ASSERT_FALSE(ec);
+        return buf;
+    }
+
+private:
+    asio::io_context _ctx;
+    asio::ip::tcp::socket _sock;
+    asio::ip::tcp::endpoint _endpoint;
+};
+
+std::unique_ptr<transport::TransportLayerIOUring> makeAndStartTL(ServiceEntryPoint* sep) {
+    auto options = [] {
+        ServerGlobalParams params;
+        params.noUnixSocket = true;
+        transport::TransportLayerIOUring::Options opts(&params);
+        opts.port = 0;
+        return opts;
+    }();
+
+    auto tl = std::make_unique<transport::TransportLayerIOUring>(options, sep);
+    ASSERT_OK(tl->setup());
+    ASSERT_OK(tl->start());
+
+    return tl;
+}
+
+class AcceptSEP : public TestSEP {
+public:
+    void startSession(transport::SessionHandle session) override {
+        log() << "Accepted connection from " << session->remote();
+        ASSERT_EQ(session->local().port(), _port);
+        session.reset();
+        notifyComplete();
+    }
+
+    void setPort(int port) {
+        _port = port;
+    }
+
+private:
+    int _port = 0;
+};
+
+TEST(TransportLayerIOUring, PortZeroConnect) {
+    if (!transport::TransportLayerIOUring::checkKernelSupport().isOK()) {
+        log() << "Skipping test, io_uring is not supported by this kernel";
+        return;
+    }
+
+    AcceptSEP sep;
+    auto tl = makeAndStartTL(&sep);
+    const int port = tl->listenerPort();
+    ASSERT_GT(port, 0);
+    sep.setPort(port);
+
+    Connector connector(port);
+    sep.waitForComplete();
+    tl->shutdown();
+}
+
+class TimeoutSyncSEP : public TestSEP {
+public:
+    void startSession(transport::SessionHandle session) override {
+        stdx::thread([ this, session = std::move(session) ]() mutable {
+            session->setTimeout(Milliseconds{500});
+            ASSERT_EQ(session->sourceMessage().getStatus(), ErrorCodes::NetworkTimeout);
+            session.reset();
+            notifyComplete();
+        }).detach();
+    }
+};
+
+TEST(TransportLayerIOUring, SourceSyncTimeoutTimesOut) {
+    if (!transport::TransportLayerIOUring::checkKernelSupport().isOK()) {
+        log() << "Skipping test, io_uring is not supported by this kernel";
+        return;
+    }
+
+    TimeoutSyncSEP sep;
+    auto tl = makeAndStartTL(&sep);
+
+    Connector connector(tl->listenerPort());
+    sep.waitForComplete();
+    tl->shutdown();
+}
+
+// Sources one message asynchronously and sinks it back.
+class AsyncEchoSEP : public TestSEP {
+public:
+    void startSession(transport::SessionHandle session) override {
+        session->asyncSourceMessage()
+            .then([session](Message msg) { return session->asyncSinkMessage(std::move(msg)); })
+            .getAsync([this, session](Status status) {
+                ASSERT_OK(status);
+                notifyComplete();
+            });
+    }
+};
+
+TEST(TransportLayerIOUring, AsyncEcho) {
+    if (!transport::TransportLayerIOUring::checkKernelSupport().isOK()) {
+        log() << "Skipping test, io_uring is not supported by this kernel";
+        return;
+    }
+
+    AsyncEchoSEP sep;
+    auto tl = makeAndStartTL(&sep);
+
+    auto reactor = tl->getReactor(transport::TransportLayer::kIngress);
+    stdx::thread reactorThread([&] { reactor->run(); });
+
+    Connector connector(tl->listenerPort());
+    const auto msg = connector.makeMessage();
+    connector.sendMessage(msg);
+    ASSERT_EQ(connector.receive(msg.size()), std::string(msg.buf(), msg.size()));
+    sep.waitForComplete();
+
+    reactor->stop();
+    reactorThread.join();
+    tl->shutdown();
+}
+
+}  // namespace
+}  // namespace mongo
@@ -31,13 +31,18 @@
 #include "mongo/transport/transport_layer_manager.h"
 
 #include "mongo/base/status.h"
+#include "mongo/config.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/stdx/memory.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer_asio.h"
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+#include "mongo/transport/transport_layer_io_uring.h"
+#endif
 #include "mongo/util/net/ssl_types.h"
 #include "mongo/util/time_support.h"
 #include <limits>
@@ -126,13 +131,60 @@ std::unique_ptr<TransportLayer> TransportLayerManager::makeAndStartDefaultEgress
     return std::unique_ptr<TransportLayer>(std::move(ret));
 }
 
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+namespace {
+
+std::unique_ptr<TransportLayer> createIOUringWithConfig(const ServerGlobalParams* config,
+                                                        ServiceContext* ctx) {
+    uassertStatusOK(transport::TransportLayerIOUring::checkKernelSupport());
+
+    transport::TransportLayerIOUring::Options ingressOpts(config);
+    auto ingress = stdx::make_unique<transport::TransportLayerIOUring>(
+        ingressOpts, ctx->getServiceEntryPoint());
+
+    if (config->serviceExecutor == "adaptive") {
+        auto reactor = ingress->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(
+            stdx::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+    } else if (config->serviceExecutor == "threadPerCore") {
+        auto reactor = ingress->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(
+            stdx::make_unique<ServiceExecutorThreadPerCore>(ctx, std::move(reactor)));
+    } else if (config->serviceExecutor == "synchronous") {
+        ctx->setServiceExecutor(stdx::make_unique<ServiceExecutorSynchronous>(ctx));
+    } else {
+        MONGO_UNREACHABLE;
+    }
+
+    // The io_uring transport layer only accepts connections, so outgoing ones go through an
+    // egress-only TransportLayerASIO. It comes first, which is where connect() and getReactor()
+    // are forwarded.
+    transport::TransportLayerASIO::Options egressOpts(config);
+    egressOpts.mode = transport::TransportLayerASIO::Options::kEgress;
+    egressOpts.ipList.clear();
+
+    std::vector<std::unique_ptr<TransportLayer>> retVector;
+    retVector.emplace_back(stdx::make_unique<transport::TransportLayerASIO>(egressOpts, nullptr));
+    retVector.emplace_back(std::move(ingress));
+    return stdx::make_unique<TransportLayerManager>(std::move(retVector));
+}
+
+}  // namespace
+#endif
+
 std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
     const ServerGlobalParams* config, ServiceContext* ctx) {
     std::unique_ptr<TransportLayer> transportLayer;
     auto sep = ctx->getServiceEntryPoint();
 
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+    if (config->transportLayer == "io_uring") {
+        return createIOUringWithConfig(config, ctx);
+    }
+#endif
+
     transport::TransportLayerASIO::Options opts(config);
-    if (config->serviceExecutor == "adaptive") {
+    if (config->serviceExecutor == "adaptive" || config->serviceExecutor == "threadPerCore") {
         opts.transportMode = transport::Mode::kAsynchronous;
     } else if (config->serviceExecutor == "synchronous") {
         opts.transportMode = transport::Mode::kSynchronous;
@@ -146,6 +198,10 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
         auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
         ctx->setServiceExecutor(
             stdx::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+    } else if (config->serviceExecutor == "threadPerCore") {
+        auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(
+            stdx::make_unique<ServiceExecutorThreadPerCore>(ctx, std::move(reactor)));
     } else if (config->serviceExecutor == "synchronous") {
         ctx->setServiceExecutor(stdx::make_unique<ServiceExecutorSynchronous>(ctx));
     }